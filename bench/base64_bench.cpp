@@ -0,0 +1,102 @@
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <openssl/evp.h>
+
+#include "cryptography/base64.hpp"
+#include "cryptography/nostr_secure_rng.hpp"
+
+using namespace nostr::cryptography;
+using namespace nostr::encoding;
+using namespace std;
+
+namespace nostr_bench
+{
+static vector<uint8_t> randomPayload(size_t size)
+{
+    vector<uint8_t> payload(size);
+    NostrSecureRng::fill(payload.data(), payload.size());
+    return payload;
+};
+
+/**
+ * @brief Encodes a payload into a reused string.
+ */
+static void BM_Base64Encode(benchmark::State& state)
+{
+    auto payload = randomPayload(state.range(0));
+    string encoded;
+
+    for (auto _ : state)
+    {
+        Base64::encode(payload.data(), payload.size(), encoded);
+        benchmark::DoNotOptimize(encoded.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * payload.size());
+};
+
+/**
+ * @brief Decodes a payload into a reused buffer.
+ */
+static void BM_Base64Decode(benchmark::State& state)
+{
+    auto payload = randomPayload(state.range(0));
+    string encoded;
+    Base64::encode(payload.data(), payload.size(), encoded);
+    vector<uint8_t> decoded;
+
+    for (auto _ : state)
+    {
+        Base64::decode(encoded.data(), encoded.size(), decoded);
+        benchmark::DoNotOptimize(decoded.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * encoded.size());
+};
+
+/**
+ * @brief Encodes a payload with OpenSSL's block encoder, for comparison.
+ */
+static void BM_Base64Encode_OpenSsl(benchmark::State& state)
+{
+    auto payload = randomPayload(state.range(0));
+    vector<uint8_t> encoded(Base64::encodedSize(payload.size()) + 1);
+
+    for (auto _ : state)
+    {
+        EVP_EncodeBlock(encoded.data(), payload.data(), static_cast<int>(payload.size()));
+        benchmark::DoNotOptimize(encoded.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * payload.size());
+};
+
+/**
+ * @brief Decodes a payload with OpenSSL's block decoder, for comparison.
+ */
+static void BM_Base64Decode_OpenSsl(benchmark::State& state)
+{
+    auto payload = randomPayload(state.range(0));
+    string encoded;
+    Base64::encode(payload.data(), payload.size(), encoded);
+    vector<uint8_t> decoded(Base64::maxDecodedSize(encoded.size()));
+
+    for (auto _ : state)
+    {
+        EVP_DecodeBlock(
+            decoded.data(),
+            reinterpret_cast<const uint8_t*>(encoded.data()),
+            static_cast<int>(encoded.size()));
+        benchmark::DoNotOptimize(decoded.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * encoded.size());
+};
+
+BENCHMARK(BM_Base64Encode)->Arg(64)->Arg(1024)->Arg(65536);
+BENCHMARK(BM_Base64Encode_OpenSsl)->Arg(64)->Arg(1024)->Arg(65536);
+BENCHMARK(BM_Base64Decode)->Arg(64)->Arg(1024)->Arg(65536);
+BENCHMARK(BM_Base64Decode_OpenSsl)->Arg(64)->Arg(1024)->Arg(65536);
+} // namespace nostr_bench
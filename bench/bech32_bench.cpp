@@ -0,0 +1,193 @@
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "cryptography/nostr_bech32.hpp"
+#include "cryptography/nostr_secure_rng.hpp"
+#include "internal/hex_encoding.hpp"
+
+using namespace nostr::cryptography;
+using namespace nostr::encoding;
+using namespace std;
+
+namespace nostr_bench
+{
+static vector<string> randomPubkeys(size_t count)
+{
+    vector<string> pubkeys;
+    uint8_t pubkey[KEY_LENGTH];
+    for (size_t i = 0; i < count; i++)
+    {
+        NostrSecureRng::fill(pubkey, sizeof(pubkey));
+        pubkeys.push_back(nostr::internal::encodeHex(pubkey, sizeof(pubkey)));
+    }
+    return pubkeys;
+};
+
+/**
+ * @brief Encodes npubs one at a time with `NostrBech32`, which regroups bits into vectors and
+ * computes the checksum one symbol at a time.
+ */
+static void BM_Bech32EncodeNpub_Vector(benchmark::State& state)
+{
+    auto pubkeys = randomPubkeys(state.range(0));
+    NostrBech32 encoder;
+
+    for (auto _ : state)
+    {
+        for (const auto& pubkey : pubkeys)
+        {
+            NostrBech32Encoding input;
+            input.type = NOSTR_BECH32_NPUB;
+            input.data.npub.pubkey = pubkey;
+
+            string npub;
+            encoder.encodeNostrBech32(input, npub);
+            benchmark::DoNotOptimize(npub);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * pubkeys.size());
+};
+
+/**
+ * @brief Encodes npubs with the table-driven batch encoder.
+ */
+static void BM_Bech32EncodeNpub_Batch(benchmark::State& state)
+{
+    auto pubkeys = randomPubkeys(state.range(0));
+
+    for (auto _ : state)
+    {
+        auto npubs = Bech32::encodeBatch("npub", pubkeys);
+        benchmark::DoNotOptimize(npubs.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * pubkeys.size());
+};
+
+/**
+ * @brief Decodes npubs one at a time with `NostrBech32`.
+ */
+static void BM_Bech32DecodeNpub_Vector(benchmark::State& state)
+{
+    auto npubs = Bech32::encodeBatch("npub", randomPubkeys(state.range(0)));
+    NostrBech32 decoder;
+
+    for (auto _ : state)
+    {
+        for (auto& npub : npubs)
+        {
+            NostrBech32Encoding parsed;
+            decoder.parseNostrBech32(npub, parsed);
+            benchmark::DoNotOptimize(parsed.data.npub.pubkey);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * npubs.size());
+};
+
+/**
+ * @brief Decodes npubs with the table-driven batch decoder.
+ */
+static void BM_Bech32DecodeNpub_Batch(benchmark::State& state)
+{
+    auto npubs = Bech32::encodeBatch("npub", randomPubkeys(state.range(0)));
+
+    for (auto _ : state)
+    {
+        auto pubkeys = Bech32::decodeBatch("npub", npubs);
+        benchmark::DoNotOptimize(pubkeys.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * npubs.size());
+};
+
+/**
+ * @brief Encodes a single npub into a stack buffer, the per-link cost when rendering.
+ */
+static void BM_Bech32EncodeBytes(benchmark::State& state)
+{
+    uint8_t pubkey[KEY_LENGTH];
+    NostrSecureRng::fill(pubkey, sizeof(pubkey));
+    char npub[Bech32::encodedLength(4, KEY_LENGTH)];
+
+    for (auto _ : state)
+    {
+        size_t length = Bech32::encodeBytes(
+            "npub", 4, pubkey, sizeof(pubkey), BECH32_ENCODING_BECH32, npub, sizeof(npub));
+        benchmark::DoNotOptimize(length);
+        benchmark::DoNotOptimize(npub);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+};
+
+static const string benchNevent =
+    "nevent1qqsx5u4fcsjyw3d3lz7ejfc2z5nvjpwaj90kkyrpqcvx8a9656ctwyqpzamhxue69uhhyetvv9ujumn0wd68ytnzv9hxgtczyqrgnh6cg75dxdmgjtdzjc3d0s8ac8h3jk85h3z8rkgfv64paj5lyznxtln";
+
+/**
+ * @brief Parses an nevent link with `NostrBech32::parseNostrBech32`, which builds a vector of
+ * TLVs and copies every value.
+ */
+static void BM_ParseNevent_Vector(benchmark::State& state)
+{
+    string nevent = benchNevent;
+    NostrBech32 parser;
+
+    for (auto _ : state)
+    {
+        NostrBech32Encoding parsed;
+        parser.parseNostrBech32(nevent, parsed);
+        benchmark::DoNotOptimize(parsed.data.nevent.event_id);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+};
+
+/**
+ * @brief Parses an nevent link into a fixed-capacity entity.
+ */
+static void BM_ParseNevent_Entity(benchmark::State& state)
+{
+    NostrBech32Entity parsed;
+
+    for (auto _ : state)
+    {
+        bool isParsed = NostrBech32::parseEntity(benchNevent.data(), benchNevent.size(), parsed);
+        benchmark::DoNotOptimize(isParsed);
+        benchmark::DoNotOptimize(parsed.special());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+};
+
+/**
+ * @brief Encodes a parsed nevent back into a stack buffer.
+ */
+static void BM_EncodeNevent_Entity(benchmark::State& state)
+{
+    NostrBech32Entity entity;
+    NostrBech32::parseEntity(benchNevent.data(), benchNevent.size(), entity);
+    char nevent[NostrBech32Entity::maxEncodedLength];
+
+    for (auto _ : state)
+    {
+        size_t length = NostrBech32::encodeEntity(entity, nevent, sizeof(nevent));
+        benchmark::DoNotOptimize(length);
+        benchmark::DoNotOptimize(nevent);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+};
+
+BENCHMARK(BM_Bech32EncodeNpub_Vector)->Arg(1000);
+BENCHMARK(BM_Bech32EncodeNpub_Batch)->Arg(1000);
+BENCHMARK(BM_Bech32DecodeNpub_Vector)->Arg(1000);
+BENCHMARK(BM_Bech32DecodeNpub_Batch)->Arg(1000);
+BENCHMARK(BM_Bech32EncodeBytes);
+BENCHMARK(BM_ParseNevent_Vector);
+BENCHMARK(BM_ParseNevent_Entity);
+BENCHMARK(BM_EncodeNevent_Entity);
+} // namespace nostr_bench
@@ -0,0 +1,146 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "cryptography/nostr_content_scanner.hpp"
+#include "cryptography/nostr_secure_rng.hpp"
+#include "internal/hex_encoding.hpp"
+
+using namespace nostr::cryptography;
+using namespace nostr::encoding;
+using namespace std;
+
+namespace nostr_bench
+{
+/**
+ * @brief Builds a corpus of kind-1 style notes: prose with links, hashtags, and multi-byte
+ * characters, where the given percentage of notes mention one or two entities.
+ */
+static vector<string> noteCorpus(size_t noteCount, int referencePercent)
+{
+    static const vector<string> words = {
+        "gm", "the", "relay", "zap", "bitcoin", "#nostr", "sats", "just", "shipped", "a", "new",
+        "client", "release", "https://example.com/image.jpg", "🤙", "⚡️", "thanks", "for", "the",
+        "follow", "nostr", "is", "growing", "fast", "pura", "vida", "🧡", "what", "do", "you", "think?"
+    };
+
+    mt19937 rng(42);
+    uniform_int_distribution<size_t> wordDistribution(0, words.size() - 1);
+    uniform_int_distribution<int> lengthDistribution(8, 60);
+    uniform_int_distribution<int> percentDistribution(0, 99);
+
+    auto randomReference = [&rng]()
+    {
+        uint8_t key[KEY_LENGTH];
+        NostrSecureRng::fill(key, sizeof(key));
+
+        NostrBech32Entity entity(rng() % 2 == 0 ? NOSTR_BECH32_NPUB : NOSTR_BECH32_NEVENT);
+        entity.setSpecial(key, sizeof(key));
+        if (entity.type() == NOSTR_BECH32_NEVENT)
+        {
+            entity.addRelay("wss://relay.damus.io");
+        }
+
+        char encoded[NostrBech32Entity::maxEncodedLength];
+        size_t length = NostrBech32::encodeEntity(entity, encoded, sizeof(encoded));
+        return "nostr:" + string(encoded, length);
+    };
+
+    vector<string> notes;
+    for (size_t i = 0; i < noteCount; i++)
+    {
+        string note;
+        int length = lengthDistribution(rng);
+        bool hasReference = percentDistribution(rng) < referencePercent;
+        for (int w = 0; w < length; w++)
+        {
+            if (hasReference && (w == length / 3 || (w == 2 * length / 3 && rng() % 2 == 0)))
+            {
+                note += randomReference() + " ";
+            }
+            note += words[wordDistribution(rng)] + " ";
+        }
+        notes.push_back(note);
+    }
+
+    return notes;
+};
+
+static size_t corpusBytes(const vector<string>& notes)
+{
+    size_t bytes = 0;
+    for (const auto& note : notes)
+    {
+        bytes += note.size();
+    }
+    return bytes;
+};
+
+/**
+ * @brief Scans a corpus of notes for entity references, collecting them in one reused vector.
+ */
+static void BM_ScanContent(benchmark::State& state)
+{
+    auto notes = noteCorpus(1000, state.range(0));
+    vector<NostrContentReference> references;
+
+    for (auto _ : state)
+    {
+        references.clear();
+        for (const auto& note : notes)
+        {
+            NostrContentScanner::scan(note, references);
+        }
+        benchmark::DoNotOptimize(references.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * corpusBytes(notes));
+    state.counters["references"] = static_cast<double>(references.size());
+};
+
+/**
+ * @brief Scans the same corpus with `std::string::find` and `NostrBech32::parseNostrBech32`,
+ * for comparison.
+ */
+static void BM_ScanContent_Naive(benchmark::State& state)
+{
+    auto notes = noteCorpus(1000, state.range(0));
+    NostrBech32 parser;
+    size_t referenceCount = 0;
+
+    for (auto _ : state)
+    {
+        referenceCount = 0;
+        for (const auto& note : notes)
+        {
+            for (size_t position = note.find("nostr:"); position != string::npos; position = note.find("nostr:", position + 1))
+            {
+                size_t end = position + 6;
+                while (end < note.size() && isalnum(static_cast<unsigned char>(note[end])))
+                {
+                    end++;
+                }
+
+                string encoding = note.substr(position + 6, end - position - 6);
+                NostrBech32Encoding parsed;
+                try
+                {
+                    referenceCount += parser.parseNostrBech32(encoding, parsed) ? 1 : 0;
+                }
+                catch (const exception&)
+                {
+                }
+            }
+        }
+        benchmark::DoNotOptimize(referenceCount);
+    }
+
+    state.SetBytesProcessed(state.iterations() * corpusBytes(notes));
+    state.counters["references"] = static_cast<double>(referenceCount);
+};
+
+BENCHMARK(BM_ScanContent)->Arg(0)->Arg(20)->Arg(100);
+BENCHMARK(BM_ScanContent_Naive)->Arg(0)->Arg(20)->Arg(100);
+} // namespace nostr_bench
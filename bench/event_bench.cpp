@@ -0,0 +1,118 @@
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "data/data.hpp"
+#include "internal/hex_encoding.hpp"
+
+using namespace nostr::data;
+using namespace std;
+
+namespace nostr_bench
+{
+/**
+ * @brief Builds a text note with a few `e` and `p` tags and content of the given length.
+ */
+static Event textNote(size_t contentSize)
+{
+    Event event;
+    event.pubkey = "3bf0c63fcb93463407af97a5e5ee64fa883d107ef9e558472c4eb9aaaefa459d";
+    event.createdAt = 1700000000;
+    event.kind = 1;
+    event.tags = {
+        { "e", "5c83da77af1dec6d7289834998ad7aafbd9e2191396d75ec3cc27f5a77226f36", "wss://relay.example.com", "root" },
+        { "p", "0689df5847a8d3376892da29622d7c0fdc1ef1958f4bc4471d90966aa1eca9f2" },
+        { "t", "nostr" },
+    };
+    event.content = string(contentSize, 'x');
+    event.sig = string(128, 'f');
+    return event;
+};
+
+/**
+ * @brief Serializes an event to JSON, which validates it and regenerates its ID first.
+ */
+static void BM_EventSerialize(benchmark::State& state)
+{
+    Event event = textNote(state.range(0));
+
+    for (auto _ : state)
+    {
+        string serialized = event.serialize();
+        benchmark::DoNotOptimize(serialized);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+};
+
+/**
+ * @brief Computes the digest an event ID is derived from, the part of `serialize` done by
+ * `generateId`.
+ */
+static void BM_EventComputeDigest(benchmark::State& state)
+{
+    Event event = textNote(state.range(0));
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+
+    for (auto _ : state)
+    {
+        event.computeDigest(digest);
+        benchmark::DoNotOptimize(digest);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+};
+
+/**
+ * @brief Parses an event from its JSON serialization.
+ */
+static void BM_EventFromString(benchmark::State& state)
+{
+    Event event = textNote(state.range(0));
+    string serialized = event.serialize();
+
+    for (auto _ : state)
+    {
+        Event parsed = Event::fromString(serialized);
+        benchmark::DoNotOptimize(parsed);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * serialized.size());
+};
+
+/**
+ * @brief Serializes a REQ message for filters following the given number of authors.
+ */
+static void BM_FiltersSerialize(benchmark::State& state)
+{
+    Filters filters;
+    for (int64_t i = 0; i < state.range(0); i++)
+    {
+        uint8_t pubkey[32] = { 0 };
+        pubkey[0] = static_cast<uint8_t>(i);
+        pubkey[1] = static_cast<uint8_t>(i >> 8);
+        filters.authors.push_back(nostr::internal::encodeHex(pubkey, sizeof(pubkey)));
+    }
+    filters.kinds = { 0, 1, 6, 7 };
+    filters.tags["t"] = { "nostr", "bitcoin" };
+    filters.since = 1700000000;
+    filters.until = 1700003600;
+    filters.limit = 64;
+    string subscriptionId = "bench";
+
+    for (auto _ : state)
+    {
+        string request = filters.serialize(subscriptionId);
+        benchmark::DoNotOptimize(request);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+};
+
+BENCHMARK(BM_EventSerialize)->Arg(64)->Arg(1024);
+BENCHMARK(BM_EventComputeDigest)->Arg(64)->Arg(1024);
+BENCHMARK(BM_EventFromString)->Arg(64)->Arg(1024);
+BENCHMARK(BM_FiltersSerialize)->Arg(1)->Arg(100);
+} // namespace nostr_bench
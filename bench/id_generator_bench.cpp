@@ -0,0 +1,33 @@
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "internal/id_generator.hpp"
+
+using namespace nostr::internal;
+using namespace std;
+
+namespace nostr_bench
+{
+/**
+ * @brief Generates subscription and signer request IDs, the per-REQ cost of opening a
+ * subscription.
+ */
+static void BM_GenerateId(benchmark::State& state)
+{
+    size_t totalLength = 0;
+    for (auto _ : state)
+    {
+        string id = IdGenerator::next();
+        totalLength += id.size();
+        benchmark::DoNotOptimize(id);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["length"] = benchmark::Counter(
+        static_cast<double>(totalLength),
+        benchmark::Counter::kAvgIterations);
+};
+
+BENCHMARK(BM_GenerateId)->ThreadRange(1, 4);
+} // namespace nostr_bench
@@ -0,0 +1,176 @@
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+#include <plog/Formatters/TxtFormatter.h>
+
+#include "internal/logging.hpp"
+#include "logging/async_appender.hpp"
+#include "service/nostr_service_base.hpp"
+#include "service_fixtures.hpp"
+
+using namespace nostr::client;
+using namespace nostr::data;
+using namespace nostr::logging;
+using namespace nostr::service;
+using namespace std;
+
+namespace nostr_bench
+{
+static const char* severityNames[] = { "none", "fatal", "error", "warning", "info", "debug", "verbose" };
+
+/**
+ * @brief Forwards records to the appender a benchmark selects.  plog keeps every appender it is
+ * given for the life of the process, so runs switch sinks through this one instead.
+ */
+class SelectableAppender : public plog::IAppender
+{
+public:
+    void select(plog::IAppender* target)
+    {
+        this->_target.store(target, memory_order_release);
+    };
+
+    void write(const plog::Record& record) override
+    {
+        plog::IAppender* target = this->_target.load(memory_order_acquire);
+        if (target != nullptr)
+        {
+            target->write(record);
+        }
+    };
+
+    static shared_ptr<SelectableAppender> shared()
+    {
+        static auto appender = make_shared<SelectableAppender>();
+        return appender;
+    };
+
+private:
+    atomic<plog::IAppender*> _target{ nullptr };
+};
+
+static void writeToDevNull(const plog::util::nstring& line)
+{
+    static FILE* devNull = fopen("/dev/null", "w");
+    fwrite(line.data(), sizeof(line[0]), line.size(), devNull);
+    fflush(devNull);
+};
+
+/**
+ * @brief Formats and writes each record on the logging thread, like plog's console and file
+ * appenders.
+ */
+class SyncDevNullAppender : public plog::IAppender
+{
+public:
+    void write(const plog::Record& record) override
+    {
+        plog::util::nstring line = plog::TxtFormatter::format(record);
+        lock_guard<mutex> lock(this->_mutex);
+        writeToDevNull(line);
+    };
+
+private:
+    mutex _mutex;
+};
+
+/**
+ * @brief A fake relay client that keeps the message handler of the last subscription, so a
+ * benchmark can feed frames to it as the WebSocket client's I/O thread would.
+ */
+class CapturingRelayClient : public FakeRelayClient
+{
+public:
+    CapturingRelayClient() : FakeRelayClient({}) { };
+
+    bool send(SharedPayload message, string_view uri, MessageHandler messageHandler) override
+    {
+        {
+            lock_guard<mutex> lock(this->_handlerMutex);
+            this->_messageHandler = messageHandler;
+        }
+        return FakeRelayClient::send(message, uri, messageHandler);
+    };
+
+    MessageHandler messageHandler()
+    {
+        lock_guard<mutex> lock(this->_handlerMutex);
+        return this->_messageHandler;
+    };
+
+private:
+    mutex _handlerMutex;
+    MessageHandler _messageHandler;
+};
+
+/**
+ * @brief Feeds EVENT frames to an open subscription's message handler, with the logger's runtime
+ * level set to each severity, writing either synchronously or through an `AsyncAppender`.
+ * @remark Levels more verbose than the build's `AEDILE_LOG_LEVEL` are compiled out of the
+ * library, so they cost nothing regardless of the runtime level.  Rebuild with a different
+ * `AEDILE_LOG_LEVEL` to compare against the compiled-out case.
+ */
+static void BM_ReceiveLoop_LogLevel(benchmark::State& state)
+{
+    const size_t eventCount = 100;
+    const auto severity = static_cast<plog::Severity>(state.range(0));
+    const bool isAsync = state.range(1) != 0;
+
+    SyncDevNullAppender syncAppender;
+    AsyncAppender<plog::TxtFormatter> asyncAppender(8192, writeToDevNull);
+
+    auto client = make_shared<CapturingRelayClient>();
+    NostrServiceBase service(SelectableAppender::shared(), client, { "wss://relay.example.com" });
+    service.openRelayConnections();
+
+    auto filters = make_shared<Filters>();
+    filters->kinds = { 1 };
+    filters->limit = eventCount;
+    string subscriptionId = service.queryRelays(
+        filters,
+        [](const string&, shared_ptr<Event> event) { benchmark::DoNotOptimize(event); },
+        [](const string&) {},
+        [](const string&, const string&) {});
+    auto messageHandler = client->messageHandler();
+
+    vector<string> frames;
+    for (const auto& event : signedTextNotes(eventCount))
+    {
+        frames.push_back(nlohmann::json::array({ "EVENT", subscriptionId, nlohmann::json::parse(event) }).dump());
+    }
+
+    SelectableAppender::shared()->select(isAsync
+        ? static_cast<plog::IAppender*>(&asyncAppender)
+        : static_cast<plog::IAppender*>(&syncAppender));
+    plog::get()->setMaxSeverity(severity);
+
+    for (auto _ : state)
+    {
+        for (const auto& frame : frames)
+        {
+            messageHandler(frame);
+        }
+    }
+
+    plog::get()->setMaxSeverity(nostr::internal::maxLogSeverity);
+    SelectableAppender::shared()->select(nullptr);
+    asyncAppender.flush();
+    service.closeSubscription(subscriptionId);
+
+    state.SetItemsProcessed(state.iterations() * eventCount);
+    state.counters["dropped"] = static_cast<double>(asyncAppender.droppedCount());
+    state.SetLabel(
+        string(severityNames[severity]) + (isAsync ? "/async" : "/sync")
+        + " (compiled: " + severityNames[nostr::internal::maxLogSeverity] + ")");
+};
+
+BENCHMARK(BM_ReceiveLoop_LogLevel)
+    ->ArgsProduct({ { plog::none, plog::error, plog::info, plog::debug, plog::verbose }, { 0, 1 } });
+} // namespace nostr_bench
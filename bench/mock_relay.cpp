@@ -0,0 +1,368 @@
+#include <algorithm>
+#include <utility>
+
+#include "mock_relay.hpp"
+
+using namespace nlohmann;
+using namespace std;
+
+namespace nostr_bench
+{
+MockRelay::MockRelay(MockRelayOptions options)
+    : _options(move(options)), _random(random_device()())
+{
+    this->_server.clear_access_channels(websocketpp::log::alevel::all);
+    this->_server.clear_error_channels(websocketpp::log::elevel::all);
+
+    this->_server.init_asio();
+    this->_server.set_reuse_addr(true);
+
+    this->_server.set_open_handler([this](websocketpp::connection_hdl handle)
+    {
+        lock_guard<mutex> lock(this->_mutex);
+        this->_subscriptions[handle];
+    });
+    this->_server.set_close_handler([this](websocketpp::connection_hdl handle)
+    {
+        lock_guard<mutex> lock(this->_mutex);
+        this->_subscriptions.erase(handle);
+    });
+    this->_server.set_fail_handler([this](websocketpp::connection_hdl handle)
+    {
+        lock_guard<mutex> lock(this->_mutex);
+        this->_subscriptions.erase(handle);
+    });
+    this->_server.set_message_handler(
+        [this](websocketpp::connection_hdl handle, websocketpp_server::message_ptr message)
+        {
+            this->_onMessage(handle, message);
+        });
+};
+
+MockRelay::~MockRelay()
+{
+    this->stop();
+};
+
+uint16_t MockRelay::start(uint16_t port)
+{
+    websocketpp::lib::asio::ip::tcp::endpoint endpoint(
+        websocketpp::lib::asio::ip::address_v4::loopback(),
+        port);
+    this->_server.listen(endpoint);
+
+    websocketpp::lib::asio::error_code error;
+    this->_port = this->_server.get_local_endpoint(error).port();
+
+    this->_server.start_accept();
+    this->_ioThread = thread([this]() { this->_server.run(); });
+
+    return this->_port;
+};
+
+void MockRelay::stop()
+{
+    if (!this->_ioThread.joinable())
+    {
+        return;
+    }
+
+    // A zero-length timer runs the shutdown on the I/O thread.  The loop then exits by itself
+    // once the listener and every connection are closed.
+    this->_server.set_timer(0, [this](const websocketpp::lib::error_code&)
+    {
+        websocketpp::lib::error_code error;
+        this->_server.stop_listening(error);
+
+        vector<websocketpp::connection_hdl> handles;
+        {
+            lock_guard<mutex> lock(this->_mutex);
+            for (const auto& [handle, subscriptions] : this->_subscriptions)
+            {
+                handles.push_back(handle);
+            }
+        }
+
+        for (const auto& handle : handles)
+        {
+            this->_server.close(handle, websocketpp::close::status::going_away, "", error);
+        }
+    });
+
+    this->_ioThread.join();
+};
+
+string MockRelay::uri() const
+{
+    return "ws://127.0.0.1:" + to_string(this->_port);
+};
+
+void MockRelay::setOptions(MockRelayOptions options)
+{
+    lock_guard<mutex> lock(this->_mutex);
+    this->_options = move(options);
+};
+
+size_t MockRelay::eventCount()
+{
+    lock_guard<mutex> lock(this->_mutex);
+    return this->_events.size();
+};
+
+size_t MockRelay::connectionCount()
+{
+    lock_guard<mutex> lock(this->_mutex);
+    return this->_subscriptions.size();
+};
+
+void MockRelay::clear()
+{
+    lock_guard<mutex> lock(this->_mutex);
+    this->_events.clear();
+    this->_eventIds.clear();
+};
+
+void MockRelay::_onMessage(websocketpp::connection_hdl handle, websocketpp_server::message_ptr message)
+{
+    {
+        lock_guard<mutex> lock(this->_mutex);
+        if (this->_roll(this->_options.dropRate))
+        {
+            return;
+        }
+    }
+
+    try
+    {
+        json jMessage = json::parse(message->get_payload());
+        string messageType = jMessage.at(0);
+
+        if (messageType == "EVENT")
+        {
+            this->_onEvent(handle, jMessage);
+        }
+        else if (messageType == "REQ")
+        {
+            this->_onReq(handle, jMessage);
+        }
+        else if (messageType == "CLOSE")
+        {
+            this->_onClose(handle, jMessage);
+        }
+        else
+        {
+            this->_send(handle, json::array({ "NOTICE", "unsupported message type" }).dump());
+        }
+    }
+    catch (const json::exception& je)
+    {
+        this->_send(handle, json::array({ "NOTICE", string("invalid: ") + je.what() }).dump());
+    }
+};
+
+void MockRelay::_onEvent(websocketpp::connection_hdl handle, const json& jMessage)
+{
+    // Accept events sent either as objects, per NIP-01, or as serialized strings.
+    const json& jPayload = jMessage.at(1);
+    json event = jPayload.is_string() ? json::parse(jPayload.get<string>()) : jPayload;
+    string eventId = event.at("id");
+
+    vector<pair<websocketpp::connection_hdl, string>> outgoing;
+    json jOk;
+    {
+        lock_guard<mutex> lock(this->_mutex);
+        if (!this->_options.acceptEvents)
+        {
+            jOk = json::array({ "OK", eventId, false, "blocked: mock relay rejects events" });
+        }
+        else if (!this->_eventIds.insert(eventId).second)
+        {
+            jOk = json::array({ "OK", eventId, true, "duplicate: already have this event" });
+        }
+        else
+        {
+            this->_events.push_back(event);
+            jOk = json::array({ "OK", eventId, true, "" });
+
+            for (const auto& [subscriber, subscriptions] : this->_subscriptions)
+            {
+                for (const auto& [subscriptionId, filters] : subscriptions)
+                {
+                    bool isMatch = any_of(filters.begin(), filters.end(), [&event](const json& filter)
+                    {
+                        return MockRelay::_matches(filter, event);
+                    });
+                    if (isMatch)
+                    {
+                        outgoing.emplace_back(
+                            subscriber,
+                            json::array({ "EVENT", subscriptionId, event }).dump());
+                    }
+                }
+            }
+        }
+    }
+
+    this->_send(handle, jOk.dump());
+    for (auto& [subscriber, message] : outgoing)
+    {
+        this->_send(subscriber, move(message));
+    }
+};
+
+void MockRelay::_onReq(websocketpp::connection_hdl handle, const json& jMessage)
+{
+    string subscriptionId = jMessage.at(1);
+    json filters = json::array();
+    for (size_t i = 2; i < jMessage.size(); i++)
+    {
+        filters.push_back(jMessage[i]);
+    }
+
+    vector<string> outgoing;
+    {
+        lock_guard<mutex> lock(this->_mutex);
+        if (this->_roll(this->_options.closedRate))
+        {
+            outgoing.push_back(
+                json::array({ "CLOSED", subscriptionId, this->_options.closedReason }).dump());
+        }
+        else
+        {
+            // Each filter's limit applies separately, counting back from the newest stored event.
+            unordered_set<string> sentIds;
+            for (const auto& filter : filters)
+            {
+                size_t limit = filter.value("limit", this->_events.size());
+                size_t count = 0;
+                for (auto it = this->_events.rbegin(); it != this->_events.rend() && count < limit; ++it)
+                {
+                    if (!MockRelay::_matches(filter, *it))
+                    {
+                        continue;
+                    }
+
+                    count++;
+                    if (sentIds.insert(it->at("id").get<string>()).second)
+                    {
+                        outgoing.push_back(json::array({ "EVENT", subscriptionId, *it }).dump());
+                    }
+                }
+            }
+            outgoing.push_back(json::array({ "EOSE", subscriptionId }).dump());
+
+            // A REQ with an existing ID replaces that subscription.
+            this->_subscriptions[handle][subscriptionId] = move(filters);
+        }
+    }
+
+    for (auto& message : outgoing)
+    {
+        this->_send(handle, move(message));
+    }
+};
+
+void MockRelay::_onClose(websocketpp::connection_hdl handle, const json& jMessage)
+{
+    string subscriptionId = jMessage.at(1);
+
+    lock_guard<mutex> lock(this->_mutex);
+    auto it = this->_subscriptions.find(handle);
+    if (it != this->_subscriptions.end())
+    {
+        it->second.erase(subscriptionId);
+    }
+};
+
+void MockRelay::_send(websocketpp::connection_hdl handle, string message)
+{
+    chrono::milliseconds latency;
+    {
+        lock_guard<mutex> lock(this->_mutex);
+        latency = this->_options.latency;
+    }
+
+    if (latency.count() <= 0)
+    {
+        websocketpp::lib::error_code error;
+        this->_server.send(handle, message, websocketpp::frame::opcode::text, error);
+        return;
+    }
+
+    // Timers with equal delays fire in the order they were set, so responses keep their order.
+    this->_server.set_timer(
+        static_cast<long>(latency.count()),
+        [this, handle, message = move(message)](const websocketpp::lib::error_code& timerError)
+        {
+            if (timerError)
+            {
+                return;
+            }
+
+            websocketpp::lib::error_code error;
+            this->_server.send(handle, message, websocketpp::frame::opcode::text, error);
+        });
+};
+
+bool MockRelay::_roll(double probability)
+{
+    if (probability <= 0.0)
+    {
+        return false;
+    }
+
+    return uniform_real_distribution<double>(0.0, 1.0)(this->_random) < probability;
+};
+
+bool MockRelay::_matches(const json& filter, const json& event)
+{
+    auto contains = [](const json& values, const json& value)
+    {
+        return find(values.begin(), values.end(), value) != values.end();
+    };
+
+    for (const auto& [key, value] : filter.items())
+    {
+        if (key == "ids" && !contains(value, event.at("id")))
+        {
+            return false;
+        }
+        else if (key == "authors" && !contains(value, event.at("pubkey")))
+        {
+            return false;
+        }
+        else if (key == "kinds" && !contains(value, event.at("kind")))
+        {
+            return false;
+        }
+        else if (key == "since" && event.at("created_at").get<int64_t>() < value.get<int64_t>())
+        {
+            return false;
+        }
+        else if (key == "until" && event.at("created_at").get<int64_t>() > value.get<int64_t>())
+        {
+            return false;
+        }
+        else if (key.size() == 2 && key[0] == '#')
+        {
+            const string tagName = key.substr(1);
+            bool hasTag = false;
+            for (const auto& tag : event.value("tags", json::array()))
+            {
+                if (tag.size() >= 2 && tag[0] == tagName && contains(value, tag[1]))
+                {
+                    hasTag = true;
+                    break;
+                }
+            }
+
+            if (!hasTag)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+};
+} // namespace nostr_bench
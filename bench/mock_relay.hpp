@@ -0,0 +1,135 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include <websocketpp/config/asio_no_tls.hpp>
+#include <websocketpp/server.hpp>
+
+namespace nostr_bench
+{
+/**
+ * @brief Fault injection settings for a `MockRelay`.
+ */
+struct MockRelayOptions
+{
+    ///< The delay applied to every response the relay sends.
+    std::chrono::milliseconds latency{ 0 };
+
+    ///< The probability, from 0 to 1, that an incoming message is silently ignored.
+    double dropRate = 0.0;
+
+    ///< The probability, from 0 to 1, that a REQ is answered with CLOSED instead of results.
+    double closedRate = 0.0;
+
+    ///< The message sent with injected CLOSED responses.
+    std::string closedReason = "error: closed by mock relay";
+
+    ///< If false, every EVENT is rejected with an OK false response.
+    bool acceptEvents = true;
+};
+
+/**
+ * @brief An in-process stand-in for a NIP-01 relay, for exercising the real WebSocket client
+ * end to end on localhost.
+ * @remark The relay accepts EVENT, REQ, and CLOSE messages and keeps events in memory.  Stored
+ * events are served to matching REQs, followed by EOSE, and events published later are pushed to
+ * matching open subscriptions.  Signatures are not verified.
+ *
+ * All protocol handling runs on the relay's own I/O thread.
+ */
+class MockRelay
+{
+public:
+    MockRelay(MockRelayOptions options = MockRelayOptions());
+
+    MockRelay(const MockRelay&) = delete;
+
+    MockRelay& operator=(const MockRelay&) = delete;
+
+    ~MockRelay();
+
+    /**
+     * @brief Starts listening on the loopback interface.
+     * @param port The port to listen on, or 0 to let the system choose one.
+     * @returns The port the relay is listening on.
+     */
+    uint16_t start(uint16_t port = 0);
+
+    /**
+     * @brief Closes every connection and stops the relay's I/O thread.
+     */
+    void stop();
+
+    /**
+     * @brief Returns the WebSocket URI clients should connect to.
+     */
+    std::string uri() const;
+
+    void setOptions(MockRelayOptions options);
+
+    /**
+     * @brief Returns the number of events the relay has stored.
+     */
+    size_t eventCount();
+
+    /**
+     * @brief Returns the number of currently open client connections.
+     */
+    size_t connectionCount();
+
+    /**
+     * @brief Discards all stored events.
+     */
+    void clear();
+
+private:
+    typedef websocketpp::server<websocketpp::config::asio> websocketpp_server;
+    typedef std::map<websocketpp::connection_hdl, std::map<std::string, nlohmann::json>,
+        std::owner_less<websocketpp::connection_hdl>> subscription_map;
+
+    websocketpp_server _server;
+    std::thread _ioThread;
+    uint16_t _port = 0;
+
+    std::mutex _mutex;
+    MockRelayOptions _options;
+    std::mt19937_64 _random;
+
+    std::vector<nlohmann::json> _events;
+    std::unordered_set<std::string> _eventIds;
+
+    ///< The open subscriptions on each connection, by subscription ID.
+    subscription_map _subscriptions;
+
+    void _onMessage(websocketpp::connection_hdl handle, websocketpp_server::message_ptr message);
+
+    void _onEvent(websocketpp::connection_hdl handle, const nlohmann::json& jMessage);
+
+    void _onReq(websocketpp::connection_hdl handle, const nlohmann::json& jMessage);
+
+    void _onClose(websocketpp::connection_hdl handle, const nlohmann::json& jMessage);
+
+    /**
+     * @brief Sends a message to a client after the configured latency.
+     */
+    void _send(websocketpp::connection_hdl handle, std::string message);
+
+    /**
+     * @brief Returns true with the given probability.
+     * @remark The caller must hold `_mutex`.
+     */
+    bool _roll(double probability);
+
+    static bool _matches(const nlohmann::json& filter, const nlohmann::json& event);
+};
+} // namespace nostr_bench
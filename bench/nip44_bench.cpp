@@ -0,0 +1,258 @@
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <noscrypt.h>
+#include <noscryptutil.h>
+
+#include "cryptography/conversation_key_cache.hpp"
+#include "cryptography/nip44_batch_cipher.hpp"
+#include "cryptography/noscrypt_context_pool.hpp"
+#include "cryptography/noscrypt_cipher.hpp"
+#include "cryptography/nostr_secure_rng.hpp"
+#include "internal/hex_encoding.hpp"
+
+using namespace nostr::cryptography;
+using namespace nostr::internal;
+using namespace std;
+
+namespace nostr_bench
+{
+/**
+ * @brief Holds a noscrypt context and a pair of keypairs for encrypting messages between two
+ * peers.
+ */
+struct Nip44Fixture
+{
+    shared_ptr<NCContext> context;
+    shared_ptr<NCSecretKey> localKey;
+    shared_ptr<NCPublicKey> remotePubkey;
+    string message;
+
+    explicit Nip44Fixture(size_t messageSize)
+        : message(messageSize, 'x')
+    {
+        context = NoscryptContextPool::create();
+
+        localKey = make_shared<NCSecretKey>();
+        NostrSecureRng::fill(localKey->key, sizeof(localKey->key));
+
+        NCSecretKey remoteKey;
+        NostrSecureRng::fill(remoteKey.key, sizeof(remoteKey.key));
+        remotePubkey = make_shared<NCPublicKey>();
+        NCGetPublicKey(context.get(), &remoteKey, remotePubkey.get());
+    };
+};
+
+/**
+ * @brief Encrypts each message with the noscrypt utility cipher, which derives the conversation
+ * key on every call.
+ */
+static void BM_Nip44Encrypt_DerivedKey(benchmark::State& state)
+{
+    Nip44Fixture fixture(state.range(0));
+
+    for (auto _ : state)
+    {
+        NoscryptCipher cipher(NoscryptCipherVersion::NIP44, NoscryptCipherMode::CIPHER_MODE_ENCRYPT);
+        auto payload = cipher.update(
+            fixture.context,
+            fixture.localKey,
+            fixture.remotePubkey,
+            fixture.message);
+        benchmark::DoNotOptimize(payload);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * fixture.message.size());
+};
+
+/**
+ * @brief Encrypts each message with a conversation key looked up in a `ConversationKeyCache`.
+ */
+static void BM_Nip44Encrypt_CachedKey(benchmark::State& state)
+{
+    Nip44Fixture fixture(state.range(0));
+    ConversationKeyCache cache;
+
+    for (auto _ : state)
+    {
+        uint8_t conversationKey[NC_CONV_KEY_SIZE];
+        cache.get(fixture.context.get(), *fixture.localKey, *fixture.remotePubkey, conversationKey);
+
+        auto payload = NoscryptCipher::encryptNip44(fixture.context.get(), conversationKey, fixture.message);
+        NostrSecureRng::zero(conversationKey, sizeof(conversationKey));
+        benchmark::DoNotOptimize(payload);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * fixture.message.size());
+};
+
+/**
+ * @brief Decrypts each message with a conversation key looked up in a `ConversationKeyCache`.
+ */
+static void BM_Nip44Decrypt_CachedKey(benchmark::State& state)
+{
+    Nip44Fixture fixture(state.range(0));
+    ConversationKeyCache cache;
+
+    uint8_t conversationKey[NC_CONV_KEY_SIZE];
+    cache.get(fixture.context.get(), *fixture.localKey, *fixture.remotePubkey, conversationKey);
+    string payload = NoscryptCipher::encryptNip44(fixture.context.get(), conversationKey, fixture.message);
+
+    for (auto _ : state)
+    {
+        cache.get(fixture.context.get(), *fixture.localKey, *fixture.remotePubkey, conversationKey);
+
+        auto message = NoscryptCipher::decryptNip44(fixture.context.get(), conversationKey, payload);
+        benchmark::DoNotOptimize(message);
+    }
+    NostrSecureRng::zero(conversationKey, sizeof(conversationKey));
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * fixture.message.size());
+};
+
+/**
+ * @brief Encrypts each message with a cached conversation key into a reused payload buffer.
+ */
+static void BM_Nip44Encrypt_CachedKey_ReusedBuffer(benchmark::State& state)
+{
+    Nip44Fixture fixture(state.range(0));
+    ConversationKeyCache cache;
+    vector<uint8_t> payload;
+
+    for (auto _ : state)
+    {
+        uint8_t conversationKey[NC_CONV_KEY_SIZE];
+        cache.get(fixture.context.get(), *fixture.localKey, *fixture.remotePubkey, conversationKey);
+
+        NoscryptCipher::encryptNip44(
+            fixture.context.get(),
+            conversationKey,
+            reinterpret_cast<const uint8_t*>(fixture.message.data()),
+            fixture.message.size(),
+            payload);
+        NostrSecureRng::zero(conversationKey, sizeof(conversationKey));
+        benchmark::DoNotOptimize(payload.data());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * fixture.message.size());
+};
+
+/**
+ * @brief Decrypts each message with a cached conversation key into a reused output buffer.
+ */
+static void BM_Nip44Decrypt_CachedKey_ReusedBuffer(benchmark::State& state)
+{
+    Nip44Fixture fixture(state.range(0));
+    ConversationKeyCache cache;
+
+    uint8_t conversationKey[NC_CONV_KEY_SIZE];
+    cache.get(fixture.context.get(), *fixture.localKey, *fixture.remotePubkey, conversationKey);
+    string payload = NoscryptCipher::encryptNip44(fixture.context.get(), conversationKey, fixture.message);
+    vector<uint8_t> message;
+
+    for (auto _ : state)
+    {
+        cache.get(fixture.context.get(), *fixture.localKey, *fixture.remotePubkey, conversationKey);
+
+        NoscryptCipher::decryptNip44(
+            fixture.context.get(),
+            conversationKey,
+            reinterpret_cast<const uint8_t*>(payload.data()),
+            payload.size(),
+            message);
+        benchmark::DoNotOptimize(message.data());
+    }
+    NostrSecureRng::zero(conversationKey, sizeof(conversationKey));
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * fixture.message.size());
+};
+
+/**
+ * @brief Encrypts each message with a utility cipher leased from a pool, writing into a reused
+ * output buffer.
+ */
+static void BM_Nip44Encrypt_PooledCipher(benchmark::State& state)
+{
+    Nip44Fixture fixture(state.range(0));
+    NoscryptCipherPool pool(NoscryptCipherVersion::NIP44);
+    vector<uint8_t> payload;
+
+    for (auto _ : state)
+    {
+        auto cipher = pool.acquire(NoscryptCipherMode::CIPHER_MODE_ENCRYPT);
+        cipher->update(
+            fixture.context.get(),
+            fixture.localKey.get(),
+            fixture.remotePubkey.get(),
+            reinterpret_cast<const uint8_t*>(fixture.message.data()),
+            fixture.message.size(),
+            payload);
+        benchmark::DoNotOptimize(payload.data());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * fixture.message.size());
+};
+
+/**
+ * @brief Decrypts an inbox of 1024 payloads from 16 peers with a `Nip44BatchCipher`, using the
+ * given number of workers.
+ */
+static void BM_Nip44Decrypt_Batch(benchmark::State& state)
+{
+    const size_t peerCount = 16;
+    const size_t inboxSize = 1024;
+
+    NCSecretKey localKey;
+    NostrSecureRng::fill(localKey.key, sizeof(localKey.key));
+    Nip44BatchCipher localCipher(localKey, state.range(0));
+
+    vector<Nip44BatchItem> inbox;
+    for (size_t peer = 0; peer < peerCount; peer++)
+    {
+        Nip44Fixture fixture(256);
+        NCPublicKey localPubkey;
+        NCGetPublicKey(fixture.context.get(), &localKey, &localPubkey);
+
+        Nip44BatchCipher peerCipher(*fixture.localKey, 1);
+        string localPubkeyHex = encodeHex(localPubkey.key, sizeof(localPubkey.key));
+        string peerPubkeyHex;
+        {
+            NCPublicKey peerPubkey;
+            NCGetPublicKey(fixture.context.get(), fixture.localKey.get(), &peerPubkey);
+            peerPubkeyHex = encodeHex(peerPubkey.key, sizeof(peerPubkey.key));
+        }
+
+        vector<Nip44BatchItem> messages(inboxSize / peerCount, { localPubkeyHex, fixture.message });
+        for (auto& result : peerCipher.encrypt(messages))
+        {
+            inbox.push_back({ peerPubkeyHex, result.output });
+        }
+    }
+
+    for (auto _ : state)
+    {
+        auto messages = localCipher.decrypt(inbox);
+        benchmark::DoNotOptimize(messages.data());
+    }
+    NostrSecureRng::zero(localKey.key, sizeof(localKey.key));
+
+    state.SetItemsProcessed(state.iterations() * inbox.size());
+};
+
+BENCHMARK(BM_Nip44Encrypt_DerivedKey)->Arg(64)->Arg(512)->Arg(4096);
+BENCHMARK(BM_Nip44Encrypt_PooledCipher)->Arg(64)->Arg(512)->Arg(4096);
+BENCHMARK(BM_Nip44Encrypt_CachedKey)->Arg(64)->Arg(512)->Arg(4096);
+BENCHMARK(BM_Nip44Encrypt_CachedKey_ReusedBuffer)->Arg(64)->Arg(512)->Arg(4096);
+BENCHMARK(BM_Nip44Decrypt_CachedKey)->Arg(64)->Arg(512)->Arg(4096);
+BENCHMARK(BM_Nip44Decrypt_CachedKey_ReusedBuffer)->Arg(64)->Arg(512)->Arg(4096);
+BENCHMARK(BM_Nip44Decrypt_Batch)->Arg(1)->Arg(4)->UseRealTime();
+} // namespace nostr_bench
@@ -0,0 +1,516 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "client/websocketpp_client.hpp"
+#include "internal/hex_encoding.hpp"
+#include "mock_relay.hpp"
+#include "service/nostr_service_base.hpp"
+#include "service_fixtures.hpp"
+
+using namespace nlohmann;
+using namespace nostr::client;
+using namespace nostr::data;
+using namespace nostr::service;
+using namespace std;
+
+namespace nostr_bench
+{
+typedef chrono::steady_clock Clock;
+
+struct LoadOptions
+{
+    size_t events = 10000;
+    size_t queries = 1000;
+    size_t queryLimit = 50;
+    size_t inFlight = 64;
+    chrono::milliseconds timeout{ 5000 };
+    bool throughService = false;
+    MockRelayOptions relay;
+};
+
+struct LoadResult
+{
+    size_t completed = 0;
+    size_t lost = 0;
+    size_t rejected = 0;
+    size_t received = 0;
+    double seconds = 0.0;
+    vector<double> latenciesUs;
+};
+
+/**
+ * @brief Tracks requests awaiting a response, and bounds how many may be outstanding at once.
+ */
+class PendingRequests
+{
+public:
+    /**
+     * @brief Starts a request once fewer than the given number are outstanding.
+     * @returns The number of requests abandoned while waiting, because they waited longer than
+     * the timeout.
+     * @remark When the window is full, the wait ends no later than the oldest request's expiry,
+     * so requests whose responses were dropped cannot hold the window closed.
+     */
+    size_t begin(const string& key, size_t maxInFlight, chrono::milliseconds timeout)
+    {
+        unique_lock<mutex> lock(this->_mutex);
+        size_t expired = 0;
+        while (this->_started.size() >= maxInFlight)
+        {
+            auto oldest = min_element(
+                this->_started.begin(),
+                this->_started.end(),
+                [](const auto& a, const auto& b) { return a.second < b.second; });
+            if (this->_changed.wait_until(lock, oldest->second + timeout) == cv_status::timeout)
+            {
+                expired += this->_expire(timeout);
+            }
+        }
+
+        this->_started[key] = Clock::now();
+        return expired;
+    };
+
+    /**
+     * @brief Records the response to a request.
+     * @returns False if the request was unknown or had already finished.
+     */
+    bool finish(const string& key, LoadResult& result, bool isRejected = false)
+    {
+        lock_guard<mutex> lock(this->_mutex);
+        auto it = this->_started.find(key);
+        if (it == this->_started.end())
+        {
+            return false;
+        }
+
+        auto elapsed = chrono::duration<double, micro>(Clock::now() - it->second);
+        result.latenciesUs.push_back(elapsed.count());
+        result.completed++;
+        result.rejected += isRejected ? 1 : 0;
+
+        this->_started.erase(it);
+        this->_changed.notify_all();
+        return true;
+    };
+
+    /**
+     * @brief Waits until every request has finished or the timeout has passed.
+     * @returns The number of requests that never finished, which are then abandoned.
+     */
+    size_t drain(chrono::milliseconds timeout)
+    {
+        unique_lock<mutex> lock(this->_mutex);
+        this->_changed.wait_for(lock, timeout, [&]() { return this->_started.empty(); });
+
+        size_t lost = this->_started.size();
+        this->_started.clear();
+        this->_changed.notify_all();
+        return lost;
+    };
+
+private:
+    mutex _mutex;
+    condition_variable _changed;
+    unordered_map<string, Clock::time_point> _started;
+
+    /**
+     * @brief Abandons the requests that have waited at least the timeout, so dropped messages do
+     * not stall the window.  The caller holds the lock.
+     */
+    size_t _expire(chrono::milliseconds timeout)
+    {
+        size_t expired = 0;
+        auto now = Clock::now();
+        for (auto it = this->_started.begin(); it != this->_started.end();)
+        {
+            if (now - it->second >= timeout)
+            {
+                it = this->_started.erase(it);
+                expired++;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        if (expired > 0)
+        {
+            this->_changed.notify_all();
+        }
+        return expired;
+    };
+};
+
+static string randomHex(mt19937_64& random, size_t byteCount)
+{
+    vector<uint8_t> bytes(byteCount);
+    for (auto& byte : bytes)
+    {
+        byte = static_cast<uint8_t>(random());
+    }
+    return nostr::internal::encodeHex(bytes.data(), bytes.size());
+};
+
+static double percentile(vector<double>& sorted, double fraction)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1));
+    return sorted[index];
+};
+
+static void report(const char* name, LoadResult& result)
+{
+    sort(result.latenciesUs.begin(), result.latenciesUs.end());
+    double throughput = result.seconds > 0.0 ? result.completed / result.seconds : 0.0;
+
+    printf(
+        "%-8s %8zu ok %6zu lost %6zu rejected %10.0f/s   p50 %8.0f us   p90 %8.0f us   "
+        "p99 %8.0f us   max %8.0f us",
+        name,
+        result.completed,
+        result.lost,
+        result.rejected,
+        throughput,
+        percentile(result.latenciesUs, 0.50),
+        percentile(result.latenciesUs, 0.90),
+        percentile(result.latenciesUs, 0.99),
+        result.latenciesUs.empty() ? 0.0 : result.latenciesUs.back());
+    if (result.received > 0)
+    {
+        printf("   %zu events", result.received);
+    }
+    printf("\n");
+};
+
+/**
+ * @brief Runs the publish and query phases against a freshly started mock relay.
+ */
+static int run(const LoadOptions& options)
+{
+    MockRelay relay(options.relay);
+    relay.start();
+
+    auto client = make_shared<WebsocketppClient>();
+    client->start();
+    auto isOpen = client->openConnection(relay.uri(), nullptr, nullptr, nullptr);
+    if (isOpen.wait_for(options.timeout) != future_status::ready || !isOpen.get())
+    {
+        cerr << "Could not connect to the mock relay at " << relay.uri() << "." << endl;
+        client->stop();
+        return 1;
+    }
+
+    PendingRequests publishes;
+    PendingRequests queries;
+    LoadResult publishResult;
+    LoadResult queryResult;
+
+    // All responses arrive on the client's I/O thread, so results are only written there.
+    client->receive(relay.uri(), [&](string_view payload)
+    {
+        json jMessage = json::parse(payload);
+        string messageType = jMessage.at(0);
+
+        if (messageType == "OK")
+        {
+            publishes.finish(jMessage.at(1).get<string>(), publishResult, !jMessage.at(2).get<bool>());
+        }
+        else if (messageType == "EVENT")
+        {
+            queryResult.received++;
+        }
+        else if (messageType == "EOSE")
+        {
+            string subscriptionId = jMessage.at(1);
+            if (queries.finish(subscriptionId, queryResult))
+            {
+                client->send(make_shared<const string>(json::array({ "CLOSE", subscriptionId }).dump()), relay.uri());
+            }
+        }
+        else if (messageType == "CLOSED")
+        {
+            queries.finish(jMessage.at(1).get<string>(), queryResult, true);
+        }
+    });
+
+    mt19937_64 random(random_device{}());
+    string pubkey = randomHex(random, 32);
+
+    auto publishStart = Clock::now();
+    for (size_t i = 0; i < options.events; i++)
+    {
+        json event = {
+            { "id", randomHex(random, 32) },
+            { "pubkey", pubkey },
+            { "created_at", 1700000000 + static_cast<int64_t>(i) },
+            { "kind", 1 },
+            { "tags", json::array({ json::array({ "t", "load" }) }) },
+            { "content", "Load test note " + to_string(i) },
+            { "sig", randomHex(random, 64) }
+        };
+
+        publishResult.lost += publishes.begin(event["id"].get<string>(), options.inFlight, options.timeout);
+        client->send(make_shared<const string>(json::array({ "EVENT", event }).dump()), relay.uri());
+    }
+    publishResult.lost += publishes.drain(options.timeout);
+    publishResult.seconds = chrono::duration<double>(Clock::now() - publishStart).count();
+
+    auto queryStart = Clock::now();
+    for (size_t i = 0; i < options.queries; i++)
+    {
+        string subscriptionId = "load-" + to_string(i);
+        json filter = {
+            { "kinds", json::array({ 1 }) },
+            { "authors", json::array({ pubkey }) },
+            { "limit", options.queryLimit }
+        };
+
+        queryResult.lost += queries.begin(subscriptionId, options.inFlight, options.timeout);
+        client->send(make_shared<const string>(json::array({ "REQ", subscriptionId, filter }).dump()), relay.uri());
+    }
+    queryResult.lost += queries.drain(options.timeout);
+    queryResult.seconds = chrono::duration<double>(Clock::now() - queryStart).count();
+
+    client->closeConnection(relay.uri());
+    client->stop();
+    relay.stop();
+
+    printf(
+        "mock relay %s: latency %lld ms, drop rate %.3f, closed rate %.3f, %zu in flight\n",
+        relay.uri().c_str(),
+        static_cast<long long>(options.relay.latency.count()),
+        options.relay.dropRate,
+        options.relay.closedRate,
+        options.inFlight);
+    report("publish", publishResult);
+    report("query", queryResult);
+
+    return 0;
+};
+
+/**
+ * @brief Runs the given request on the given number of threads until every index has been taken,
+ * recording each request's latency, and returns the time the whole phase took.
+ * @remark The request returns false if the relay rejected or did not answer it.
+ */
+static double runConcurrently(
+    size_t count,
+    size_t threadCount,
+    LoadResult& result,
+    const function<bool(size_t)>& request)
+{
+    atomic<size_t> nextIndex{ 0 };
+    mutex resultMutex;
+
+    auto start = Clock::now();
+    vector<thread> threads;
+    for (size_t t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&]()
+        {
+            for (size_t i = nextIndex++; i < count; i = nextIndex++)
+            {
+                auto requestStart = Clock::now();
+                bool isAnswered = request(i);
+                auto elapsed = chrono::duration<double, micro>(Clock::now() - requestStart);
+
+                lock_guard<mutex> lock(resultMutex);
+                result.latenciesUs.push_back(elapsed.count());
+                result.completed++;
+                result.rejected += isAnswered ? 0 : 1;
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    return chrono::duration<double>(Clock::now() - start).count();
+};
+
+/**
+ * @brief Runs the publish and query phases through `NostrServiceBase` against a freshly started
+ * mock relay, so the service's routing, batching, and parsing are measured along with the client.
+ * @remark Each of `inFlight` threads publishes or queries one request at a time and waits for its
+ * result, as an application calling the service would.  Requests the relay drops are bounded by
+ * the service's connection timeout, which is set from `--timeout-ms`, and count as rejected.
+ */
+static int runService(const LoadOptions& options)
+{
+    MockRelay relay(options.relay);
+    relay.start();
+
+    auto client = make_shared<WebsocketppClient>();
+    NostrServiceBase service(NullAppender::shared(), client, { relay.uri() });
+    service.setConnectionTimeout(options.timeout);
+    if (service.openRelayConnections().empty())
+    {
+        cerr << "Could not connect to the mock relay at " << relay.uri() << "." << endl;
+        relay.stop();
+        return 1;
+    }
+
+    mt19937_64 random(random_device{}());
+    string pubkey = randomHex(random, 32);
+    vector<shared_ptr<Event>> events;
+    for (size_t i = 0; i < options.events; i++)
+    {
+        auto event = make_shared<Event>();
+        event->pubkey = pubkey;
+        event->createdAt = 1700000000 + static_cast<time_t>(i);
+        event->kind = 1;
+        event->tags = { { "t", "load" } };
+        event->content = "Load test note " + to_string(i);
+        event->sig = randomHex(random, 64);
+        events.push_back(move(event));
+    }
+
+    LoadResult publishResult;
+    publishResult.seconds = runConcurrently(
+        options.events,
+        options.inFlight,
+        publishResult,
+        [&](size_t i)
+        {
+            auto [successfulRelays, failedRelays] = service.publishEvent(events[i]);
+            return !successfulRelays.empty();
+        });
+
+    LoadResult queryResult;
+    atomic<size_t> receivedCount{ 0 };
+    queryResult.seconds = runConcurrently(
+        options.queries,
+        options.inFlight,
+        queryResult,
+        [&](size_t)
+        {
+            auto filters = make_shared<Filters>();
+            filters->authors = { pubkey };
+            filters->kinds = { 1 };
+            filters->limit = static_cast<int>(min<size_t>(options.queryLimit, 64));
+
+            receivedCount += service.queryRelays(filters).get().size();
+            return true;
+        });
+    queryResult.received = receivedCount.load();
+
+    service.closeRelayConnections();
+    relay.stop();
+
+    printf(
+        "service over mock relay %s: latency %lld ms, drop rate %.3f, closed rate %.3f, %zu threads\n",
+        relay.uri().c_str(),
+        static_cast<long long>(options.relay.latency.count()),
+        options.relay.dropRate,
+        options.relay.closedRate,
+        options.inFlight);
+    report("publish", publishResult);
+    report("query", queryResult);
+
+    return 0;
+};
+
+static bool parseOption(const char* argument, const char* name, const char*& value)
+{
+    size_t length = strlen(name);
+    if (strncmp(argument, name, length) != 0 || argument[length] != '=')
+    {
+        return false;
+    }
+
+    value = argument + length + 1;
+    return true;
+};
+} // namespace nostr_bench
+
+/**
+ * @brief Measures publish and query throughput and latency through `WebsocketppClient` against an
+ * in-process mock relay on localhost.
+ * @remark Options are given as `--name=value`: `--events`, `--queries`, `--query-limit`,
+ * `--in-flight`, `--timeout-ms`, `--latency-ms`, `--drop-rate`, `--closed-rate`, and
+ * `--reject-events=1`.  With `--service=1`, requests go through `NostrServiceBase` publish and
+ * query calls instead of raw frames on the client.
+ */
+int main(int argc, char* argv[])
+{
+    using namespace nostr_bench;
+
+    LoadOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        const char* value = nullptr;
+        if (parseOption(argv[i], "--events", value))
+        {
+            options.events = strtoull(value, nullptr, 10);
+        }
+        else if (parseOption(argv[i], "--queries", value))
+        {
+            options.queries = strtoull(value, nullptr, 10);
+        }
+        else if (parseOption(argv[i], "--query-limit", value))
+        {
+            options.queryLimit = strtoull(value, nullptr, 10);
+        }
+        else if (parseOption(argv[i], "--in-flight", value))
+        {
+            options.inFlight = max<size_t>(1, strtoull(value, nullptr, 10));
+        }
+        else if (parseOption(argv[i], "--timeout-ms", value))
+        {
+            options.timeout = chrono::milliseconds(strtoll(value, nullptr, 10));
+        }
+        else if (parseOption(argv[i], "--latency-ms", value))
+        {
+            options.relay.latency = chrono::milliseconds(strtoll(value, nullptr, 10));
+        }
+        else if (parseOption(argv[i], "--drop-rate", value))
+        {
+            options.relay.dropRate = strtod(value, nullptr);
+        }
+        else if (parseOption(argv[i], "--closed-rate", value))
+        {
+            options.relay.closedRate = strtod(value, nullptr);
+        }
+        else if (parseOption(argv[i], "--reject-events", value))
+        {
+            options.relay.acceptEvents = strtol(value, nullptr, 10) == 0;
+        }
+        else if (parseOption(argv[i], "--service", value))
+        {
+            options.throughService = strtol(value, nullptr, 10) != 0;
+        }
+        else
+        {
+            cerr << "Unknown option: " << argv[i] << endl;
+            return 2;
+        }
+    }
+
+    return options.throughService ? runService(options) : run(options);
+};
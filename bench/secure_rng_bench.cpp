@@ -0,0 +1,74 @@
+#include <cstring>
+#include <memory>
+
+#include <benchmark/benchmark.h>
+#include <plog/Appenders/ConsoleAppender.h>
+#include <plog/Formatters/TxtFormatter.h>
+
+#include "cryptography/nostr_secure_rng.hpp"
+#include "signer/noscrypt_local_signer.hpp"
+
+using namespace nostr::cryptography;
+using namespace nostr::data;
+using namespace nostr::signer;
+using namespace std;
+
+namespace nostr_bench
+{
+/**
+ * @brief Draws a 32-byte value, the size of a signing nonce or NIP-44 IV, with the buffered
+ * generator on or off.
+ */
+static void BM_SecureRngFill32(benchmark::State& state)
+{
+    const bool wasBuffered = NostrSecureRng::isBuffered();
+    NostrSecureRng::setBuffered(state.range(0) != 0);
+
+    uint8_t nonce[32];
+    for (auto _ : state)
+    {
+        NostrSecureRng::fill(nonce, sizeof(nonce));
+        benchmark::DoNotOptimize(nonce);
+    }
+    NostrSecureRng::zero(nonce, sizeof(nonce));
+
+    NostrSecureRng::setBuffered(wasBuffered);
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(state.range(0) != 0 ? "buffered" : "RAND_bytes");
+};
+
+/**
+ * @brief Signs text notes with a local signer, which draws a nonce for every signature, with the
+ * buffered generator on or off.
+ */
+static void BM_SignEvent(benchmark::State& state)
+{
+    const bool wasBuffered = NostrSecureRng::isBuffered();
+    NostrSecureRng::setBuffered(state.range(0) != 0);
+
+    static auto appender = make_shared<plog::ConsoleAppender<plog::TxtFormatter>>();
+    NCSecretKey secretKey;
+    NostrSecureRng::fill(secretKey.key, sizeof(secretKey.key));
+    NoscryptLocalSigner signer(appender, secretKey);
+    NostrSecureRng::zero(secretKey.key, sizeof(secretKey.key));
+
+    auto event = make_shared<Event>();
+    event->kind = 1;
+    event->createdAt = 1700000000;
+    event->content = "Benchmarking signatures.";
+
+    for (auto _ : state)
+    {
+        event->pubkey.clear();
+        auto signingPromise = signer.sign(event);
+        benchmark::DoNotOptimize(signingPromise->get_future().get());
+    }
+
+    NostrSecureRng::setBuffered(wasBuffered);
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(state.range(0) != 0 ? "buffered" : "RAND_bytes");
+};
+
+BENCHMARK(BM_SecureRngFill32)->Arg(0)->Arg(1)->ThreadRange(1, 4);
+BENCHMARK(BM_SignEvent)->Arg(0)->Arg(1);
+} // namespace nostr_bench
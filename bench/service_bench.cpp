@@ -0,0 +1,216 @@
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+
+#include "service/nostr_service_base.hpp"
+#include "service_fixtures.hpp"
+
+using namespace nostr::data;
+using namespace nostr::service;
+using namespace std;
+
+namespace nostr_bench
+{
+/**
+ * @brief Runs a subscription against one relay whose stored events are replayed from memory:
+ * the REQ is serialized and sent, each EVENT frame is dispatched through the service's
+ * subscription message handler, and the subscription is closed.  With verification on, every
+ * event's signature is also checked before it reaches the handler.
+ */
+static void BM_QueryRelays_Dispatch(benchmark::State& state)
+{
+    const size_t eventCount = 100;
+    const bool isVerified = state.range(0) != 0;
+
+    auto client = make_shared<FakeRelayClient>(signedTextNotes(eventCount));
+    NostrServiceBase service(NullAppender::shared(), client, { "wss://relay.example.com" });
+    service.openRelayConnections();
+    service.setEventVerification(isVerified);
+
+    auto filters = make_shared<Filters>();
+    filters->kinds = { 1 };
+    filters->limit = eventCount;
+
+    atomic<size_t> receivedCount{ 0 };
+    for (auto _ : state)
+    {
+        receivedCount.store(0, memory_order_relaxed);
+        string subscriptionId = service.queryRelays(
+            filters,
+            [&receivedCount](const string&, shared_ptr<Event> event)
+            {
+                benchmark::DoNotOptimize(event);
+                receivedCount.fetch_add(1, memory_order_relaxed);
+            },
+            [](const string&) {},
+            [](const string&, const string&) {});
+
+        // Verified events may be delivered from the verifier's workers after the query returns.
+        while (receivedCount.load(memory_order_relaxed) < eventCount)
+        {
+            this_thread::yield();
+        }
+
+        service.closeSubscription(subscriptionId);
+    }
+
+    state.SetItemsProcessed(state.iterations() * eventCount);
+    state.SetLabel(isVerified ? "verified" : "unverified");
+};
+
+BENCHMARK(BM_QueryRelays_Dispatch)->Arg(0)->Arg(1)->UseRealTime();
+
+/**
+ * @brief Opens and closes connections to many relays at once, as a client does at startup and
+ * shutdown.
+ */
+static void BM_OpenRelayConnections(benchmark::State& state)
+{
+    const size_t relayCount = static_cast<size_t>(state.range(0));
+
+    vector<string> relays;
+    for (size_t i = 0; i < relayCount; i++)
+    {
+        relays.push_back("wss://relay" + to_string(i) + ".example.com");
+    }
+
+    auto client = make_shared<FakeRelayClient>(vector<string>());
+    NostrServiceBase service(NullAppender::shared(), client, relays);
+
+    for (auto _ : state)
+    {
+        auto connectedRelays = service.openRelayConnections();
+        benchmark::DoNotOptimize(connectedRelays);
+        service.closeRelayConnections();
+    }
+
+    state.SetItemsProcessed(state.iterations() * relayCount);
+};
+
+BENCHMARK(BM_OpenRelayConnections)->Arg(10)->Arg(300)->UseRealTime();
+
+/**
+ * @brief Returns a service connected to the given number of relays, each of which accepts every
+ * event it is sent.
+ */
+static unique_ptr<NostrServiceBase> publishingService(size_t relayCount)
+{
+    vector<string> relays;
+    for (size_t i = 0; i < relayCount; i++)
+    {
+        relays.push_back("wss://relay" + to_string(i) + ".example.com");
+    }
+
+    auto service = make_unique<NostrServiceBase>(
+        NullAppender::shared(),
+        make_shared<FakeRelayClient>(vector<string>()),
+        relays);
+    service->openRelayConnections();
+    return service;
+};
+
+static shared_ptr<Event> publishableNote(size_t index)
+{
+    auto event = make_shared<Event>();
+    event->pubkey = "f7234bd4c1394dda46d09f35bd384dd30cc552ad5541990f98844fb06676e9ca";
+    event->kind = 1;
+    event->createdAt = 1700000000 + index;
+    event->tags = { { "t", "nostr" } };
+    event->content = "Benchmark note number " + to_string(index) + ", with some ordinary text in it.";
+    return event;
+};
+
+/**
+ * @brief Builds the EVENT messages for one event bound for each of the given number of relays,
+ * either as the service once did, wrapping the serialized event in a JSON string and dumping the
+ * message for every relay, or as it does now, serializing the message once for all relays.
+ */
+static void BM_PublishEvent_MessageBuild(benchmark::State& state)
+{
+    const size_t relayCount = static_cast<size_t>(state.range(0));
+    const bool isSerializedOnce = state.range(1) != 0;
+
+    auto event = publishableNote(0);
+    for (auto _ : state)
+    {
+        string serializedEvent = event->serialize();
+        if (isSerializedOnce)
+        {
+            auto payload = make_shared<const string>("[\"EVENT\"," + serializedEvent + "]");
+            for (size_t i = 0; i < relayCount; i++)
+            {
+                nostr::client::SharedPayload relayPayload = payload;
+                benchmark::DoNotOptimize(relayPayload);
+            }
+        }
+        else
+        {
+            nlohmann::json message = nlohmann::json::array({ "EVENT", serializedEvent });
+            for (size_t i = 0; i < relayCount; i++)
+            {
+                string relayPayload = message.dump();
+                benchmark::DoNotOptimize(relayPayload);
+            }
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * relayCount);
+    state.SetLabel(isSerializedOnce ? "serialize once" : "dump per relay");
+};
+
+BENCHMARK(BM_PublishEvent_MessageBuild)->Args({ 50, 0 })->Args({ 50, 1 });
+
+/**
+ * @brief Publishes events one at a time to many relays, each of which answers with an OK before
+ * `send` returns.
+ */
+static void BM_PublishEvent_FanOut(benchmark::State& state)
+{
+    const size_t relayCount = static_cast<size_t>(state.range(0));
+    auto service = publishingService(relayCount);
+
+    size_t index = 0;
+    for (auto _ : state)
+    {
+        auto [successes, failures] = service->publishEvent(publishableNote(index++));
+        benchmark::DoNotOptimize(successes);
+    }
+
+    state.SetItemsProcessed(state.iterations() * relayCount);
+};
+
+BENCHMARK(BM_PublishEvent_FanOut)->Arg(50)->UseRealTime();
+
+/**
+ * @brief Publishes a batch of events to many relays in one call.
+ */
+static void BM_PublishEvents_FanOut(benchmark::State& state)
+{
+    const size_t relayCount = static_cast<size_t>(state.range(0));
+    const size_t batchSize = static_cast<size_t>(state.range(1));
+    auto service = publishingService(relayCount);
+
+    size_t index = 0;
+    for (auto _ : state)
+    {
+        vector<shared_ptr<Event>> events;
+        for (size_t i = 0; i < batchSize; i++)
+        {
+            events.push_back(publishableNote(index++));
+        }
+
+        auto results = service->publishEvents(events);
+        benchmark::DoNotOptimize(results);
+    }
+
+    state.SetItemsProcessed(state.iterations() * relayCount * batchSize);
+};
+
+BENCHMARK(BM_PublishEvents_FanOut)->Args({ 50, 16 })->UseRealTime();
+} // namespace nostr_bench
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include <plog/Appenders/IAppender.h>
+
+#include "client/web_socket_client.hpp"
+#include "cryptography/nostr_secure_rng.hpp"
+#include "signer/noscrypt_local_signer.hpp"
+
+namespace nostr_bench
+{
+/**
+ * @brief Discards log records, so that logging does not dominate the measurements.
+ */
+class NullAppender : public plog::IAppender
+{
+public:
+    void write(const plog::Record&) override {};
+
+    /**
+     * @brief Returns the appender shared by all benchmarks, which plog keeps for the whole run.
+     */
+    static std::shared_ptr<NullAppender> shared()
+    {
+        static auto appender = std::make_shared<NullAppender>();
+        return appender;
+    };
+};
+
+/**
+ * @brief A WebSocket client that answers from memory before `send` returns.  Every REQ is
+ * answered with a fixed set of events followed by an EOSE, and every EVENT with an OK.
+ */
+class FakeRelayClient : public nostr::client::IWebSocketClient
+{
+public:
+    explicit FakeRelayClient(const std::vector<std::string>& eventJson)
+    {
+        // Each event is embedded in EVENT frames as a JSON object, as NIP-01 relays send it.
+        this->_eventJson = eventJson;
+    };
+
+    void start() override {};
+
+    void stop() override {};
+
+    void openConnection(std::string_view uri) override
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_connected[std::string(uri)] = true;
+    };
+
+    bool isConnected(std::string_view uri) override
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        return this->_connected[std::string(uri)];
+    };
+
+    bool send(nostr::client::SharedPayload message, std::string_view uri) override
+    {
+        if (message->compare(0, 9, "[\"EVENT\",") == 0)
+        {
+            nostr::client::MessageHandler messageHandler;
+            {
+                std::lock_guard<std::mutex> lock(this->_mutex);
+                messageHandler = this->_handlers[std::string(uri)];
+            }
+            this->_accept(*message, messageHandler);
+        }
+        return true;
+    };
+
+    bool send(
+        nostr::client::SharedPayload message,
+        std::string_view uri,
+        nostr::client::MessageHandler messageHandler) override
+    {
+        if (message->compare(0, 9, "[\"EVENT\",") == 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(this->_mutex);
+                this->_handlers[std::string(uri)] = messageHandler;
+            }
+            this->_accept(*message, messageHandler);
+            return true;
+        }
+
+        // REQ messages have the form ["REQ","<subscription ID>",{...}].
+        std::size_t idStart = message->find('"', 6) + 1;
+        std::string subscriptionId = message->substr(idStart, message->find('"', idStart) - idStart);
+
+        for (const auto& event : this->_eventJson)
+        {
+            messageHandler("[\"EVENT\",\"" + subscriptionId + "\"," + event + "]");
+        }
+        messageHandler("[\"EOSE\",\"" + subscriptionId + "\"]");
+
+        return true;
+    };
+
+    void receive(std::string_view uri, nostr::client::MessageHandler messageHandler) override {};
+
+    void closeConnection(std::string_view uri) override
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_connected[std::string(uri)] = false;
+    };
+
+private:
+    std::vector<std::string> _eventJson;
+    std::mutex _mutex;
+    std::unordered_map<std::string, bool> _connected;
+    std::unordered_map<std::string, nostr::client::MessageHandler> _handlers;
+
+    /**
+     * @brief Answers an EVENT message with an OK that accepts the event.
+     */
+    static void _accept(const std::string& message, const nostr::client::MessageHandler& messageHandler)
+    {
+        // Event IDs are 64 hex characters, following the "id" key of the embedded object.
+        std::size_t idStart = message.find("\"id\":\"") + 6;
+        messageHandler("[\"OK\",\"" + message.substr(idStart, 64) + "\",true,\"\"]");
+    };
+};
+
+/**
+ * @brief Signs the given number of text notes with a fresh key, and returns their JSON.
+ */
+inline std::vector<std::string> signedTextNotes(std::size_t count)
+{
+    NCSecretKey secretKey;
+    nostr::cryptography::NostrSecureRng::fill(secretKey.key, sizeof(secretKey.key));
+    nostr::signer::NoscryptLocalSigner signer(NullAppender::shared(), secretKey);
+    nostr::cryptography::NostrSecureRng::zero(secretKey.key, sizeof(secretKey.key));
+
+    std::vector<std::string> notes;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        auto event = std::make_shared<nostr::data::Event>();
+        event->kind = 1;
+        event->createdAt = 1700000000 + i;
+        event->tags = { { "t", "nostr" } };
+        event->content = "Benchmark note number " + std::to_string(i) + ", with some ordinary text in it.";
+        signer.sign(event)->get_future().get();
+        notes.push_back(event->serialize());
+    }
+
+    return notes;
+};
+} // namespace nostr_bench
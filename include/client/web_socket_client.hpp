@@ -1,14 +1,33 @@
 #pragma once
 
+#include <cstddef>
 #include <functional>
+#include <future>
+#include <memory>
 #include <string>
+#include <string_view>
 
 namespace nostr
 {
 namespace client
 {
+/**
+ * @brief An immutable message payload that can be shared by many sends.
+ * @remark A message published to several servers is serialized once, and each send holds a
+ * reference to the same buffer rather than a copy of it.
+ */
+typedef std::shared_ptr<const std::string> SharedPayload;
+
+/**
+ * @brief Receives the payload of each message from a server.
+ * @remark The payload is only valid for the duration of the call.  Copy it to keep it.
+ */
+typedef std::function<void(std::string_view)> MessageHandler;
+
 /**
  * @brief An interface for a WebSocket client singleton.
+ * @remark Server URIs are passed as views.  Implementations copy a URI only when they store it,
+ * such as when they open a connection.
  */
 class IWebSocketClient
 {
@@ -30,51 +49,98 @@ public:
 
     /**
      * @brief Opens a connection to the given server.
+     * @remark The connection may still be opening when this method returns.  Use the overload
+     * that takes handlers to learn when the connection is established.
+     */
+    virtual void openConnection(std::string_view uri) = 0;
+
+    /**
+     * @brief Opens a connection to the given server, and reports when it opens, fails to open,
+     * or later closes.
+     * @param uri The URI of the server.
+     * @param openHandler Invoked once the opening handshake completes.  May be empty.
+     * @param failHandler Invoked with a reason if the connection cannot be opened.  May be empty.
+     * @param closeHandler Invoked with a reason when an open connection closes, whether the
+     * client or the server closed it.  May be empty.
+     * @returns A future that becomes true when the connection opens, or false if it fails.
+     * @remark Messages sent to the server before the connection opens are queued, and sent in
+     * order once it opens.  If the connection fails, they are discarded.
+     *
+     * The default implementation suits clients whose `openConnection` completes the handshake
+     * before returning: it opens the connection, checks `isConnected`, and invokes the open or
+     * fail handler before it returns.  It never invokes the close handler.
      */
-    virtual void openConnection(std::string uri) = 0;
+    virtual std::future<bool> openConnection(
+        std::string_view uri,
+        std::function<void()> openHandler,
+        std::function<void(std::string_view)> failHandler,
+        std::function<void(std::string_view)> closeHandler
+    )
+    {
+        this->openConnection(uri);
+
+        std::promise<bool> openPromise;
+        bool isOpen = this->isConnected(uri);
+        if (isOpen && openHandler)
+        {
+            openHandler();
+        }
+        else if (!isOpen && failHandler)
+        {
+            failHandler("Connection did not open.");
+        }
+        openPromise.set_value(isOpen);
+
+        return openPromise.get_future();
+    };
 
     /**
      * @brief Indicates whether the client is connected to the given server.
      * @returns True if the client is connected, false otherwise.
+     * @remark A connection counts as connected once its opening handshake has completed.
      */
-    virtual bool isConnected(std::string uri) = 0;
+    virtual bool isConnected(std::string_view uri) = 0;
 
     /**
      * @brief Sends the given message to the given server.
-     * @returns A tuple indicating the server URI and whether the message was successfully
-     * sent.
+     * @returns True if the message was successfully sent, false otherwise.
      */
-    virtual std::tuple<std::string, bool> send(std::string message, std::string uri) = 0;
+    virtual bool send(SharedPayload message, std::string_view uri) = 0;
 
     /**
      * @brief Sends the given message to the given server and sets up a message handler for
      * messages received from the server.
-     * @returns A tuple indicating the server URI and whether the message was successfully
-     * sent.
+     * @returns True if the message was successfully sent, false otherwise.
      * @remark Use this method to send a message and set up a message handler for responses in the
      * same call.
      */
-    virtual std::tuple<std::string, bool> send(
-        std::string message,
-        std::string uri,
-        std::function<void(const std::string&)> messageHandler
-    ) = 0;
+    virtual bool send(SharedPayload message, std::string_view uri, MessageHandler messageHandler) = 0;
 
     /**
      * @brief Sets up a message handler for the given server.
      * @param uri The URI of the server to which the message handler should be attached.
      * @param messageHandler A callable object that will be invoked with the payload the client
      * receives from the server.
+     * @remark Each connection has a single message handler, which this method replaces.  It may
+     * be called from any thread, including while a message is being handled.
      */
-    virtual void receive(
-        std::string uri,
-        std::function<void(const std::string&)> messageHandler
-    ) = 0;
+    virtual void receive(std::string_view uri, MessageHandler messageHandler) = 0;
 
     /**
      * @brief Closes the connection to the given server.
      */
-    virtual void closeConnection(std::string uri) = 0;
+    virtual void closeConnection(std::string_view uri) = 0;
+
+    /**
+     * @brief Returns the number of messages to the given server that the client has accepted but
+     * not yet written to the connection.
+     * @remark Clients that write each message before `send` returns have no queue, which is what
+     * the default implementation reports.
+     */
+    virtual std::size_t queuedMessageCount(std::string_view uri)
+    {
+        return 0;
+    };
 };
 } // namespace client
 } // namespace nostr
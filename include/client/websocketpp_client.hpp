@@ -1,8 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
-#include <tuple>
 
 #include <websocketpp/client.hpp>
 #include <websocketpp/config/asio_client.hpp>
@@ -15,6 +22,19 @@ namespace client
 {
 /**
  * @brief An implementation of the `IWebSocketClient` interface that uses the WebSocket++ library.
+ * @remark `start` runs the client's I/O loop on a dedicated thread, which `stop` joins.  Message
+ * handlers and connection handlers are invoked on that thread.  Each connection has one message
+ * handler, which `receive` and `send` replace, so callers with several requests open on one
+ * connection install a handler that dispatches to all of them.
+ *
+ * Each connection has its own lock-free send queue.  `send` only pushes the message onto the
+ * queue, and the I/O thread drains the queue, handing every queued message to WebSocket++ in one
+ * pass so that they leave in as few socket writes as possible.  Messages sent while the
+ * connection's handshake is in progress wait in the queue until it opens.
+ *
+ * When a connection's queue reaches its high-water mark, `send` rejects further messages to that
+ * server until the queue drains to the low-water mark, and the backpressure handler, if any, is
+ * told of both transitions.
  */
 class WebsocketppClient : public IWebSocketClient
 {
@@ -23,29 +43,104 @@ public:
 
     void stop() override;
 
-    void openConnection(std::string uri) override;
+    void openConnection(std::string_view uri) override;
 
-    bool isConnected(std::string uri) override;
+    std::future<bool> openConnection(
+        std::string_view uri,
+        std::function<void()> openHandler,
+        std::function<void(std::string_view)> failHandler,
+        std::function<void(std::string_view)> closeHandler
+    ) override;
 
-    std::tuple<std::string, bool> send(std::string message, std::string uri) override;
+    bool isConnected(std::string_view uri) override;
 
-    std::tuple<std::string, bool> send(
-        std::string message,
-        std::string uri,
-        std::function<void(const std::string&)> messageHandler
-    ) override;
+    bool send(SharedPayload message, std::string_view uri) override;
+
+    bool send(SharedPayload message, std::string_view uri, MessageHandler messageHandler) override;
+
+    void receive(std::string_view uri, MessageHandler messageHandler) override;
+
+    void closeConnection(std::string_view uri) override;
 
-    void receive(std::string uri, std::function<void(const std::string&)> messageHandler) override;
+    std::size_t queuedMessageCount(std::string_view uri) override;
 
-    void closeConnection(std::string uri) override;
+    /**
+     * @brief Returns the number of messages the client accepted but WebSocket++ refused to send,
+     * such as because the connection closed before they were written.
+     */
+    std::size_t droppedMessageCount() const;
+
+    /**
+     * @brief Sets the queue depths at which a connection becomes congested, and at which it stops
+     * being congested.
+     * @param highWaterMark The number of queued messages at which `send` starts rejecting
+     * messages to the server.
+     * @param lowWaterMark The number of queued messages to which the queue must drain before
+     * `send` accepts messages again.  Must be less than the high-water mark.
+     */
+    void setSendQueueLimits(std::size_t highWaterMark, std::size_t lowWaterMark);
+
+    /**
+     * @brief Sets a handler that is invoked with a server URI and `true` when the connection to
+     * the server becomes congested, and with the URI and `false` when it stops being congested.
+     * @remark The handler is invoked on the thread whose send was rejected, or on the I/O thread
+     * when the queue drains.
+     */
+    void setBackpressureHandler(std::function<void(std::string_view, bool)> backpressureHandler);
+
+    ///< The default number of queued messages at which a connection becomes congested.
+    static constexpr std::size_t defaultHighWaterMark = 4096;
+
+    ///< The default number of queued messages at which a connection stops being congested.
+    static constexpr std::size_t defaultLowWaterMark = 1024;
 
 private:
     typedef websocketpp::client<websocketpp::config::asio_client> websocketpp_client;
-    typedef std::unordered_map<std::string, websocketpp::connection_hdl>::iterator connection_hdl_iterator;
+
+    struct Connection;
 
     websocketpp_client _client;
-    std::unordered_map<std::string, websocketpp::connection_hdl> _connectionHandles;
-    std::mutex _propertyMutex;
+    std::thread _ioThread;
+
+    ///< Guards the connection map.  Sends only read it, so they take the lock shared.
+    std::shared_mutex _connectionMutex;
+
+    ///< Connections keyed by views of their own URIs, so lookups by view need no copy.
+    std::unordered_map<std::string_view, std::shared_ptr<Connection>> _connections;
+
+    ///< The number of messages WebSocket++ refused to send.
+    std::atomic<std::size_t> _droppedCount{ 0 };
+
+    std::atomic<std::size_t> _highWaterMark{ defaultHighWaterMark };
+    std::atomic<std::size_t> _lowWaterMark{ defaultLowWaterMark };
+
+    std::mutex _backpressureMutex;
+    std::function<void(std::string_view, bool)> _backpressureHandler;
+
+    std::shared_ptr<Connection> _findConnection(std::string_view uri);
+
+    /**
+     * @brief Forgets the connection to the given server, if it is still the given connection.
+     * @remark A handler of a replaced connection must not remove its replacement.
+     * @returns True if the connection was forgotten.
+     */
+    bool _eraseConnection(const std::shared_ptr<Connection>& connection);
+
+    /**
+     * @brief Arranges for the I/O thread to drain the connection's send queue, unless it is
+     * already due to.
+     */
+    void _scheduleFlush(const std::shared_ptr<Connection>& connection);
+
+    /**
+     * @brief Writes every queued message of the connection.  Runs on the I/O thread.
+     * @remark Messages WebSocket++ refuses are logged and counted as dropped.  WebSocket++ copies
+     * each payload into its own frame, so a payload shared by several connections is copied once
+     * for each of them.
+     */
+    void _flush(const std::shared_ptr<Connection>& connection);
+
+    void _signalBackpressure(std::string_view uri, bool isCongested);
 };
 } // namespace client
 } // namespace nostr
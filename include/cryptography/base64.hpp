@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nostr
+{
+namespace encoding
+{
+/**
+ * @brief A standard (RFC 4648 section 4) base64 codec with padding.
+ * @remark Blocks of input are translated with SSSE3 or AVX2 instructions when the library is
+ * compiled for a CPU that supports them; the remainder is handled by a table-driven scalar path.
+ * Decoding is strict: the input length must be a multiple of four, padding may only appear at the
+ * end, the unused bits before padding must be zero, and whitespace or characters outside the
+ * alphabet are rejected.
+ */
+class Base64
+{
+public:
+    /**
+     * @brief Computes the length of the base64 encoding of `n` bytes, including padding.
+     */
+    static constexpr std::size_t encodedSize(std::size_t n)
+    {
+        return ((n + 2) / 3) * 4;
+    };
+
+    /**
+     * @brief Computes the maximum number of bytes `n` base64 characters can decode to.
+     * @remark The exact size is smaller by the number of padding characters.
+     */
+    static constexpr std::size_t maxDecodedSize(std::size_t n)
+    {
+        return (n / 4) * 3;
+    };
+
+    /**
+     * @brief Encodes a buffer into a caller-provided character buffer.
+     * @param input The bytes to encode.
+     * @param inputSize The number of bytes to encode.
+     * @param output A buffer of at least `encodedSize(inputSize)` characters.  No NUL terminator
+     * is written.
+     * @returns The number of characters written.
+     */
+    static std::size_t encode(const uint8_t* input, std::size_t inputSize, char* output);
+
+    /**
+     * @brief Encodes a buffer into a string, reusing the string's capacity.
+     * @param output The string that receives the encoding.  Its previous contents are replaced.
+     */
+    static void encode(const uint8_t* input, std::size_t inputSize, std::string& output);
+
+    /**
+     * @brief Encodes a string of bytes.
+     * @returns The base64 encoding of `input`.
+     */
+    static std::string encode(const std::string& input);
+
+    /**
+     * @brief Decodes base64 characters into a caller-provided buffer.
+     * @param input The characters to decode.
+     * @param inputSize The number of characters to decode.  It must be a multiple of four.
+     * @param output A buffer of at least `maxDecodedSize(inputSize)` bytes.
+     * @param outputSize Receives the number of bytes written.
+     * @returns True if the input was valid base64, false otherwise.  The contents of `output` are
+     * unspecified on failure.
+     */
+    static bool decode(
+        const char* input,
+        std::size_t inputSize,
+        uint8_t* output,
+        std::size_t& outputSize
+    );
+
+    /**
+     * @brief Decodes base64 characters into a vector, reusing the vector's capacity.
+     * @param output The vector that receives the decoded bytes.  Its previous contents are
+     * replaced, and it is cleared on failure.
+     * @returns True if the input was valid base64, false otherwise.
+     */
+    static bool decode(const char* input, std::size_t inputSize, std::vector<uint8_t>& output);
+
+    /**
+     * @brief Decodes a base64 string.
+     * @param input The string to decode.
+     * @param output The string that receives the decoded bytes.  It is cleared on failure.
+     * @returns True if the input was valid base64, false otherwise.
+     */
+    static bool decode(const std::string& input, std::string& output);
+};
+
+/**
+ * @brief Encodes a stream of bytes to base64 in chunks of any size.
+ * @remark Up to two bytes that do not fill a complete 3-byte group are carried over to the next
+ * call, so the output of all `update` calls followed by `finish` equals the encoding of the
+ * concatenated input.
+ */
+class Base64Encoder
+{
+public:
+    /**
+     * @brief Encodes the next chunk of input, appending whole 4-character groups to `output`.
+     */
+    void update(const uint8_t* input, std::size_t inputSize, std::string& output);
+
+    /**
+     * @brief Encodes any carried-over bytes with padding and resets the encoder.
+     */
+    void finish(std::string& output);
+
+private:
+    uint8_t _pending[3];
+    std::size_t _pendingSize = 0;
+};
+
+/**
+ * @brief Decodes a stream of base64 characters in chunks of any size.
+ * @remark The final 4-character group is held back until `finish`, since only it may contain
+ * padding.  Once a call fails, the decoder stays failed until `finish` resets it.
+ */
+class Base64Decoder
+{
+public:
+    /**
+     * @brief Decodes the next chunk of input, appending decoded bytes to `output`.
+     * @returns False if the input so far is not valid base64.
+     */
+    bool update(const char* input, std::size_t inputSize, std::vector<uint8_t>& output);
+
+    /**
+     * @brief Decodes the final group and resets the decoder.
+     * @returns False if the complete input was not valid base64.
+     */
+    bool finish(std::vector<uint8_t>& output);
+
+private:
+    char _pending[4];
+    std::size_t _pendingSize = 0;
+    bool _isFailed = false;
+};
+} // namespace encoding
+} // namespace nostr
@@ -185,6 +185,88 @@ public:
         int inbits,
         int pad
     );
+
+    ///< The longest human readable part accepted by `encodeBytes` and `decodeBytes`.
+    static constexpr std::size_t maxHrpLength = 83;
+
+    /**
+     * @brief Returns the length of the Bech32 string `encodeBytes` produces for the given human
+     * readable part and payload lengths.
+     */
+    static constexpr std::size_t encodedLength(std::size_t hrpLength, std::size_t dataLength)
+    {
+        return hrpLength + 1 + (dataLength * FROM_BITS + TO_BITS - 1) / TO_BITS + 6;
+    }
+
+    /**
+     * @brief Encodes a byte payload as a Bech32 or Bech32m string without allocating.
+     * @param hrp The human readable part, in lowercase.
+     * @param hrpLength The length of the human readable part.
+     * @param data The 8-bit payload, which is regrouped into 5-bit symbols and zero-padded.
+     * @param dataLength The length of the payload.
+     * @param enc Which encoding to use (BECH32_ENCODING_BECH32{,M}).
+     * @param output The buffer that will receive the encoded string.  It is not null-terminated.
+     * @param outputCapacity The size of `output`, which must be at least
+     * `encodedLength(hrpLength, dataLength)`.
+     * @returns The number of characters written, or 0 if the input was invalid or the output
+     * buffer was too small.
+     * @remark The checksum is computed two symbols at a time with a precomputed table.
+     */
+    static std::size_t encodeBytes(
+        const char *hrp,
+        std::size_t hrpLength,
+        const uint8_t *data,
+        std::size_t dataLength,
+        Bech32EncodingType enc,
+        char *output,
+        std::size_t outputCapacity
+    );
+
+    /**
+     * @brief Decodes a Bech32 or Bech32m string into its byte payload without allocating.
+     * @param input The encoded string.  Either all-lowercase or all-uppercase input is accepted.
+     * @param inputLength The length of the encoded string.
+     * @param hrpLength Updated to the length of the human readable part, which occupies the start
+     * of `input`.
+     * @param output The buffer that will receive the 8-bit payload.
+     * @param outputCapacity The size of `output`.
+     * @param outputLength Updated to the number of payload bytes written.
+     * @returns The encoding that was decoded, or BECH32_ENCODING_NONE if the string was invalid,
+     * had non-zero padding bits, or its payload did not fit in `output`.
+     */
+    static Bech32EncodingType decodeBytes(
+        const char *input,
+        std::size_t inputLength,
+        std::size_t &hrpLength,
+        uint8_t *output,
+        std::size_t outputCapacity,
+        std::size_t &outputLength
+    );
+
+    /**
+     * @brief Encodes a batch of hex-encoded keys or event IDs, such as npubs or notes, as
+     * Bech32 strings with the same human readable part.
+     * @param hrp The human readable part, in lowercase, such as "npub".
+     * @param hexValues The hex-encoded payloads.
+     * @returns The encoded strings, in the order of `hexValues`.  An entry is empty if its
+     * payload was not valid hex or was longer than MAX_INPUT_LENGTH bytes.
+     */
+    static std::vector<std::string> encodeBatch(
+        const std::string &hrp,
+        const std::vector<std::string> &hexValues
+    );
+
+    /**
+     * @brief Decodes a batch of Bech32 strings, such as npubs or notes, into hex-encoded payloads.
+     * @param hrp The human readable part every string is expected to have, in lowercase.
+     * @param encodings The Bech32 strings.
+     * @returns The lowercase hex-encoded payloads, in the order of `encodings`.  An entry is
+     * empty if its string was invalid, was Bech32m, or had a different human readable part.
+     */
+    static std::vector<std::string> decodeBatch(
+        const std::string &hrp,
+        const std::vector<std::string> &encodings
+    );
 };
 }
 }
\ No newline at end of file
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <noscrypt.h>
+
+#include "cryptography/verified_event_cache.hpp"
+#include "data/data.hpp"
+
+namespace nostr
+{
+namespace internal
+{
+class WorkerPool;
+} // namespace internal
+
+namespace cryptography
+{
+/**
+ * @brief A snapshot of the work done by an `EventVerifier`.
+ */
+struct EventVerifierStats
+{
+    uint64_t verified; ///< The number of events whose ID and signature were valid.
+    uint64_t rejected; ///< The number of events that failed verification.
+    double verifiedPerSecond; ///< Events the pool verifies per second, measured over the time its workers spent busy.
+    uint64_t cacheHits; ///< Valid events whose signature check was skipped because they were verified before.
+    uint64_t cacheMisses; ///< Events whose signature had to be checked.
+    uint64_t pending; ///< Events submitted but not yet picked up by a worker.
+};
+
+/**
+ * @brief Verifies the IDs and Schnorr signatures of received Nostr events across a pool of
+ * worker threads.
+ * @remark Events submitted individually are collected into batches, and each batch is verified
+ * on one worker with that worker's own noscrypt context from `NoscryptContextPool`.  Under light
+ * load a batch may hold a single event, so verification adds little latency; under heavy load
+ * events queue up and are drained in batches of up to `batchSize` by every worker at once.
+ *
+ * The same event is commonly received from several relays and on several subscriptions, so
+ * the verifier remembers the IDs and signatures of events that passed.  A repeat of a known
+ * event only has its ID recomputed from its contents; the Schnorr check is skipped.
+ */
+class EventVerifier
+{
+public:
+    /**
+     * @param workerCount The number of worker threads.  A value of 0 starts one worker per
+     * hardware thread.
+     * @param batchSize The maximum number of events a worker verifies before returning to the
+     * queue.
+     * @param cacheCapacity The number of verified events to remember.  A value of 0 disables
+     * the cache.
+     */
+    EventVerifier(
+        std::size_t workerCount = 0,
+        std::size_t batchSize = 64,
+        std::size_t cacheCapacity = 65536);
+
+    ~EventVerifier();
+
+    EventVerifier(const EventVerifier&) = delete;
+
+    EventVerifier& operator=(const EventVerifier&) = delete;
+
+    /**
+     * @brief Queues an event for verification.
+     * @param event The event to verify.
+     * @param verificationHandler A callable object that will be invoked with the event and the
+     * verification result once the event has been checked.
+     * @remark The handler is invoked on one of the verifier's worker threads.
+     */
+    void submit(
+        std::shared_ptr<data::Event> event,
+        std::function<void(std::shared_ptr<data::Event>, bool)> verificationHandler
+    );
+
+    /**
+     * @brief Verifies a batch of events in parallel and waits for the results.
+     * @param events The events to verify.
+     * @returns A vector of the same length as `events`, where each element indicates whether
+     * the corresponding event is valid.
+     */
+    std::vector<bool> verify(const std::vector<std::shared_ptr<data::Event>>& events);
+
+    /**
+     * @brief Checks that an event's ID matches its contents, and that its signature is a valid
+     * Schnorr signature of the ID by the event's pubkey.
+     * @param context An initialized noscrypt context.  The context must not be used
+     * concurrently by another thread.
+     * @param event The event to verify.
+     * @returns True if the event is valid, false otherwise.
+     */
+    static bool verifyEvent(const NCContext* context, const data::Event& event);
+
+    /**
+     * @brief Returns the number of worker threads used for verification.
+     */
+    std::size_t workerCount() const;
+
+    /**
+     * @brief Returns a snapshot of the verifier's counters.
+     */
+    EventVerifierStats stats() const;
+
+private:
+    struct PendingVerification
+    {
+        std::shared_ptr<data::Event> event;
+        std::function<void(std::shared_ptr<data::Event>, bool)> verificationHandler;
+    };
+
+    const std::size_t _batchSize;
+
+    VerifiedEventCache _verifiedEvents;
+
+    std::deque<PendingVerification> _pending; ///< Events waiting to be picked up by a worker.
+
+    std::size_t _activeDrains = 0; ///< The number of drain tasks currently queued or running on the pool.
+
+    mutable std::mutex _pendingMutex;
+
+    std::atomic<uint64_t> _verifiedCount{ 0 };
+    std::atomic<uint64_t> _rejectedCount{ 0 };
+    std::atomic<uint64_t> _busyNanoseconds{ 0 };
+
+    std::unique_ptr<internal::WorkerPool> _pool; ///< Declared last so the workers are joined before the state they use is destroyed.
+
+    /**
+     * @brief Verifies queued events in batches until the queue is empty.
+     */
+    void _drain();
+
+    /**
+     * @brief Verifies one event, consulting and updating the verified event cache, and records
+     * the result in the verifier's counters.
+     */
+    bool _verifyAndCount(const data::Event& event);
+};
+} // namespace cryptography
+} // namespace nostr
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <noscrypt.h>
+
+namespace nostr
+{
+namespace internal
+{
+class WorkerPool;
+} // namespace internal
+
+namespace cryptography
+{
+class ConversationKeyCache;
+
+/**
+ * @brief The reason a single item of a NIP-44 batch could not be processed.
+ */
+enum class Nip44BatchError
+{
+    NONE, ///< The item was processed successfully.
+    INVALID_PUBLIC_KEY, ///< The peer public key is not a 32-byte hex string.
+    KEY_DERIVATION_FAILED, ///< No conversation key could be derived with the peer public key.
+    INVALID_PAYLOAD, ///< The payload is not valid base64, is malformed, or failed authentication.
+    CIPHER_FAILED, ///< The message could not be encrypted.
+};
+
+/**
+ * @brief One message of a NIP-44 batch.
+ */
+struct Nip44BatchItem
+{
+    std::string peerPublicKey; ///< The public key of the other party, as a lowercase hex string.
+    std::string payload; ///< The plaintext message to encrypt, or the base64 payload to decrypt.
+};
+
+/**
+ * @brief The outcome of one message of a NIP-44 batch.
+ */
+struct Nip44BatchResult
+{
+    Nip44BatchError error; ///< `Nip44BatchError::NONE` if the item succeeded.
+    std::string output; ///< The base64 payload or the decrypted message.  Empty on failure.
+};
+
+/**
+ * @brief Encrypts and decrypts batches of NIP-44 v2 messages for one local key across a pool of
+ * worker threads.
+ * @remark Each worker uses its own noscrypt context from `NoscryptContextPool`.  Conversation
+ * keys are derived once per peer and shared by all workers, so a batch dominated by a few peers
+ * costs little more than its symmetric encryption.  A failed item does not affect the rest of
+ * its batch.
+ */
+class Nip44BatchCipher
+{
+public:
+    /**
+     * @param localKey The local secret key.  The cipher keeps its own copy of the key and zeroes
+     * it on destruction.
+     * @param workerCount The number of worker threads.  A value of 0 starts one worker per
+     * hardware thread.
+     * @param keyCacheCapacity The number of conversation keys to keep.
+     * @throws `std::invalid_argument` if the secret key is not a valid secp256k1 secret key.
+     */
+    Nip44BatchCipher(
+        const NCSecretKey& localKey,
+        std::size_t workerCount = 0,
+        std::size_t keyCacheCapacity = 256
+    );
+
+    ~Nip44BatchCipher();
+
+    Nip44BatchCipher(const Nip44BatchCipher&) = delete;
+
+    Nip44BatchCipher& operator=(const Nip44BatchCipher&) = delete;
+
+    /**
+     * @brief Encrypts a batch of messages, each to its own peer.
+     * @param items The peers and plaintext messages.
+     * @returns A vector of the same length as `items`, where each element holds the base64
+     * NIP-44 payload of the corresponding message, or the reason it could not be encrypted.
+     */
+    std::vector<Nip44BatchResult> encrypt(const std::vector<Nip44BatchItem>& items);
+
+    /**
+     * @brief Decrypts a batch of payloads, each from its own peer.
+     * @param items The peers and base64 NIP-44 payloads.
+     * @returns A vector of the same length as `items`, where each element holds the decrypted
+     * message of the corresponding payload, or the reason it could not be decrypted.
+     */
+    std::vector<Nip44BatchResult> decrypt(const std::vector<Nip44BatchItem>& items);
+
+    /**
+     * @brief Returns the number of worker threads used for each batch.
+     */
+    std::size_t workerCount() const;
+
+private:
+    NCSecretKey _localKey;
+
+    std::shared_ptr<ConversationKeyCache> _conversationKeys;
+
+    std::unique_ptr<internal::WorkerPool> _pool; ///< Destroyed first, since the workers read the key and the key cache.
+
+    /**
+     * @brief Runs an operation on every item of a batch, spread across the workers.
+     * @param operation Processes one item with the given worker context, writing its output to
+     * the string it is passed.
+     */
+    std::vector<Nip44BatchResult> _process(
+        const std::vector<Nip44BatchItem>& items,
+        std::function<Nip44BatchError(const NCContext*, const Nip44BatchItem&, std::string&)> operation
+    );
+
+    /**
+     * @brief Looks up the conversation key shared with a peer.
+     * @returns `Nip44BatchError::NONE` if `conversationKey` was filled in.
+     */
+    Nip44BatchError _getConversationKey(
+        const NCContext* context,
+        const std::string& peerPublicKey,
+        uint8_t conversationKey[NC_CONV_KEY_SIZE]
+    );
+};
+} // namespace cryptography
+} // namespace nostr
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include <noscrypt.h>
+
+namespace nostr
+{
+namespace cryptography
+{
+/**
+ * @brief Hands out noscrypt contexts, one per thread.
+ * @remark A noscrypt context must not be used by two threads at once.  Rather than guard a
+ * shared context with a lock, every thread that performs cryptographic work gets its own context
+ * the first time it asks for one, so signing, verification, and encryption scale across cores.
+ * Each context is randomized with its own entropy from `NostrSecureRng`, and is destroyed and
+ * freed when its thread exits.
+ */
+class NoscryptContextPool
+{
+public:
+    /**
+     * @brief Returns the calling thread's noscrypt context, creating it on first use.
+     * @returns The context, or `nullptr` if it could not be allocated or initialized.
+     * @remark The context is owned by the calling thread.  It must not be passed to another
+     * thread, or used after the calling thread exits.
+     */
+    static const NCContext* local();
+
+    /**
+     * @brief Allocates and randomizes a noscrypt context owned by the caller.
+     * @returns The context, or `nullptr` if it could not be allocated or initialized.  The
+     * context is destroyed and freed when its last reference is released.
+     */
+    static std::shared_ptr<NCContext> create();
+
+    /**
+     * @brief Returns the number of contexts created by the pool that have not yet been
+     * destroyed.
+     */
+    static std::size_t liveCount();
+};
+} // namespace cryptography
+} // namespace nostr
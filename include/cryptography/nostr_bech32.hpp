@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <string_view>
+
 #include "bech32.hpp"
 
 #define MAX_RELAYS 10
@@ -99,9 +101,169 @@ typedef struct NostrBech32Encoding
 } NostrBech32Encoding;
 
 
+class NostrBech32;
+
+/**
+ * @brief A decoded NIP-19 entity held in fixed-capacity storage, so that encoding and parsing
+ * never allocate.
+ * @remark Values live in an internal buffer of `payloadCapacity` bytes: a parsed entity keeps
+ * the decoded TLV stream there and points into it, and values set directly are appended to it.
+ * Accessors return pointers and views into that buffer, which stay valid until the entity is
+ * cleared, parsed into again, or destroyed.
+ *
+ * The special value is the event ID for `note` and `nevent`, the public key for `npub` and
+ * `nprofile`, the private key for `nsec`, and the `d` tag for `naddr`.
+ */
+class NostrBech32Entity
+{
+public:
+    ///< The maximum total size of the TLV values an entity can hold.
+    static constexpr std::size_t payloadCapacity = 1024;
+
+    ///< The size of the longest TLV stream an entity can encode to: its values, plus a type and
+    ///< length byte for each TLV and the 4-byte kind.
+    static constexpr std::size_t maxStreamLength = payloadCapacity + 2 * (MAX_RELAYS + 3) + 4;
+
+    ///< The length of the longest string `NostrBech32::encodeEntity` can produce.
+    static constexpr std::size_t maxEncodedLength = Bech32::encodedLength(8, maxStreamLength);
+
+    NostrBech32Entity() = default;
+
+    explicit NostrBech32Entity(NostrBech32Type type) : _type(type) {}
+
+    NostrBech32Type type() const { return _type; }
+
+    /**
+     * @brief Empties the entity and gives it a new type.
+     */
+    void clear(NostrBech32Type type);
+
+    const uint8_t *special() const { return _payload + _special.offset; }
+
+    std::size_t specialLength() const { return _special.length; }
+
+    /**
+     * @brief Returns the special value as text, as used for an naddr's `d` tag.
+     */
+    std::string_view identifier() const
+    {
+        return std::string_view(reinterpret_cast<const char *>(special()), specialLength());
+    }
+
+    bool hasAuthor() const { return _hasAuthor; }
+
+    /**
+     * @brief Returns the 32-byte author public key.  Only meaningful if `hasAuthor()` is true.
+     */
+    const uint8_t *author() const { return _payload + _author.offset; }
+
+    bool hasKind() const { return _hasKind; }
+
+    uint32_t kind() const { return _kind; }
+
+    std::size_t relayCount() const { return _relayCount; }
+
+    std::string_view relay(std::size_t index) const
+    {
+        return std::string_view(reinterpret_cast<const char *>(_payload + _relays[index].offset), _relays[index].length);
+    }
+
+    /**
+     * @brief Sets the special value.  It may only be set once per entity.
+     * @returns False if the value is longer than 255 bytes, or does not fit in the entity.
+     */
+    bool setSpecial(const uint8_t *value, std::size_t length);
+
+    /**
+     * @brief Sets the special value to a string, as used for an naddr's `d` tag.
+     */
+    bool setIdentifier(std::string_view identifier)
+    {
+        return setSpecial(reinterpret_cast<const uint8_t *>(identifier.data()), identifier.size());
+    }
+
+    /**
+     * @brief Sets the 32-byte author public key.
+     * @returns False if the key does not fit in the entity.
+     */
+    bool setAuthor(const uint8_t *pubkey);
+
+    void setKind(uint32_t kind)
+    {
+        _kind = kind;
+        _hasKind = true;
+    }
+
+    /**
+     * @brief Appends a relay URL.
+     * @returns False if the entity already holds MAX_RELAYS relays, the URL is longer than 255
+     * bytes, or it does not fit in the entity.
+     */
+    bool addRelay(std::string_view relay);
+
+private:
+    friend class NostrBech32;
+
+    struct Span
+    {
+        uint16_t offset = 0;
+        uint8_t length = 0;
+    };
+
+    NostrBech32Type _type = NOSTR_BECH32_NPUB;
+
+    uint8_t _payload[payloadCapacity];
+
+    std::size_t _payloadLength = 0;
+
+    Span _special;
+
+    bool _hasSpecial = false;
+
+    Span _author;
+
+    bool _hasAuthor = false;
+
+    uint32_t _kind = 0;
+
+    bool _hasKind = false;
+
+    Span _relays[MAX_RELAYS];
+
+    std::size_t _relayCount = 0;
+
+    bool _append(const uint8_t *value, std::size_t length, Span &span);
+};
+
 class NostrBech32
 {
 public:
+    /**
+     * @brief Encodes an entity as a NIP-19 string into a caller-provided buffer, without
+     * allocating.
+     * @param input The entity to encode.  `nprofile`, `nevent`, `npub`, `note`, and `nsec`
+     * entities need a 32-byte special value; `naddr` entities need an author and a kind.
+     * @param output The buffer that will receive the encoded string.  It is not null-terminated.
+     * @param outputCapacity The size of `output`.  `NostrBech32Entity::maxEncodedLength` is
+     * always enough.
+     * @returns The number of characters written, or 0 if the entity is incomplete or the
+     * encoding does not fit in `output`.
+     */
+    static std::size_t encodeEntity(const NostrBech32Entity &input, char *output, std::size_t outputCapacity);
+
+    /**
+     * @brief Parses a NIP-19 string into a fixed-capacity entity, without allocating.
+     * @param input The encoded string.
+     * @param inputLength The length of the encoded string.
+     * @param parsed The entity that will receive the decoded values.
+     * @returns True if the string was a valid `npub`, `nsec`, `note`, `nprofile`, `nevent`, or
+     * `naddr` with all of its required values.
+     * @remark The TLV stream is walked once, without building an intermediate list.  Unknown TLV
+     * types are skipped, as NIP-19 requires, and relays beyond MAX_RELAYS are ignored.
+     */
+    static bool parseEntity(const char *input, std::size_t inputLength, NostrBech32Entity &parsed);
+
+
     /**
      * @brief Given an input data structure containing pubkeys or event ids,
      * or relays, etc, and a desired encoding type, this function will
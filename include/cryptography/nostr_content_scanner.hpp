@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "nostr_bech32.hpp"
+
+namespace nostr
+{
+namespace encoding
+{
+/**
+ * @brief A NIP-27 entity reference found in note content.
+ * @remark The views point into the scanned content, and are only valid as long as it is.
+ */
+struct NostrContentReference
+{
+    std::string_view uri; ///< The whole reference, starting with "nostr:".
+
+    std::string_view encoding; ///< The Bech32 entity, without the "nostr:" scheme.
+
+    NostrBech32Type type;
+
+    ///< The event ID for `note` and `nevent`, or the public key for `npub` and `nprofile`.  For
+    ///< `naddr`, the author's public key.
+    uint8_t id[KEY_LENGTH];
+
+    bool hasKind; ///< True if the entity carries a kind; always true for `naddr`.
+
+    uint32_t kind;
+
+    /**
+     * @brief Returns `id` as a lowercase hex string, as used in filters.
+     */
+    std::string hexId() const;
+};
+
+/**
+ * @brief Finds and decodes the `nostr:` entity references in note content.
+ * @remark Content is searched for the "nostr:" scheme 16 bytes at a time with SSE2 when the
+ * library is compiled for a CPU that supports it; each candidate is then matched against the
+ * known prefixes and decoded with `NostrBech32::parseEntity`.  The whole scan is a single pass
+ * over the content, and the only allocations are for growing the caller's result vector.
+ *
+ * References to `npub`, `nprofile`, `note`, `nevent`, and `naddr` entities are reported.  An
+ * `nsec` is never decoded, and references that fail to decode are skipped.
+ */
+class NostrContentScanner
+{
+public:
+    /**
+     * @brief Scans content and appends each reference found to `references`.
+     * @param content The content to scan.
+     * @param references The vector that receives the references, in order of appearance.  It is
+     * appended to, so one vector can collect the references from many notes.
+     * @returns The number of references found in `content`.
+     */
+    static std::size_t scan(std::string_view content, std::vector<NostrContentReference>& references);
+
+    /**
+     * @brief Scans content and calls `visit` for each reference found, in order of appearance.
+     * @param visit Receives the reference and the fully decoded entity, including relays and an
+     * naddr's `d` tag.  Both are only valid for the duration of the call.
+     * @returns The number of references found in `content`.
+     */
+    static std::size_t scan(
+        std::string_view content,
+        std::function<void(const NostrContentReference&, const NostrBech32Entity&)> visit
+    );
+
+    /**
+     * @brief Returns the offset of the next "nostr:" scheme at or after `from`, or
+     * `std::string_view::npos` if there is none.
+     */
+    static std::size_t findScheme(std::string_view content, std::size_t from);
+};
+} // namespace encoding
+} // namespace nostr
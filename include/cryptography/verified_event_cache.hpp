@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace nostr
+{
+namespace cryptography
+{
+/**
+ * @brief The binary form of a Nostr event ID: the SHA-256 hash of the serialized event data.
+ */
+using EventId = std::array<uint8_t, 32>;
+
+/**
+ * @brief The binary form of a BIP-340 Schnorr signature.
+ */
+using EventSignature = std::array<uint8_t, 64>;
+
+/**
+ * @brief Hashes an `EventId` for use in unordered containers.
+ * @remark Event IDs are already uniformly distributed, so the first word of the ID is used as
+ * its hash.
+ */
+struct EventIdHash
+{
+    std::size_t operator()(const EventId& id) const noexcept
+    {
+        std::size_t hash;
+        std::memcpy(&hash, id.data(), sizeof(hash));
+        return hash;
+    };
+};
+
+/**
+ * @brief A snapshot of the counters of a `VerifiedEventCache`.
+ */
+struct VerifiedEventCacheStats
+{
+    uint64_t hits; ///< Lookups that found a matching verified event.
+    uint64_t misses; ///< Lookups that did not.
+    std::size_t size; ///< The number of events currently held in the cache.
+};
+
+/**
+ * @brief A bounded, thread-safe record of events whose signatures have already been verified.
+ * @remark The cache is split into shards, each guarded by its own mutex and evicting its least
+ * recently used entries once full, so concurrent lookups from verifier workers rarely contend.
+ * Entries store the signature alongside the ID: an event with a cached ID is only considered
+ * verified if it carries the same signature, and callers must still check that the ID matches
+ * the event's contents.
+ */
+class VerifiedEventCache
+{
+public:
+    /**
+     * @param capacity The maximum number of events held across all shards.  A capacity of 0
+     * disables the cache.
+     * @param shardCount The number of independently locked shards.
+     */
+    VerifiedEventCache(std::size_t capacity = 65536, std::size_t shardCount = 16);
+
+    VerifiedEventCache(const VerifiedEventCache&) = delete;
+
+    VerifiedEventCache& operator=(const VerifiedEventCache&) = delete;
+
+    /**
+     * @brief Checks whether an event with the given ID and signature has been verified.
+     * @returns True if the cache holds the ID with the same signature, false otherwise.
+     * @remark A hit marks the entry as recently used.
+     */
+    bool contains(const EventId& id, const EventSignature& signature);
+
+    /**
+     * @brief Records an event as verified, evicting the least recently used entry in its shard
+     * if the shard is full.
+     */
+    void insert(const EventId& id, const EventSignature& signature);
+
+    /**
+     * @brief Removes all entries from the cache.  The hit and miss counters are kept.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the maximum number of events the cache will hold.
+     */
+    std::size_t capacity() const;
+
+    /**
+     * @brief Returns a snapshot of the cache's counters.
+     */
+    VerifiedEventCacheStats stats() const;
+
+private:
+    using Entry = std::pair<EventId, EventSignature>;
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::list<Entry> entries; ///< Ordered from most to least recently used.
+        std::unordered_map<EventId, std::list<Entry>::iterator, EventIdHash> index;
+    };
+
+    std::size_t _capacity;
+    std::size_t _shardCapacity;
+    std::vector<std::unique_ptr<Shard>> _shards;
+
+    std::atomic<uint64_t> _hits{ 0 };
+    std::atomic<uint64_t> _misses{ 0 };
+
+    /**
+     * @brief Selects the shard responsible for an ID.
+     */
+    Shard& _shardFor(const EventId& id) const;
+};
+} // namespace cryptography
+} // namespace nostr
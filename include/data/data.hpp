@@ -50,6 +50,15 @@ struct Event
      */
     static Event fromJson(nlohmann::json j);
 
+    /**
+     * @brief Computes the SHA-256 digest of the event data from which the event ID is derived.
+     * @param digest A buffer of `SHA256_DIGEST_LENGTH` bytes that will receive the digest.
+     * @remark The digest is taken over a JSON array of the form
+     * `[0,pubkey,created_at,kind,tags,content]`.  It is the message signed by the event's author,
+     * and its hex encoding is the event ID.
+     */
+    void computeDigest(uint8_t digest[SHA256_DIGEST_LENGTH]) const;
+
     /**
      * @brief Compares two events for equality.
      * @remark Two events are considered equal if they have the same ID, since the ID is uniquely
@@ -58,7 +67,6 @@ struct Event
      */
     bool operator==(const Event& other) const;
 
-private:
     /**
      * @brief Validates the event.
      * @throws `std::invalid_argument` if the event object is invalid.
@@ -66,6 +74,7 @@ private:
      */
     void validate();
 
+private:
     /**
      * @brief Generates an ID for the event and assigns it to the event's `id` field.
      * @remark The ID is a 32-bytes lowercase hex-encoded sha256 of the serialized event data.
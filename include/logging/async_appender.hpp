@@ -0,0 +1,249 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <plog/Appenders/IAppender.h>
+#include <plog/Log.h>
+
+namespace nostr
+{
+namespace logging
+{
+/**
+ * @brief A plog appender that writes log lines from a background thread, so that logging never
+ * blocks the thread that logs.
+ * @tparam Formatter A plog formatter, such as `plog::TxtFormatter`.
+ * @remark Each record is formatted on the logging thread, since a record's time and thread ID
+ * cannot be carried over to another thread, and the line is pushed into a fixed-size lock-free
+ * ring buffer.  A single writer thread drains the ring and passes each line to the sink.  When
+ * the ring is full, the line is dropped and counted instead of waiting for space, so a slow sink
+ * costs log lines rather than I/O latency.
+ *
+ * Pass the appender to the SDK's components in place of a synchronous one, for example
+ * `std::make_shared<AsyncAppender<plog::TxtFormatter>>()`.  Lines still in the ring are written
+ * before the appender is destroyed.
+ */
+template <class Formatter>
+class AsyncAppender : public plog::IAppender
+{
+public:
+    ///< Receives each formatted line on the writer thread.
+    typedef std::function<void(const plog::util::nstring&)> Sink;
+
+    /**
+     * @param capacity The number of lines the ring holds, rounded up to a power of two.
+     * @param sink Receives each line, in the order lines were pushed.  Defaults to stdout.
+     */
+    explicit AsyncAppender(std::size_t capacity = 8192, Sink sink = AsyncAppender::writeToStdout)
+        : _sink(std::move(sink))
+    {
+        this->_capacity = 2;
+        while (this->_capacity < capacity)
+        {
+            this->_capacity <<= 1;
+        }
+
+        this->_slots.reset(new Slot[this->_capacity]);
+        for (std::size_t i = 0; i < this->_capacity; i++)
+        {
+            this->_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        this->_writer = std::thread([this]() { this->_drain(); });
+    };
+
+    AsyncAppender(const AsyncAppender&) = delete;
+
+    AsyncAppender& operator=(const AsyncAppender&) = delete;
+
+    ~AsyncAppender() override
+    {
+        this->_isStopping.store(true, std::memory_order_release);
+        this->_wake.notify_one();
+        this->_writer.join();
+    };
+
+    void write(const plog::Record& record) override
+    {
+        if (!this->_tryPush(Formatter::format(record)))
+        {
+            this->_droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // Pairs with the fence in `_drain`, so either the writer sees the new line or this thread
+        // sees that the writer is about to wait.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (this->_isWriterWaiting.load(std::memory_order_relaxed))
+        {
+            this->_wake.notify_one();
+        }
+    };
+
+    /**
+     * @brief Blocks until every line pushed before the call has been passed to the sink.
+     */
+    void flush()
+    {
+        const std::size_t target = this->_enqueuePosition.load(std::memory_order_acquire);
+        while (this->_writtenCount.load(std::memory_order_acquire) < target)
+        {
+            this->_wake.notify_one();
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    };
+
+    /**
+     * @brief Returns the number of lines dropped because the ring was full.
+     */
+    uint64_t droppedCount() const
+    {
+        return this->_droppedCount.load(std::memory_order_relaxed);
+    };
+
+    std::size_t capacity() const
+    {
+        return this->_capacity;
+    };
+
+    static void writeToStdout(const plog::util::nstring& line)
+    {
+        AsyncAppender::_writeLine(line);
+    };
+
+private:
+    struct Slot
+    {
+        std::atomic<std::size_t> sequence;
+        plog::util::nstring line;
+    };
+
+    ///< How long the writer sleeps when the ring is empty, if it misses a wake-up.
+    static constexpr std::chrono::milliseconds idleTimeout{ 10 };
+
+    Sink _sink;
+    std::size_t _capacity;
+    std::unique_ptr<Slot[]> _slots;
+
+    alignas(64) std::atomic<std::size_t> _enqueuePosition{ 0 };
+    alignas(64) std::size_t _dequeuePosition = 0; ///< Only touched by the writer thread.
+    alignas(64) std::atomic<std::size_t> _writtenCount{ 0 };
+
+    std::atomic<uint64_t> _droppedCount{ 0 };
+    std::atomic<bool> _isStopping{ false };
+    std::atomic<bool> _isWriterWaiting{ false };
+    std::mutex _wakeMutex;
+    std::condition_variable _wake;
+
+    std::thread _writer;
+
+    /**
+     * @brief Claims a slot and moves the line into it, as in Vyukov's bounded MPMC queue.
+     * @returns False if the ring is full.
+     */
+    bool _tryPush(plog::util::nstring line)
+    {
+        std::size_t position = this->_enqueuePosition.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot& slot = this->_slots[position & (this->_capacity - 1)];
+            std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t difference =
+                static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+            if (difference == 0)
+            {
+                if (this->_enqueuePosition.compare_exchange_weak(
+                    position,
+                    position + 1,
+                    std::memory_order_relaxed))
+                {
+                    slot.line = std::move(line);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = this->_enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    };
+
+    bool _tryPop(plog::util::nstring& line)
+    {
+        Slot& slot = this->_slots[this->_dequeuePosition & (this->_capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != this->_dequeuePosition + 1)
+        {
+            return false;
+        }
+
+        line = std::move(slot.line);
+        slot.line.clear();
+        slot.sequence.store(this->_dequeuePosition + this->_capacity, std::memory_order_release);
+        this->_dequeuePosition++;
+        return true;
+    };
+
+    void _drain()
+    {
+        plog::util::nstring line;
+        while (true)
+        {
+            while (this->_tryPop(line))
+            {
+                this->_sink(line);
+                this->_writtenCount.fetch_add(1, std::memory_order_release);
+            }
+
+            if (this->_isStopping.load(std::memory_order_acquire))
+            {
+                while (this->_tryPop(line))
+                {
+                    this->_sink(line);
+                    this->_writtenCount.fetch_add(1, std::memory_order_release);
+                }
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock(this->_wakeMutex);
+            this->_isWriterWaiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            Slot& next = this->_slots[this->_dequeuePosition & (this->_capacity - 1)];
+            bool isEmpty = next.sequence.load(std::memory_order_acquire) != this->_dequeuePosition + 1;
+            if (isEmpty && !this->_isStopping.load(std::memory_order_acquire))
+            {
+                this->_wake.wait_for(lock, idleTimeout);
+            }
+            this->_isWriterWaiting.store(false, std::memory_order_relaxed);
+        }
+    };
+
+    static void _writeLine(const std::string& line)
+    {
+        std::fwrite(line.data(), 1, line.size(), stdout);
+    };
+
+    static void _writeLine(const std::wstring& line)
+    {
+        std::wcout << line;
+    };
+};
+} // namespace logging
+} // namespace nostr
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <future>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <vector>
 
@@ -13,9 +17,22 @@
 
 #include "data/data.hpp"
 #include "client/web_socket_client.hpp"
+#include "cryptography/event_verifier.hpp"
+#include "service/service_metrics.hpp"
+#include "service/service_tracer.hpp"
 
 namespace nostr
 {
+namespace internal
+{
+class LifetimeGuard;
+class MessageRouter;
+class MetricsRegistry;
+class RelayRegistry;
+struct RelayMembership;
+typedef uint32_t RelayId;
+} // namespace internal
+
 namespace service
 {
 class INostrServiceBase
@@ -56,6 +73,18 @@ public:
         std::shared_ptr<data::Event> event
     ) = 0;
 
+    /**
+     * @brief Publishes several Nostr events to all open relay connections.
+     * @returns A tuple of `<successes, failures>` for each event, in the order the events were
+     * given, as `publishEvent` returns for a single event.
+     * @remark Each event is serialized once, and every relay is sent the same buffer.  The events
+     * go out back to back, and the relays' OK messages are matched to the events by ID, so the
+     * call waits for one round trip rather than one per event.
+     */
+    virtual std::vector<std::tuple<std::vector<std::string>, std::vector<std::string>>> publishEvents(
+        std::vector<std::shared_ptr<data::Event>> events
+    ) = 0;
+
     /**
      * @brief Queries all open relay connections for events matching the given set of filters, and
      * returns all stored matching events returned by the relays.
@@ -64,7 +93,9 @@ public:
      * from all open relay connections.
      * @remark This method runs until the relays send an EOSE message, indicating they have no more
      * stored events matching the given filters.  When the EOSE message is received, the method
-     * will close the subscription for each relay and return the received events.
+     * will close the subscription for each relay and return the received events.  Relays that send
+     * a CLOSED message instead, or that do not finish within the service's connection timeout,
+     * contribute the events they sent before then.
      * @remark Use this method to fetch a batch of events from the relays.  A `limit` value must be
      * set on the filters in the range 1-64, inclusive.  If no valid limit is given, it will be
      * defaulted to 16.
@@ -80,7 +111,7 @@ public:
      * an event matching the filters.
      * @param eoseHandler A callable object that will be invoked when the relay sends an EOSE
      * message.
-     * @param closeHandler A callable object that will be invoked when the relay sends a CLOSE
+     * @param closeHandler A callable object that will be invoked when the relay sends a CLOSED
      * message.
      * @returns The ID of the subscription created for the query.
      * @remark By providing a response handler, the caller assumes responsibility for handling all
@@ -93,6 +124,23 @@ public:
         std::function<void(const std::string&)> eoseHandler,
         std::function<void(const std::string&, const std::string&)> closeHandler
     ) = 0;
+
+    /**
+     * @brief Queries all open relay connections for events matching the given set of filters,
+     * and reports which relay sent each CLOSED message.
+     * @param closeHandler A callable object that will be invoked with the subscription ID, the
+     * reason, and the URI of the relay when a relay sends a CLOSED message.
+     * @returns The ID of the subscription created for the query.
+     * @remark Otherwise the same as the overload whose close handler omits the relay.  A relay
+     * that closes a subscription only stops serving it itself, so callers that track what each
+     * relay delivers use this overload to tell the relays apart.
+     */
+    virtual std::string queryRelays(
+        std::shared_ptr<data::Filters> filters,
+        std::function<void(const std::string&, std::shared_ptr<data::Event>)> eventHandler,
+        std::function<void(const std::string&)> eoseHandler,
+        std::function<void(const std::string&, const std::string&, const std::string&)> closeHandler
+    ) = 0;
     
     /**
      * @brief Closes the subscription with the given ID on all open relay connections.
@@ -117,6 +165,22 @@ public:
      * @returns A list of any subscription IDs that failed to close.
      */
     virtual std::vector<std::string> closeSubscriptions() = 0;
+
+    /**
+     * @brief Sets whether subscriptions opened after this call verify the ID and signature of
+     * each event they receive.
+     * @param isEnabled True to verify received events, false to pass them through unchecked.
+     * @remark Verification is disabled by default.  Events that fail verification are dropped.
+     * Event handlers of verified subscriptions are invoked on the service's verification
+     * workers rather than on the WebSocket client's thread.
+     */
+    virtual void setEventVerification(bool isEnabled) = 0;
+
+    /**
+     * @brief Enables or disables event verification on an open subscription.
+     * @returns True if the subscription was found, false otherwise.
+     */
+    virtual bool setEventVerification(std::string subscriptionId, bool isEnabled) = 0;
 };
 
 class NostrServiceBase : public INostrServiceBase
@@ -153,7 +217,9 @@ public:
     std::tuple<std::vector<std::string>, std::vector<std::string>> publishEvent(
         std::shared_ptr<data::Event> event) override;
 
-    // TODO: Add a timeout to this method to prevent hanging while waiting for the relay.
+    std::vector<std::tuple<std::vector<std::string>, std::vector<std::string>>> publishEvents(
+        std::vector<std::shared_ptr<data::Event>> events) override;
+
     std::future<std::vector<std::shared_ptr<data::Event>>> queryRelays(
         std::shared_ptr<data::Filters> filters) override;
 
@@ -164,6 +230,13 @@ public:
         std::function<void(const std::string&, const std::string&)> closeHandler
     ) override;
 
+    std::string queryRelays(
+        std::shared_ptr<data::Filters> filters,
+        std::function<void(const std::string&, std::shared_ptr<data::Event>)> eventHandler,
+        std::function<void(const std::string&)> eoseHandler,
+        std::function<void(const std::string&, const std::string&, const std::string&)> closeHandler
+    ) override;
+
     std::tuple<std::vector<std::string>, std::vector<std::string>> closeSubscription(
         std::string subscriptionId
     ) override;
@@ -172,53 +245,160 @@ public:
 
     std::vector<std::string> closeSubscriptions() override;
 
+    void setEventVerification(bool isEnabled) override;
+
+    bool setEventVerification(std::string subscriptionId, bool isEnabled) override;
+
+    /**
+     * @brief Sets how long `openRelayConnections` waits for the connections it opens to complete
+     * their handshakes, how long `publishEvents` waits for relays to accept its events, and how
+     * long `queryRelays` waits for relays to finish sending stored events.
+     * @remark Connections are opened together, so the timeout bounds the whole call rather than
+     * each relay.  Relays that have not connected when it expires are reported as failed, as are
+     * relays that have not accepted an event.  A query returns the events received by then.
+     */
+    void setConnectionTimeout(std::chrono::milliseconds timeout);
+
+    std::chrono::milliseconds connectionTimeout() const;
+
+    /**
+     * @brief Returns the counters of the verifier that checks received events.
+     */
+    cryptography::EventVerifierStats verificationStats() const;
+
+    /**
+     * @brief Returns a snapshot of the service's metrics.
+     * @remark Counters and histograms are updated without locks as messages are sent and
+     * received, so they can be pulled as often as needed, such as on every scrape by a metrics
+     * collector.  Use `ServiceMetricsSnapshot::toPrometheusText` to export them.
+     */
+    ServiceMetricsSnapshot metrics() const;
+
 private:
     ///< The maximum number of events the service will store for each subscription.
     const int MAX_EVENTS_PER_SUBSCRIPTION = 128;
 
+    ///< The number of milliseconds `openRelayConnections` waits for connections to open.
+    std::atomic<int64_t> _connectionTimeout{ 10000 };
+
     ///< The WebSocket client used to communicate with relays.
     std::shared_ptr<client::IWebSocketClient> _client;
 
     ///< A mutex to protect the instance properties.
-    std::mutex _propertyMutex;
+    mutable std::mutex _propertyMutex;
+
+    ///< Assigns each relay URI the integer ID by which the service tracks it.
+    std::shared_ptr<internal::RelayRegistry> _relays;
 
     ///< The default set of Nostr relays to which the service will attempt to connect.
-    std::vector<std::string> _defaultRelays;
+    std::vector<internal::RelayId> _defaultRelays;
 
-    ///< The set of Nostr relays to which the service is currently connected.
-    std::vector<std::string> _activeRelays; 
-    
-    ///< A map from subscription IDs to the relays on which each subscription is open.
-    std::unordered_map<std::string, std::vector<std::string>> _subscriptions;
+    ///< The relays to which the service is connected, and the relays of each open subscription.
+    std::unique_ptr<internal::RelayMembership> _membership;
+
+    ///< Verifies the IDs and signatures of events received on verified subscriptions.
+    std::shared_ptr<cryptography::EventVerifier> _eventVerifier;
+
+    ///< Whether newly opened subscriptions verify the events they receive.
+    std::atomic<bool> _verifyEventsByDefault{ false };
+
+    ///< Verification flags of open subscriptions, shared with each subscription's handlers.
+    std::unordered_map<std::string, std::shared_ptr<std::atomic<bool>>> _subscriptionVerification;
+
+    ///< Per-relay traffic counters and latency histograms.
+    std::shared_ptr<internal::MetricsRegistry> _metrics;
+
+    ///< Routes each relay message to the query or publish it answers.
+    std::shared_ptr<internal::MessageRouter> _router;
+
+    ///< Shared with the handlers given to the client, which may run after the service is gone.
+    std::shared_ptr<internal::LifetimeGuard> _lifetime;
 
-    std::vector<std::string> _getConnectedRelays(std::vector<std::string> relays);
+    /**
+     * @brief Returns the IDs of the given relays, interning any not yet seen, without duplicates.
+     */
+    std::vector<internal::RelayId> _internRelays(const std::vector<std::string>& relays);
+
+    std::vector<internal::RelayId> _getConnectedRelays(const std::vector<internal::RelayId>& relays);
 
-    std::vector<std::string> _getUnconnectedRelays(std::vector<std::string> relays);
+    std::vector<internal::RelayId> _getUnconnectedRelays(const std::vector<internal::RelayId>& relays);
 
-    bool _isConnected(std::string relay);
+    bool _isConnected(internal::RelayId relay);
 
-    void _eraseActiveRelay(std::string relay);
+    void _eraseActiveRelay(internal::RelayId relay);
+
+    /**
+     * @brief Starts opening a connection to the given relay, without waiting for it to open.
+     * @returns A future that becomes true when the connection opens, or false if it fails.
+     */
+    std::future<bool> _connect(internal::RelayId relay);
 
-    void _connect(std::string relay);
+    /**
+     * @brief Waits until each of the given connections opens or fails, or the connection timeout
+     * expires, and marks the relays whose connections opened active.
+     */
+    void _awaitConnections(std::vector<std::tuple<internal::RelayId, std::future<bool>>> pendingConnections);
 
-    void _disconnect(std::string relay);
+    void _onConnected(internal::RelayId relay);
+
+    /**
+     * @brief Marks a relay inactive when its connection closes, and ends the publishes and
+     * queries still waiting on it.
+     */
+    void _onDisconnected(internal::RelayId relay, std::string_view reason);
+
+    void _disconnect(internal::RelayId relay);
+
+    /**
+     * @brief Returns the message handler installed on the given relay's connection with every
+     * request, which counts each message and passes it to the routes registered for it.
+     */
+    client::MessageHandler _routeMessages(internal::RelayId relay);
 
     std::string _generateSubscriptionId();
 
     std::string _generateCloseRequest(std::string subscriptionId);
 
+    /**
+     * @brief Validates the given event, generates its ID, and returns its EVENT message, with the
+     * event embedded as a JSON object per NIP-01.
+     */
+    std::string _generateEventMessage(std::shared_ptr<data::Event> event);
+
     bool _hasSubscription(std::string subscriptionId);
 
-    bool _hasSubscription(std::string subscriptionId, std::string relay);
+    bool _hasSubscription(const std::string& subscriptionId, internal::RelayId relay);
+
+    bool _closeSubscription(const std::string& subscriptionId, internal::RelayId relay);
+
+    /**
+     * @brief Creates the verification flag for a new subscription from the service default.
+     */
+    std::shared_ptr<std::atomic<bool>> _createVerificationFlag(const std::string& subscriptionId);
+
+    /**
+     * @brief Wraps an event handler so events are verified before they reach it whenever the
+     * given verification flag is set.
+     */
+    std::function<void(const std::string&, std::shared_ptr<data::Event>)> _withVerification(
+        std::shared_ptr<std::atomic<bool>> verifyEvents,
+        std::function<void(const std::string&, std::shared_ptr<data::Event>)> eventHandler
+    );
 
     void _onSubscriptionMessage(
-        std::string message,
+        std::string_view message,
         std::function<void(const std::string&, std::shared_ptr<data::Event>)> eventHandler,
         std::function<void(const std::string&)> eoseHandler,
         std::function<void(const std::string&, const std::string&)> closeHandler
     );
 
-    void _onAcceptance(std::string message, std::function<void(const bool)> acceptanceHandler);
+    /**
+     * @brief Passes the event ID and verdict of an OK message to the given handler.
+     */
+    void _onAcceptance(
+        std::string_view message,
+        std::function<void(const std::string&, const bool)> acceptanceHandler
+    );
 };
 } // namespace service
 } // namespace nostr
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cryptography/event_verifier.hpp"
+
+namespace nostr
+{
+namespace service
+{
+/**
+ * @brief A summary of a latency histogram.  All durations are in nanoseconds.
+ * @remark Percentiles are reported as the upper bound of the histogram bucket that holds them,
+ * so they overstate the true value by at most 1/32 of it.
+ */
+struct LatencySummary
+{
+    uint64_t count; ///< The number of recorded durations.
+    uint64_t sum; ///< The total of all recorded durations.
+    uint64_t min;
+    uint64_t max;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+};
+
+/**
+ * @brief Traffic and latency counters of one relay.
+ */
+struct RelayMetricsSnapshot
+{
+    std::string relay; ///< The relay URI.
+    uint64_t messagesIn; ///< Messages received from the relay.
+    uint64_t messagesOut; ///< Messages successfully handed to the WebSocket client for the relay.
+    uint64_t bytesIn; ///< Payload bytes received from the relay.
+    uint64_t bytesOut; ///< Payload bytes handed to the WebSocket client for the relay.
+    uint64_t connects; ///< Successful connections, including the first.
+    uint64_t reconnects; ///< Successful connections after the first.
+    uint64_t connectFailures; ///< Connection attempts that failed.
+    uint64_t outboundQueueDepth; ///< Messages the WebSocket client has queued for the relay and not yet written.
+    LatencySummary eoseLatency; ///< Time from sending a REQ to receiving its EOSE.
+    LatencySummary okLatency; ///< Time from sending an EVENT to receiving its OK.
+};
+
+/**
+ * @brief A point-in-time view of a service's metrics, as returned by `NostrServiceBase::metrics`.
+ * @remark Counters are cumulative over the life of the service.  Values are read without
+ * stopping the service, so counters of different relays may be a few messages apart in time.
+ */
+struct ServiceMetricsSnapshot
+{
+    std::vector<RelayMetricsSnapshot> relays; ///< Every relay the service has tried to connect to.
+    LatencySummary parseTime; ///< Time spent decoding each received EVENT message, including the event.
+    uint64_t activeRelays; ///< Relays the service is currently connected to.
+    uint64_t activeSubscriptions; ///< Subscriptions open on at least one relay.
+    cryptography::EventVerifierStats verification; ///< Includes the verification queue depth.
+
+    /**
+     * @brief Formats the snapshot in the Prometheus text exposition format.
+     * @remark Latencies are exported as summaries in seconds, and relay counters are labeled with
+     * the relay URI.
+     */
+    std::string toPrometheusText() const;
+};
+} // namespace service
+} // namespace nostr
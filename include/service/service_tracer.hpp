@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace nostr
+{
+namespace service
+{
+/**
+ * @brief Controls the recording of tracing spans around the service's hot paths, and exports
+ * them as Chrome trace-event JSON.
+ * @remark When tracing is enabled, `NostrServiceBase` records a span for each relay connection,
+ * each call to the WebSocket client's `send`, each frame received from a relay, and, within a
+ * frame, the handling of the subscription message, the decoding of its event, and the call into
+ * the caller's handler.  Set side by side on a timeline, these show whether a slow query is
+ * spent connecting, sending, waiting on the relay, parsing, or in the caller's own code.
+ *
+ * Each thread records spans into its own buffer, so recording takes no shared locks.  Tracing is
+ * process-wide and disabled by default; while disabled, each span costs a single atomic load.
+ *
+ * Open the file written by `writeChromeTrace` in Perfetto (ui.perfetto.dev) or `chrome://tracing`.
+ */
+class ServiceTracer
+{
+public:
+    ///< The default number of spans each thread keeps before further spans are dropped.
+    static constexpr std::size_t defaultSpansPerThread = 65536;
+
+    /**
+     * @brief Starts recording spans.
+     * @param spansPerThread The number of spans each thread keeps.  Once a thread's buffer is
+     * full, its further spans are dropped and counted until the trace is cleared.
+     */
+    static void enable(std::size_t spansPerThread = defaultSpansPerThread);
+
+    /**
+     * @brief Stops recording spans.  Spans already recorded are kept until the trace is cleared.
+     */
+    static void disable();
+
+    static bool isEnabled();
+
+    /**
+     * @brief Discards all recorded spans, and resets the dropped span count.
+     */
+    static void clear();
+
+    /**
+     * @brief Returns the number of spans dropped because a thread's buffer was full.
+     */
+    static uint64_t droppedCount();
+
+    /**
+     * @brief Returns the recorded spans as a Chrome trace-event JSON document.
+     * @remark Spans are "complete" events with timestamps in microseconds from the first use of
+     * the tracer.  The relay a span concerns, if any, is given in its `args`.
+     */
+    static std::string toChromeTraceJson();
+
+    /**
+     * @brief Writes the recorded spans to the given file as Chrome trace-event JSON.
+     * @returns True if the file was written, false otherwise.
+     */
+    static bool writeChromeTrace(const std::string& path);
+};
+} // namespace service
+} // namespace nostr
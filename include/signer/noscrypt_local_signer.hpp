@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <plog/Init.h>
+#include <plog/Log.h>
+#include <noscrypt.h>
+
+#include "signer/signer.hpp"
+
+namespace nostr
+{
+namespace internal
+{
+class WorkerPool;
+} // namespace internal
+
+namespace signer
+{
+/**
+ * @brief Signs Nostr events in-process with a secret key held by the signer.
+ * @remark Unlike `NoscryptSigner`, no messages are exchanged with a remote signer, so signing
+ * completes before `sign` returns.  This signer is intended for service accounts whose keys are
+ * held by the application.
+ */
+class NoscryptLocalSigner : public ISigner
+{
+public:
+    /**
+     * @param appender The plog appender used for logging.
+     * @param secretKey The secret key with which events will be signed.  The signer keeps its
+     * own copy of the key and zeroes it on destruction.
+     * @param workerCount The number of worker threads used by `signEvents`.  With a value of 1,
+     * batches are signed on the calling thread.  A value of 0 starts one worker per hardware
+     * thread.
+     * @throws `std::invalid_argument` if the secret key is not a valid secp256k1 secret key.
+     */
+    NoscryptLocalSigner(
+        std::shared_ptr<plog::IAppender> appender,
+        const NCSecretKey& secretKey,
+        std::size_t workerCount = 1
+    );
+
+    ~NoscryptLocalSigner();
+
+    NoscryptLocalSigner(const NoscryptLocalSigner&) = delete;
+
+    NoscryptLocalSigner& operator=(const NoscryptLocalSigner&) = delete;
+
+    /**
+     * @brief Signs the given Nostr event.
+     * @param event The event to sign.  If its `pubkey` field is empty, it is set to the signer's
+     * public key; otherwise it must match the signer's public key.
+     * @returns A promise that has already been fulfilled with `true` if the signing succeeded,
+     * and `false` if it failed.
+     * @remark The event's `id` and `sig` fields are updated in-place.
+     */
+    std::shared_ptr<std::promise<bool>> sign(std::shared_ptr<data::Event> event) override;
+
+    /**
+     * @brief Signs a batch of events, spreading the work across the signer's workers.
+     * @param events The events to sign.  Each event is treated as in `sign`.
+     * @returns A vector of the same length as `events`, where each element indicates whether
+     * the corresponding event was signed.
+     */
+    std::vector<bool> signEvents(const std::vector<std::shared_ptr<data::Event>>& events);
+
+    /**
+     * @brief Returns the signer's public key as a lowercase hex string.
+     */
+    std::string publicKey() const;
+
+private:
+    NCSecretKey _secretKey;
+    NCPublicKey _publicKey;
+    std::string _publicKeyHex;
+
+    std::unique_ptr<internal::WorkerPool> _pool; ///< Only created when more than one worker is requested.
+
+    /**
+     * @brief Computes the ID of an event and signs it with the calling thread's noscrypt context.
+     * @returns True if the event was signed, false otherwise.
+     */
+    bool _signEvent(data::Event& event) const;
+};
+} // namespace signer
+} // namespace nostr
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
 #include <plog/Init.h>
 #include <plog/Log.h>
 #include <noscrypt.h>
@@ -9,6 +14,11 @@
 
 namespace nostr
 {
+namespace cryptography
+{
+class ConversationKeyCache;
+} // namespace cryptography
+
 namespace signer
 {
 class NoscryptSigner : public INostrConnectSigner
@@ -31,16 +41,15 @@ public:
         std::optional<std::string> description
     ) override;
 
-    std::promise<bool> ping() override;
+    std::shared_ptr<std::promise<bool>> ping() override;
 
     std::shared_ptr<std::promise<bool>> sign(std::shared_ptr<data::Event> event) override;
 
 private:
     static constexpr int _nostrConnectKind = 24133; // Kind 24133 is reserved for NIP-46 events.
 
-    Encryption _nostrConnectEncryption;
+    Encryption _nostrConnectEncryption = Encryption::NIP44;
 
-    std::shared_ptr<NCContext> _noscryptContext;
     std::shared_ptr<nostr::service::INostrServiceBase> _nostrService;
 
     ///< Local nsec for communicating with the remote signer.
@@ -52,12 +61,50 @@ private:
     ///< The npub on whose behalf the remote signer is acting.
     std::shared_ptr<NCPublicKey> _remotePublicKey;
 
+    ///< NIP-44 conversation keys derived from the local keypair, reused across messages.
+    std::shared_ptr<nostr::cryptography::ConversationKeyCache> _conversationKeys;
+
     ///< An optional secret value provided by the remote signer.
     std::string _bunkerSecret;
 
     ///< A list of relays that will be used to connect to the remote signer.
     std::vector<std::string> _relays;
 
+    ///< Serializes attempts to open the response subscription.
+    std::mutex _responseSubscriptionMutex;
+
+    ///< The ID of the long-lived subscription on which the remote signer's responses arrive.
+    std::string _responseSubscriptionId;
+
+    ///< Whether the response subscription is open.  Guarded by `_pendingRequestMutex`.
+    bool _isResponseSubscriptionOpen = false;
+
+    ///< The relays that have closed the response subscription.  Guarded by `_pendingRequestMutex`.
+    std::unordered_set<std::string> _closedResponseRelays;
+
+    /**
+     * @brief A request awaiting a response from the remote signer.
+     */
+    struct PendingRequest
+    {
+        std::function<void(const nlohmann::json&)> responseHandler;
+
+        ///< The relays that accepted the request and on which the response subscription is open.
+        std::unordered_set<std::string> relays;
+
+        ///< Whether the request has been published, and so whether `relays` is known.
+        bool isPublished = false;
+    };
+
+    ///< Requests awaiting a response from the remote signer, keyed by request ID.
+    std::unordered_map<std::string, PendingRequest> _pendingRequests;
+
+    ///< A mutex to protect the pending request map.
+    std::mutex _pendingRequestMutex;
+
+    ///< Shared with the handlers given to the service, which may run after the signer is gone.
+    std::shared_ptr<internal::LifetimeGuard> _lifetime;
+
     #pragma region Private Accessors
 
     inline std::string _getLocalPrivateKey() const;
@@ -100,7 +147,7 @@ private:
 
     /**
      * @brief Generates a unique ID for a signer request.
-     * @returns A GUID string.
+     * @returns A short, URL-safe ID string.
      */
     inline std::string _generateSignerRequestId() const;
 
@@ -127,6 +174,58 @@ private:
      */
     inline std::shared_ptr<nostr::data::Filters> _buildSignerMessageFilters() const;
 
+    /**
+     * @brief Opens the subscription on which all responses from the remote signer are received,
+     * if it is not already open.
+     * @returns True if the subscription is open, false if it could not be opened.
+     */
+    bool _openResponseSubscription();
+
+    /**
+     * @brief Sends a request to the remote signer and registers a handler for its response.
+     * @param jrpc The JRPC-like request payload.  It must contain a unique `id` field.
+     * @param responseHandler A callable object that will be invoked with the JRPC-like response
+     * payload, or with a payload containing only an `error` field if the request could not be
+     * completed.
+     * @remark Any number of requests may be in flight at once.  Responses are matched to their
+     * requests by ID.
+     */
+    void _sendSignerRequest(
+        nlohmann::json jrpc,
+        std::function<void(const nlohmann::json&)> responseHandler
+    );
+
+    /**
+     * @brief Unwraps a message received on the response subscription and dispatches it to the
+     * handler of the matching pending request.
+     */
+    void _handleSignerResponse(std::shared_ptr<nostr::data::Event> event);
+
+    /**
+     * @brief Fails the pending requests that can no longer receive a response because the given
+     * relay closed the response subscription.
+     * @remark Requests that were also accepted by relays still serving the subscription remain
+     * pending.
+     */
+    void _onResponseSubscriptionClosed(
+        const std::string& subscriptionId,
+        const std::string& relay,
+        const std::string& reason
+    );
+
+    /**
+     * @brief Marks the response subscription for reopening if some relay has closed it and no
+     * request is waiting on the relays that have not.
+     * @remark The caller must hold `_pendingRequestMutex`.
+     */
+    void _retireResponseSubscriptionIfIdle();
+
+    /**
+     * @brief Fails all pending requests, typically because the signer is being destroyed.
+     * @param reason A description of the failure that is passed to each request's handler.
+     */
+    void _failPendingRequests(const std::string& reason);
+
     #pragma endregion
 
     #pragma region Cryptography
@@ -152,7 +251,7 @@ private:
      * @return The resulting encrypted string, or an empty string if the input could not be
      * encrypted.
      */
-    std::string _encryptNip44(const std::string input); // TODO: Return or set HMAC?
+    std::string _encryptNip44(const std::string input);
 
     /**
      * @brief Decrypts a NIP-44 encrypted string.
@@ -81,7 +81,7 @@ public:
      * @returns A promise that will be fulfilled with `true` if the remote signer is connected, and
      * `false` otherwise.
      */
-    virtual std::promise<bool> ping() = 0;
+    virtual std::shared_ptr<std::promise<bool>> ping() = 0;
 };
 } // namespace signer
 } // namespace nostr
@@ -1,114 +1,387 @@
 #include <mutex>
+#include <thread>
 
 #include "client/websocketpp_client.hpp"
+#include "../internal/logging.hpp"
+#include "../internal/mpsc_queue.hpp"
 
 using namespace nostr::client;
 using namespace std;
 
+/**
+ * @brief The state of one connection, shared between senders and the I/O thread.
+ */
+struct WebsocketppClient::Connection
+{
+    string uri;
+    websocketpp_client::connection_ptr connection;
+
+    ///< Set by the I/O thread once the opening handshake completes.
+    atomic<bool> isOpen{ false };
+
+    ///< Messages accepted by `send` and not yet handed to WebSocket++.
+    nostr::internal::MpscQueue<SharedPayload> sendQueue;
+
+    ///< The number of messages in the send queue.
+    atomic<size_t> queuedCount{ 0 };
+
+    ///< Whether a drain of the send queue is already scheduled on the I/O thread.
+    atomic<bool> isFlushScheduled{ false };
+
+    ///< Whether the queue has reached the high-water mark and not yet drained to the low one.
+    atomic<bool> isCongested{ false };
+
+    ///< Guards the message handler, which `receive` replaces on the caller's thread while the I/O
+    ///< thread reads it.
+    mutex handlerMutex;
+
+    ///< The handler of messages from the server, shared so the I/O thread can hold it unlocked.
+    shared_ptr<const MessageHandler> messageHandler;
+};
+
 void WebsocketppClient::start()
 {
+    // Per-frame access logging would otherwise write every message to stdout.
+    this->_client.clear_access_channels(websocketpp::log::alevel::all);
+
     this->_client.init_asio();
     this->_client.start_perpetual();
+
+    // Connects, sends, and message handlers are all serviced by this loop.
+    this->_ioThread = thread([this]() { this->_client.run(); });
 };
 
 void WebsocketppClient::stop()
 {
     this->_client.stop_perpetual();
     this->_client.stop();
+
+    if (this->_ioThread.joinable())
+    {
+        this->_ioThread.join();
+    }
 };
 
-void WebsocketppClient::openConnection(string uri)
+void WebsocketppClient::openConnection(string_view uri)
 {
+    this->openConnection(uri, nullptr, nullptr, nullptr);
+};
+
+future<bool> WebsocketppClient::openConnection(
+    string_view uri,
+    function<void()> openHandler,
+    function<void(string_view)> failHandler,
+    function<void(string_view)> closeHandler
+)
+{
+    auto openPromise = make_shared<promise<bool>>();
+    future<bool> isOpen = openPromise->get_future();
+
     error_code error;
-    websocketpp_client::connection_ptr connection = this->_client.get_connection(uri, error);
+    websocketpp_client::connection_ptr connection = this->_client.get_connection(string(uri), error);
 
-    if (error.value() == -1)
+    if (error)
     {
-        // PLOG_ERROR << "Error connecting to relay " << relay << ": " << error.message();
+        if (failHandler)
+        {
+            failHandler(error.message());
+        }
+        openPromise->set_value(false);
+        return isOpen;
     }
 
-    // Configure the connection here via the connection pointer.
-    connection->set_fail_handler([this, uri](auto handle) {
-        // PLOG_ERROR << "Error connecting to relay " << relay << ": Handshake failed.";
-        lock_guard<mutex> lock(this->_propertyMutex);
-        if (this->isConnected(uri))
+    auto entry = make_shared<Connection>();
+    entry->uri = uri;
+    entry->connection = connection;
+
+    // Each handler runs on the I/O thread.  The handlers hold the entry weakly, since the entry
+    // holds the connection that holds them.
+    weak_ptr<Connection> weakEntry = entry;
+    connection->set_open_handler([this, weakEntry, openHandler, openPromise](websocketpp::connection_hdl)
+    {
+        if (auto entry = weakEntry.lock())
+        {
+            entry->isOpen = true;
+            this->_flush(entry);
+        }
+
+        if (openHandler)
         {
-            this->_connectionHandles.erase(uri);
+            openHandler();
         }
+        openPromise->set_value(true);
     });
 
-    lock_guard<mutex> lock(this->_propertyMutex);
-    this->_connectionHandles[uri] = connection->get_handle();
+    connection->set_fail_handler([this, weakEntry, failHandler, openPromise](websocketpp::connection_hdl)
+    {
+        string reason = "Handshake failed.";
+        if (auto entry = weakEntry.lock())
+        {
+            error_code connectionError = entry->connection->get_ec();
+            if (connectionError)
+            {
+                reason = connectionError.message();
+            }
+            this->_eraseConnection(entry);
+        }
+
+        if (failHandler)
+        {
+            failHandler(reason);
+        }
+        openPromise->set_value(false);
+    });
+
+    // Setting a WebSocket++ handler is not synchronized with the I/O thread, so one handler is set
+    // before the connection starts, and passes each message to whichever one `receive` stored.
+    connection->set_message_handler([weakEntry](
+        websocketpp::connection_hdl,
+        websocketpp_client::message_ptr message)
+    {
+        auto entry = weakEntry.lock();
+        if (entry == nullptr)
+        {
+            return;
+        }
+
+        shared_ptr<const MessageHandler> messageHandler;
+        {
+            lock_guard<mutex> lock(entry->handlerMutex);
+            messageHandler = entry->messageHandler;
+        }
+
+        if (!messageHandler || !*messageHandler)
+        {
+            return;
+        }
+
+        // An exception leaving the handler would unwind the I/O loop and end the process, so a
+        // message the handler cannot handle is dropped instead.
+        try
+        {
+            (*messageHandler)(string_view(message->get_payload()));
+        }
+        catch (const exception& e)
+        {
+            PLOG_WARNING << "Message handler failed on a message from " << entry->uri << ": " << e.what();
+        }
+    });
+
+    connection->set_close_handler([this, weakEntry, closeHandler](websocketpp::connection_hdl)
+    {
+        string reason;
+        if (auto entry = weakEntry.lock())
+        {
+            reason = entry->connection->get_remote_close_reason();
+            this->_eraseConnection(entry);
+        }
+
+        if (closeHandler)
+        {
+            closeHandler(reason);
+        }
+    });
+
+    // A replaced entry is erased first, since its key is a view of its own URI.
+    unique_lock<shared_mutex> lock(this->_connectionMutex);
+    this->_connections.erase(uri);
+    this->_connections.emplace(entry->uri, entry);
+    lock.unlock();
+
     this->_client.connect(connection);
+
+    return isOpen;
 };
 
-bool WebsocketppClient::isConnected(string uri)
+bool WebsocketppClient::isConnected(string_view uri)
 {
-    lock_guard<mutex> lock(this->_propertyMutex);
-    return this->_connectionHandles.find(uri) != this->_connectionHandles.end();
+    auto connection = this->_findConnection(uri);
+    return connection != nullptr && connection->isOpen;
 };
 
-tuple<string, bool> WebsocketppClient::send(string message, string uri)
+bool WebsocketppClient::send(SharedPayload message, string_view uri)
 {
-    error_code error;
+    auto connection = this->_findConnection(uri);
+    if (connection == nullptr)
+    {
+        return false;
+    }
 
-    // Make sure the connection isn't closed from under us.
-    lock_guard<mutex> lock(this->_propertyMutex);
-    this->_client.send(
-        this->_connectionHandles[uri],
-        message,
-        websocketpp::frame::opcode::text,
-        error);
+    // The slot is claimed before the message is pushed, so the queue never exceeds the mark.
+    size_t queuedCount = connection->queuedCount.fetch_add(1);
+    if (queuedCount >= this->_highWaterMark.load(memory_order_relaxed))
+    {
+        connection->queuedCount.fetch_sub(1);
+        if (!connection->isCongested.exchange(true))
+        {
+            this->_signalBackpressure(uri, true);
+        }
+        return false;
+    }
+
+    connection->sendQueue.push(move(message));
 
-    if (error.value() == -1)
+    // Until the connection opens, messages wait in the queue, and the open handler drains it.
+    if (connection->isOpen)
     {
-        return make_tuple(uri, false);
+        this->_scheduleFlush(connection);
     }
 
-    return make_tuple(uri, true);
+    return true;
 };
 
-tuple<string, bool> WebsocketppClient::send(
-    string message,
-    string uri,
-    function<void(const string&)> messageHandler
-)
+bool WebsocketppClient::send(SharedPayload message, string_view uri, MessageHandler messageHandler)
 {
-    auto successes = this->send(message, uri);
-    this->receive(uri, messageHandler);
-    return successes;
+    // The handler is attached first, so that no response can arrive before it.
+    this->receive(uri, move(messageHandler));
+    return this->send(move(message), uri);
 };
 
-void WebsocketppClient::receive(
-    string uri,
-    function<void(const string&)> messageHandler
-)
+void WebsocketppClient::receive(string_view uri, MessageHandler messageHandler)
+{
+    auto connection = this->_findConnection(uri);
+    if (connection == nullptr)
+    {
+        return;
+    }
+
+    auto handler = make_shared<const MessageHandler>(move(messageHandler));
+    lock_guard<mutex> lock(connection->handlerMutex);
+    connection->messageHandler = move(handler);
+};
+
+void WebsocketppClient::closeConnection(string_view uri)
+{
+    unique_lock<shared_mutex> lock(this->_connectionMutex);
+    auto it = this->_connections.find(uri);
+    if (it == this->_connections.end())
+    {
+        return;
+    }
+
+    auto connection = it->second;
+    this->_connections.erase(it);
+    lock.unlock();
+
+    // Messages accepted before the close still go out, ahead of the close frame.
+    this->_client.set_timer(0, [this, connection](const websocketpp::lib::error_code&)
+    {
+        this->_flush(connection);
+
+        error_code error;
+        connection->connection->close(
+            websocketpp::close::status::going_away,
+            "_client requested close.",
+            error
+        );
+    });
+};
+
+size_t WebsocketppClient::queuedMessageCount(string_view uri)
+{
+    auto connection = this->_findConnection(uri);
+    return connection == nullptr ? 0 : connection->queuedCount.load(memory_order_relaxed);
+};
+
+size_t WebsocketppClient::droppedMessageCount() const
+{
+    return this->_droppedCount.load(memory_order_relaxed);
+};
+
+void WebsocketppClient::setSendQueueLimits(size_t highWaterMark, size_t lowWaterMark)
+{
+    this->_highWaterMark = highWaterMark;
+    this->_lowWaterMark = lowWaterMark;
+};
+
+void WebsocketppClient::setBackpressureHandler(function<void(string_view, bool)> backpressureHandler)
+{
+    lock_guard<mutex> lock(this->_backpressureMutex);
+    this->_backpressureHandler = backpressureHandler;
+};
+
+shared_ptr<WebsocketppClient::Connection> WebsocketppClient::_findConnection(string_view uri)
+{
+    shared_lock<shared_mutex> lock(this->_connectionMutex);
+    auto it = this->_connections.find(uri);
+    return it == this->_connections.end() ? nullptr : it->second;
+};
+
+bool WebsocketppClient::_eraseConnection(const shared_ptr<Connection>& connection)
+{
+    unique_lock<shared_mutex> lock(this->_connectionMutex);
+    auto it = this->_connections.find(connection->uri);
+    if (it == this->_connections.end() || it->second != connection)
+    {
+        return false;
+    }
+
+    this->_connections.erase(it);
+    return true;
+};
+
+void WebsocketppClient::_scheduleFlush(const shared_ptr<Connection>& connection)
+{
+    if (connection->isFlushScheduled.exchange(true))
+    {
+        return;
+    }
+
+    this->_client.set_timer(0, [this, connection](const websocketpp::lib::error_code&)
+    {
+        this->_flush(connection);
+    });
+};
+
+void WebsocketppClient::_flush(const shared_ptr<Connection>& connection)
 {
-    lock_guard<mutex> lock(this->_propertyMutex);
-    auto connectionHandle = this->_connectionHandles[uri];
-    auto connection = this->_client.get_con_from_hdl(connectionHandle);
+    // Cleared before draining, so a message pushed during the drain schedules another one.
+    connection->isFlushScheduled = false;
 
-    connection->set_message_handler(
-        [messageHandler](
-            websocketpp::connection_hdl connectionHandle,
-            websocketpp_client::message_ptr message
-        )
+    // WebSocket++ queues each message behind any write in progress, and writes everything queued
+    // in one gathered write when that write completes, so handing over the whole batch at once
+    // lets it leave in one or two writes rather than one per message.
+    size_t droppedCount = 0;
+    error_code firstError;
+    size_t sentCount = connection->sendQueue.drain([&connection, &droppedCount, &firstError](SharedPayload&& message)
+    {
+        error_code error = connection->connection->send(*message, websocketpp::frame::opcode::text);
+        if (error)
         {
-            messageHandler(message->get_payload());
+            if (droppedCount++ == 0)
+            {
+                firstError = error;
+            }
         }
-    );
+    });
+    size_t queuedCount = connection->queuedCount.fetch_sub(sentCount) - sentCount;
+
+    // A connection that fails mid-drain fails every later send the same way, so one warning
+    // covers the drain.
+    if (droppedCount > 0)
+    {
+        this->_droppedCount.fetch_add(droppedCount, memory_order_relaxed);
+        PLOG_WARNING << "Dropped " << droppedCount << "/" << sentCount << " messages to " << connection->uri << ": " << firstError.message();
+    }
+
+    if (connection->isCongested
+        && queuedCount <= this->_lowWaterMark.load(memory_order_relaxed)
+        && connection->isCongested.exchange(false))
+    {
+        this->_signalBackpressure(connection->uri, false);
+    }
 };
 
-void WebsocketppClient::closeConnection(string uri)
+void WebsocketppClient::_signalBackpressure(string_view uri, bool isCongested)
 {
-    lock_guard<mutex> lock(this->_propertyMutex);
-
-    websocketpp::connection_hdl handle = this->_connectionHandles[uri];
-    this->_client.close(
-        handle,
-        websocketpp::close::status::going_away,
-        "_client requested close."
-    );
+    function<void(string_view, bool)> backpressureHandler;
+    {
+        lock_guard<mutex> lock(this->_backpressureMutex);
+        backpressureHandler = this->_backpressureHandler;
+    }
 
-    this->_connectionHandles.erase(uri);
+    if (backpressureHandler)
+    {
+        backpressureHandler(uri, isCongested);
+    }
 };
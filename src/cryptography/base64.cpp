@@ -0,0 +1,551 @@
+#include <array>
+#include <cstring>
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "cryptography/base64.hpp"
+
+using namespace std;
+using namespace nostr::encoding;
+
+static const char base64Alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+///< Marks characters that are not in the base64 alphabet.  Valid values never set the top two bits.
+static constexpr uint8_t invalidBase64Value = 0xFF;
+
+static constexpr array<uint8_t, 256> makeBase64DecodeTable()
+{
+    array<uint8_t, 256> table{};
+    for (size_t i = 0; i < table.size(); i++)
+    {
+        table[i] = invalidBase64Value;
+    }
+    for (uint8_t i = 0; i < 64; i++)
+    {
+        table[static_cast<uint8_t>(base64Alphabet[i])] = i;
+    }
+
+    return table;
+};
+
+static constexpr array<uint8_t, 256> base64DecodeTable = makeBase64DecodeTable();
+
+#pragma region SIMD Blocks
+
+#if defined(__SSSE3__)
+/**
+ * @brief Maps 6-bit indices held in each byte to their base64 characters.
+ * @remark Each index is reduced to a small class number, which selects the offset that takes the
+ * index to its character from a 16-entry table.
+ */
+static inline __m128i translateIndicesSsse3(__m128i indices)
+{
+    const __m128i offsets = _mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+        '/' - 63, 'A', 0, 0);
+
+    __m128i classes = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    const __m128i isUpper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    classes = _mm_or_si128(classes, _mm_and_si128(isUpper, _mm_set1_epi8(13)));
+
+    return _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, classes));
+};
+
+/**
+ * @brief Encodes 12 bytes into 16 characters.
+ * @remark 16 bytes are read from `input`.
+ */
+static inline void encodeBlockSsse3(const uint8_t* input, char* output)
+{
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+
+    // Spread each 3-byte group over a 32-bit lane as [b1, b0, b2, b1], then shift each 6-bit
+    // field into its own byte.
+    bytes = _mm_shuffle_epi8(bytes, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    const __m128i high = _mm_mulhi_epu16(
+        _mm_and_si128(bytes, _mm_set1_epi32(0x0fc0fc00)),
+        _mm_set1_epi32(0x04000040));
+    const __m128i low = _mm_mullo_epi16(
+        _mm_and_si128(bytes, _mm_set1_epi32(0x003f03f0)),
+        _mm_set1_epi32(0x01000010));
+
+    const __m128i characters = translateIndicesSsse3(_mm_or_si128(high, low));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output), characters);
+};
+
+/**
+ * @brief Decodes 16 characters into 12 bytes.
+ * @remark 16 bytes are written to `output`; the last four are scratch.
+ * @returns False if any character is outside the base64 alphabet.
+ */
+static inline bool decodeBlockSsse3(const char* input, uint8_t* output)
+{
+    const __m128i characters = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+
+    // Signed comparisons treat bytes above 0x7F as negative, so they fall in no range.
+    const __m128i isUpper = _mm_and_si128(
+        _mm_cmpgt_epi8(characters, _mm_set1_epi8('A' - 1)),
+        _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), characters));
+    const __m128i isLower = _mm_and_si128(
+        _mm_cmpgt_epi8(characters, _mm_set1_epi8('a' - 1)),
+        _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), characters));
+    const __m128i isDigit = _mm_and_si128(
+        _mm_cmpgt_epi8(characters, _mm_set1_epi8('0' - 1)),
+        _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), characters));
+    const __m128i isPlus = _mm_cmpeq_epi8(characters, _mm_set1_epi8('+'));
+    const __m128i isSlash = _mm_cmpeq_epi8(characters, _mm_set1_epi8('/'));
+
+    const __m128i isValid = _mm_or_si128(
+        _mm_or_si128(isUpper, isLower),
+        _mm_or_si128(isDigit, _mm_or_si128(isPlus, isSlash)));
+    if (_mm_movemask_epi8(isValid) != 0xFFFF)
+    {
+        return false;
+    }
+
+    __m128i shift = _mm_and_si128(isUpper, _mm_set1_epi8(-'A'));
+    shift = _mm_or_si128(shift, _mm_and_si128(isLower, _mm_set1_epi8(26 - 'a')));
+    shift = _mm_or_si128(shift, _mm_and_si128(isDigit, _mm_set1_epi8(52 - '0')));
+    shift = _mm_or_si128(shift, _mm_and_si128(isPlus, _mm_set1_epi8(62 - '+')));
+    shift = _mm_or_si128(shift, _mm_and_si128(isSlash, _mm_set1_epi8(63 - '/')));
+    const __m128i indices = _mm_add_epi8(characters, shift);
+
+    // Merge pairs of 6-bit indices into 12-bit words, then pairs of words into 24-bit groups,
+    // and gather the three bytes of each group in big-endian order.
+    const __m128i words = _mm_maddubs_epi16(indices, _mm_set1_epi32(0x01400140));
+    const __m128i groups = _mm_madd_epi16(words, _mm_set1_epi32(0x00011000));
+    const __m128i bytes = _mm_shuffle_epi8(
+        groups,
+        _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output), bytes);
+    return true;
+};
+#endif
+
+#if defined(__AVX2__)
+/**
+ * @brief Encodes 24 bytes into 32 characters.
+ * @remark 28 bytes are read from `input`.  Each 128-bit lane encodes 12 bytes exactly as
+ * `encodeBlockSsse3` does.
+ */
+static inline void encodeBlockAvx2(const uint8_t* input, char* output)
+{
+    const __m128i lowHalf = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+    const __m128i highHalf = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + 12));
+    __m256i bytes = _mm256_inserti128_si256(_mm256_castsi128_si256(lowHalf), highHalf, 1);
+
+    bytes = _mm256_shuffle_epi8(bytes, _mm256_broadcastsi128_si256(
+        _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1)));
+    const __m256i high = _mm256_mulhi_epu16(
+        _mm256_and_si256(bytes, _mm256_set1_epi32(0x0fc0fc00)),
+        _mm256_set1_epi32(0x04000040));
+    const __m256i low = _mm256_mullo_epi16(
+        _mm256_and_si256(bytes, _mm256_set1_epi32(0x003f03f0)),
+        _mm256_set1_epi32(0x01000010));
+    const __m256i indices = _mm256_or_si256(high, low);
+
+    const __m256i offsets = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+        '/' - 63, 'A', 0, 0));
+    __m256i classes = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    const __m256i isUpper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+    classes = _mm256_or_si256(classes, _mm256_and_si256(isUpper, _mm256_set1_epi8(13)));
+
+    const __m256i characters = _mm256_add_epi8(indices, _mm256_shuffle_epi8(offsets, classes));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output), characters);
+};
+
+/**
+ * @brief Decodes 32 characters into 24 bytes.
+ * @remark 32 bytes are written to `output`; the last eight are scratch.
+ * @returns False if any character is outside the base64 alphabet.
+ */
+static inline bool decodeBlockAvx2(const char* input, uint8_t* output)
+{
+    const __m256i characters = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input));
+
+    const __m256i isUpper = _mm256_and_si256(
+        _mm256_cmpgt_epi8(characters, _mm256_set1_epi8('A' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), characters));
+    const __m256i isLower = _mm256_and_si256(
+        _mm256_cmpgt_epi8(characters, _mm256_set1_epi8('a' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), characters));
+    const __m256i isDigit = _mm256_and_si256(
+        _mm256_cmpgt_epi8(characters, _mm256_set1_epi8('0' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), characters));
+    const __m256i isPlus = _mm256_cmpeq_epi8(characters, _mm256_set1_epi8('+'));
+    const __m256i isSlash = _mm256_cmpeq_epi8(characters, _mm256_set1_epi8('/'));
+
+    const __m256i isValid = _mm256_or_si256(
+        _mm256_or_si256(isUpper, isLower),
+        _mm256_or_si256(isDigit, _mm256_or_si256(isPlus, isSlash)));
+    if (_mm256_movemask_epi8(isValid) != -1)
+    {
+        return false;
+    }
+
+    __m256i shift = _mm256_and_si256(isUpper, _mm256_set1_epi8(-'A'));
+    shift = _mm256_or_si256(shift, _mm256_and_si256(isLower, _mm256_set1_epi8(26 - 'a')));
+    shift = _mm256_or_si256(shift, _mm256_and_si256(isDigit, _mm256_set1_epi8(52 - '0')));
+    shift = _mm256_or_si256(shift, _mm256_and_si256(isPlus, _mm256_set1_epi8(62 - '+')));
+    shift = _mm256_or_si256(shift, _mm256_and_si256(isSlash, _mm256_set1_epi8(63 - '/')));
+    const __m256i indices = _mm256_add_epi8(characters, shift);
+
+    const __m256i words = _mm256_maddubs_epi16(indices, _mm256_set1_epi32(0x01400140));
+    const __m256i groups = _mm256_madd_epi16(words, _mm256_set1_epi32(0x00011000));
+    __m256i bytes = _mm256_shuffle_epi8(groups, _mm256_broadcastsi128_si256(
+        _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1)));
+
+    // Each lane now holds 12 bytes followed by four of scratch; close the gap between lanes.
+    bytes = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output), bytes);
+    return true;
+};
+#endif
+
+#pragma endregion
+
+#pragma region Scalar Groups
+
+static inline void encodeGroup(const uint8_t* input, char* output)
+{
+    const uint32_t group = (input[0] << 16) | (input[1] << 8) | input[2];
+    output[0] = base64Alphabet[(group >> 18) & 0x3F];
+    output[1] = base64Alphabet[(group >> 12) & 0x3F];
+    output[2] = base64Alphabet[(group >> 6) & 0x3F];
+    output[3] = base64Alphabet[group & 0x3F];
+};
+
+/**
+ * @brief Encodes the final one or two bytes of an input, with padding.
+ */
+static inline void encodePartialGroup(const uint8_t* input, size_t inputSize, char* output)
+{
+    const uint32_t group = (input[0] << 16) | (inputSize > 1 ? input[1] << 8 : 0);
+    output[0] = base64Alphabet[(group >> 18) & 0x3F];
+    output[1] = base64Alphabet[(group >> 12) & 0x3F];
+    output[2] = inputSize > 1 ? base64Alphabet[(group >> 6) & 0x3F] : '=';
+    output[3] = '=';
+};
+
+/**
+ * @brief Decodes whole 4-character groups that contain no padding.
+ * @param inputSize The number of characters to decode, which must be a multiple of four.
+ * @param output A buffer of exactly `inputSize / 4 * 3` bytes.
+ * @returns False if any character is outside the base64 alphabet.
+ */
+static bool decodeUnpaddedGroups(const char* input, size_t inputSize, uint8_t* output)
+{
+    // The vector blocks write scratch bytes past their decoded output, so each loop stops while
+    // enough decoded bytes remain after the block to absorb them.
+#if defined(__AVX2__)
+    while (inputSize >= 44)
+    {
+        if (!decodeBlockAvx2(input, output))
+        {
+            return false;
+        }
+        input += 32;
+        inputSize -= 32;
+        output += 24;
+    }
+#endif
+#if defined(__SSSE3__)
+    while (inputSize >= 24)
+    {
+        if (!decodeBlockSsse3(input, output))
+        {
+            return false;
+        }
+        input += 16;
+        inputSize -= 16;
+        output += 12;
+    }
+#endif
+
+    for (; inputSize >= 4; inputSize -= 4, input += 4, output += 3)
+    {
+        const uint8_t a = base64DecodeTable[static_cast<uint8_t>(input[0])];
+        const uint8_t b = base64DecodeTable[static_cast<uint8_t>(input[1])];
+        const uint8_t c = base64DecodeTable[static_cast<uint8_t>(input[2])];
+        const uint8_t d = base64DecodeTable[static_cast<uint8_t>(input[3])];
+        if (((a | b | c | d) & 0xC0) != 0)
+        {
+            return false;
+        }
+
+        const uint32_t group = (a << 18) | (b << 12) | (c << 6) | d;
+        output[0] = static_cast<uint8_t>(group >> 16);
+        output[1] = static_cast<uint8_t>(group >> 8);
+        output[2] = static_cast<uint8_t>(group);
+    }
+
+    return true;
+};
+
+/**
+ * @brief Decodes the final 4-character group of an input, which may end in padding.
+ * @param output A buffer of at least three bytes.
+ * @param outputSize Receives the number of bytes the group decodes to.
+ * @returns False if the group is not valid, including when the bits discarded by padding are not
+ * zero.
+ */
+static bool decodeFinalGroup(const char* input, uint8_t* output, size_t& outputSize)
+{
+    const size_t paddingSize = input[3] != '=' ? 0 : (input[2] != '=' ? 1 : 2);
+    if (paddingSize == 0)
+    {
+        outputSize = 3;
+        return decodeUnpaddedGroups(input, 4, output);
+    }
+
+    const uint8_t a = base64DecodeTable[static_cast<uint8_t>(input[0])];
+    const uint8_t b = base64DecodeTable[static_cast<uint8_t>(input[1])];
+    const uint8_t c = paddingSize == 1 ? base64DecodeTable[static_cast<uint8_t>(input[2])] : 0;
+    if (((a | b | c) & 0xC0) != 0)
+    {
+        return false;
+    }
+
+    const uint32_t group = (a << 18) | (b << 12) | (c << 6);
+    output[0] = static_cast<uint8_t>(group >> 16);
+    output[1] = static_cast<uint8_t>(group >> 8);
+    outputSize = 3 - paddingSize;
+
+    // Encoders zero the bits that padding discards; anything else is a different encoding of the
+    // same bytes, and is rejected so that every payload has one representation.
+    const uint32_t discardedBits = paddingSize == 1 ? group & 0xFF : group & 0xFFFF;
+    return discardedBits == 0;
+};
+
+#pragma endregion
+
+#pragma region Base64
+
+size_t Base64::encode(const uint8_t* input, size_t inputSize, char* output)
+{
+    char* const start = output;
+
+    // The vector blocks read four bytes past the input they encode, so each loop stops while
+    // those bytes are still in bounds.
+#if defined(__AVX2__)
+    while (inputSize >= 28)
+    {
+        encodeBlockAvx2(input, output);
+        input += 24;
+        inputSize -= 24;
+        output += 32;
+    }
+#endif
+#if defined(__SSSE3__)
+    while (inputSize >= 16)
+    {
+        encodeBlockSsse3(input, output);
+        input += 12;
+        inputSize -= 12;
+        output += 16;
+    }
+#endif
+
+    for (; inputSize >= 3; inputSize -= 3, input += 3, output += 4)
+    {
+        encodeGroup(input, output);
+    }
+
+    if (inputSize > 0)
+    {
+        encodePartialGroup(input, inputSize, output);
+        output += 4;
+    }
+
+    return output - start;
+};
+
+void Base64::encode(const uint8_t* input, size_t inputSize, string& output)
+{
+    output.resize(Base64::encodedSize(inputSize));
+    Base64::encode(input, inputSize, &output[0]);
+};
+
+string Base64::encode(const string& input)
+{
+    string output;
+    Base64::encode(reinterpret_cast<const uint8_t*>(input.data()), input.size(), output);
+    return output;
+};
+
+bool Base64::decode(const char* input, size_t inputSize, uint8_t* output, size_t& outputSize)
+{
+    outputSize = 0;
+    if (inputSize % 4 != 0)
+    {
+        return false;
+    }
+    if (inputSize == 0)
+    {
+        return true;
+    }
+
+    // Only the final group may hold padding, so it is decoded separately from the body.
+    const size_t bodySize = inputSize - 4;
+    const size_t bodyOutputSize = bodySize / 4 * 3;
+    if (!decodeUnpaddedGroups(input, bodySize, output))
+    {
+        return false;
+    }
+
+    size_t finalGroupSize;
+    if (!decodeFinalGroup(input + bodySize, output + bodyOutputSize, finalGroupSize))
+    {
+        return false;
+    }
+
+    outputSize = bodyOutputSize + finalGroupSize;
+    return true;
+};
+
+bool Base64::decode(const char* input, size_t inputSize, vector<uint8_t>& output)
+{
+    output.resize(Base64::maxDecodedSize(inputSize));
+
+    size_t outputSize;
+    if (!Base64::decode(input, inputSize, output.data(), outputSize))
+    {
+        output.clear();
+        return false;
+    }
+
+    output.resize(outputSize);
+    return true;
+};
+
+bool Base64::decode(const string& input, string& output)
+{
+    output.resize(Base64::maxDecodedSize(input.size()));
+
+    size_t outputSize;
+    if (!Base64::decode(input.data(), input.size(), reinterpret_cast<uint8_t*>(&output[0]), outputSize))
+    {
+        output.clear();
+        return false;
+    }
+
+    output.resize(outputSize);
+    return true;
+};
+
+#pragma endregion
+
+#pragma region Streaming
+
+void Base64Encoder::update(const uint8_t* input, size_t inputSize, string& output)
+{
+    // Complete a group carried over from the previous call.
+    if (this->_pendingSize > 0)
+    {
+        while (this->_pendingSize < 3 && inputSize > 0)
+        {
+            this->_pending[this->_pendingSize++] = *input++;
+            inputSize--;
+        }
+
+        if (this->_pendingSize < 3)
+        {
+            return;
+        }
+
+        const size_t offset = output.size();
+        output.resize(offset + 4);
+        encodeGroup(this->_pending, &output[offset]);
+        this->_pendingSize = 0;
+    }
+
+    const size_t wholeSize = inputSize - inputSize % 3;
+    const size_t offset = output.size();
+    output.resize(offset + Base64::encodedSize(wholeSize));
+    Base64::encode(input, wholeSize, &output[offset]);
+
+    this->_pendingSize = inputSize - wholeSize;
+    memcpy(this->_pending, input + wholeSize, this->_pendingSize);
+};
+
+void Base64Encoder::finish(string& output)
+{
+    if (this->_pendingSize > 0)
+    {
+        const size_t offset = output.size();
+        output.resize(offset + 4);
+        encodePartialGroup(this->_pending, this->_pendingSize, &output[offset]);
+    }
+
+    this->_pendingSize = 0;
+};
+
+bool Base64Decoder::update(const char* input, size_t inputSize, vector<uint8_t>& output)
+{
+    if (this->_isFailed)
+    {
+        return false;
+    }
+
+    while (this->_pendingSize < 4 && inputSize > 0)
+    {
+        this->_pending[this->_pendingSize++] = *input++;
+        inputSize--;
+    }
+
+    // A carried group is held until more input arrives, since it may be the padded final group.
+    if (this->_pendingSize < 4 || inputSize == 0)
+    {
+        return true;
+    }
+
+    // Hold back the trailing partial group, or the last whole group if there is no partial one.
+    const size_t heldSize = inputSize % 4 == 0 ? 4 : inputSize % 4;
+    const size_t bodySize = inputSize - heldSize;
+
+    const size_t offset = output.size();
+    output.resize(offset + 3 + bodySize / 4 * 3);
+    if (!decodeUnpaddedGroups(this->_pending, 4, output.data() + offset)
+        || !decodeUnpaddedGroups(input, bodySize, output.data() + offset + 3))
+    {
+        output.resize(offset);
+        this->_isFailed = true;
+        return false;
+    }
+
+    memcpy(this->_pending, input + bodySize, heldSize);
+    this->_pendingSize = heldSize;
+
+    return true;
+};
+
+bool Base64Decoder::finish(vector<uint8_t>& output)
+{
+    bool isValid = !this->_isFailed && (this->_pendingSize == 0 || this->_pendingSize == 4);
+
+    if (isValid && this->_pendingSize == 4)
+    {
+        uint8_t group[3];
+        size_t groupSize;
+        isValid = decodeFinalGroup(this->_pending, group, groupSize);
+        if (isValid)
+        {
+            output.insert(output.end(), group, group + groupSize);
+        }
+    }
+
+    this->_pendingSize = 0;
+    this->_isFailed = false;
+
+    return isValid;
+};
+
+#pragma endregion
@@ -1,6 +1,8 @@
 
 #include <cryptography/bech32.hpp>
 
+#include "../internal/hex_encoding.hpp"
+
 namespace nostr
 {
 namespace encoding
@@ -22,6 +24,109 @@ namespace encoding
         assert(0);
     }
 
+    // The checksum update is linear, so two steps can be folded into one: the low 20 bits of the
+    // checksum shift up by 10, and the top 10 bits select a precomputed remainder.
+    struct Bech32PolymodPairTable
+    {
+        uint32_t values[1024];
+    };
+
+    static constexpr uint32_t bech32PolymodStepConstexpr(uint32_t value)
+    {
+        uint32_t b = value >> 25;
+        return ((value & 0x1FFFFFF) << 5) ^
+            (-((b >> 0) & 1) & 0x3b6a57b2UL) ^
+            (-((b >> 1) & 1) & 0x26508e6dUL) ^
+            (-((b >> 2) & 1) & 0x1ea119faUL) ^
+            (-((b >> 3) & 1) & 0x3d4233ddUL) ^
+            (-((b >> 4) & 1) & 0x2a1462b3UL);
+    }
+
+    static constexpr Bech32PolymodPairTable makeBech32PolymodPairTable()
+    {
+        Bech32PolymodPairTable table{};
+        for (uint32_t top = 0; top < 1024; top++)
+        {
+            table.values[top] = bech32PolymodStepConstexpr(bech32PolymodStepConstexpr(top << 20));
+        }
+        return table;
+    }
+
+    static constexpr Bech32PolymodPairTable bech32PolymodPairs = makeBech32PolymodPairTable();
+
+    static inline uint32_t bech32PolymodPair(uint32_t chk, uint32_t first, uint32_t second)
+    {
+        return bech32PolymodPairs.values[chk >> 20] ^ ((chk & 0xFFFFF) << 10) ^ (first << 5) ^ second;
+    }
+
+    // Feeds `count` 5-bit symbols into the checksum, two at a time.
+    static uint32_t bech32PolymodSymbols(uint32_t chk, const uint8_t *symbols, std::size_t count)
+    {
+        std::size_t i = 0;
+        for (; i + 2 <= count; i += 2)
+            chk = bech32PolymodPair(chk, symbols[i], symbols[i + 1]);
+        if (i < count)
+            chk = bech32PolymodStep(chk) ^ symbols[i];
+        return chk;
+    }
+
+    // Feeds the expanded human readable part into a fresh checksum.  Uppercase characters are
+    // folded to lowercase only if `foldCase` is set; otherwise they are rejected.
+    static bool bech32HrpChecksum(const char *hrp, std::size_t hrpLength, bool foldCase, uint32_t &chk)
+    {
+        if (hrpLength == 0 || hrpLength > Bech32::maxHrpLength)
+            return false;
+
+        uint8_t expanded[Bech32::maxHrpLength * 2 + 1];
+        for (std::size_t i = 0; i < hrpLength; i++)
+        {
+            char c = hrp[i];
+            if (c < 33 || c > 126)
+                return false;
+            if (c >= 'A' && c <= 'Z')
+            {
+                if (!foldCase)
+                    return false;
+                c = (c - 'A') + 'a';
+            }
+            expanded[i] = c >> 5;
+            expanded[hrpLength + 1 + i] = c & 0x1f;
+        }
+        expanded[hrpLength] = 0;
+
+        chk = bech32PolymodSymbols(1, expanded, hrpLength * 2 + 1);
+        return true;
+    }
+
+    // Regroups bytes into 5-bit symbols, zero-padding the last one.  Five bytes make exactly
+    // eight symbols, so whole groups are split with shifts of a single 40-bit word.
+    static void bech32BytesToSymbols(const uint8_t *data, std::size_t dataLength, uint8_t *symbols)
+    {
+        std::size_t i = 0;
+        for (; i + 5 <= dataLength; i += 5, symbols += 8)
+        {
+            uint64_t group = ((uint64_t)data[i] << 32) | ((uint64_t)data[i + 1] << 24) |
+                ((uint64_t)data[i + 2] << 16) | ((uint64_t)data[i + 3] << 8) | data[i + 4];
+            for (int k = 0; k < 8; k++)
+                symbols[k] = (group >> (35 - 5 * k)) & 0x1f;
+        }
+
+        uint32_t value = 0;
+        int bits = 0;
+        for (; i < dataLength; i++)
+        {
+            value = (value << 8) | data[i];
+            bits += 8;
+            while (bits >= 5)
+            {
+                bits -= 5;
+                *symbols++ = (value >> bits) & 0x1f;
+            }
+        }
+        if (bits)
+            *symbols = (value << (5 - bits)) & 0x1f;
+    }
+
     int Bech32::segwitAddrEncode(
         std::string &output,
         const std::string hrp,
@@ -242,6 +347,219 @@ namespace encoding
     }
 
 
+    std::size_t Bech32::encodeBytes(
+        const char *hrp,
+        std::size_t hrpLength,
+        const uint8_t *data,
+        std::size_t dataLength,
+        Bech32EncodingType enc,
+        char *output,
+        std::size_t outputCapacity
+    )
+    {
+        if (enc != BECH32_ENCODING_BECH32 && enc != BECH32_ENCODING_BECH32M)
+            return 0;
+
+        std::size_t length = Bech32::encodedLength(hrpLength, dataLength);
+        if (length > outputCapacity)
+            return 0;
+
+        uint32_t chk;
+        if (!bech32HrpChecksum(hrp, hrpLength, false, chk))
+            return 0;
+
+        memcpy(output, hrp, hrpLength);
+        output[hrpLength] = '1';
+
+        // The symbol values are staged in the output buffer and mapped to characters in place.
+        uint8_t *symbols = reinterpret_cast<uint8_t *>(output + hrpLength + 1);
+        std::size_t symbolCount = length - hrpLength - 1 - 6;
+        bech32BytesToSymbols(data, dataLength, symbols);
+
+        static const uint8_t checksumPlaceholder[6] = { 0 };
+        chk = bech32PolymodSymbols(chk, symbols, symbolCount);
+        chk = bech32PolymodSymbols(chk, checksumPlaceholder, 6);
+        chk ^= bech32FinalConstant(enc);
+        for (std::size_t i = 0; i < 6; i++)
+            symbols[symbolCount + i] = (chk >> (5 - i) * 5) & 0x1f;
+
+        for (std::size_t i = 0; i < symbolCount + 6; i++)
+            output[hrpLength + 1 + i] = bech32Charset[symbols[i]];
+
+        return length;
+    }
+
+    Bech32EncodingType Bech32::decodeBytes(
+        const char *input,
+        std::size_t inputLength,
+        std::size_t &hrpLength,
+        uint8_t *output,
+        std::size_t outputCapacity,
+        std::size_t &outputLength
+    )
+    {
+        outputLength = 0;
+
+        // The separator is the last '1', since the human readable part may itself contain one.
+        std::size_t separator = inputLength;
+        while (separator > 0 && input[separator - 1] != '1')
+            --separator;
+        if (separator == 0)
+            return BECH32_ENCODING_NONE;
+        hrpLength = separator - 1;
+
+        const char *encoded = input + separator;
+        std::size_t encodedCount = inputLength - separator;
+        if (encodedCount < 6)
+            return BECH32_ENCODING_NONE;
+
+        int have_lower = 0, have_upper = 0;
+        for (std::size_t i = 0; i < inputLength; i++)
+        {
+            if (input[i] >= 'a' && input[i] <= 'z')
+                have_lower = 1;
+            else if (input[i] >= 'A' && input[i] <= 'Z')
+                have_upper = 1;
+        }
+        if (have_lower && have_upper)
+            return BECH32_ENCODING_NONE;
+
+        uint32_t chk;
+        if (!bech32HrpChecksum(input, hrpLength, true, chk))
+            return BECH32_ENCODING_NONE;
+
+        // Validate the data part and fold it into the checksum two characters at a time.  An
+        // invalid character maps to 0xFF, which sets bits no valid symbol has.
+        auto symbolAt = [encoded](std::size_t i) -> uint8_t
+        {
+            uint8_t c = encoded[i];
+            return (c & 0x80) ? 0xFF : (uint8_t)bech32CharsetRev[c];
+        };
+
+        uint8_t invalid = 0;
+        std::size_t i = 0;
+        for (; i + 2 <= encodedCount; i += 2)
+        {
+            uint8_t first = symbolAt(i), second = symbolAt(i + 1);
+            invalid |= first | second;
+            chk = bech32PolymodPair(chk, first & 0x1f, second & 0x1f);
+        }
+        if (i < encodedCount)
+        {
+            uint8_t last = symbolAt(i);
+            invalid |= last;
+            chk = bech32PolymodStep(chk) ^ (last & 0x1f);
+        }
+        if (invalid & 0xE0)
+            return BECH32_ENCODING_NONE;
+
+        Bech32EncodingType enc;
+        if (chk == bech32FinalConstant(BECH32_ENCODING_BECH32))
+            enc = BECH32_ENCODING_BECH32;
+        else if (chk == bech32FinalConstant(BECH32_ENCODING_BECH32M))
+            enc = BECH32_ENCODING_BECH32M;
+        else
+            return BECH32_ENCODING_NONE;
+
+        std::size_t symbolCount = encodedCount - 6;
+        std::size_t byteCount = symbolCount * TO_BITS / FROM_BITS;
+        if (byteCount > outputCapacity)
+            return BECH32_ENCODING_NONE;
+
+        // Eight symbols make exactly five bytes; the remainder is regrouped bit by bit.
+        i = 0;
+        uint8_t *out = output;
+        for (; i + 8 <= symbolCount; i += 8, out += 5)
+        {
+            uint64_t group = 0;
+            for (int k = 0; k < 8; k++)
+                group = (group << 5) | symbolAt(i + k);
+            out[0] = group >> 32;
+            out[1] = group >> 24;
+            out[2] = group >> 16;
+            out[3] = group >> 8;
+            out[4] = group;
+        }
+
+        uint32_t value = 0;
+        int bits = 0;
+        for (; i < symbolCount; i++)
+        {
+            value = (value << 5) | symbolAt(i);
+            bits += 5;
+            if (bits >= 8)
+            {
+                bits -= 8;
+                *out++ = (value >> bits) & 0xff;
+            }
+        }
+
+        // As in `convertBits` without padding: at most four padding bits, all zero.
+        if (bits >= 5 || (value & ((1u << bits) - 1)))
+            return BECH32_ENCODING_NONE;
+
+        outputLength = byteCount;
+        return enc;
+    }
+
+    std::vector<std::string> Bech32::encodeBatch(
+        const std::string &hrp,
+        const std::vector<std::string> &hexValues
+    )
+    {
+        std::vector<std::string> results(hexValues.size());
+
+        uint8_t bytes[MAX_INPUT_LENGTH];
+        char encoded[Bech32::encodedLength(Bech32::maxHrpLength, MAX_INPUT_LENGTH)];
+        for (std::size_t i = 0; i < hexValues.size(); i++)
+        {
+            const std::string &hex = hexValues[i];
+            std::size_t byteCount = hex.size() / 2;
+            if (byteCount > sizeof(bytes) || !nostr::internal::decodeHex(hex, bytes, byteCount))
+                continue;
+
+            std::size_t length = Bech32::encodeBytes(
+                hrp.data(), hrp.size(), bytes, byteCount, BECH32_ENCODING_BECH32, encoded, sizeof(encoded));
+            results[i].assign(encoded, length);
+        }
+
+        return results;
+    }
+
+    std::vector<std::string> Bech32::decodeBatch(
+        const std::string &hrp,
+        const std::vector<std::string> &encodings
+    )
+    {
+        std::vector<std::string> results(encodings.size());
+
+        uint8_t bytes[MAX_INPUT_LENGTH];
+        for (std::size_t i = 0; i < encodings.size(); i++)
+        {
+            const std::string &encoding = encodings[i];
+            std::size_t hrpLength, byteCount;
+            Bech32EncodingType enc = Bech32::decodeBytes(
+                encoding.data(), encoding.size(), hrpLength, bytes, sizeof(bytes), byteCount);
+            if (enc != BECH32_ENCODING_BECH32 || hrpLength != hrp.size())
+                continue;
+
+            bool isHrpMatch = true;
+            for (std::size_t k = 0; k < hrpLength && isHrpMatch; k++)
+            {
+                char c = encoding[k];
+                if (c >= 'A' && c <= 'Z')
+                    c = (c - 'A') + 'a';
+                isHrpMatch = c == hrp[k];
+            }
+            if (!isHrpMatch)
+                continue;
+
+            results[i] = nostr::internal::encodeHex(bytes, byteCount);
+        }
+
+        return results;
+    }
+
     int Bech32::convertBits(BytesArray &out, int outbits,
                 const BytesArray &in, int inbits,
                 int pad)
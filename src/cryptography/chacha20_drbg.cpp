@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include <pthread.h>
+
+#include <plog/Init.h>
+#include <plog/Log.h>
+
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+
+#include "chacha20_drbg.hpp"
+#include "../internal/logging.hpp"
+
+using namespace std;
+using namespace nostr::cryptography;
+
+///< Incremented in a forked child, so generators inherited from the parent know to reseed.
+static atomic<uint64_t> forkGeneration{ 0 };
+
+static uint64_t currentForkGeneration()
+{
+    static const bool isForkHandlerRegistered = []()
+    {
+        return pthread_atfork(
+            nullptr,
+            nullptr,
+            []() { forkGeneration.fetch_add(1, memory_order_relaxed); }) == 0;
+    }();
+    (void)isForkHandlerRegistered;
+
+    return forkGeneration.load(memory_order_relaxed);
+};
+
+ChaCha20Drbg::ChaCha20Drbg()
+{
+    this->_cipherContext = EVP_CIPHER_CTX_new();
+    this->reseed();
+};
+
+ChaCha20Drbg::~ChaCha20Drbg()
+{
+    OPENSSL_cleanse(this->_key, sizeof(this->_key));
+    OPENSSL_cleanse(this->_buffer, sizeof(this->_buffer));
+    EVP_CIPHER_CTX_free(this->_cipherContext);
+};
+
+bool ChaCha20Drbg::generate(uint8_t* output, size_t length)
+{
+    if (!this->_isSeeded
+        || this->_servedSinceReseed >= reseedInterval
+        || this->_seededForkGeneration != currentForkGeneration())
+    {
+        if (!this->reseed())
+        {
+            return false;
+        }
+    }
+
+    while (length > 0)
+    {
+        if (this->_position == bufferSize && !this->_refill())
+        {
+            return false;
+        }
+
+        size_t count = min(length, bufferSize - this->_position);
+        memcpy(output, this->_buffer + this->_position, count);
+
+        // Wipe served bytes immediately, so they cannot be recovered from the generator's state.
+        OPENSSL_cleanse(this->_buffer + this->_position, count);
+
+        this->_position += count;
+        this->_servedSinceReseed += count;
+        output += count;
+        length -= count;
+    }
+
+    return true;
+};
+
+bool ChaCha20Drbg::reseed()
+{
+    OPENSSL_cleanse(this->_buffer, sizeof(this->_buffer));
+    this->_position = bufferSize;
+    this->_servedSinceReseed = 0;
+
+    this->_isSeeded = this->_cipherContext != nullptr
+        && RAND_bytes(this->_key, sizeof(this->_key)) == 1;
+    this->_seededForkGeneration = currentForkGeneration();
+
+    if (!this->_isSeeded)
+    {
+        PLOG_ERROR << "Failed to seed the buffered random generator.";
+    }
+
+    return this->_isSeeded;
+};
+
+bool ChaCha20Drbg::_refill()
+{
+    // Each key encrypts exactly one buffer, so a zero nonce and counter are never reused.
+    static const uint8_t zeroIv[16] = { 0 };
+    memset(this->_buffer, 0, sizeof(this->_buffer));
+
+    int outputLength = 0;
+    bool isGenerated =
+        EVP_EncryptInit_ex(this->_cipherContext, EVP_chacha20(), nullptr, this->_key, zeroIv) == 1
+        && EVP_EncryptUpdate(
+            this->_cipherContext,
+            this->_buffer,
+            &outputLength,
+            this->_buffer,
+            static_cast<int>(sizeof(this->_buffer))) == 1
+        && outputLength == static_cast<int>(sizeof(this->_buffer));
+
+    if (!isGenerated)
+    {
+        PLOG_ERROR << "Failed to generate keystream for the buffered random generator.";
+        EVP_CIPHER_CTX_reset(this->_cipherContext);
+        OPENSSL_cleanse(this->_buffer, sizeof(this->_buffer));
+        this->_isSeeded = false;
+        return false;
+    }
+
+    // The cipher context holds the old key schedule, which could regenerate the buffer.
+    EVP_CIPHER_CTX_reset(this->_cipherContext);
+
+    // Fast key erasure: the start of the keystream becomes the next key, and is never served.
+    memcpy(this->_key, this->_buffer, sizeof(this->_key));
+    OPENSSL_cleanse(this->_buffer, sizeof(this->_key));
+    this->_position = sizeof(this->_key);
+
+    return true;
+};
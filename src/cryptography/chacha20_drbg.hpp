@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <openssl/evp.h>
+
+namespace nostr
+{
+namespace cryptography
+{
+class ChaCha20DrbgProbe;
+
+/**
+ * @brief A buffered ChaCha20 random bit generator with fast key erasure.
+ * @remark The generator is seeded from OpenSSL's `RAND_bytes`.  Each refill encrypts a block of
+ * zeros under the current key; the first 32 bytes of the keystream replace the key, and the rest
+ * is served to callers.  Served bytes are wiped from the buffer as they are handed out, so a
+ * later compromise of the generator's state reveals nothing about earlier output.  The key is
+ * replaced with fresh system entropy after `reseedInterval` bytes, and whenever the process has
+ * forked since the last seeding.
+ *
+ * A generator is not thread-safe; `NostrSecureRng` keeps one per thread.
+ */
+class ChaCha20Drbg
+{
+public:
+    ///< The number of bytes of keystream produced by each refill, including the next key.
+    static constexpr std::size_t bufferSize = 1024;
+
+    ///< The number of bytes served between reseeds from system entropy.
+    static constexpr std::size_t reseedInterval = 1 << 20;
+
+    ChaCha20Drbg();
+
+    /**
+     * @remark The key and any unserved output are securely zeroed.
+     */
+    ~ChaCha20Drbg();
+
+    ChaCha20Drbg(const ChaCha20Drbg&) = delete;
+
+    ChaCha20Drbg& operator=(const ChaCha20Drbg&) = delete;
+
+    /**
+     * @brief Fills a buffer with random bytes.
+     * @returns True if the buffer was filled, false if neither the generator nor the system
+     * source could produce output.
+     */
+    bool generate(uint8_t* output, std::size_t length);
+
+    /**
+     * @brief Replaces the key with fresh system entropy and discards buffered output.
+     * @returns True if the generator was reseeded.
+     */
+    bool reseed();
+
+private:
+    friend class ChaCha20DrbgProbe; ///< Inspects the key and buffer in tests.
+
+    EVP_CIPHER_CTX* _cipherContext;
+
+    uint8_t _key[32];
+
+    uint8_t _buffer[bufferSize]; ///< Keystream waiting to be served, starting at `_position`.
+
+    std::size_t _position = bufferSize;
+
+    std::size_t _servedSinceReseed = 0;
+
+    uint64_t _seededForkGeneration = 0; ///< Compared against the fork count, so a forked child reseeds.
+
+    bool _isSeeded = false;
+
+    /**
+     * @brief Generates a new buffer of keystream and rotates the key.
+     */
+    bool _refill();
+};
+} // namespace cryptography
+} // namespace nostr
@@ -0,0 +1,113 @@
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+
+#include "conversation_key_cache.hpp"
+#include "nostr_secure_rng.hpp"
+#include "../internal/noscrypt_logger.hpp"
+
+using namespace std;
+using namespace nostr::cryptography;
+
+ConversationKeyCache::ConversationKeyCache(size_t capacity) : _capacity(capacity) { };
+
+ConversationKeyCache::~ConversationKeyCache()
+{
+    this->clear();
+};
+
+bool ConversationKeyCache::get(
+    const NCContext* context,
+    const NCSecretKey& localKey,
+    const NCPublicKey& remoteKey,
+    uint8_t conversationKey[NC_CONV_KEY_SIZE]
+)
+{
+    PeerId peerId;
+    EVP_Digest(localKey.key, sizeof(localKey.key), peerId.data(), NULL, EVP_sha256(), NULL);
+    memcpy(peerId.data() + SHA256_DIGEST_LENGTH, remoteKey.key, sizeof(remoteKey.key));
+
+    if (this->_capacity > 0)
+    {
+        lock_guard<mutex> lock(this->_entryMutex);
+        auto it = this->_index.find(peerId);
+        if (it != this->_index.end())
+        {
+            this->_entries.splice(this->_entries.begin(), this->_entries, it->second);
+            memcpy(conversationKey, it->second->conversationKey, NC_CONV_KEY_SIZE);
+            this->_hits.fetch_add(1, memory_order_relaxed);
+            return true;
+        }
+    }
+
+    this->_misses.fetch_add(1, memory_order_relaxed);
+
+    // Derive the key outside the lock, so a slow derivation does not block lookups for other
+    // peers.  Two threads may race to derive the same key; the second insert is skipped.
+    NCResult result = NCGetConversationKey(context, &localKey, &remoteKey, conversationKey);
+    if (result != NC_SUCCESS)
+    {
+        NC_LOG_ERROR(result);
+        return false;
+    }
+
+    if (this->_capacity == 0)
+    {
+        return true;
+    }
+
+    lock_guard<mutex> lock(this->_entryMutex);
+    if (this->_index.find(peerId) != this->_index.end())
+    {
+        return true;
+    }
+
+    if (this->_entries.size() >= this->_capacity)
+    {
+        this->_evictOldest();
+    }
+
+    if (this->_spare.empty())
+    {
+        this->_entries.emplace_front();
+    }
+    else
+    {
+        this->_entries.splice(this->_entries.begin(), this->_spare);
+    }
+
+    Entry& entry = this->_entries.front();
+    entry.peerId = peerId;
+    memcpy(entry.conversationKey, conversationKey, NC_CONV_KEY_SIZE);
+    this->_index[peerId] = this->_entries.begin();
+
+    return true;
+};
+
+void ConversationKeyCache::clear()
+{
+    lock_guard<mutex> lock(this->_entryMutex);
+    while (!this->_entries.empty())
+    {
+        this->_evictOldest();
+    }
+};
+
+uint64_t ConversationKeyCache::hits() const
+{
+    return this->_hits.load(memory_order_relaxed);
+};
+
+uint64_t ConversationKeyCache::misses() const
+{
+    return this->_misses.load(memory_order_relaxed);
+};
+
+void ConversationKeyCache::_evictOldest()
+{
+    Entry& oldest = this->_entries.back();
+    NostrSecureRng::zero(oldest.conversationKey, sizeof(oldest.conversationKey));
+
+    this->_index.erase(oldest.peerId);
+    this->_spare.clear();
+    this->_spare.splice(this->_spare.begin(), this->_entries, prev(this->_entries.end()));
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include <noscrypt.h>
+
+namespace nostr
+{
+namespace cryptography
+{
+class ConversationKeyCacheProbe;
+
+/**
+ * @brief A bounded cache of NIP-44 conversation keys, keyed by local secret key and remote
+ * public key.
+ * @remark Deriving a conversation key requires an ECDH and an HKDF extraction, which dominate the
+ * cost of encrypting or decrypting a short message.  Conversations with the same peer reuse the
+ * same key, so it is derived once and kept until it is evicted.  Evicted keys are securely zeroed.
+ * Local secret keys are identified by their SHA-256 fingerprint, so no secret key material is held
+ * by the cache.
+ */
+class ConversationKeyCache
+{
+public:
+    /**
+     * @param capacity The maximum number of conversation keys to hold.  A capacity of 0 disables
+     * the cache, so every lookup derives a fresh key.
+     */
+    explicit ConversationKeyCache(std::size_t capacity = 256);
+
+    /**
+     * @remark All cached keys are securely zeroed.
+     */
+    ~ConversationKeyCache();
+
+    ConversationKeyCache(const ConversationKeyCache&) = delete;
+
+    ConversationKeyCache& operator=(const ConversationKeyCache&) = delete;
+
+    /**
+     * @brief Looks up the conversation key between a local secret key and a remote public key,
+     * deriving and caching it if it is not already cached.
+     * @param context An initialized noscrypt context.
+     * @param localKey The local secret key.
+     * @param remoteKey The remote public key.
+     * @param conversationKey A buffer of `NC_CONV_KEY_SIZE` bytes that will receive the key.  The
+     * caller should zero it once it is no longer needed.
+     * @returns True if the key was found or derived, false if it could not be derived.
+     */
+    bool get(
+        const NCContext* context,
+        const NCSecretKey& localKey,
+        const NCPublicKey& remoteKey,
+        uint8_t conversationKey[NC_CONV_KEY_SIZE]
+    );
+
+    /**
+     * @brief Removes and zeroes all cached keys.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the number of lookups that found a cached key.
+     */
+    uint64_t hits() const;
+
+    /**
+     * @brief Returns the number of lookups that had to derive a key.
+     */
+    uint64_t misses() const;
+
+private:
+    friend class ConversationKeyCacheProbe; ///< Inspects evicted entries in tests.
+
+    ///< The fingerprint of the local secret key followed by the remote public key.
+    using PeerId = std::array<uint8_t, 64>;
+
+    struct PeerIdHash
+    {
+        std::size_t operator()(const PeerId& peerId) const noexcept
+        {
+            // Both halves are uniformly distributed, so mix one word from each.
+            std::size_t localPart, remotePart;
+            std::memcpy(&localPart, peerId.data(), sizeof(localPart));
+            std::memcpy(&remotePart, peerId.data() + 32, sizeof(remotePart));
+            return localPart ^ remotePart;
+        };
+    };
+
+    struct Entry
+    {
+        PeerId peerId;
+        uint8_t conversationKey[NC_CONV_KEY_SIZE];
+    };
+
+    std::size_t _capacity;
+
+    ///< Cached keys, ordered from most to least recently used.
+    std::list<Entry> _entries;
+
+    std::unordered_map<PeerId, std::list<Entry>::iterator, PeerIdHash> _index;
+
+    ///< The zeroed node of the last evicted entry, reused by the next insert so that a full cache
+    ///< does not allocate on each miss.
+    std::list<Entry> _spare;
+
+    ///< A mutex to protect the cached entries.
+    std::mutex _entryMutex;
+
+    std::atomic<uint64_t> _hits{ 0 };
+    std::atomic<uint64_t> _misses{ 0 };
+
+    /**
+     * @brief Zeroes and removes the least recently used entry, keeping its node as the spare.
+     */
+    void _evictOldest();
+};
+} // namespace cryptography
+} // namespace nostr
@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include <plog/Init.h>
+#include <plog/Log.h>
+
+#include "cryptography/event_verifier.hpp"
+#include "cryptography/noscrypt_context_pool.hpp"
+#include "nostr_secure_rng.hpp"
+#include "../internal/hex_encoding.hpp"
+#include "../internal/logging.hpp"
+#include "../internal/noscrypt_logger.hpp"
+#include "../internal/worker_pool.hpp"
+
+using namespace nostr::cryptography;
+using namespace nostr::data;
+using namespace nostr::internal;
+using namespace std;
+
+#pragma region Local Statics
+
+/**
+ * @brief Decodes the binary fields of an event and checks that its ID matches its contents.
+ * @returns True if the fields are well-formed and the ID is correct, false otherwise.
+ */
+static bool decodeEvent(
+    const Event& event,
+    NCPublicKey& pubkey,
+    EventId& id,
+    EventSignature& signature)
+{
+    if (!decodeHex(event.pubkey, pubkey.key, sizeof(pubkey.key))
+        || !decodeHex(event.id, id.data(), id.size())
+        || !decodeHex(event.sig, signature.data(), signature.size()))
+    {
+        PLOG_VERBOSE << "Event " << event.id << " has a malformed pubkey, ID, or signature.";
+        return false;
+    }
+
+    // The ID must be the hash of the event data, otherwise the signature covers other content.
+    EventId digest;
+    event.computeDigest(digest.data());
+    if (digest != id)
+    {
+        PLOG_VERBOSE << "Event " << event.id << " does not match its contents.";
+        return false;
+    }
+
+    return true;
+};
+
+static bool verifySignature(
+    const NCContext* context,
+    const NCPublicKey& pubkey,
+    const EventId& id,
+    const EventSignature& signature)
+{
+    NCResult verifyResult = NCVerifyDigest(context, &pubkey, id.data(), signature.data());
+    if (verifyResult != NC_SUCCESS)
+    {
+        PLOG_VERBOSE << "Event " << encodeHex(id.data(), id.size()) << " has an invalid signature.";
+        return false;
+    }
+
+    return true;
+};
+
+#pragma endregion
+
+EventVerifier::EventVerifier(size_t workerCount, size_t batchSize, size_t cacheCapacity)
+    : _batchSize(max<size_t>(1, batchSize)), _verifiedEvents(cacheCapacity)
+{
+    if (workerCount == 0)
+    {
+        workerCount = max<size_t>(1, thread::hardware_concurrency());
+    }
+
+    this->_pool = make_unique<WorkerPool>(workerCount);
+};
+
+EventVerifier::~EventVerifier()
+{
+    // Join the workers before the queue and cache are torn down.
+    this->_pool.reset();
+};
+
+void EventVerifier::submit(
+    shared_ptr<Event> event,
+    function<void(shared_ptr<Event>, bool)> verificationHandler
+)
+{
+    {
+        lock_guard<mutex> lock(this->_pendingMutex);
+        this->_pending.push_back({ move(event), move(verificationHandler) });
+
+        // Every worker is already draining the queue, so the event will be picked up by one of
+        // them as part of a later batch.
+        if (this->_activeDrains >= this->_pool->size())
+        {
+            return;
+        }
+        this->_activeDrains++;
+    }
+
+    this->_pool->submit([this](size_t) { this->_drain(); });
+};
+
+vector<bool> EventVerifier::verify(const vector<shared_ptr<Event>>& events)
+{
+    vector<uint8_t> results(events.size(), 0);
+    this->_pool->parallelFor(events.size(), [this, &events, &results](size_t i)
+    {
+        results[i] = this->_verifyAndCount(*events[i]) ? 1 : 0;
+    });
+
+    return vector<bool>(results.begin(), results.end());
+};
+
+bool EventVerifier::verifyEvent(const NCContext* context, const Event& event)
+{
+    NCPublicKey pubkey;
+    EventId id;
+    EventSignature signature;
+
+    return decodeEvent(event, pubkey, id, signature)
+        && verifySignature(context, pubkey, id, signature);
+};
+
+size_t EventVerifier::workerCount() const
+{
+    return this->_pool->size();
+};
+
+EventVerifierStats EventVerifier::stats() const
+{
+    EventVerifierStats stats;
+    stats.verified = this->_verifiedCount.load(memory_order_relaxed);
+    stats.rejected = this->_rejectedCount.load(memory_order_relaxed);
+
+    VerifiedEventCacheStats cacheStats = this->_verifiedEvents.stats();
+    stats.cacheHits = cacheStats.hits;
+    stats.cacheMisses = cacheStats.misses;
+
+    {
+        lock_guard<mutex> lock(this->_pendingMutex);
+        stats.pending = this->_pending.size();
+    }
+
+    // Busy time is summed across workers, so scale by the worker count to get the rate of the
+    // whole pool.
+    uint64_t busyNanoseconds = this->_busyNanoseconds.load(memory_order_relaxed);
+    stats.verifiedPerSecond = busyNanoseconds == 0
+        ? 0.0
+        : (stats.verified + stats.rejected) * this->_pool->size() * 1e9 / busyNanoseconds;
+
+    return stats;
+};
+
+void EventVerifier::_drain()
+{
+    vector<PendingVerification> batch;
+    batch.reserve(this->_batchSize);
+
+    while (true)
+    {
+        {
+            lock_guard<mutex> lock(this->_pendingMutex);
+            if (this->_pending.empty())
+            {
+                this->_activeDrains--;
+                return;
+            }
+
+            size_t takeCount = min(this->_batchSize, this->_pending.size());
+            move(
+                this->_pending.begin(),
+                this->_pending.begin() + takeCount,
+                back_inserter(batch));
+            this->_pending.erase(this->_pending.begin(), this->_pending.begin() + takeCount);
+        }
+
+        for (PendingVerification& pending : batch)
+        {
+            bool isValid = this->_verifyAndCount(*pending.event);
+            try
+            {
+                pending.verificationHandler(pending.event, isValid);
+            }
+            catch (const exception& e)
+            {
+                // A throwing handler must not stop the drain, or queued events would be stranded.
+                PLOG_ERROR << "Event verification handler threw an exception: " << e.what();
+            }
+        }
+        batch.clear();
+    }
+};
+
+bool EventVerifier::_verifyAndCount(const Event& event)
+{
+    auto start = chrono::steady_clock::now();
+
+    NCPublicKey pubkey;
+    EventId id;
+    EventSignature signature;
+    bool isValid = decodeEvent(event, pubkey, id, signature);
+
+    // The pubkey is part of the hashed event data, so a cached ID and signature pair that
+    // matches the contents needs no further checks.
+    if (isValid && !this->_verifiedEvents.contains(id, signature))
+    {
+        // Each worker thread verifies with its own context, so no lock is needed.
+        isValid = verifySignature(NoscryptContextPool::local(), pubkey, id, signature);
+        if (isValid)
+        {
+            this->_verifiedEvents.insert(id, signature);
+        }
+    }
+
+    auto elapsed = chrono::steady_clock::now() - start;
+
+    this->_busyNanoseconds.fetch_add(
+        chrono::duration_cast<chrono::nanoseconds>(elapsed).count(),
+        memory_order_relaxed);
+    (isValid ? this->_verifiedCount : this->_rejectedCount).fetch_add(1, memory_order_relaxed);
+
+    return isValid;
+};
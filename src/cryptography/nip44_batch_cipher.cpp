@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#include <plog/Init.h>
+#include <plog/Log.h>
+
+#include "cryptography/base64.hpp"
+#include "cryptography/nip44_batch_cipher.hpp"
+#include "cryptography/noscrypt_context_pool.hpp"
+#include "conversation_key_cache.hpp"
+#include "noscrypt_cipher.hpp"
+#include "nostr_secure_rng.hpp"
+#include "../internal/hex_encoding.hpp"
+#include "../internal/logging.hpp"
+#include "../internal/noscrypt_logger.hpp"
+#include "../internal/worker_pool.hpp"
+
+using namespace nostr::cryptography;
+using namespace nostr::encoding;
+using namespace nostr::internal;
+using namespace std;
+
+#pragma region Local Statics
+
+///< Messages in a batch can differ in length by orders of magnitude, so each worker's share is
+///< split into several chunks rather than handed out whole.
+static const size_t chunksPerWorker = 4;
+
+#pragma endregion
+
+Nip44BatchCipher::Nip44BatchCipher(
+    const NCSecretKey& localKey,
+    size_t workerCount,
+    size_t keyCacheCapacity
+)
+    : _localKey(localKey), _conversationKeys(make_shared<ConversationKeyCache>(keyCacheCapacity))
+{
+    if (workerCount == 0)
+    {
+        workerCount = max<size_t>(1, thread::hardware_concurrency());
+    }
+
+    NCResult validationResult = NCValidateSecretKey(NoscryptContextPool::local(), &this->_localKey);
+    if (validationResult != NC_SUCCESS)
+    {
+        NostrSecureRng::zero(&this->_localKey, sizeof(NCSecretKey));
+        throw invalid_argument("Nip44BatchCipher: The provided secret key is invalid.");
+    }
+
+    this->_pool = make_unique<WorkerPool>(workerCount);
+};
+
+Nip44BatchCipher::~Nip44BatchCipher()
+{
+    // The local key is wiped below, so no worker may still be deriving conversation keys from it.
+    this->_pool.reset();
+    NostrSecureRng::zero(&this->_localKey, sizeof(NCSecretKey));
+};
+
+vector<Nip44BatchResult> Nip44BatchCipher::encrypt(const vector<Nip44BatchItem>& items)
+{
+    return this->_process(items, [this](const NCContext* context, const Nip44BatchItem& item, string& output)
+    {
+        uint8_t conversationKey[NC_CONV_KEY_SIZE];
+        Nip44BatchError keyError = this->_getConversationKey(context, item.peerPublicKey, conversationKey);
+        if (keyError != Nip44BatchError::NONE)
+        {
+            return keyError;
+        }
+
+        // Worker threads live as long as the pool, so their scratch buffers are reused across
+        // items and batches.
+        thread_local vector<uint8_t> payload;
+        bool isEncrypted = NoscryptCipher::encryptNip44(
+            context,
+            conversationKey,
+            reinterpret_cast<const uint8_t*>(item.payload.data()),
+            item.payload.size(),
+            payload);
+        NostrSecureRng::zero(conversationKey, sizeof(conversationKey));
+
+        if (!isEncrypted)
+        {
+            return Nip44BatchError::CIPHER_FAILED;
+        }
+
+        Base64::encode(payload.data(), payload.size(), output);
+        return Nip44BatchError::NONE;
+    });
+};
+
+vector<Nip44BatchResult> Nip44BatchCipher::decrypt(const vector<Nip44BatchItem>& items)
+{
+    return this->_process(items, [this](const NCContext* context, const Nip44BatchItem& item, string& output)
+    {
+        thread_local vector<uint8_t> payload;
+        if (!Base64::decode(item.payload.data(), item.payload.size(), payload))
+        {
+            return Nip44BatchError::INVALID_PAYLOAD;
+        }
+
+        uint8_t conversationKey[NC_CONV_KEY_SIZE];
+        Nip44BatchError keyError = this->_getConversationKey(context, item.peerPublicKey, conversationKey);
+        if (keyError != Nip44BatchError::NONE)
+        {
+            return keyError;
+        }
+
+        thread_local vector<uint8_t> message;
+        bool isDecrypted = NoscryptCipher::decryptNip44(
+            context,
+            conversationKey,
+            payload.data(),
+            payload.size(),
+            message);
+        NostrSecureRng::zero(conversationKey, sizeof(conversationKey));
+
+        if (!isDecrypted)
+        {
+            return Nip44BatchError::INVALID_PAYLOAD;
+        }
+
+        // Copy the plaintext out and wipe the scratch buffer, so it does not linger on the worker.
+        output.assign(message.begin(), message.end());
+        NostrSecureRng::zero(message.data(), message.size());
+        return Nip44BatchError::NONE;
+    });
+};
+
+size_t Nip44BatchCipher::workerCount() const
+{
+    return this->_pool->size();
+};
+
+vector<Nip44BatchResult> Nip44BatchCipher::_process(
+    const vector<Nip44BatchItem>& items,
+    function<Nip44BatchError(const NCContext*, const Nip44BatchItem&, string&)> operation
+)
+{
+    vector<Nip44BatchResult> results(items.size());
+    this->_pool->parallelFor(
+        items.size(),
+        [&items, &results, &operation](size_t i)
+        {
+            results[i].error = operation(NoscryptContextPool::local(), items[i], results[i].output);
+            if (results[i].error != Nip44BatchError::NONE)
+            {
+                results[i].output.clear();
+            }
+        },
+        chunksPerWorker);
+
+    return results;
+};
+
+Nip44BatchError Nip44BatchCipher::_getConversationKey(
+    const NCContext* context,
+    const string& peerPublicKey,
+    uint8_t conversationKey[NC_CONV_KEY_SIZE]
+)
+{
+    NCPublicKey remoteKey;
+    if (!decodeHex(peerPublicKey, remoteKey.key, sizeof(remoteKey.key)))
+    {
+        return Nip44BatchError::INVALID_PUBLIC_KEY;
+    }
+
+    if (!this->_conversationKeys->get(context, this->_localKey, remoteKey, conversationKey))
+    {
+        PLOG_VERBOSE << "Unable to derive a NIP-44 conversation key for peer " << peerPublicKey << ".";
+        return Nip44BatchError::KEY_DERIVATION_FAILED;
+    }
+
+    return Nip44BatchError::NONE;
+};
@@ -1,15 +1,22 @@
 #include <plog/Init.h>
 #include <plog/Log.h>
 
-#include <openssl/evp.h>
+#include <cstring>
+
+#include <openssl/crypto.h>
 
 #include "nostr_secure_rng.hpp"
 #include "noscrypt_cipher.hpp"
+#include "../internal/logging.hpp"
 #include "../internal/noscrypt_logger.hpp"
 
 using namespace std;
 using namespace nostr::cryptography;
 
+static constexpr uint8_t nip44Version = 2;
+static constexpr size_t nip44VersionSize = 1;
+static constexpr size_t nip44LengthPrefixSize = 2;
+static constexpr size_t nip44MaxMessageSize = 65535;
 
 NoscryptCipher::NoscryptCipher(NoscryptCipherVersion version, NoscryptCipherMode mode) :
  _cipher(version, mode)
@@ -37,23 +44,46 @@ std::string NoscryptCipher::update(
     const std::shared_ptr<const NCPublicKey> remoteKey,
     const std::string& input
 )
+{
+    vector<uint8_t> output;
+    bool isSuccess = this->update(
+        libContext.get(),
+        localKey.get(),
+        remoteKey.get(),
+        reinterpret_cast<const uint8_t*>(input.data()),
+        input.size(),
+        output
+    );
+
+    return isSuccess
+        ? string(output.begin(), output.end())
+        : string();
+}
+
+bool NoscryptCipher::update(
+    const NCContext* libContext,
+    const NCSecretKey* localKey,
+    const NCPublicKey* remoteKey,
+    const uint8_t* input,
+    size_t inputSize,
+    vector<uint8_t>& output
+)
 {
     NCResult result;
+    output.clear();
 
     //Argument exception if the input is empty
-    if (input.empty())
+    if (inputSize == 0)
     {
-        return string();
+        return false;
     }
 
-    //Safely convert the string to a vector of bytes (allocates and copies, so maybe speed up later)
-    const vector<uint8_t> inputBuffer(input.begin(), input.end());
-
-    result = this->_cipher.setInput(inputBuffer);
+    //The input is read in place, noscrypt only keeps a pointer to it until the update completes
+    result = this->_cipher.setInput(input, inputSize);
     if (result != NC_SUCCESS)
     {
         NC_LOG_ERROR(result);
-        return string();
+        return false;
     }
 
     /*
@@ -75,72 +105,331 @@ std::string NoscryptCipher::update(
     if (result != NC_SUCCESS)
     {
         NC_LOG_ERROR(result);
-        return string();
+        return false;
     }
 
     /*
-    * Time to read the ciper output by getting the size of the output, then creating
-    * a string to store it to
+    * Time to read the ciper output by getting the size of the output, then reading it into
+    * the caller's buffer, which only reallocates when it is too small
     */
 
     NCResult outputSize = this->_cipher.outputSize();
     if (outputSize <= 0)
     {
         NC_LOG_ERROR(outputSize);
-        return string();
+        return false;
     }
 
-    //Alloc vector for reading input data (maybe only alloc once)
-    vector<uint8_t> output(outputSize);
+    output.resize(outputSize);
 
     result = this->_cipher.readOutput(output);
     if (result != outputSize)
     {
         NC_LOG_ERROR(result);
-        return string();
+        output.clear();
+        return false;
     }
 
-    return string(output.begin(), output.end());
+    return true;
 }
 
-string NoscryptCipher::naiveEncodeBase64(const std::string& str)
+NoscryptCipherMode NoscryptCipher::mode() const
 {
-    // Compute base64 size and allocate a string buffer of that size.
-    const size_t encodedSize = NoscryptCipher::base64EncodedSize(str.size());
-
-    auto encodedData = make_unique<uint8_t>(encodedSize);
+    return this->_cipher.mode();
+}
 
-    // Encode the input string to base64.
-    EVP_EncodeBlock(
-        encodedData.get(),
-        reinterpret_cast<const uint8_t*>(str.c_str()),
-        str.size()
+string NoscryptCipher::encryptNip44(
+    const NCContext* libContext,
+    const uint8_t conversationKey[NC_CONV_KEY_SIZE],
+    const string& input
+)
+{
+    vector<uint8_t> payload;
+    bool isSuccess = NoscryptCipher::encryptNip44(
+        libContext,
+        conversationKey,
+        reinterpret_cast<const uint8_t*>(input.data()),
+        input.size(),
+        payload
     );
 
-    // Construct the encoded string from the buffer.
-    return string(
-        reinterpret_cast<char*>(encodedData.get()),
-        encodedSize
+    return isSuccess
+        ? string(payload.begin(), payload.end())
+        : string();
+};
+
+string NoscryptCipher::decryptNip44(
+    const NCContext* libContext,
+    const uint8_t conversationKey[NC_CONV_KEY_SIZE],
+    const string& payload
+)
+{
+    vector<uint8_t> output;
+    bool isSuccess = NoscryptCipher::decryptNip44(
+        libContext,
+        conversationKey,
+        reinterpret_cast<const uint8_t*>(payload.data()),
+        payload.size(),
+        output
     );
-}
 
-string NoscryptCipher::naiveDecodeBase64(const string& str)
+    string message = isSuccess
+        ? string(output.begin(), output.end())
+        : string();
+    NostrSecureRng::zero(output.data(), output.size());
+
+    return message;
+};
+
+bool NoscryptCipher::encryptNip44(
+    const NCContext* libContext,
+    const uint8_t conversationKey[NC_CONV_KEY_SIZE],
+    const uint8_t* input,
+    size_t inputSize,
+    vector<uint8_t>& payload
+)
 {
-    // Compute the size of the decoded string and allocate a buffer of that size.
-    const size_t decodedSize = NoscryptCipher::base64DecodedSize(str.size());
+    uint8_t nonce[NC_ENCRYPTION_NONCE_SIZE];
+    NostrSecureRng::fill(nonce, sizeof(nonce));
 
-    auto decodedData = make_unique<uint8_t>(decodedSize);
+    return NoscryptCipher::encryptNip44(libContext, conversationKey, nonce, input, inputSize, payload);
+};
 
-    // Decode the input string from base64.
-    EVP_DecodeBlock(
-        decodedData.get(),
-        reinterpret_cast<const uint8_t*>(str.c_str()),
-        str.size()
-    );
+bool NoscryptCipher::encryptNip44(
+    const NCContext* libContext,
+    const uint8_t conversationKey[NC_CONV_KEY_SIZE],
+    const uint8_t nonce[NC_ENCRYPTION_NONCE_SIZE],
+    const uint8_t* input,
+    size_t inputSize,
+    vector<uint8_t>& payload
+)
+{
+    payload.clear();
 
-    // Construct the decoded string from the buffer.
-    return string(
-        reinterpret_cast<char*>(decodedData.get()),
-        decodedSize
-    );
+    if (inputSize == 0 || inputSize > nip44MaxMessageSize)
+    {
+        PLOG_ERROR << "NIP-44 messages must be between 1 and " << nip44MaxMessageSize << " bytes long.";
+        return false;
+    }
+
+    /*
+    * The plaintext is prefixed with its big-endian length and zero padded, so the ciphertext
+    * only reveals the length bucket of the message.  It is staged in a per-thread buffer that
+    * keeps its capacity, and is zeroed after every use.
+    */
+    thread_local vector<uint8_t> padded;
+    const size_t paddedSize = nip44LengthPrefixSize + NoscryptCipher::nip44PaddedSize(inputSize);
+    padded.assign(paddedSize, 0);
+    padded[0] = static_cast<uint8_t>(inputSize >> 8);
+    padded[1] = static_cast<uint8_t>(inputSize & 0xff);
+    memcpy(padded.data() + nip44LengthPrefixSize, input, inputSize);
+
+    // The payload is laid out as `version || nonce || ciphertext || mac`.
+    payload.resize(nip44VersionSize + NC_ENCRYPTION_NONCE_SIZE + paddedSize + NC_ENCRYPTION_MAC_SIZE);
+    uint8_t* payloadNonce = payload.data() + nip44VersionSize;
+    uint8_t* ciphertext = payloadNonce + NC_ENCRYPTION_NONCE_SIZE;
+    uint8_t* mac = ciphertext + paddedSize;
+
+    payload[0] = nip44Version;
+    memcpy(payloadNonce, nonce, NC_ENCRYPTION_NONCE_SIZE);
+
+    uint8_t hmacKey[NC_HMAC_KEY_SIZE];
+    NCEncryptionArgs args = {};
+    NCEncryptionSetProperty(&args, NC_ENC_SET_VERSION, NC_ENC_VERSION_NIP44);
+    NCEncryptionSetPropertyEx(&args, NC_ENC_SET_IV, payloadNonce, NC_ENCRYPTION_NONCE_SIZE);
+    NCEncryptionSetPropertyEx(&args, NC_ENC_SET_NIP44_MAC_KEY, hmacKey, sizeof(hmacKey));
+    NCEncryptionSetData(&args, padded.data(), ciphertext, static_cast<uint32_t>(paddedSize));
+
+    NCResult result = NCEncryptEx(libContext, conversationKey, &args);
+    if (result == NC_SUCCESS)
+    {
+        // The MAC covers the nonce and the ciphertext, which are contiguous in the payload.
+        result = NCComputeMac(
+            libContext,
+            hmacKey,
+            payloadNonce,
+            static_cast<uint32_t>(NC_ENCRYPTION_NONCE_SIZE + paddedSize),
+            mac
+        );
+    }
+
+    NostrSecureRng::zero(hmacKey, sizeof(hmacKey));
+    NostrSecureRng::zero(padded.data(), padded.size());
+
+    if (result != NC_SUCCESS)
+    {
+        NC_LOG_ERROR(result);
+        payload.clear();
+        return false;
+    }
+
+    return true;
+};
+
+bool NoscryptCipher::decryptNip44(
+    const NCContext* libContext,
+    const uint8_t conversationKey[NC_CONV_KEY_SIZE],
+    const uint8_t* payload,
+    size_t payloadSize,
+    vector<uint8_t>& output
+)
+{
+    output.clear();
+
+    const size_t minPayloadSize = nip44VersionSize
+        + NC_ENCRYPTION_NONCE_SIZE
+        + nip44LengthPrefixSize
+        + NoscryptCipher::nip44PaddedSize(1)
+        + NC_ENCRYPTION_MAC_SIZE;
+
+    if (payloadSize < minPayloadSize)
+    {
+        PLOG_ERROR << "The NIP-44 payload is too short.";
+        return false;
+    }
+
+    if (payload[0] != nip44Version)
+    {
+        PLOG_ERROR << "Unsupported NIP-44 payload version: " << static_cast<int>(payload[0]);
+        return false;
+    }
+
+    const uint8_t* nonce = payload + nip44VersionSize;
+    const uint8_t* ciphertext = nonce + NC_ENCRYPTION_NONCE_SIZE;
+    const size_t paddedSize = payloadSize - nip44VersionSize - NC_ENCRYPTION_NONCE_SIZE - NC_ENCRYPTION_MAC_SIZE;
+    const uint8_t* mac = ciphertext + paddedSize;
+
+    // The padded plaintext is decrypted straight into the output buffer, then shifted down over
+    // its length prefix once it has been checked.
+    output.resize(paddedSize);
+    uint8_t hmacKey[NC_HMAC_KEY_SIZE];
+    uint8_t expectedMac[NC_ENCRYPTION_MAC_SIZE];
+
+    NCEncryptionArgs args = {};
+    NCEncryptionSetProperty(&args, NC_ENC_SET_VERSION, NC_ENC_VERSION_NIP44);
+    NCEncryptionSetPropertyEx(&args, NC_ENC_SET_IV, const_cast<uint8_t*>(nonce), NC_ENCRYPTION_NONCE_SIZE);
+    NCEncryptionSetPropertyEx(&args, NC_ENC_SET_NIP44_MAC_KEY, hmacKey, sizeof(hmacKey));
+    NCEncryptionSetData(&args, ciphertext, output.data(), static_cast<uint32_t>(paddedSize));
+
+    NCResult result = NCDecryptEx(libContext, conversationKey, &args);
+    if (result == NC_SUCCESS)
+    {
+        result = NCComputeMac(
+            libContext,
+            hmacKey,
+            nonce,
+            static_cast<uint32_t>(NC_ENCRYPTION_NONCE_SIZE + paddedSize),
+            expectedMac
+        );
+    }
+    NostrSecureRng::zero(hmacKey, sizeof(hmacKey));
+
+    if (result != NC_SUCCESS)
+    {
+        NC_LOG_ERROR(result);
+        NostrSecureRng::zero(output.data(), output.size());
+        output.clear();
+        return false;
+    }
+
+    if (CRYPTO_memcmp(expectedMac, mac, sizeof(expectedMac)) != 0)
+    {
+        PLOG_ERROR << "The NIP-44 payload MAC does not match.";
+        NostrSecureRng::zero(output.data(), output.size());
+        output.clear();
+        return false;
+    }
+
+    // The padding must be exactly what the sender should have produced for the stated length.
+    const size_t messageSize = (static_cast<size_t>(output[0]) << 8) | output[1];
+    if (messageSize == 0
+        || nip44LengthPrefixSize + NoscryptCipher::nip44PaddedSize(messageSize) != paddedSize)
+    {
+        PLOG_ERROR << "The NIP-44 payload has invalid padding.";
+        NostrSecureRng::zero(output.data(), output.size());
+        output.clear();
+        return false;
+    }
+
+    memmove(output.data(), output.data() + nip44LengthPrefixSize, messageSize);
+    NostrSecureRng::zero(output.data() + messageSize, output.size() - messageSize);
+    output.resize(messageSize);
+
+    return true;
+};
+
+size_t NoscryptCipher::nip44PaddedSize(const size_t n)
+{
+    if (n <= 32)
+    {
+        return 32;
+    }
+
+    // Messages are padded to a multiple of a chunk size that grows with the next power of two.
+    size_t nextPower = 1;
+    while (nextPower < n)
+    {
+        nextPower <<= 1;
+    }
+
+    const size_t chunk = nextPower <= 256 ? 32 : nextPower / 8;
+    return chunk * ((n - 1) / chunk + 1);
+};
+
+NoscryptCipherPool::Lease::Lease(NoscryptCipherPool* pool, unique_ptr<NoscryptCipher> cipher)
+    : _pool(pool), _cipher(move(cipher)) { };
+
+NoscryptCipherPool::Lease::Lease(Lease&& other) noexcept
+    : _pool(other._pool), _cipher(move(other._cipher)) { };
+
+NoscryptCipherPool::Lease::~Lease()
+{
+    if (this->_cipher)
+    {
+        this->_pool->_release(move(this->_cipher));
+    }
+};
+
+NoscryptCipherPool::NoscryptCipherPool(NoscryptCipherVersion version, size_t maxIdleCount)
+    : _version(version), _maxIdleCount(maxIdleCount) { };
+
+NoscryptCipherPool::Lease NoscryptCipherPool::acquire(NoscryptCipherMode mode)
+{
+    {
+        lock_guard<mutex> lock(this->_idleMutex);
+        auto& idleCiphers = mode == NoscryptCipherMode::CIPHER_MODE_ENCRYPT
+            ? this->_idleEncryptCiphers
+            : this->_idleDecryptCiphers;
+
+        if (!idleCiphers.empty())
+        {
+            unique_ptr<NoscryptCipher> cipher = move(idleCiphers.back());
+            idleCiphers.pop_back();
+            return Lease(this, move(cipher));
+        }
+    }
+
+    return Lease(this, make_unique<NoscryptCipher>(this->_version, mode));
+};
+
+size_t NoscryptCipherPool::idleCount(NoscryptCipherMode mode) const
+{
+    lock_guard<mutex> lock(this->_idleMutex);
+    return mode == NoscryptCipherMode::CIPHER_MODE_ENCRYPT
+        ? this->_idleEncryptCiphers.size()
+        : this->_idleDecryptCiphers.size();
+};
+
+void NoscryptCipherPool::_release(unique_ptr<NoscryptCipher> cipher)
+{
+    lock_guard<mutex> lock(this->_idleMutex);
+    auto& idleCiphers = cipher->mode() == NoscryptCipherMode::CIPHER_MODE_ENCRYPT
+        ? this->_idleEncryptCiphers
+        : this->_idleDecryptCiphers;
+
+    // Ciphers beyond the idle limit are freed, which zeroes their state.
+    if (idleCiphers.size() < this->_maxIdleCount)
+    {
+        idleCiphers.push_back(move(cipher));
+    }
 };
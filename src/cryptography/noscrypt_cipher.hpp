@@ -1,6 +1,9 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 #include <noscrypt.h>
 #include <noscryptutil.h>
@@ -70,7 +73,16 @@ public:
         const std::shared_ptr<const NCPublicKey> remoteKey
     ) const
     {
-        return NCUtilCipherUpdate(_cipher, libContext.get(), localKey.get(), remoteKey.get());
+        return update(libContext.get(), localKey.get(), remoteKey.get());
+    }
+
+    NCResult update(
+        const NCContext* libContext,
+        const NCSecretKey* localKey,
+        const NCPublicKey* remoteKey
+    ) const
+    {
+        return NCUtilCipherUpdate(_cipher, libContext, localKey, remoteKey);
     }
 
     NCResult setIV(std::vector<uint8_t>& iv) const
@@ -117,17 +129,27 @@ public:
 
     NCResult readOutput(std::vector<uint8_t>& output) const
     {
-        return NCUtilCipherReadOutput(_cipher, output.data(), (uint32_t)output.size());
+        return readOutput(output.data(), output.size());
+    }
+
+    NCResult readOutput(uint8_t* output, size_t outputSize) const
+    {
+        return NCUtilCipherReadOutput(_cipher, output, (uint32_t)outputSize);
     }
 
     NCResult setInput(const std::vector<uint8_t>& input) const
+    {
+        return setInput(input.data(), input.size());
+    }
+
+    NCResult setInput(const uint8_t* input, size_t inputSize) const
     {
         /*
         * Assign and validate input string. Init can be only called multiple times
         * without side effects when the reusable flag is set. (currently set)
         */
 
-        return NCUtilCipherInit(_cipher, input.data(), input.size());
+        return NCUtilCipherInit(_cipher, input, (uint32_t)inputSize);
     }
 };
 
@@ -165,29 +187,184 @@ public:
         const std::string& input
     );
 
+    /*
+     * @brief Performs the cipher operation on a buffer and writes the result to a caller-owned
+     * buffer, so repeated calls allocate nothing once the buffer has grown to fit.
+     * @param libContext The noscrypt library context.
+     * @param localKey The local secret key used to encrypt/decrypt the data.
+     * @param remoteKey The remote public key used to encrypt/decrypt the data.
+     * @param input A pointer to the data to encrypt/decrypt.
+     * @param inputSize The number of bytes to encrypt/decrypt.
+     * @param output The buffer that receives the result.  It is resized to the size of the
+     * result, and its capacity is kept between calls.
+     * @returns True if the operation succeeded.  On failure `output` is cleared.
+     */
+    bool update(
+        const NCContext* libContext,
+        const NCSecretKey* localKey,
+        const NCPublicKey* remoteKey,
+        const uint8_t* input,
+        size_t inputSize,
+        std::vector<uint8_t>& output
+    );
+
+    /*
+     * @brief Returns the mode the cipher was created with.
+     */
+    NoscryptCipherMode mode() const;
+
+    /*
+     * @brief Encrypts a message into a NIP-44 v2 payload using a precomputed conversation key.
+     * @param libContext The noscrypt library context.
+     * @param conversationKey The conversation key shared by the sender and the recipient.
+     * @param input The message to encrypt.  It must be between 1 and 65535 bytes long.
+     * @returns The binary payload `version || nonce || ciphertext || mac`, which must still be
+     * base64 encoded, or an empty string if the message could not be encrypted.
+     * @remark Unlike `update`, the conversation key is not derived on each call, so callers that
+     * exchange many messages with the same peer should cache it.
+     */
+    static std::string encryptNip44(
+        const NCContext* libContext,
+        const uint8_t conversationKey[NC_CONV_KEY_SIZE],
+        const std::string& input
+    );
+
+    /*
+     * @brief Decrypts a binary NIP-44 v2 payload using a precomputed conversation key.
+     * @param libContext The noscrypt library context.
+     * @param conversationKey The conversation key shared by the sender and the recipient.
+     * @param payload The base64-decoded payload.
+     * @returns The decrypted message, or an empty string if the payload is malformed or its MAC
+     * does not match.
+     */
+    static std::string decryptNip44(
+        const NCContext* libContext,
+        const uint8_t conversationKey[NC_CONV_KEY_SIZE],
+        const std::string& payload
+    );
+
+    /*
+     * @brief Encrypts a message into a NIP-44 v2 payload in a caller-owned buffer.
+     * @param payload The buffer that receives the binary payload.  It is resized to the size of
+     * the payload, and its capacity is kept between calls.
+     * @returns True if the message was encrypted.  On failure `payload` is cleared.
+     * @remark See the string overload for the remaining parameters.  The padded plaintext is
+     * staged in a per-thread buffer, so steady-state calls do not allocate.
+     */
+    static bool encryptNip44(
+        const NCContext* libContext,
+        const uint8_t conversationKey[NC_CONV_KEY_SIZE],
+        const uint8_t* input,
+        size_t inputSize,
+        std::vector<uint8_t>& payload
+    );
+
+    /*
+     * @brief Encrypts a message into a NIP-44 v2 payload with the given nonce.
+     * @param nonce The 32-byte nonce.  It must never be reused with the same conversation key,
+     * so outside of tests against fixed vectors, use the overload that draws a random nonce.
+     * @remark See the overload without a nonce for the remaining parameters.
+     */
+    static bool encryptNip44(
+        const NCContext* libContext,
+        const uint8_t conversationKey[NC_CONV_KEY_SIZE],
+        const uint8_t nonce[NC_ENCRYPTION_NONCE_SIZE],
+        const uint8_t* input,
+        size_t inputSize,
+        std::vector<uint8_t>& payload
+    );
+
+    /*
+     * @brief Decrypts a binary NIP-44 v2 payload into a caller-owned buffer.
+     * @param output The buffer that receives the decrypted message.  It is resized to the size of
+     * the message, and its capacity is kept between calls.
+     * @returns True if the payload was decrypted.  On failure `output` is cleared.
+     * @remark See the string overload for the remaining parameters.
+     */
+    static bool decryptNip44(
+        const NCContext* libContext,
+        const uint8_t conversationKey[NC_CONV_KEY_SIZE],
+        const uint8_t* payload,
+        size_t payloadSize,
+        std::vector<uint8_t>& output
+    );
+
     /**
-     * @brief Computes the length of a base64 encoded string.
-     * @param n The length of the string to be encoded.
-     * @return The length of the resulting base64 encoded string.
+     * @brief Computes the length to which NIP-44 pads a message before encryption.
+     * @param n The length of the message.
+     * @return The padded length, excluding the two-byte length prefix.
      */
-    inline static size_t base64EncodedSize(const size_t n)
-    {
-        return (((n + 2) / 3) << 2) + 1;
-    };
+    static size_t nip44PaddedSize(const size_t n);
+};
 
+/**
+ * @brief A pool of reusable ciphers of one version, kept separately for each mode.
+ * @remark Allocating a noscrypt cipher context and its IV buffer costs more than encrypting a
+ * short message, so high-rate callers lease a cipher from the pool for each message and return it
+ * when the lease ends.  Leases must not outlive the pool.
+ */
+class NoscryptCipherPool
+{
+public:
     /**
-     * @brief Computes the length of a string decoded from base64.
-     * @param n The length of the base64 encoded string.
-     * @return The length of the decoded string.
+     * @brief Exclusive use of a pooled cipher, which is returned to the pool on destruction.
      */
-    inline static size_t base64DecodedSize(const size_t n)
+    class Lease
     {
-        return (n * 3) >> 2;
+    public:
+        Lease(Lease&& other) noexcept;
+
+        Lease& operator=(Lease&& other) = delete;
+
+        Lease(const Lease&) = delete;
+
+        Lease& operator=(const Lease&) = delete;
+
+        ~Lease();
+
+        NoscryptCipher& operator*() const { return *this->_cipher; };
+
+        NoscryptCipher* operator->() const { return this->_cipher.get(); };
+
+    private:
+        friend class NoscryptCipherPool;
+
+        Lease(NoscryptCipherPool* pool, std::unique_ptr<NoscryptCipher> cipher);
+
+        NoscryptCipherPool* _pool;
+        std::unique_ptr<NoscryptCipher> _cipher;
     };
 
-    static std::string naiveEncodeBase64(const std::string& str);
+    /**
+     * @param version The cipher version of every cipher in the pool.
+     * @param maxIdleCount The maximum number of idle ciphers kept for each mode.  Ciphers returned
+     * beyond this number are freed.
+     */
+    NoscryptCipherPool(NoscryptCipherVersion version, size_t maxIdleCount = 16);
+
+    NoscryptCipherPool(const NoscryptCipherPool&) = delete;
+
+    NoscryptCipherPool& operator=(const NoscryptCipherPool&) = delete;
+
+    /**
+     * @brief Leases an idle cipher of the given mode, creating one if none is idle.
+     */
+    Lease acquire(NoscryptCipherMode mode);
+
+    /**
+     * @brief Returns the number of idle ciphers of the given mode.
+     */
+    size_t idleCount(NoscryptCipherMode mode) const;
+
+private:
+    const NoscryptCipherVersion _version;
+    const size_t _maxIdleCount;
+
+    std::vector<std::unique_ptr<NoscryptCipher>> _idleEncryptCiphers;
+    std::vector<std::unique_ptr<NoscryptCipher>> _idleDecryptCiphers;
+    mutable std::mutex _idleMutex;
 
-    static std::string naiveDecodeBase64(const std::string& str);
+    void _release(std::unique_ptr<NoscryptCipher> cipher);
 };
 } // namespace cryptography
 } // namespace nostr
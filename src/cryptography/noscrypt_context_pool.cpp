@@ -0,0 +1,68 @@
+#include <atomic>
+
+#include <plog/Init.h>
+#include <plog/Log.h>
+#include <noscryptutil.h>
+
+#include "cryptography/noscrypt_context_pool.hpp"
+#include "nostr_secure_rng.hpp"
+#include "../internal/logging.hpp"
+#include "../internal/noscrypt_logger.hpp"
+
+using namespace nostr::cryptography;
+using namespace std;
+
+static atomic<size_t> liveContextCount{ 0 };
+
+const NCContext* NoscryptContextPool::local()
+{
+    // The context is released, and so destroyed, when the thread's storage is torn down.
+    thread_local shared_ptr<NCContext> threadContext;
+    if (!threadContext)
+    {
+        threadContext = NoscryptContextPool::create();
+    }
+
+    return threadContext.get();
+};
+
+shared_ptr<NCContext> NoscryptContextPool::create()
+{
+    NCContext* context = NCUtilContextAlloc();
+    if (context == nullptr)
+    {
+        PLOG_ERROR << "Unable to allocate a noscrypt context.";
+        return nullptr;
+    }
+
+    uint8_t randomEntropy[NC_CONTEXT_ENTROPY_SIZE];
+    NostrSecureRng::fill(randomEntropy, sizeof(randomEntropy));
+
+    NCResult initResult = NCInitContext(context, randomEntropy);
+    NostrSecureRng::zero(randomEntropy, sizeof(randomEntropy));
+
+    if (initResult != NC_SUCCESS)
+    {
+        NC_LOG_ERROR(initResult);
+        NCUtilContextFree(context);
+        return nullptr;
+    }
+
+    liveContextCount.fetch_add(1, memory_order_relaxed);
+
+    return shared_ptr<NCContext>(
+        context,
+        [](NCContext* context)
+        {
+            // Destroying the context wipes its randomization state before the memory is freed.
+            NCDestroyContext(context);
+            NCUtilContextFree(context);
+            liveContextCount.fetch_sub(1, memory_order_relaxed);
+        }
+    );
+};
+
+size_t NoscryptContextPool::liveCount()
+{
+    return liveContextCount.load(memory_order_relaxed);
+};
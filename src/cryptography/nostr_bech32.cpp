@@ -1,5 +1,6 @@
 #include <cryptography/nostr_bech32.hpp>
 #include <stdio.h>
+#include <cctype>
 namespace nostr
 {
 namespace encoding
@@ -623,6 +624,219 @@ bool NostrBech32::parseNostrBech32Naddr(BytesArray &encoding, NostrBech32Encodin
 }
 
 
+void NostrBech32Entity::clear(NostrBech32Type type)
+{
+    _type = type;
+    _payloadLength = 0;
+    _special = Span();
+    _hasSpecial = false;
+    _author = Span();
+    _hasAuthor = false;
+    _kind = 0;
+    _hasKind = false;
+    _relayCount = 0;
+}
+
+bool NostrBech32Entity::_append(const uint8_t *value, std::size_t length, Span &span)
+{
+    if (length > 0xFF || length > payloadCapacity - _payloadLength)
+        return false;
+
+    memcpy(_payload + _payloadLength, value, length);
+    span.offset = _payloadLength;
+    span.length = length;
+    _payloadLength += length;
+    return true;
+}
+
+bool NostrBech32Entity::setSpecial(const uint8_t *value, std::size_t length)
+{
+    if (_hasSpecial || !_append(value, length, _special))
+        return false;
+
+    _hasSpecial = true;
+    return true;
+}
+
+bool NostrBech32Entity::setAuthor(const uint8_t *pubkey)
+{
+    if (!_append(pubkey, KEY_LENGTH, _author))
+        return false;
+
+    _hasAuthor = true;
+    return true;
+}
+
+bool NostrBech32Entity::addRelay(std::string_view relay)
+{
+    if (_relayCount >= MAX_RELAYS
+        || !_append(reinterpret_cast<const uint8_t *>(relay.data()), relay.size(), _relays[_relayCount]))
+        return false;
+
+    _relayCount++;
+    return true;
+}
+
+// The human readable part for each entity type, indexed by NostrBech32Type.
+static const char *const entityPrefixes[] = {
+    nullptr, "note", "npub", "nprofile", "nevent", nullptr, "naddr", "nsec"
+};
+
+static bool isTlvEntity(NostrBech32Type type)
+{
+    return type == NOSTR_BECH32_NPROFILE || type == NOSTR_BECH32_NEVENT || type == NOSTR_BECH32_NADDR;
+}
+
+static uint8_t *writeTlv(uint8_t *stream, uint8_t type, const uint8_t *value, std::size_t length)
+{
+    stream[0] = type;
+    stream[1] = length;
+    memcpy(stream + 2, value, length);
+    return stream + 2 + length;
+}
+
+std::size_t NostrBech32::encodeEntity(const NostrBech32Entity &input, char *output, std::size_t outputCapacity)
+{
+    NostrBech32Type type = input.type();
+    if (type < NOSTR_BECH32_NOTE || type > NOSTR_BECH32_NSEC || entityPrefixes[type] == nullptr)
+        return 0;
+
+    if (type != NOSTR_BECH32_NADDR && input.specialLength() != KEY_LENGTH)
+        return 0;
+    if (type == NOSTR_BECH32_NADDR && (!input.hasAuthor() || !input.hasKind()))
+        return 0;
+
+    const char *hrp = entityPrefixes[type];
+    if (!isTlvEntity(type))
+    {
+        return Bech32::encodeBytes(
+            hrp, strlen(hrp), input.special(), KEY_LENGTH, BECH32_ENCODING_BECH32, output, outputCapacity);
+    }
+
+    // TLVs are written in the same order as `encodeNostrBech32`: special, relays, author, kind.
+    uint8_t stream[NostrBech32Entity::maxStreamLength];
+    uint8_t *end = writeTlv(stream, TLV_SPECIAL, input.special(), input.specialLength());
+    for (std::size_t i = 0; i < input.relayCount(); i++)
+    {
+        std::string_view relay = input.relay(i);
+        end = writeTlv(end, TLV_RELAY, reinterpret_cast<const uint8_t *>(relay.data()), relay.size());
+    }
+    if (input.hasAuthor())
+        end = writeTlv(end, TLV_AUTHOR, input.author(), KEY_LENGTH);
+    if (input.hasKind() && type != NOSTR_BECH32_NPROFILE)
+    {
+        uint8_t kind[4] = {
+            (uint8_t)(input.kind() >> 24), (uint8_t)(input.kind() >> 16),
+            (uint8_t)(input.kind() >> 8), (uint8_t)input.kind()
+        };
+        end = writeTlv(end, TLV_KIND, kind, sizeof(kind));
+    }
+
+    return Bech32::encodeBytes(
+        hrp, strlen(hrp), stream, end - stream, BECH32_ENCODING_BECH32, output, outputCapacity);
+}
+
+bool NostrBech32::parseEntity(const char *input, std::size_t inputLength, NostrBech32Entity &parsed)
+{
+    // The payload is decoded straight into the entity, and the spans point at the TLV values
+    // within it.
+    std::size_t hrpLength, streamLength;
+    if (Bech32::decodeBytes(input, inputLength, hrpLength, parsed._payload, sizeof(parsed._payload), streamLength)
+        != BECH32_ENCODING_BECH32)
+        return false;
+
+    char hrp[9] = { 0 };
+    if (hrpLength >= sizeof(hrp))
+        return false;
+    for (std::size_t i = 0; i < hrpLength; i++)
+        hrp[i] = std::tolower(static_cast<unsigned char>(input[i]));
+
+    NostrBech32Type type = NOSTR_BECH32_NRELAY;
+    for (int candidate = NOSTR_BECH32_NOTE; candidate <= NOSTR_BECH32_NSEC; candidate++)
+    {
+        if (entityPrefixes[candidate] != nullptr && strcmp(hrp, entityPrefixes[candidate]) == 0)
+            type = static_cast<NostrBech32Type>(candidate);
+    }
+    if (type == NOSTR_BECH32_NRELAY)
+        return false;
+
+    parsed.clear(type);
+    parsed._payloadLength = streamLength;
+
+    if (!isTlvEntity(type))
+    {
+        if (streamLength != KEY_LENGTH)
+            return false;
+        parsed._special.length = KEY_LENGTH;
+        parsed._hasSpecial = true;
+        return true;
+    }
+
+    const uint8_t *stream = parsed._payload;
+    std::size_t cur = 0;
+    while (cur < streamLength)
+    {
+        if (streamLength - cur < 2)
+            return false;
+
+        uint8_t tlvType = stream[cur];
+        uint8_t length = stream[cur + 1];
+        cur += 2;
+        if (length > streamLength - cur)
+            return false;
+
+        NostrBech32Entity::Span span;
+        span.offset = cur;
+        span.length = length;
+        cur += length;
+
+        // Only the first TLV of each singular type counts, as with `findTlv`.
+        switch (tlvType)
+        {
+        case TLV_SPECIAL:
+            if (!parsed._hasSpecial)
+            {
+                parsed._special = span;
+                parsed._hasSpecial = true;
+            }
+            break;
+        case TLV_RELAY:
+            if (parsed._relayCount < MAX_RELAYS)
+                parsed._relays[parsed._relayCount++] = span;
+            break;
+        case TLV_AUTHOR:
+            if (!parsed._hasAuthor)
+            {
+                if (length != KEY_LENGTH)
+                    return false;
+                parsed._author = span;
+                parsed._hasAuthor = true;
+            }
+            break;
+        case TLV_KIND:
+            if (!parsed._hasKind)
+            {
+                if (length != 4)
+                    return false;
+                const uint8_t *kind = stream + span.offset;
+                parsed.setKind(((uint32_t)kind[0] << 24) | ((uint32_t)kind[1] << 16) | ((uint32_t)kind[2] << 8) | kind[3]);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (!parsed._hasSpecial)
+        return false;
+    if (type != NOSTR_BECH32_NADDR && parsed._special.length != KEY_LENGTH)
+        return false;
+    if (type == NOSTR_BECH32_NADDR && (!parsed._hasAuthor || !parsed._hasKind))
+        return false;
+
+    return true;
+}
+
 bool NostrBech32::parseNostrBech32(std::string &encoding, NostrBech32Encoding &parsed)
 {
     std::string hrp;
@@ -0,0 +1,148 @@
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "cryptography/nostr_content_scanner.hpp"
+#include "../internal/hex_encoding.hpp"
+
+using namespace std;
+using namespace nostr::encoding;
+
+#pragma region Local Statics
+
+static const char uriScheme[] = "nostr:";
+
+static const size_t uriSchemeLength = sizeof(uriScheme) - 1;
+
+///< The entity prefixes that are reported, each with its separator.
+static const string_view referencePrefixes[] = {
+    "npub1", "nprofile1", "note1", "nevent1", "naddr1"
+};
+
+static inline bool isBech32Character(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9');
+};
+
+#pragma endregion
+
+string NostrContentReference::hexId() const
+{
+    return nostr::internal::encodeHex(this->id, sizeof(this->id));
+};
+
+size_t NostrContentScanner::findScheme(string_view content, size_t from)
+{
+    const char* data = content.data();
+    size_t size = content.size();
+    size_t i = from;
+
+#if defined(__SSE2__)
+    // Candidates must have 'n' at their first byte, 'o' at their second, and ':' at their sixth,
+    // so three unaligned loads rule out almost every position in a block at once.
+    const __m128i n = _mm_set1_epi8('n');
+    const __m128i o = _mm_set1_epi8('o');
+    const __m128i colon = _mm_set1_epi8(':');
+    for (; i + 16 + uriSchemeLength - 1 <= size; i += 16)
+    {
+        __m128i first = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), n);
+        __m128i second = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1)), o);
+        __m128i last = _mm_cmpeq_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + uriSchemeLength - 1)),
+            colon);
+
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_and_si128(first, second), last));
+        while (mask != 0)
+        {
+            size_t candidate = i + __builtin_ctz(mask);
+            if (memcmp(data + candidate, uriScheme, uriSchemeLength) == 0)
+            {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; i + uriSchemeLength <= size; i++)
+    {
+        if (data[i] == 'n' && memcmp(data + i, uriScheme, uriSchemeLength) == 0)
+        {
+            return i;
+        }
+    }
+
+    return string_view::npos;
+};
+
+size_t NostrContentScanner::scan(string_view content, vector<NostrContentReference>& references)
+{
+    return scan(content, [&references](const NostrContentReference& reference, const NostrBech32Entity&)
+    {
+        references.push_back(reference);
+    });
+};
+
+size_t NostrContentScanner::scan(
+    string_view content,
+    function<void(const NostrContentReference&, const NostrBech32Entity&)> visit
+)
+{
+    // One entity is reused for every reference, so decoding never allocates.
+    NostrBech32Entity entity;
+    NostrContentReference reference;
+    size_t count = 0;
+
+    size_t position = findScheme(content, 0);
+    while (position != string_view::npos)
+    {
+        size_t start = position + uriSchemeLength;
+        string_view rest = content.substr(start);
+
+        bool isKnownPrefix = false;
+        for (const auto& prefix : referencePrefixes)
+        {
+            if (rest.size() >= prefix.size() && rest.compare(0, prefix.size(), prefix) == 0)
+            {
+                isKnownPrefix = true;
+                break;
+            }
+        }
+
+        if (!isKnownPrefix)
+        {
+            position = findScheme(content, start);
+            continue;
+        }
+
+        // The entity runs until the first character outside the lowercase Bech32 alphabet, such
+        // as the punctuation or whitespace that follows a reference in prose.
+        size_t end = start;
+        size_t limit = min(content.size(), start + NostrBech32Entity::maxEncodedLength);
+        while (end < limit && isBech32Character(content[end]))
+        {
+            end++;
+        }
+
+        if (NostrBech32::parseEntity(content.data() + start, end - start, entity))
+        {
+            reference.uri = content.substr(position, end - position);
+            reference.encoding = content.substr(start, end - start);
+            reference.type = entity.type();
+            reference.hasKind = entity.hasKind();
+            reference.kind = entity.kind();
+
+            const uint8_t* id = entity.type() == NOSTR_BECH32_NADDR ? entity.author() : entity.special();
+            memcpy(reference.id, id, sizeof(reference.id));
+
+            visit(reference, entity);
+            count++;
+        }
+
+        position = findScheme(content, end);
+    }
+
+    return count;
+};
@@ -5,13 +5,41 @@
 #include <openssl/rand.h>
 #include <openssl/crypto.h>
 
+#include <atomic>
+#include <memory>
+
+#include "chacha20_drbg.hpp"
 #include "nostr_secure_rng.hpp"
+#include "../internal/logging.hpp"
 
 using namespace std;
 using namespace nostr::cryptography;
 
+#ifdef AEDILE_BUFFERED_RNG
+static atomic<bool> isBufferedRng{ true };
+#else
+static atomic<bool> isBufferedRng{ false };
+#endif
+
+ChaCha20Drbg* NostrSecureRng::_threadDrbg(bool create)
+{
+	thread_local unique_ptr<ChaCha20Drbg> drbg;
+	if (!drbg && create)
+	{
+		drbg = make_unique<ChaCha20Drbg>();
+	}
+
+	return drbg.get();
+}
+
 void NostrSecureRng::fill(void* buffer, size_t length)
 {
+	if (isBufferedRng.load(memory_order_relaxed)
+		&& NostrSecureRng::_threadDrbg(true)->generate(static_cast<uint8_t*>(buffer), length))
+	{
+		return;
+	}
+
 	if (RAND_bytes((uint8_t*)buffer, length) != 1)
 	{
 		//TODO throw runtime exception
@@ -28,6 +56,22 @@ void NostrSecureRng::reseed(uint32_t bufferSize)
 		PLOG_WARNING << "Failed to reseed the RNG with /dev/random, falling back to /dev/urandom.";
 		RAND_poll();
 	}
+
+	ChaCha20Drbg* drbg = NostrSecureRng::_threadDrbg(false);
+	if (drbg != nullptr)
+	{
+		drbg->reseed();
+	}
+}
+
+void NostrSecureRng::setBuffered(bool isBuffered)
+{
+	isBufferedRng.store(isBuffered, memory_order_relaxed);
+}
+
+bool NostrSecureRng::isBuffered()
+{
+	return isBufferedRng.load(memory_order_relaxed);
 }
 
 void NostrSecureRng::zero(void* buffer, size_t length)
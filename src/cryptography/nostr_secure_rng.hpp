@@ -1,15 +1,27 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace nostr
 {
 namespace cryptography
 {
+class ChaCha20Drbg;
+class ChaCha20DrbgProbe;
 
 class NostrSecureRng
 {
 private:
+    friend class ChaCha20DrbgProbe; ///< Reaches the calling thread's generator in tests.
+
+    /**
+     * @brief Returns the calling thread's buffered generator, optionally creating it.
+     * @returns The generator, or nullptr if the thread has none and `create` is false.
+     */
+    static ChaCha20Drbg* _threadDrbg(bool create);
 
 public:
 
@@ -32,10 +44,27 @@ public:
     /*
      * @brief Reseeds the RNG with random bytes from /dev/random.
      * @param bufferSize The number of bytes to read from /dev/random.
-     * @remark Falls back to /dev/urandom if /dev/random is not available.
+     * @remark Falls back to /dev/urandom if /dev/random is not available.  If the calling thread
+     * has a buffered generator, it is reseeded as well.
      */
     static void reseed(uint32_t bufferSize = 32);
 
+    /**
+     * @brief Selects whether `fill` draws from a per-thread buffered generator.
+     * @param isBuffered When true, each thread serves `fill` from its own ChaCha20 generator,
+     * which is seeded and periodically reseeded from OpenSSL and erases its key as it goes.  When
+     * false, every call goes to OpenSSL's `RAND_bytes`.  Buffering is off unless the library is
+     * built with `AEDILE_BUFFERED_RNG`.
+     * @remark Buffering saves the cost of a `RAND_bytes` call for each small request, such as a
+     * signing nonce or an encryption IV, at high message rates.
+     */
+    static void setBuffered(bool isBuffered);
+
+    /**
+     * @brief Returns whether `fill` draws from a per-thread buffered generator.
+     */
+    static bool isBuffered();
+
     /*
      * @brief Securley zeroes out the given buffer.
      * @param buffer A pointer to the buffer to zero out.
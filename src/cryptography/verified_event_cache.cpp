@@ -0,0 +1,110 @@
+#include <algorithm>
+
+#include "cryptography/verified_event_cache.hpp"
+
+using namespace nostr::cryptography;
+using namespace std;
+
+VerifiedEventCache::VerifiedEventCache(size_t capacity, size_t shardCount)
+    : _capacity(capacity)
+{
+    // Never use more shards than entries, or some shards could hold nothing.
+    shardCount = max<size_t>(1, min(shardCount, max<size_t>(1, capacity)));
+    this->_shardCapacity = capacity == 0 ? 0 : (capacity + shardCount - 1) / shardCount;
+
+    for (size_t i = 0; i < shardCount; i++)
+    {
+        this->_shards.push_back(make_unique<Shard>());
+    }
+};
+
+bool VerifiedEventCache::contains(const EventId& id, const EventSignature& signature)
+{
+    if (this->_capacity == 0)
+    {
+        this->_misses.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+
+    Shard& shard = this->_shardFor(id);
+    lock_guard<mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(id);
+    if (it == shard.index.end() || it->second->second != signature)
+    {
+        this->_misses.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    this->_hits.fetch_add(1, memory_order_relaxed);
+    return true;
+};
+
+void VerifiedEventCache::insert(const EventId& id, const EventSignature& signature)
+{
+    if (this->_capacity == 0)
+    {
+        return;
+    }
+
+    Shard& shard = this->_shardFor(id);
+    lock_guard<mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(id);
+    if (it != shard.index.end())
+    {
+        it->second->second = signature;
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+
+    if (shard.entries.size() >= this->_shardCapacity)
+    {
+        shard.index.erase(shard.entries.back().first);
+        shard.entries.pop_back();
+    }
+
+    shard.entries.emplace_front(id, signature);
+    shard.index[id] = shard.entries.begin();
+};
+
+void VerifiedEventCache::clear()
+{
+    for (auto& shard : this->_shards)
+    {
+        lock_guard<mutex> lock(shard->mutex);
+        shard->index.clear();
+        shard->entries.clear();
+    }
+};
+
+size_t VerifiedEventCache::capacity() const
+{
+    return this->_capacity;
+};
+
+VerifiedEventCacheStats VerifiedEventCache::stats() const
+{
+    VerifiedEventCacheStats stats;
+    stats.hits = this->_hits.load(memory_order_relaxed);
+    stats.misses = this->_misses.load(memory_order_relaxed);
+    stats.size = 0;
+
+    for (auto& shard : this->_shards)
+    {
+        lock_guard<mutex> lock(shard->mutex);
+        stats.size += shard->entries.size();
+    }
+
+    return stats;
+};
+
+VerifiedEventCache::Shard& VerifiedEventCache::_shardFor(const EventId& id) const
+{
+    // The hash uses the leading bytes of the ID, so take the shard from the trailing bytes to
+    // keep the per-shard maps evenly spread.
+    uint32_t tail;
+    memcpy(&tail, id.data() + id.size() - sizeof(tail), sizeof(tail));
+    return *this->_shards[tail % this->_shards.size()];
+};
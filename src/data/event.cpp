@@ -3,6 +3,7 @@
 
 #include "data/data.hpp"
 #include "cryptography/nostr_bech32.hpp"
+#include "../internal/hex_encoding.hpp"
 
 using namespace nlohmann;
 using namespace nostr::data;
@@ -71,22 +72,21 @@ void Event::validate()
     }
 };
 
-void Event::generateId()
+void Event::computeDigest(uint8_t digest[SHA256_DIGEST_LENGTH]) const
 {
     // Create a JSON array of values used to generate the event ID.
     json arr = { 0, this->pubkey, this->createdAt, this->kind, this->tags, this->content };
     string serializedData = arr.dump();
 
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    EVP_Digest(serializedData.c_str(), serializedData.length(), hash, NULL, EVP_sha256(), NULL);
+    EVP_Digest(serializedData.c_str(), serializedData.length(), digest, NULL, EVP_sha256(), NULL);
+};
 
-    stringstream ss;
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++)
-    {
-        ss << hex << setw(2) << setfill('0') << (int)hash[i];
-    }
+void Event::generateId()
+{
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    this->computeDigest(hash);
 
-    this->id = ss.str();
+    this->id = nostr::internal::encodeHex(hash, SHA256_DIGEST_LENGTH);
 };
 
 bool Event::operator==(const Event& other) const
@@ -130,7 +130,8 @@ void adl_serializer<Event>::from_json(const json& j, Event& event)
         event.content = j.at("content");
         event.sig = j.at("sig");
 
-        // TODO: Validate the event against its signature.
+        // Signatures are not checked here.  Received events are verified in batches by
+        // `nostr::cryptography::EventVerifier` when verification is enabled on a subscription.
     }
     catch (const json::type_error& te)
     {
@@ -253,41 +254,58 @@ std::string NostrEvent::toNaddr()
 
 void NostrEvent::fromNote(std::string &encoding)
 {
-    NostrBech32 parser = NostrBech32();
-    NostrBech32Encoding parsedData;
-
-    if(!parser.parseNostrBech32(encoding, parsedData))
+    NostrBech32Entity parsed;
+    if (!NostrBech32::parseEntity(encoding.data(), encoding.size(), parsed)
+        || parsed.type() != NOSTR_BECH32_NOTE)
+    {
         std::cerr << "failed to decode Note encoding\n";
+        return;
+    }
 
-    this->data->id = parsedData.data.note.event_id;
+    this->data->id = nostr::internal::encodeHex(parsed.special(), parsed.specialLength());
 }
 
 void NostrEvent::fromNevent(std::string &encoding)
 {
-    NostrBech32 parser = NostrBech32();
-    NostrBech32Encoding parsedData;
-
-    if(!parser.parseNostrBech32(encoding, parsedData))
+    NostrBech32Entity parsed;
+    if (!NostrBech32::parseEntity(encoding.data(), encoding.size(), parsed)
+        || parsed.type() != NOSTR_BECH32_NEVENT)
+    {
         std::cerr << "failed to decode nevent encoding\n";
+        return;
+    }
+
+    this->data->id = nostr::internal::encodeHex(parsed.special(), parsed.specialLength());
+    this->data->pubkey = parsed.hasAuthor() ? nostr::internal::encodeHex(parsed.author(), KEY_LENGTH) : "";
 
-    this->data->id = parsedData.data.nevent.event_id;
-    this->data->pubkey = parsedData.data.nevent.pubkey;
-    this->relays = parsedData.data.nevent.relays;
+    this->relays.clear();
+    for (size_t i = 0; i < parsed.relayCount(); i++)
+    {
+        this->relays.emplace_back(parsed.relay(i));
+    }
 
-    if(parsedData.data.nevent.has_kind)
-        this->data->kind = parsedData.data.nevent.kind;
+    if (parsed.hasKind())
+        this->data->kind = parsed.kind();
 }
 
 void NostrEvent::fromNaddr(std::string &encoding)
 {
-    NostrBech32 parser = NostrBech32();
-    NostrBech32Encoding parsedData;
+    NostrBech32Entity parsed;
+    if (!NostrBech32::parseEntity(encoding.data(), encoding.size(), parsed)
+        || parsed.type() != NOSTR_BECH32_NADDR)
+    {
+        std::cerr << "failed to decode naddr encoding\n";
+        return;
+    }
 
-    if(!parser.parseNostrBech32(encoding, parsedData))
-        std::cerr << "failed to decode nevent encoding\n";
+    this->data->tags.push_back({"d", string(parsed.identifier())});
+    this->data->pubkey = nostr::internal::encodeHex(parsed.author(), KEY_LENGTH);
+
+    this->relays.clear();
+    for (size_t i = 0; i < parsed.relayCount(); i++)
+    {
+        this->relays.emplace_back(parsed.relay(i));
+    }
 
-    this->data->tags.push_back({"d", parsedData.data.naddr.tag});
-    this->data->pubkey = parsedData.data.naddr.pubkey;
-    this->relays = parsedData.data.naddr.relays;
-    this->data->kind = parsedData.data.naddr.kind;
+    this->data->kind = parsed.kind();
 }
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace nostr
+{
+namespace internal
+{
+/**
+ * @brief Encodes a byte buffer as a lowercase hex string.
+ * @param data The bytes to encode.
+ * @param size The number of bytes to encode.
+ * @returns A string of `2 * size` lowercase hex characters.
+ */
+inline std::string encodeHex(const uint8_t* data, std::size_t size)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    std::string hex(size * 2, '\0');
+    for (std::size_t i = 0; i < size; i++)
+    {
+        hex[2 * i] = digits[data[i] >> 4];
+        hex[2 * i + 1] = digits[data[i] & 0x0f];
+    }
+
+    return hex;
+};
+
+/**
+ * @brief Decodes a hex string of exactly `2 * size` characters into a byte buffer.
+ * @param hex The hex string to decode.  Upper- and lowercase digits are accepted.
+ * @param out The buffer that will receive the decoded bytes.
+ * @param size The number of bytes to decode.
+ * @returns True if the string had the expected length and contained only hex digits, false
+ * otherwise.  The contents of `out` are unspecified on failure.
+ */
+inline bool decodeHex(const std::string& hex, uint8_t* out, std::size_t size)
+{
+    if (hex.size() != size * 2)
+    {
+        return false;
+    }
+
+    auto nibble = [](char c) -> int
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+
+    for (std::size_t i = 0; i < size; i++)
+    {
+        int high = nibble(hex[2 * i]);
+        int low = nibble(hex[2 * i + 1]);
+        if (high < 0 || low < 0)
+        {
+            return false;
+        }
+        out[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+
+    return true;
+};
+} // namespace internal
+} // namespace nostr
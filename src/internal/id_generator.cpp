@@ -0,0 +1,49 @@
+#include <cstdint>
+
+#include "id_generator.hpp"
+#include "../cryptography/chacha20_drbg.hpp"
+#include "../cryptography/nostr_secure_rng.hpp"
+
+using namespace nostr::cryptography;
+using namespace nostr::internal;
+using namespace std;
+
+#pragma region Local Statics
+
+static const char idAlphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+///< The number of random bytes drawn for each ID, enough for `maxLength` six-bit characters.
+static const size_t randomSize = (IdGenerator::maxLength * 6 + 7) / 8;
+
+#pragma endregion
+
+string IdGenerator::next()
+{
+    thread_local ChaCha20Drbg drbg;
+
+    uint8_t random[randomSize];
+    if (!drbg.generate(random, sizeof(random)))
+    {
+        NostrSecureRng::fill(random, sizeof(random));
+    }
+
+    // Six bits at a time, carrying the bits of each byte into the next character.
+    char id[maxLength];
+    uint32_t bits = 0;
+    size_t bitCount = 0;
+    size_t byteIndex = 0;
+    for (size_t i = 0; i < maxLength; i++)
+    {
+        if (bitCount < 6)
+        {
+            bits = (bits << 8) | random[byteIndex++];
+            bitCount += 8;
+        }
+
+        bitCount -= 6;
+        id[i] = idAlphabet[(bits >> bitCount) & 0x3f];
+    }
+
+    return string(id, maxLength);
+};
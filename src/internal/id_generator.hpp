@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace nostr
+{
+namespace internal
+{
+/**
+ * @brief Generates short identifiers for subscriptions and signer requests.
+ * @remark Every ID is drawn from fresh random bits, so IDs are unlinkable: a relay cannot tell
+ * whether two subscriptions came from the same client, nor how many IDs the client has issued.
+ * Each thread draws the bits from its own `ChaCha20Drbg`, so generating an ID takes no locks and
+ * makes no system call, and falls back to `NostrSecureRng` if the generator fails.
+ *
+ * IDs use the URL-safe base64 alphabet, so they need no escaping in JSON.  Each ID is 15
+ * characters, holding 90 random bits: short enough to be stored inline in a `std::string` and
+ * well within the 64-character limit NIP-01 places on subscription IDs, while a collision is
+ * unlikely until some 2^45 IDs are in use at once.
+ */
+class IdGenerator
+{
+public:
+    ///< The length of every ID `next()` returns.
+    static constexpr std::size_t maxLength = 15;
+
+    /**
+     * @brief Returns a new ID.
+     */
+    static std::string next();
+};
+} // namespace internal
+} // namespace nostr
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace nostr
+{
+namespace internal
+{
+/**
+ * @brief Tells handlers that outlive their owner whether the owner still exists.
+ * @remark The owner shares the guard with each handler it gives away, such as to a WebSocket
+ * client whose I/O thread may deliver a message or a close after the owner is destroyed.  The
+ * owner calls `end` when it is destroyed, which waits for handlers in progress, so a handler that
+ * runs through `ifAlive` can use its owner safely.  Handlers may nest, but must not destroy their
+ * owner.
+ */
+class LifetimeGuard
+{
+public:
+    /**
+     * @brief Runs the given function if the owner has not ended, and holds off its end until the
+     * function returns.
+     * @returns True if the function ran.
+     */
+    template <typename Function>
+    bool ifAlive(Function&& function)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->_mutex);
+            if (!this->_isAlive)
+            {
+                return false;
+            }
+            this->_activeCount++;
+        }
+
+        // Released on the way out, even if the function throws.
+        struct Release
+        {
+            LifetimeGuard* guard;
+
+            ~Release()
+            {
+                std::lock_guard<std::mutex> lock(this->guard->_mutex);
+                if (--this->guard->_activeCount == 0)
+                {
+                    this->guard->_idle.notify_all();
+                }
+            };
+        } release{ this };
+
+        function();
+        return true;
+    };
+
+    /**
+     * @brief Marks the owner ended, once every function running under `ifAlive` has returned.
+     */
+    void end()
+    {
+        std::unique_lock<std::mutex> lock(this->_mutex);
+        this->_isAlive = false;
+        this->_idle.wait(lock, [this]() { return this->_activeCount == 0; });
+    };
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _idle;
+    bool _isAlive = true;
+    std::size_t _activeCount = 0;
+};
+} // namespace internal
+} // namespace nostr
@@ -0,0 +1,56 @@
+#include <mutex>
+
+#include <plog/Init.h>
+
+#include "logging.hpp"
+
+using namespace std;
+
+namespace
+{
+/**
+ * @brief The appender the library adds to plog, which passes each record on to the appender
+ * currently in use.
+ */
+class ForwardingAppender : public plog::IAppender
+{
+public:
+    void write(const plog::Record& record) override
+    {
+        shared_ptr<plog::IAppender> target;
+        {
+            lock_guard<mutex> lock(this->_targetMutex);
+            target = this->_target;
+        }
+
+        if (target != nullptr)
+        {
+            target->write(record);
+        }
+    };
+
+    void setTarget(shared_ptr<plog::IAppender> target)
+    {
+        lock_guard<mutex> lock(this->_targetMutex);
+        this->_target = move(target);
+    };
+
+private:
+    mutex _targetMutex;
+    shared_ptr<plog::IAppender> _target;
+};
+} // namespace
+
+void nostr::internal::initLogging(shared_ptr<plog::IAppender> appender)
+{
+    // Constructed before plog's logger, so it outlives the logger that points to it.
+    static ForwardingAppender forwarder;
+    static once_flag loggerFlag;
+
+    if (appender != nullptr)
+    {
+        forwarder.setTarget(move(appender));
+    }
+
+    call_once(loggerFlag, []() { plog::init(maxLogSeverity, &forwarder); });
+};
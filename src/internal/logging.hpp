@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+
+#include <plog/Appenders/IAppender.h>
+#include <plog/Log.h>
+
+/**
+ * The most verbose `plog::Severity` compiled into the library, set by the `AEDILE_LOG_LEVEL`
+ * CMake option.  Defaults to `plog::debug`, the level the library has always logged at.
+ */
+#ifndef AEDILE_LOG_LEVEL
+#define AEDILE_LOG_LEVEL 5
+#endif
+
+namespace nostr
+{
+namespace internal
+{
+///< The most verbose severity compiled into the library, which is also the runtime level set by
+///< `initLogging`.
+constexpr plog::Severity maxLogSeverity = static_cast<plog::Severity>(AEDILE_LOG_LEVEL);
+
+/**
+ * @brief Directs the library's log records to the given appender, creating the default plog
+ * logger on first use.
+ * @remark The library adds a single appender of its own to plog, which passes each record to the
+ * appender most recently given here, so every service writes each record once, however many
+ * services are built.  plog cannot remove an appender, so the one it holds is never replaced.
+ * A null appender leaves the current one in place.
+ */
+void initLogging(std::shared_ptr<plog::IAppender> appender);
+} // namespace internal
+} // namespace nostr
+
+// Replace plog's guard so that statements more verbose than the build's level test a constant
+// condition.  The compiler then removes them entirely, including formatting of their arguments.
+#ifndef PLOG_DISABLE_LOGGING
+#undef IF_PLOG_
+#define IF_PLOG_(instanceId, severity) \
+    if ((severity) > nostr::internal::maxLogSeverity \
+        || !plog::get<instanceId>() \
+        || !plog::get<instanceId>()->checkSeverity(severity)) {;} else
+#endif
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <mutex>
+
+#include "message_router.hpp"
+
+using namespace nostr::client;
+using namespace nostr::internal;
+using namespace std;
+
+/**
+ * @brief Advances past JSON whitespace.
+ */
+static void skipWhitespace(string_view message, size_t& position)
+{
+    while (position < message.size()
+        && (message[position] == ' ' || message[position] == '\t'
+            || message[position] == '\n' || message[position] == '\r'))
+    {
+        position++;
+    }
+};
+
+/**
+ * @brief Reads a JSON string starting at the given position, leaving the position after its
+ * closing quote.
+ * @returns The characters between the quotes, or nothing if there is no complete string there.
+ */
+static optional<string_view> readString(string_view message, size_t& position)
+{
+    if (position >= message.size() || message[position] != '"')
+    {
+        return nullopt;
+    }
+
+    size_t start = ++position;
+    while (position < message.size() && message[position] != '"')
+    {
+        // An escape covers the character after it, which may be a quote.
+        position += message[position] == '\\' ? 2 : 1;
+    }
+
+    if (position >= message.size())
+    {
+        return nullopt;
+    }
+
+    return message.substr(start, position++ - start);
+};
+
+MessageRouter::RouteId MessageRouter::add(
+    RelayId relay,
+    const string& key,
+    MessageHandler handler,
+    function<void(string_view)> closeHandler
+)
+{
+    unique_lock<shared_mutex> lock(this->_routeMutex);
+    RouteId route = this->_nextRouteId++;
+    this->_routes[key].push_back({ route, relay, move(handler), move(closeHandler) });
+    return route;
+};
+
+void MessageRouter::remove(const string& key, RouteId route)
+{
+    unique_lock<shared_mutex> lock(this->_routeMutex);
+    auto it = this->_routes.find(key);
+    if (it == this->_routes.end())
+    {
+        return;
+    }
+
+    auto& routes = it->second;
+    routes.erase(
+        remove_if(routes.begin(), routes.end(), [route](const Route& entry) { return entry.id == route; }),
+        routes.end());
+    if (routes.empty())
+    {
+        this->_routes.erase(it);
+    }
+};
+
+void MessageRouter::removeOnRelay(const string& key, RelayId relay)
+{
+    unique_lock<shared_mutex> lock(this->_routeMutex);
+    auto it = this->_routes.find(key);
+    if (it == this->_routes.end())
+    {
+        return;
+    }
+
+    auto& routes = it->second;
+    routes.erase(
+        remove_if(routes.begin(), routes.end(), [relay](const Route& entry) { return entry.relay == relay; }),
+        routes.end());
+    if (routes.empty())
+    {
+        this->_routes.erase(it);
+    }
+};
+
+void MessageRouter::removeAll(const string& key)
+{
+    unique_lock<shared_mutex> lock(this->_routeMutex);
+    this->_routes.erase(key);
+};
+
+void MessageRouter::close(RelayId relay, string_view reason)
+{
+    // The close handlers are moved out, so they run without the lock held.
+    vector<function<void(string_view)>> closeHandlers;
+    {
+        unique_lock<shared_mutex> lock(this->_routeMutex);
+        for (auto it = this->_routes.begin(); it != this->_routes.end();)
+        {
+            auto& routes = it->second;
+            auto closed = stable_partition(
+                routes.begin(),
+                routes.end(),
+                [relay](const Route& route) { return route.relay != relay; });
+            for (auto route = closed; route != routes.end(); route++)
+            {
+                if (route->closeHandler)
+                {
+                    closeHandlers.push_back(move(route->closeHandler));
+                }
+            }
+            routes.erase(closed, routes.end());
+
+            it = routes.empty() ? this->_routes.erase(it) : next(it);
+        }
+    }
+
+    for (const auto& closeHandler : closeHandlers)
+    {
+        closeHandler(reason);
+    }
+};
+
+size_t MessageRouter::dispatch(RelayId relay, string_view message) const
+{
+    optional<string_view> key = routingKey(message);
+    if (!key.has_value())
+    {
+        return 0;
+    }
+
+    // The handlers are copied out, so they run without the lock held.
+    vector<MessageHandler> handlers;
+    {
+        shared_lock<shared_mutex> lock(this->_routeMutex);
+        auto it = this->_routes.find(string(*key));
+        if (it == this->_routes.end())
+        {
+            return 0;
+        }
+
+        for (const Route& route : it->second)
+        {
+            if (route.relay == relay)
+            {
+                handlers.push_back(route.handler);
+            }
+        }
+    }
+
+    for (const MessageHandler& handler : handlers)
+    {
+        handler(message);
+    }
+
+    return handlers.size();
+};
+
+optional<string_view> MessageRouter::routingKey(string_view message)
+{
+    size_t position = 0;
+    skipWhitespace(message, position);
+    if (position >= message.size() || message[position++] != '[')
+    {
+        return nullopt;
+    }
+
+    skipWhitespace(message, position);
+    if (!readString(message, position).has_value())
+    {
+        return nullopt;
+    }
+
+    skipWhitespace(message, position);
+    if (position >= message.size() || message[position++] != ',')
+    {
+        return nullopt;
+    }
+
+    skipWhitespace(message, position);
+    return readString(message, position);
+};
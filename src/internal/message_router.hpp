@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "client/web_socket_client.hpp"
+#include "relay_registry.hpp"
+
+namespace nostr
+{
+namespace internal
+{
+/**
+ * @brief Routes each message a relay sends to the handlers of the requests it answers.
+ * @remark A WebSocket client holds one message handler per connection, so requests that each
+ * installed their own handler would replace one another's.  Instead, every request to a relay
+ * installs the same routing handler, and registers a route under the key the relay's replies
+ * carry: the subscription ID of a query, or the ID of a published event.
+ *
+ * When a relay's connection closes, `close` tells each of its routes, so requests waiting on the
+ * relay can give up rather than wait for replies that will never come.
+ *
+ * Routes are looked up under a shared lock, and their handlers run after it is released, so a
+ * handler may add or remove routes.
+ */
+class MessageRouter
+{
+public:
+    typedef uint64_t RouteId;
+
+    /**
+     * @brief Routes the messages from the given relay that carry the given key to the handler.
+     * @param closeHandler Invoked with a reason if the relay's connection closes while the route
+     * is in place.  May be empty.
+     * @returns The ID of the route, with which it is removed.
+     * @remark A key may have several routes on one relay, such as when the same event is
+     * published twice at once, and each of them receives every message.
+     */
+    RouteId add(
+        RelayId relay,
+        const std::string& key,
+        client::MessageHandler handler,
+        std::function<void(std::string_view)> closeHandler = nullptr);
+
+    /**
+     * @brief Removes the route with the given key and ID, if it is still present.
+     */
+    void remove(const std::string& key, RouteId route);
+
+    /**
+     * @brief Removes every route with the given key on the given relay.
+     */
+    void removeOnRelay(const std::string& key, RelayId relay);
+
+    /**
+     * @brief Removes every route with the given key.
+     */
+    void removeAll(const std::string& key);
+
+    /**
+     * @brief Removes every route on the given relay, and invokes the close handler of each.
+     */
+    void close(RelayId relay, std::string_view reason);
+
+    /**
+     * @brief Passes a message from the given relay to each handler routed under its key.
+     * @returns The number of handlers the message reached.
+     */
+    std::size_t dispatch(RelayId relay, std::string_view message) const;
+
+    /**
+     * @brief Returns the routing key of a relay message: the second element of its JSON array.
+     * @returns The key as it appears between its quotes, or nothing if the message does not
+     * begin with two strings, as NOTICE messages do not.
+     * @remark Only the start of the message is scanned, so an EVENT message is routed without
+     * parsing the event it carries.  Escapes are not decoded.  Keys the service generates are
+     * hex or alphanumeric, so their escaped and decoded forms are the same.
+     */
+    static std::optional<std::string_view> routingKey(std::string_view message);
+
+private:
+    struct Route
+    {
+        RouteId id;
+        RelayId relay;
+        client::MessageHandler handler;
+        std::function<void(std::string_view)> closeHandler;
+    };
+
+    mutable std::shared_mutex _routeMutex;
+
+    ///< The ID of the next route added.
+    RouteId _nextRouteId = 0;
+
+    ///< The routes registered under each key.
+    std::unordered_map<std::string, std::vector<Route>> _routes;
+};
+} // namespace internal
+} // namespace nostr
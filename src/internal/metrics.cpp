@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <mutex>
+
+#include "metrics.hpp"
+
+using namespace nostr::internal;
+using namespace nostr::service;
+using namespace std;
+
+uint64_t MetricsCounter::value() const
+{
+    uint64_t total = 0;
+    for (const auto& stripe : this->_stripes)
+    {
+        total += stripe.value.load(memory_order_relaxed);
+    }
+    return total;
+};
+
+size_t MetricsCounter::threadStripe()
+{
+    static atomic<size_t> nextStripe{ 0 };
+    thread_local const size_t stripe = nextStripe.fetch_add(1, memory_order_relaxed) % stripeCount;
+    return stripe;
+};
+
+void LatencyHistogram::record(uint64_t nanoseconds)
+{
+    this->_buckets[bucketIndex(nanoseconds)].fetch_add(1, memory_order_relaxed);
+    this->_sum.fetch_add(nanoseconds, memory_order_relaxed);
+
+    uint64_t currentMin = this->_min.load(memory_order_relaxed);
+    while (nanoseconds < currentMin
+        && !this->_min.compare_exchange_weak(currentMin, nanoseconds, memory_order_relaxed))
+    {
+    }
+
+    uint64_t currentMax = this->_max.load(memory_order_relaxed);
+    while (nanoseconds > currentMax
+        && !this->_max.compare_exchange_weak(currentMax, nanoseconds, memory_order_relaxed))
+    {
+    }
+};
+
+LatencySummary LatencyHistogram::summary() const
+{
+    LatencySummary summary{};
+
+    // Percentiles are taken from a copy of the buckets, so they agree with the count even while
+    // other threads keep recording.
+    array<uint64_t, bucketCount> buckets;
+    for (size_t i = 0; i < bucketCount; i++)
+    {
+        buckets[i] = this->_buckets[i].load(memory_order_relaxed);
+        summary.count += buckets[i];
+    }
+
+    if (summary.count == 0)
+    {
+        return summary;
+    }
+
+    summary.sum = this->_sum.load(memory_order_relaxed);
+    summary.min = this->_min.load(memory_order_relaxed);
+    summary.max = this->_max.load(memory_order_relaxed);
+
+    const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+    uint64_t* results[] = { &summary.p50, &summary.p90, &summary.p99, &summary.p999 };
+
+    size_t bucket = 0;
+    uint64_t seen = 0;
+    for (size_t q = 0; q < 4; q++)
+    {
+        uint64_t rank = max<uint64_t>(1, static_cast<uint64_t>(quantiles[q] * summary.count + 0.5));
+        while (bucket < bucketCount && seen + buckets[bucket] < rank)
+        {
+            seen += buckets[bucket];
+            bucket++;
+        }
+
+        *results[q] = min(bucketUpperBound(min(bucket, bucketCount - 1)), summary.max);
+    }
+
+    return summary;
+};
+
+size_t LatencyHistogram::bucketIndex(uint64_t value)
+{
+    if (value < subBucketCount)
+    {
+        return static_cast<size_t>(value);
+    }
+
+    value = min(value, maxValue);
+    unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(value));
+    unsigned shift = exponent - subBucketBits;
+    uint64_t subBucket = (value >> shift) - subBucketCount;
+
+    return static_cast<size_t>(subBucketCount + shift * subBucketCount + subBucket);
+};
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index)
+{
+    if (index < subBucketCount)
+    {
+        return index;
+    }
+
+    unsigned shift = static_cast<unsigned>((index - subBucketCount) / subBucketCount);
+    uint64_t subBucket = (index - subBucketCount) % subBucketCount;
+    uint64_t lowerBound = (subBucketCount + subBucket) << shift;
+
+    return lowerBound + (uint64_t(1) << shift) - 1;
+};
+
+RelayMetrics& MetricsRegistry::relay(const string& uri)
+{
+    {
+        shared_lock<shared_mutex> lock(this->_relayMutex);
+        auto it = this->_relays.find(uri);
+        if (it != this->_relays.end())
+        {
+            return *it->second;
+        }
+    }
+
+    unique_lock<shared_mutex> lock(this->_relayMutex);
+    auto& entry = this->_relays[uri];
+    if (!entry)
+    {
+        entry = make_unique<RelayMetrics>();
+    }
+    return *entry;
+};
+
+void MetricsRegistry::snapshot(ServiceMetricsSnapshot& snapshot) const
+{
+    snapshot.parseTime = this->_parseTime.summary();
+    snapshot.relays.clear();
+
+    shared_lock<shared_mutex> lock(this->_relayMutex);
+    for (const auto& [uri, relay] : this->_relays)
+    {
+        RelayMetricsSnapshot relaySnapshot;
+        relaySnapshot.relay = uri;
+        relaySnapshot.messagesIn = relay->messagesIn.value();
+        relaySnapshot.messagesOut = relay->messagesOut.value();
+        relaySnapshot.bytesIn = relay->bytesIn.value();
+        relaySnapshot.bytesOut = relay->bytesOut.value();
+        relaySnapshot.connects = relay->connects.value();
+        relaySnapshot.reconnects = relay->reconnects.value();
+        relaySnapshot.connectFailures = relay->connectFailures.value();
+        relaySnapshot.outboundQueueDepth = 0; // The service reads this from its WebSocket client.
+        relaySnapshot.eoseLatency = relay->eoseLatency.summary();
+        relaySnapshot.okLatency = relay->okLatency.summary();
+        snapshot.relays.push_back(move(relaySnapshot));
+    }
+
+    sort(
+        snapshot.relays.begin(),
+        snapshot.relays.end(),
+        [](const RelayMetricsSnapshot& a, const RelayMetricsSnapshot& b) { return a.relay < b.relay; });
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+#include "service/service_metrics.hpp"
+
+namespace nostr
+{
+namespace internal
+{
+/**
+ * @brief A monotonically increasing counter that many threads can update without contending.
+ * @remark Each thread adds to one of `stripeCount` cache-line-sized slots, chosen once per
+ * thread, so concurrent updates from different threads rarely touch the same cache line.  Reading
+ * the value sums the slots.
+ */
+class MetricsCounter
+{
+public:
+    static constexpr std::size_t stripeCount = 16;
+
+    void add(uint64_t amount = 1)
+    {
+        this->_stripes[threadStripe()].value.fetch_add(amount, std::memory_order_relaxed);
+    };
+
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Stripe
+    {
+        std::atomic<uint64_t> value{ 0 };
+    };
+
+    Stripe _stripes[stripeCount];
+
+    /**
+     * @brief Returns the stripe used by the calling thread.
+     */
+    static std::size_t threadStripe();
+};
+
+/**
+ * @brief A lock-free histogram of durations with log-linear buckets, in the manner of
+ * HdrHistogram.
+ * @remark Values below 32 ns each have their own bucket.  Above that, each power of two is
+ * split into 32 equal buckets, so any recorded value is known to within 1/32 of itself.  Values
+ * beyond about 4.9 hours are clamped into the last bucket.  Recording is a few relaxed atomic
+ * adds and takes no locks.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned subBucketBits = 5;
+    static constexpr uint64_t subBucketCount = uint64_t(1) << subBucketBits;
+    static constexpr unsigned maxExponent = 43;
+    static constexpr uint64_t maxValue = (uint64_t(1) << (maxExponent + 1)) - 1;
+    static constexpr std::size_t bucketCount =
+        subBucketCount + (maxExponent + 1 - subBucketBits) * subBucketCount;
+
+    void record(uint64_t nanoseconds);
+
+    service::LatencySummary summary() const;
+
+    /**
+     * @brief Returns the index of the bucket that holds the given value.
+     */
+    static std::size_t bucketIndex(uint64_t value);
+
+    /**
+     * @brief Returns the largest value held by the bucket with the given index.
+     */
+    static uint64_t bucketUpperBound(std::size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, bucketCount> _buckets{};
+    std::atomic<uint64_t> _sum{ 0 };
+    std::atomic<uint64_t> _min{ UINT64_MAX };
+    std::atomic<uint64_t> _max{ 0 };
+};
+
+/**
+ * @brief The counters and histograms the service keeps for each relay.
+ */
+struct RelayMetrics
+{
+    MetricsCounter messagesIn;
+    MetricsCounter messagesOut;
+    MetricsCounter bytesIn;
+    MetricsCounter bytesOut;
+    MetricsCounter connects;
+    MetricsCounter reconnects;
+    MetricsCounter connectFailures;
+    LatencyHistogram eoseLatency;
+    LatencyHistogram okLatency;
+
+    void recordReceived(std::size_t bytes)
+    {
+        this->messagesIn.add();
+        this->bytesIn.add(bytes);
+    };
+
+    void recordSent(std::size_t bytes)
+    {
+        this->messagesOut.add();
+        this->bytesOut.add(bytes);
+    };
+};
+
+/**
+ * @brief Holds the metrics of a `NostrServiceBase`.
+ * @remark Relay entries are created on first use and never removed, so references returned by
+ * `relay` stay valid for the lifetime of the registry, and message handlers may hold on to them
+ * instead of looking the relay up for every message.
+ */
+class MetricsRegistry
+{
+public:
+    /**
+     * @brief Returns the metrics of the given relay, creating them if needed.
+     */
+    RelayMetrics& relay(const std::string& uri);
+
+    LatencyHistogram& parseTime()
+    {
+        return this->_parseTime;
+    };
+
+    /**
+     * @brief Fills in the relay and parse-time fields of a snapshot.
+     * @remark Service-level fields, such as the active subscription count, are left to the caller.
+     */
+    void snapshot(service::ServiceMetricsSnapshot& snapshot) const;
+
+private:
+    mutable std::shared_mutex _relayMutex;
+
+    std::unordered_map<std::string, std::unique_ptr<RelayMetrics>> _relays;
+
+    LatencyHistogram _parseTime;
+};
+} // namespace internal
+} // namespace nostr
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace nostr
+{
+namespace internal
+{
+/**
+ * @brief An unbounded lock-free queue with many producers and a single consumer.
+ * @remark Producers push onto an intrusive stack with a single compare-and-swap.  The consumer
+ * takes the whole stack with one exchange and reverses it, so items come out in the order they
+ * were pushed, and the consumer never contends with producers item by item.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue() = default;
+
+    MpscQueue(const MpscQueue&) = delete;
+
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    ~MpscQueue()
+    {
+        Node* node = this->_head.exchange(nullptr, std::memory_order_acquire);
+        while (node != nullptr)
+        {
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+    };
+
+    void push(T value)
+    {
+        Node* node = new Node{ std::move(value), this->_head.load(std::memory_order_relaxed) };
+        while (!this->_head.compare_exchange_weak(
+            node->next,
+            node,
+            std::memory_order_release,
+            std::memory_order_relaxed))
+        {
+        }
+    };
+
+    /**
+     * @brief Removes every item in the queue, passing each to the given function in push order.
+     * @remark Only one thread may drain the queue at a time.
+     * @returns The number of items removed.
+     */
+    template <typename F>
+    std::size_t drain(F&& consume)
+    {
+        Node* node = this->_head.exchange(nullptr, std::memory_order_acquire);
+
+        Node* ordered = nullptr;
+        while (node != nullptr)
+        {
+            Node* next = node->next;
+            node->next = ordered;
+            ordered = node;
+            node = next;
+        }
+
+        std::size_t count = 0;
+        while (ordered != nullptr)
+        {
+            Node* next = ordered->next;
+            consume(std::move(ordered->value));
+            delete ordered;
+            ordered = next;
+            count++;
+        }
+        return count;
+    };
+
+private:
+    struct Node
+    {
+        T value;
+        Node* next;
+    };
+
+    std::atomic<Node*> _head{ nullptr };
+};
+} // namespace internal
+} // namespace nostr
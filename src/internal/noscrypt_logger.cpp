@@ -1,3 +1,4 @@
+#include "logging.hpp"
 #include "noscrypt_logger.hpp"
 
 void _printNoscryptError(NCResult result, const char *func, int line)
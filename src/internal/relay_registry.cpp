@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <mutex>
+
+#include "relay_registry.hpp"
+#include "tracing.hpp"
+
+using namespace nostr::internal;
+using namespace std;
+
+#pragma region RelaySet
+
+bool RelaySet::insert(RelayId id)
+{
+    size_t index = id / bitsPerWord;
+    if (index >= this->wordCount())
+    {
+        this->_moreWords.resize(index, 0);
+    }
+
+    uint64_t mask = uint64_t(1) << (id % bitsPerWord);
+    uint64_t& word = this->word(index);
+    bool isNew = (word & mask) == 0;
+    word |= mask;
+    return isNew;
+};
+
+bool RelaySet::erase(RelayId id)
+{
+    if (!this->contains(id))
+    {
+        return false;
+    }
+
+    this->word(id / bitsPerWord) &= ~(uint64_t(1) << (id % bitsPerWord));
+    return true;
+};
+
+void RelaySet::clear()
+{
+    this->_firstWord = 0;
+    this->_moreWords.clear();
+};
+
+bool RelaySet::empty() const
+{
+    return this->_firstWord == 0
+        && all_of(this->_moreWords.begin(), this->_moreWords.end(), [](uint64_t word) { return word == 0; });
+};
+
+size_t RelaySet::size() const
+{
+    size_t count = bitset<bitsPerWord>(this->_firstWord).count();
+    for (uint64_t word : this->_moreWords)
+    {
+        count += bitset<bitsPerWord>(word).count();
+    }
+    return count;
+};
+
+vector<RelayId> RelaySet::ids() const
+{
+    vector<RelayId> relayIds;
+    for (size_t index = 0; index < this->wordCount(); index++)
+    {
+        uint64_t word = this->word(index);
+        while (word != 0)
+        {
+            // Peel off the lowest set bit.
+            uint64_t lowestBit = word & (~word + 1);
+            size_t offset = bitset<bitsPerWord>(lowestBit - 1).count();
+            relayIds.push_back(static_cast<RelayId>(index * bitsPerWord + offset));
+            word ^= lowestBit;
+        }
+    }
+    return relayIds;
+};
+
+#pragma endregion
+
+#pragma region RelayRegistry
+
+string RelayRegistry::normalize(string_view uri)
+{
+    string normalized(uri);
+
+    size_t schemeEnd = normalized.find("://");
+    if (schemeEnd == string::npos)
+    {
+        return normalized;
+    }
+
+    size_t hostStart = schemeEnd + 3;
+    size_t hostEnd = normalized.find_first_of("/?#", hostStart);
+    if (hostEnd == string::npos)
+    {
+        hostEnd = normalized.size();
+    }
+
+    transform(
+        normalized.begin(),
+        normalized.begin() + hostEnd,
+        normalized.begin(),
+        [](unsigned char c) { return static_cast<char>(tolower(c)); });
+
+    string_view scheme(normalized.data(), schemeEnd);
+    string_view defaultPort = scheme == "wss" ? ":443" : scheme == "ws" ? ":80" : "";
+    if (!defaultPort.empty()
+        && hostEnd - hostStart > defaultPort.size()
+        && string_view(normalized).substr(hostEnd - defaultPort.size(), defaultPort.size()) == defaultPort)
+    {
+        normalized.erase(hostEnd - defaultPort.size(), defaultPort.size());
+        hostEnd -= defaultPort.size();
+    }
+
+    if (normalized.size() == hostEnd + 1 && normalized[hostEnd] == '/')
+    {
+        normalized.pop_back();
+    }
+
+    return normalized;
+};
+
+RelayId RelayRegistry::intern(string_view uri)
+{
+    string normalized = RelayRegistry::normalize(uri);
+    {
+        shared_lock<shared_mutex> lock(this->_mutex);
+        auto it = this->_ids.find(normalized);
+        if (it != this->_ids.end())
+        {
+            return it->second;
+        }
+    }
+
+    unique_lock<shared_mutex> lock(this->_mutex);
+    auto it = this->_ids.find(normalized);
+    if (it != this->_ids.end())
+    {
+        return it->second;
+    }
+
+    RelayId id = static_cast<RelayId>(this->_uris.size());
+    this->_uris.push_back(move(normalized));
+    this->_ids.emplace(this->_uris.back(), id);
+    this->_traceNames.push_back(Tracing::intern(this->_uris.back()));
+    return id;
+};
+
+optional<RelayId> RelayRegistry::find(string_view uri) const
+{
+    string normalized = RelayRegistry::normalize(uri);
+
+    shared_lock<shared_mutex> lock(this->_mutex);
+    auto it = this->_ids.find(normalized);
+    if (it == this->_ids.end())
+    {
+        return nullopt;
+    }
+    return it->second;
+};
+
+const string& RelayRegistry::uri(RelayId id) const
+{
+    shared_lock<shared_mutex> lock(this->_mutex);
+    return this->_uris.at(id);
+};
+
+const char* RelayRegistry::traceName(RelayId id) const
+{
+    shared_lock<shared_mutex> lock(this->_mutex);
+    return this->_traceNames.at(id);
+};
+
+vector<string> RelayRegistry::uris(const RelaySet& relays) const
+{
+    vector<RelayId> relayIds = relays.ids();
+
+    shared_lock<shared_mutex> lock(this->_mutex);
+    vector<string> relayUris;
+    relayUris.reserve(relayIds.size());
+    for (RelayId id : relayIds)
+    {
+        relayUris.push_back(this->_uris.at(id));
+    }
+    return relayUris;
+};
+
+#pragma endregion
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace nostr
+{
+namespace internal
+{
+/**
+ * @brief A dense integer handle for a relay, assigned by a `RelayRegistry`.
+ */
+typedef uint32_t RelayId;
+
+/**
+ * @brief A set of relays, stored as a bitmap indexed by relay ID.
+ * @remark The first 64 relays fit in a word held inline, so sets drawn from a typical relay list
+ * never allocate.  Membership tests, inserts, and erases are a single bit operation.
+ */
+class RelaySet
+{
+public:
+    bool contains(RelayId id) const
+    {
+        std::size_t index = id / bitsPerWord;
+        return index < this->wordCount() && (this->word(index) >> (id % bitsPerWord)) & 1;
+    };
+
+    /**
+     * @brief Adds the given relay to the set.
+     * @returns True if the relay was added, false if it was already in the set.
+     */
+    bool insert(RelayId id);
+
+    /**
+     * @brief Removes the given relay from the set.
+     * @returns True if the relay was removed, false if it was not in the set.
+     */
+    bool erase(RelayId id);
+
+    void clear();
+
+    bool empty() const;
+
+    std::size_t size() const;
+
+    /**
+     * @brief Returns the IDs of the relays in the set, in ascending order.
+     */
+    std::vector<RelayId> ids() const;
+
+private:
+    static constexpr std::size_t bitsPerWord = 64;
+
+    uint64_t _firstWord = 0;
+
+    ///< The words for relay IDs 64 and above, allocated only once such a relay is added.
+    std::vector<uint64_t> _moreWords;
+
+    std::size_t wordCount() const
+    {
+        return 1 + this->_moreWords.size();
+    };
+
+    uint64_t word(std::size_t index) const
+    {
+        return index == 0 ? this->_firstWord : this->_moreWords[index - 1];
+    };
+
+    uint64_t& word(std::size_t index)
+    {
+        return index == 0 ? this->_firstWord : this->_moreWords[index - 1];
+    };
+};
+
+/**
+ * @brief Assigns each relay URI a dense integer ID, so the service can track relays in bitmaps
+ * rather than in lists of strings.
+ * @remark URIs are normalized before they are interned, so spellings of the same relay that
+ * differ only in case, a default port, or a trailing slash share an ID.  IDs are assigned from
+ * zero in the order relays are first seen and are never reused, and the URI of each ID is never
+ * moved, so references returned by `uri` stay valid for the lifetime of the registry.
+ */
+class RelayRegistry
+{
+public:
+    /**
+     * @brief Returns the canonical form of the given relay URI.
+     * @remark The scheme and host are lowercased, the port is dropped if it is the default for
+     * the scheme, and a path consisting of a single slash is removed.
+     */
+    static std::string normalize(std::string_view uri);
+
+    /**
+     * @brief Returns the ID of the given relay, assigning one if the relay has not been seen.
+     */
+    RelayId intern(std::string_view uri);
+
+    /**
+     * @brief Returns the ID of the given relay, if it has been interned.
+     */
+    std::optional<RelayId> find(std::string_view uri) const;
+
+    /**
+     * @brief Returns the normalized URI of the relay with the given ID.
+     */
+    const std::string& uri(RelayId id) const;
+
+    /**
+     * @brief Returns the normalized URI of the relay with the given ID, as a string that lives
+     * for the rest of the process.
+     * @remark Trace spans name their relay with it, so a span may outlive the registry, and a
+     * relay's URI is interned with the tracer once, when the relay is first seen, rather than on
+     * every send.
+     */
+    const char* traceName(RelayId id) const;
+
+    /**
+     * @brief Returns the normalized URIs of the relays in the given set, in ID order.
+     */
+    std::vector<std::string> uris(const RelaySet& relays) const;
+
+private:
+    mutable std::shared_mutex _mutex;
+
+    ///< The URI of each relay, indexed by ID.  A deque, so that interning never moves a URI.
+    std::deque<std::string> _uris;
+
+    ///< The URI of each relay as interned by the tracer, indexed by ID.
+    std::vector<const char*> _traceNames;
+
+    ///< A map from each URI to its ID, keyed by views of the strings in `_uris`.
+    std::unordered_map<std::string_view, RelayId> _ids;
+};
+
+/**
+ * @brief The relays a service is connected to, and the relays each of its subscriptions is open
+ * on.
+ * @remark Not synchronized.  The service guards it with its property mutex.
+ */
+struct RelayMembership
+{
+    RelaySet activeRelays;
+
+    ///< A map from subscription IDs to the relays on which each subscription is open.
+    std::unordered_map<std::string, RelaySet> subscriptions;
+};
+} // namespace internal
+} // namespace nostr
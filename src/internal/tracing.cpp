@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <chrono>
+#include <shared_mutex>
+#include <unordered_set>
+
+#include "tracing.hpp"
+
+using namespace nostr::internal;
+using namespace std;
+
+#pragma region Local Statics
+
+namespace
+{
+struct TraceRegistry
+{
+    mutex registryMutex;
+    vector<shared_ptr<TraceBuffer>> buffers;
+    shared_mutex internMutex;
+    unordered_set<string> internedStrings;
+    atomic<size_t> spansPerThread{ 0 };
+    atomic<uint32_t> nextThreadId{ 1 };
+    atomic<uint64_t> droppedCount{ 0 };
+};
+
+/**
+ * @brief Returns the registry, which is never destroyed so that threads exiting during shutdown
+ * can still release their buffers.
+ */
+TraceRegistry& registry()
+{
+    static TraceRegistry* traceRegistry = new TraceRegistry();
+    return *traceRegistry;
+};
+
+/**
+ * @brief Owns the calling thread's buffer.  When the thread exits, an empty buffer is released at
+ * once, and a buffer holding spans is kept until the trace is cleared.
+ */
+struct ThreadTraceBuffer
+{
+    shared_ptr<TraceBuffer> buffer;
+
+    ~ThreadTraceBuffer()
+    {
+        if (this->buffer == nullptr || !this->buffer->isEmpty())
+        {
+            return;
+        }
+
+        TraceRegistry& traceRegistry = registry();
+        lock_guard<mutex> lock(traceRegistry.registryMutex);
+        auto it = find(traceRegistry.buffers.begin(), traceRegistry.buffers.end(), this->buffer);
+        if (it != traceRegistry.buffers.end())
+        {
+            traceRegistry.buffers.erase(it);
+        }
+    };
+};
+
+TraceBuffer& threadBuffer()
+{
+    thread_local ThreadTraceBuffer threadTraceBuffer;
+    if (threadTraceBuffer.buffer == nullptr)
+    {
+        TraceRegistry& traceRegistry = registry();
+        threadTraceBuffer.buffer = make_shared<TraceBuffer>(
+            traceRegistry.nextThreadId.fetch_add(1, memory_order_relaxed),
+            traceRegistry.spansPerThread.load(memory_order_relaxed));
+
+        lock_guard<mutex> lock(traceRegistry.registryMutex);
+        traceRegistry.buffers.push_back(threadTraceBuffer.buffer);
+    }
+    return *threadTraceBuffer.buffer;
+};
+} // namespace
+
+#pragma endregion
+
+#pragma region TraceBuffer
+
+TraceBuffer::TraceBuffer(uint32_t threadId, size_t capacity)
+    : _threadId(threadId), _capacity(capacity)
+{
+    this->_records.reserve(min<size_t>(capacity, 1024));
+};
+
+void TraceBuffer::append(const TraceRecord& record)
+{
+    lock_guard<mutex> lock(this->_mutex);
+    if (this->_records.size() >= this->_capacity)
+    {
+        Tracing::addDropped();
+        return;
+    }
+    this->_records.push_back(record);
+};
+
+void TraceBuffer::copyTo(vector<TraceRecord>& records) const
+{
+    lock_guard<mutex> lock(this->_mutex);
+    records.insert(records.end(), this->_records.begin(), this->_records.end());
+};
+
+void TraceBuffer::clear()
+{
+    lock_guard<mutex> lock(this->_mutex);
+    this->_records.clear();
+};
+
+void TraceBuffer::setCapacity(size_t capacity)
+{
+    lock_guard<mutex> lock(this->_mutex);
+    this->_capacity = capacity;
+};
+
+bool TraceBuffer::isEmpty() const
+{
+    lock_guard<mutex> lock(this->_mutex);
+    return this->_records.empty();
+};
+
+#pragma endregion
+
+#pragma region Tracing
+
+void Tracing::setEnabled(bool isEnabled, size_t spansPerThread)
+{
+    TraceRegistry& traceRegistry = registry();
+    if (isEnabled)
+    {
+        traceRegistry.spansPerThread.store(spansPerThread, memory_order_relaxed);
+
+        lock_guard<mutex> lock(traceRegistry.registryMutex);
+        for (auto& buffer : traceRegistry.buffers)
+        {
+            buffer->setCapacity(spansPerThread);
+        }
+    }
+
+    enabled().store(isEnabled, memory_order_relaxed);
+};
+
+uint64_t Tracing::now()
+{
+    static const auto epoch = chrono::steady_clock::now();
+    return static_cast<uint64_t>(
+        chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count());
+};
+
+void Tracing::record(const TraceRecord& record)
+{
+    threadBuffer().append(record);
+};
+
+const char* Tracing::intern(const string& value)
+{
+    TraceRegistry& traceRegistry = registry();
+    {
+        shared_lock<shared_mutex> lock(traceRegistry.internMutex);
+        auto it = traceRegistry.internedStrings.find(value);
+        if (it != traceRegistry.internedStrings.end())
+        {
+            return it->c_str();
+        }
+    }
+
+    unique_lock<shared_mutex> lock(traceRegistry.internMutex);
+    return traceRegistry.internedStrings.insert(value).first->c_str();
+};
+
+vector<pair<uint32_t, vector<TraceRecord>>> Tracing::collect()
+{
+    TraceRegistry& traceRegistry = registry();
+    lock_guard<mutex> lock(traceRegistry.registryMutex);
+
+    vector<pair<uint32_t, vector<TraceRecord>>> threads;
+    for (const auto& buffer : traceRegistry.buffers)
+    {
+        vector<TraceRecord> records;
+        buffer->copyTo(records);
+        if (!records.empty())
+        {
+            threads.emplace_back(buffer->threadId(), move(records));
+        }
+    }
+    return threads;
+};
+
+void Tracing::clear()
+{
+    TraceRegistry& traceRegistry = registry();
+    lock_guard<mutex> lock(traceRegistry.registryMutex);
+
+    // Buffers held only by the registry belong to threads that have exited.
+    traceRegistry.buffers.erase(
+        remove_if(
+            traceRegistry.buffers.begin(),
+            traceRegistry.buffers.end(),
+            [](const shared_ptr<TraceBuffer>& buffer) { return buffer.use_count() == 1; }),
+        traceRegistry.buffers.end());
+
+    for (auto& buffer : traceRegistry.buffers)
+    {
+        buffer->clear();
+    }
+    traceRegistry.droppedCount.store(0, memory_order_relaxed);
+};
+
+uint64_t Tracing::droppedCount()
+{
+    return registry().droppedCount.load(memory_order_relaxed);
+};
+
+void Tracing::addDropped()
+{
+    registry().droppedCount.fetch_add(1, memory_order_relaxed);
+};
+
+atomic<bool>& Tracing::enabled()
+{
+    static atomic<bool> isEnabled{ false };
+    return isEnabled;
+};
+
+#pragma endregion
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace nostr
+{
+namespace internal
+{
+/**
+ * @brief A span recorded by a `TraceSpan`.
+ * @remark Names and relays point to strings that live for the whole process, either literals or
+ * strings interned by `Tracing::intern`, so recording a span never allocates.
+ */
+struct TraceRecord
+{
+    const char* name;
+    const char* relay;
+    uint64_t startNanoseconds;
+    uint64_t durationNanoseconds;
+};
+
+/**
+ * @brief The spans recorded by one thread.
+ * @remark Only the owning thread appends to the buffer.  The mutex is taken by the owning thread
+ * for each span and by exports, so it is only ever contended while a trace is being exported.
+ */
+class TraceBuffer
+{
+public:
+    TraceBuffer(uint32_t threadId, std::size_t capacity);
+
+    void append(const TraceRecord& record);
+
+    uint32_t threadId() const
+    {
+        return this->_threadId;
+    };
+
+    /**
+     * @brief Copies the recorded spans onto the end of the given vector.
+     */
+    void copyTo(std::vector<TraceRecord>& records) const;
+
+    void clear();
+
+    /**
+     * @brief Sets the number of spans the buffer keeps.  Spans already recorded are kept.
+     */
+    void setCapacity(std::size_t capacity);
+
+    bool isEmpty() const;
+
+private:
+    const uint32_t _threadId;
+
+    mutable std::mutex _mutex;
+
+    std::size_t _capacity;
+
+    std::vector<TraceRecord> _records;
+};
+
+/**
+ * @brief The process-wide registry of trace buffers behind `service::ServiceTracer`.
+ */
+class Tracing
+{
+public:
+    static bool isEnabled()
+    {
+        return enabled().load(std::memory_order_relaxed);
+    };
+
+    static void setEnabled(bool isEnabled, std::size_t spansPerThread);
+
+    /**
+     * @brief Returns the nanoseconds elapsed since the tracer's epoch.
+     */
+    static uint64_t now();
+
+    /**
+     * @brief Records a finished span in the calling thread's buffer.
+     */
+    static void record(const TraceRecord& record);
+
+    /**
+     * @brief Returns a copy of the given string that lives for the rest of the process.
+     * @remark Equal strings share one copy, so interning the URI of each relay costs memory only
+     * once per relay.
+     */
+    static const char* intern(const std::string& value);
+
+    /**
+     * @brief Returns the spans of every thread, grouped by thread ID.
+     */
+    static std::vector<std::pair<uint32_t, std::vector<TraceRecord>>> collect();
+
+    static void clear();
+
+    static uint64_t droppedCount();
+
+    static void addDropped();
+
+private:
+    static std::atomic<bool>& enabled();
+};
+
+/**
+ * @brief Records a span from its construction to its destruction, if tracing is enabled.
+ */
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char* name, const char* relay = nullptr)
+        : _name(name), _relay(relay)
+    {
+        this->_isRecording = Tracing::isEnabled();
+        if (this->_isRecording)
+        {
+            this->_start = Tracing::now();
+        }
+    };
+
+    TraceSpan(const TraceSpan&) = delete;
+
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    ~TraceSpan()
+    {
+        this->end();
+    };
+
+    /**
+     * @brief Ends the span before the end of its scope.
+     */
+    void end()
+    {
+        if (this->_isRecording)
+        {
+            Tracing::record({ this->_name, this->_relay, this->_start, Tracing::now() - this->_start });
+            this->_isRecording = false;
+        }
+    };
+
+private:
+    const char* _name;
+    const char* _relay;
+    uint64_t _start = 0;
+    bool _isRecording;
+};
+} // namespace internal
+} // namespace nostr
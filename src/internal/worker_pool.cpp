@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <future>
+
+#include "worker_pool.hpp"
+
+using namespace nostr::internal;
+using namespace std;
+
+WorkerPool::WorkerPool(size_t workerCount)
+{
+    if (workerCount == 0)
+    {
+        workerCount = max<size_t>(1, thread::hardware_concurrency());
+    }
+
+    for (size_t i = 0; i < workerCount; i++)
+    {
+        this->_workers.emplace_back([this, i]() { this->_run(i); });
+    }
+};
+
+WorkerPool::~WorkerPool()
+{
+    {
+        lock_guard<mutex> lock(this->_taskMutex);
+        this->_isStopping = true;
+    }
+    this->_taskAvailable.notify_all();
+
+    for (thread& worker : this->_workers)
+    {
+        worker.join();
+    }
+};
+
+size_t WorkerPool::size() const
+{
+    return this->_workers.size();
+};
+
+void WorkerPool::submit(function<void(size_t)> task)
+{
+    {
+        lock_guard<mutex> lock(this->_taskMutex);
+        this->_tasks.push_back(move(task));
+    }
+    this->_taskAvailable.notify_one();
+};
+
+void WorkerPool::parallelFor(size_t count, const function<void(size_t)>& task, size_t chunksPerWorker)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    size_t chunkCount = min(this->size() * max<size_t>(1, chunksPerWorker), count);
+    size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+    vector<future<void>> chunkFutures;
+    for (size_t begin = 0; begin < count; begin += chunkSize)
+    {
+        size_t end = min(begin + chunkSize, count);
+        auto chunkPromise = make_shared<promise<void>>();
+        chunkFutures.push_back(chunkPromise->get_future());
+
+        // The call waits for every chunk, so the task may be captured by reference.
+        this->submit([&task, begin, end, chunkPromise](size_t)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                task(i);
+            }
+            chunkPromise->set_value();
+        });
+    }
+
+    for (auto& chunkFuture : chunkFutures)
+    {
+        chunkFuture.get();
+    }
+};
+
+void WorkerPool::_run(size_t workerIndex)
+{
+    while (true)
+    {
+        function<void(size_t)> task;
+        {
+            unique_lock<mutex> lock(this->_taskMutex);
+            this->_taskAvailable.wait(lock, [this]()
+            {
+                return this->_isStopping || !this->_tasks.empty();
+            });
+
+            if (this->_tasks.empty())
+            {
+                // The pool is stopping and there is no work left.
+                return;
+            }
+
+            task = move(this->_tasks.front());
+            this->_tasks.pop_front();
+        }
+
+        task(workerIndex);
+    }
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nostr
+{
+namespace internal
+{
+/**
+ * @brief A fixed-size pool of worker threads that run queued tasks in FIFO order.
+ * @remark Each task is passed the index of the worker running it, in the range
+ * `[0, size())`.  Tasks that need a noscrypt context take the running thread's own from
+ * `NoscryptContextPool::local` rather than one selected by the index.
+ */
+class WorkerPool
+{
+public:
+    /**
+     * @param workerCount The number of worker threads to start.  A value of 0 starts one worker
+     * per hardware thread.
+     */
+    explicit WorkerPool(std::size_t workerCount = 0);
+
+    /**
+     * @remark Tasks already queued are run to completion before the workers are joined.
+     */
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * @brief Returns the number of worker threads in the pool.
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Queues a task to be run on the next available worker.
+     */
+    void submit(std::function<void(std::size_t)> task);
+
+    /**
+     * @brief Runs a task once for each index in `[0, count)`, spread across the workers, and
+     * waits until every index has been processed.
+     * @param count The number of indices.
+     * @param task Invoked with each index.  Indices are handed out in contiguous chunks, and
+     * chunks run concurrently, so the task must not write to storage shared with other indices,
+     * such as neighbouring elements of a `std::vector<bool>`.
+     * @param chunksPerWorker The number of chunks each worker's share is split into.  More chunks
+     * let workers that finish early take over work from slower ones.
+     * @remark Must not be called from one of the pool's own workers, which would wait on itself.
+     */
+    void parallelFor(
+        std::size_t count,
+        const std::function<void(std::size_t)>& task,
+        std::size_t chunksPerWorker = 1);
+
+private:
+    std::vector<std::thread> _workers;
+    std::deque<std::function<void(std::size_t)>> _tasks;
+    std::mutex _taskMutex;
+    std::condition_variable _taskAvailable;
+    bool _isStopping = false;
+
+    void _run(std::size_t workerIndex);
+};
+} // namespace internal
+} // namespace nostr
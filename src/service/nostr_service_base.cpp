@@ -1,17 +1,125 @@
+#include <chrono>
 #include <exception>
 #include <future>
+#include <optional>
 #include <stdexcept>
 #include <thread>
 #include <unordered_set>
 
-#include <uuid_v4.h>
-
 #include "service/nostr_service_base.hpp"
+#include "../internal/hex_encoding.hpp"
+#include "../internal/id_generator.hpp"
+#include "../internal/lifetime_guard.hpp"
+#include "../internal/logging.hpp"
+#include "../internal/message_router.hpp"
+#include "../internal/metrics.hpp"
+#include "../internal/relay_registry.hpp"
+#include "../internal/tracing.hpp"
 
 using namespace nlohmann;
+using namespace nostr::cryptography;
+using namespace nostr::internal;
 using namespace nostr::service;
 using namespace std;
 
+static uint64_t nanosecondsSince(chrono::steady_clock::time_point start)
+{
+    return static_cast<uint64_t>(
+        chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+};
+
+namespace
+{
+/**
+ * @brief The outcome of each event published to one relay, settled as the relay's OK messages
+ * arrive.
+ * @remark Shared with the relay's message handler, which may run after the publish returns if the
+ * relay repeats an OK message.  Repeats are ignored.
+ */
+struct PublishBatch
+{
+    mutex batchMutex;
+    vector<promise<bool>> acceptances;
+    vector<future<bool>> outcomes;
+    vector<bool> isSettled;
+
+    explicit PublishBatch(size_t eventCount)
+        : acceptances(eventCount), isSettled(eventCount, false)
+    {
+        for (auto& acceptance : this->acceptances)
+        {
+            this->outcomes.push_back(acceptance.get_future());
+        }
+    };
+
+    void settle(size_t index, bool isAccepted)
+    {
+        lock_guard<mutex> lock(this->batchMutex);
+        if (!this->isSettled[index])
+        {
+            this->isSettled[index] = true;
+            this->acceptances[index].set_value(isAccepted);
+        }
+    };
+};
+
+/**
+ * @brief The events one query has received, and whether each relay has ended it with an EOSE.
+ * @remark Shared with the routes of the query's relays, which may run after the query returns if
+ * a relay sends a late message.  Only the first EOSE or CLOSE from each relay counts.
+ */
+struct QueryBatch
+{
+    mutex batchMutex;
+    vector<shared_ptr<nostr::data::Event>> events;
+    unordered_set<string> uniqueEventIds;
+    vector<promise<bool>> completions;
+    vector<future<bool>> outcomes;
+    vector<bool> isSettled;
+
+    explicit QueryBatch(size_t relayCount)
+        : completions(relayCount), isSettled(relayCount, false)
+    {
+        for (auto& completion : this->completions)
+        {
+            this->outcomes.push_back(completion.get_future());
+        }
+    };
+
+    /**
+     * @brief Keeps the given event, unless it duplicates one already kept and duplicates are
+     * dropped.
+     */
+    void add(shared_ptr<nostr::data::Event> event, bool keepDuplicates)
+    {
+        lock_guard<mutex> lock(this->batchMutex);
+        if (keepDuplicates || this->uniqueEventIds.insert(event->id).second)
+        {
+            this->events.push_back(move(event));
+        }
+    };
+
+    void settle(size_t index, bool isEose)
+    {
+        lock_guard<mutex> lock(this->batchMutex);
+        if (!this->isSettled[index])
+        {
+            this->isSettled[index] = true;
+            this->completions[index].set_value(isEose);
+        }
+    };
+
+    /**
+     * @brief Returns the events received so far.  Events that arrive later are discarded.
+     */
+    vector<shared_ptr<nostr::data::Event>> takeEvents()
+    {
+        lock_guard<mutex> lock(this->batchMutex);
+        return move(this->events);
+    };
+};
+} // namespace
+
 NostrServiceBase::NostrServiceBase(
     shared_ptr<plog::IAppender> appender,
     shared_ptr<client::IWebSocketClient> client
@@ -21,90 +129,104 @@ NostrServiceBase::NostrServiceBase(
     shared_ptr<plog::IAppender> appender,
     shared_ptr<client::IWebSocketClient> client,
     vector<string> relays
-) : _defaultRelays(relays), _client(client)
+) : _client(client)
 {
-    plog::init(plog::debug, appender.get());
+    nostr::internal::initLogging(appender);
+    this->_relays = make_shared<RelayRegistry>();
+    this->_defaultRelays = this->_internRelays(relays);
+    this->_membership = make_unique<RelayMembership>();
+    this->_eventVerifier = make_shared<EventVerifier>();
+    this->_metrics = make_shared<nostr::internal::MetricsRegistry>();
+    this->_router = make_shared<MessageRouter>();
+    this->_lifetime = make_shared<LifetimeGuard>();
     client->start();
 };
 
 NostrServiceBase::~NostrServiceBase()
 {
+    // The client may outlive the service, so its handlers are cut off first.
+    this->_lifetime->end();
     this->_client->stop();
 };
 
 vector<string> NostrServiceBase::defaultRelays() const
-{ return this->_defaultRelays; };
+{
+    vector<string> relays;
+    for (RelayId relay : this->_defaultRelays)
+    {
+        relays.push_back(this->_relays->uri(relay));
+    }
+    return relays;
+};
 
 vector<string> NostrServiceBase::activeRelays() const
-{ return this->_activeRelays; };
+{
+    lock_guard<mutex> lock(this->_propertyMutex);
+    return this->_relays->uris(this->_membership->activeRelays);
+};
 
 unordered_map<string, vector<string>> NostrServiceBase::subscriptions() const
-{ return this->_subscriptions; };
+{
+    lock_guard<mutex> lock(this->_propertyMutex);
+    unordered_map<string, vector<string>> subscriptions;
+    for (const auto& [subscriptionId, relays] : this->_membership->subscriptions)
+    {
+        subscriptions[subscriptionId] = this->_relays->uris(relays);
+    }
+    return subscriptions;
+};
 
 vector<string> NostrServiceBase::openRelayConnections()
 {
-    return this->openRelayConnections(this->_defaultRelays);
+    return this->openRelayConnections(this->defaultRelays());
 };
 
 vector<string> NostrServiceBase::openRelayConnections(vector<string> relays)
 {
     PLOG_INFO << "Attempting to connect to Nostr relays.";
-    vector<string> unconnectedRelays = this->_getUnconnectedRelays(relays);
+    vector<RelayId> unconnectedRelays = this->_getUnconnectedRelays(this->_internRelays(relays));
 
-    vector<thread> connectionThreads;
-    for (string relay : unconnectedRelays)
+    // The client performs each handshake on its I/O loop, so every connection is started from
+    // this thread, and the handshakes proceed together.
+    vector<tuple<RelayId, future<bool>>> pendingConnections;
+    for (RelayId relay : unconnectedRelays)
     {
-        thread connectionThread([this, relay]() {
-            this->_connect(relay);
-        });
-        connectionThreads.push_back(move(connectionThread));
+        pendingConnections.emplace_back(relay, this->_connect(relay));
     }
+    this->_awaitConnections(move(pendingConnections));
 
-    for (thread& connectionThread : connectionThreads)
-    {
-        connectionThread.join();
-    }
+    // This property should only contain successful relays at this point.
+    vector<string> activeRelays = this->activeRelays();
 
     std::size_t targetCount = relays.size();
-    std::size_t activeCount = this->_activeRelays.size();
+    std::size_t activeCount = activeRelays.size();
     PLOG_INFO << "Connected to " << activeCount << "/" << targetCount << " target relays.";
 
-    // This property should only contain successful relays at this point.
-    return this->_activeRelays;
+    return activeRelays;
 };
 
 void NostrServiceBase::closeRelayConnections()
 {
-    if (this->_activeRelays.size() == 0)
+    vector<string> activeRelays = this->activeRelays();
+    if (activeRelays.size() == 0)
     {
         PLOG_INFO << "No active relay connections to close.";
         return;
     }
 
-    this->closeRelayConnections(this->_activeRelays);
+    this->closeRelayConnections(activeRelays);
 };
 
 void NostrServiceBase::closeRelayConnections(vector<string> relays)
 {
     PLOG_INFO << "Disconnecting from Nostr relays.";
-    vector<string> connectedRelays = this->_getConnectedRelays(relays);
+    vector<RelayId> connectedRelays = this->_getConnectedRelays(this->_internRelays(relays));
 
-    vector<thread> disconnectionThreads;
-    for (string relay : connectedRelays)
+    // Like connects, closes are carried out on the client's I/O loop, so none of them blocks.
+    // TODO: Close subscriptions before disconnecting.
+    for (RelayId relay : connectedRelays)
     {
-        thread disconnectionThread([this, relay]() {
-            this->_disconnect(relay);
-        });
-        disconnectionThreads.push_back(move(disconnectionThread));
-
-        // TODO: Close subscriptions before disconnecting.
-        lock_guard<mutex> lock(this->_propertyMutex);
-        this->_subscriptions.erase(relay);
-    }
-
-    for (thread& disconnectionThread : disconnectionThreads)
-    {
-        disconnectionThread.join();
+        this->_disconnect(relay);
     }
 };
 
@@ -113,86 +235,161 @@ tuple<vector<string>, vector<string>> NostrServiceBase::publishEvent(
     shared_ptr<nostr::data::Event> event
 )
 {
-    vector<string> successfulRelays;
-    vector<string> failedRelays;
-
-    PLOG_INFO << "Attempting to publish event to Nostr relays.";
+    return this->publishEvents({ event }).front();
+};
 
-    json message;
-    try
-    {
-        message = json::array({ "EVENT", event->serialize() });
-    }
-    catch (const std::invalid_argument& e)
+vector<tuple<vector<string>, vector<string>>> NostrServiceBase::publishEvents(
+    vector<shared_ptr<nostr::data::Event>> events
+)
+{
+    vector<tuple<vector<string>, vector<string>>> results(events.size());
+    if (events.empty())
     {
-        PLOG_ERROR << "Failed to sign event: " << e.what();
-        throw e;
+        return results;
     }
-    catch (const json::exception& je)
+
+    PLOG_INFO << "Attempting to publish " << events.size() << " events to Nostr relays.";
+
+    // Each event is serialized once, and every relay's send shares the serialized payload.
+    vector<client::SharedPayload> payloads;
+    auto eventIndices = make_shared<unordered_map<string, vector<size_t>>>();
+    for (size_t i = 0; i < events.size(); i++)
     {
-        PLOG_ERROR << "Failed to serialize event: " << je.what();
-        throw je;
+        payloads.push_back(make_shared<const string>(this->_generateEventMessage(events[i])));
+        (*eventIndices)[events[i]->id].push_back(i);
     }
 
-    lock_guard<mutex> lock(this->_propertyMutex);
-    vector<string> targetRelays = this->_activeRelays;
-    vector<future<tuple<string, bool>>> publishFutures;
-    for (const string& relay : targetRelays)
-    {
-        promise<tuple<string, bool>> publishPromise;
-        publishFutures.push_back(move(publishPromise.get_future()));
+    unique_lock<mutex> lock(this->_propertyMutex);
+    vector<RelayId> targetRelays = this->_membership->activeRelays.ids();
+    lock.unlock();
 
-        auto [uri, success] = this->_client->send(
-            message.dump(),
-            relay,
-            [this, &relay, &event, &publishPromise](string response)
+    vector<shared_ptr<PublishBatch>> batches;
+    vector<tuple<string, MessageRouter::RouteId>> routes;
+    for (RelayId relayId : targetRelays)
+    {
+        const string& relay = this->_relays->uri(relayId);
+        auto batch = make_shared<PublishBatch>(events.size());
+        batches.push_back(batch);
+
+        auto relayMetrics = &this->_metrics->relay(relay);
+        const char* traceRelay = this->_relays->traceName(relayId);
+        auto sentAt = chrono::steady_clock::now();
+
+        // One handler serves the whole batch, matching each OK message to its events by ID.  It
+        // is routed under each event's ID before any event is sent, so no OK can arrive first.
+        client::MessageHandler acceptanceHandler =
+            [this, relay, eventIndices, batch, relayMetrics, sentAt](string_view response)
             {
                 this->_onAcceptance(
                     response,
-                    [this, &relay, &event, &publishPromise](bool isAccepted)
+                    [&relay, &eventIndices, &batch, relayMetrics, sentAt](const string& eventId, bool isAccepted)
                     {
+                        auto it = eventIndices->find(eventId);
+                        if (it == eventIndices->end())
+                        {
+                            return;
+                        }
+                        relayMetrics->okLatency.record(nanosecondsSince(sentAt));
+
                         if (isAccepted)
                         {
-                            PLOG_INFO << "Relay " << relay << " accepted event: " << event->id;
-                            publishPromise.set_value(make_tuple(relay, true));
+                            PLOG_INFO << "Relay " << relay << " accepted event: " << eventId;
                         }
                         else
                         {
-                            PLOG_WARNING << "Relay " << relay << " rejected event: " << event->id;
-                            publishPromise.set_value(make_tuple(relay, false));
+                            PLOG_WARNING << "Relay " << relay << " rejected event: " << eventId;
+                        }
+
+                        for (size_t index : it->second)
+                        {
+                            batch->settle(index, isAccepted);
                         }
                     }
                 );
-            });
+            };
 
-        if (!success)
+        for (const auto& [eventId, indices] : *eventIndices)
         {
-            PLOG_WARNING << "Failed to send event to relay " << relay;
-            publishPromise.set_value(make_tuple(relay, false));
+            // If the connection closes first, the relay will not accept the event.
+            auto closeHandler = [batch, indices = indices](string_view)
+            {
+                for (size_t index : indices)
+                {
+                    batch->settle(index, false);
+                }
+            };
+            routes.emplace_back(eventId, this->_router->add(relayId, eventId, acceptanceHandler, closeHandler));
         }
-    }
 
-    for (auto& publishFuture : publishFutures)
-    {
-        auto [relay, isSuccess] = publishFuture.get();
-        if (isSuccess)
+        // The routing handler goes with every send, so the relay is answered through it even if
+        // the connection's handler was replaced between sends.
+        client::MessageHandler routeHandler = this->_routeMessages(relayId);
+        for (size_t i = 0; i < payloads.size(); i++)
         {
-            successfulRelays.push_back(relay);
+            // An event given more than once is sent once, and its answer settles every copy.
+            const vector<size_t>& indices = (*eventIndices)[events[i]->id];
+            if (indices.front() != i)
+            {
+                continue;
+            }
+
+            TraceSpan sendSpan("send", traceRelay);
+            bool success = this->_client->send(payloads[i], relay, routeHandler);
+            sendSpan.end();
+
+            if (success)
+            {
+                relayMetrics->recordSent(payloads[i]->size());
+            }
+            else
+            {
+                PLOG_WARNING << "Failed to send event " << events[i]->id << " to relay " << relay;
+                for (size_t index : indices)
+                {
+                    batch->settle(index, false);
+                }
+            }
         }
-        else
+    }
+
+    // Relays that have not answered an event by the deadline are counted as rejecting it.
+    const auto deadline = chrono::steady_clock::now() + this->connectionTimeout();
+    size_t acceptedCount = 0;
+    for (size_t r = 0; r < targetRelays.size(); r++)
+    {
+        const string& relay = this->_relays->uri(targetRelays[r]);
+        for (size_t i = 0; i < events.size(); i++)
         {
-            failedRelays.push_back(relay);
+            auto& [successfulRelays, failedRelays] = results[i];
+            auto& outcome = batches[r]->outcomes[i];
+            if (outcome.wait_until(deadline) != future_status::ready)
+            {
+                PLOG_WARNING << "Relay " << relay << " did not answer event " << events[i]->id << " within " << this->connectionTimeout().count() << " ms.";
+                failedRelays.push_back(relay);
+            }
+            else if (outcome.get())
+            {
+                successfulRelays.push_back(relay);
+                acceptedCount++;
+            }
+            else
+            {
+                failedRelays.push_back(relay);
+            }
         }
     }
 
-    std::size_t targetCount = targetRelays.size();
-    std::size_t successfulCount = successfulRelays.size();
-    PLOG_INFO << "Published event to " << successfulCount << "/" << targetCount << " target relays.";
+    for (const auto& [eventId, route] : routes)
+    {
+        this->_router->remove(eventId, route);
+    }
 
-    return make_tuple(successfulRelays, failedRelays);
+    std::size_t targetCount = targetRelays.size() * events.size();
+    PLOG_INFO << "Published " << events.size() << " events with " << acceptedCount << "/" << targetCount << " relay acceptances.";
+
+    return results;
 };
 
-// TODO: Add a timeout to this method to prevent hanging while waiting for the relay.
 future<vector<shared_ptr<nostr::data::Event>>> NostrServiceBase::queryRelays(
     shared_ptr<nostr::data::Filters> filters)
 {
@@ -204,14 +401,13 @@ future<vector<shared_ptr<nostr::data::Event>>> NostrServiceBase::queryRelays(
             filters->limit = 16;
         }
 
-        vector<shared_ptr<nostr::data::Event>> events;
-
         string subscriptionId = this->_generateSubscriptionId();
-        string request;
+        auto verifyEvents = this->_createVerificationFlag(subscriptionId);
+        client::SharedPayload request;
 
         try
         {
-            request = filters->serialize(subscriptionId);
+            request = make_shared<const string>(filters->serialize(subscriptionId));
         }
         catch (const invalid_argument& e)
         {
@@ -224,75 +420,120 @@ future<vector<shared_ptr<nostr::data::Event>>> NostrServiceBase::queryRelays(
             throw je;
         }
 
-        vector<future<tuple<string, bool>>> requestFutures;
-
-        unordered_set<string> uniqueEventIds;
-
         // Send the same query to each relay.  As events trickle in from each relay, they will be added
-        // to the events vector.  Duplicate copies of the same event will be ignored, as events are
-        // stored on multiple relays.  The function will block until all of the relays send an EOSE or
-        // CLOSE message.
-        for (const string relay : this->_activeRelays)
-        {
-            promise<tuple<string, bool>> eosePromise;
-            requestFutures.push_back(move(eosePromise.get_future()));
-
-            auto [uri, success] = this->_client->send(
-                request,
-                relay,
-                [this, &relay, &events, &eosePromise, &uniqueEventIds](string payload)
+        // to the batch.  Duplicate copies of the same event will be ignored, as events are stored on
+        // multiple relays.  The function will block until all of the relays send an EOSE or CLOSED
+        // message, or the connection timeout passes.
+        unique_lock<mutex> relaysLock(this->_propertyMutex);
+        vector<RelayId> targetRelays = this->_membership->activeRelays.ids();
+        relaysLock.unlock();
+
+        auto query = make_shared<QueryBatch>(targetRelays.size());
+        for (size_t r = 0; r < targetRelays.size(); r++)
+        {
+            RelayId relayId = targetRelays[r];
+            const string& relay = this->_relays->uri(relayId);
+
+            auto relayMetrics = &this->_metrics->relay(relay);
+            auto sentAt = chrono::steady_clock::now();
+            this->_router->add(
+                relayId,
+                subscriptionId,
+                [this, r, query, verifyEvents, relayMetrics, sentAt](string_view payload)
                 {
                     this->_onSubscriptionMessage(
                         payload,
-                        [&events, &uniqueEventIds](const string&, shared_ptr<nostr::data::Event> event)
+                        [query, verifyEvents](const string&, shared_ptr<nostr::data::Event> event)
                         {
-                            // Check if the event is unique before adding.
-                            if (uniqueEventIds.insert(event->id).second)
-                            {
-                                events.push_back(event);
-                            }
+                            // Verified queries keep every copy until the batch is checked, so a
+                            // forged copy cannot shadow a genuine one.
+                            query->add(event, verifyEvents->load());
                         },
-                        [relay, &eosePromise](const string&)
+                        [r, query, relayMetrics, sentAt](const string&)
                         {
-                            eosePromise.set_value(make_tuple(relay, true));
+                            relayMetrics->eoseLatency.record(nanosecondsSince(sentAt));
+                            query->settle(r, true);
                         },
-                        [relay, &eosePromise](const string&, const string&)
+                        [r, query](const string&, const string&)
                         {
-                            eosePromise.set_value(make_tuple(relay, false));
+                            query->settle(r, false);
                         });
+                },
+                [r, query](string_view)
+                {
+                    query->settle(r, false);
                 }
             );
 
+            TraceSpan sendSpan("send", this->_relays->traceName(relayId));
+            bool success = this->_client->send(request, relay, this->_routeMessages(relayId));
+            sendSpan.end();
+
             if (success)
             {
                 PLOG_INFO << "Sent query to relay " << relay;
+                relayMetrics->recordSent(request->size());
                 lock_guard<mutex> lock(this->_propertyMutex);
-                this->_subscriptions[subscriptionId].push_back(relay);
+                this->_membership->subscriptions[subscriptionId].insert(relayId);
             }
             else
             {
                 PLOG_WARNING << "Failed to send query to relay " << relay;
-                eosePromise.set_value(make_tuple(uri, false));
+                query->settle(r, false);
             }
         }
 
-
-        // Close open subscriptions and disconnect from relays after events are received.
-
-        for (auto& publishFuture : requestFutures)
+        // Close open subscriptions after events are received.  A CLOSED message ends only this
+        // subscription, so the relay's connection stays open for other requests.  Relays that have
+        // not finished by the deadline keep whatever events they sent.
+        const auto deadline = chrono::steady_clock::now() + this->connectionTimeout();
+        for (size_t r = 0; r < targetRelays.size(); r++)
         {
-            auto [relay, isEose] = publishFuture.get();
-            if (isEose)
+            const string& relay = this->_relays->uri(targetRelays[r]);
+            auto& outcome = query->outcomes[r];
+            if (outcome.wait_until(deadline) != future_status::ready)
+            {
+                PLOG_WARNING << "Relay " << relay << " did not finish query " << subscriptionId << " within " << this->connectionTimeout().count() << " ms.";
+            }
+            else if (outcome.get())
             {
                 PLOG_INFO << "Received EOSE message from relay " << relay;
             }
             else
             {
-                PLOG_WARNING << "Received CLOSE message from relay " << relay;
-                this->closeRelayConnections({ relay });
+                PLOG_WARNING << "Relay " << relay << " closed query " << subscriptionId << ".";
             }
         }
         this->closeSubscription(subscriptionId);
+        vector<shared_ptr<nostr::data::Event>> events = query->takeEvents();
+
+        if (verifyEvents->load())
+        {
+            // Check all received events at once so the work is spread across the verifier's
+            // workers, then drop invalid events and duplicates.
+            vector<bool> isValid = this->_eventVerifier->verify(events);
+
+            // Valid events have well-formed IDs, so they are deduplicated by their binary form.
+            vector<shared_ptr<nostr::data::Event>> verifiedEvents;
+            unordered_set<EventId, EventIdHash> verifiedEventIds;
+            for (size_t i = 0; i < events.size(); i++)
+            {
+                if (!isValid[i])
+                {
+                    continue;
+                }
+
+                EventId eventId;
+                nostr::internal::decodeHex(events[i]->id, eventId.data(), eventId.size());
+                if (verifiedEventIds.insert(eventId).second)
+                {
+                    verifiedEvents.push_back(events[i]);
+                }
+            }
+
+            PLOG_INFO << "Verified " << verifiedEvents.size() << "/" << events.size() << " events received for subscription " << subscriptionId;
+            events = move(verifiedEvents);
+        }
 
         return events;
     });
@@ -304,29 +545,82 @@ string NostrServiceBase::queryRelays(
     function<void(const string&)> eoseHandler,
     function<void(const string&, const string&)> closeHandler
 )
+{
+    return this->queryRelays(
+        filters,
+        eventHandler,
+        eoseHandler,
+        [closeHandler](const string& subscriptionId, const string& reason, const string&)
+        {
+            closeHandler(subscriptionId, reason);
+        });
+};
+
+string NostrServiceBase::queryRelays(
+    shared_ptr<nostr::data::Filters> filters,
+    function<void(const string&, shared_ptr<nostr::data::Event>)> eventHandler,
+    function<void(const string&)> eoseHandler,
+    function<void(const string&, const string&, const string&)> closeHandler
+)
 {
     vector<string> successfulRelays;
     vector<string> failedRelays;
 
     string subscriptionId = this->_generateSubscriptionId();
-    string request = filters->serialize(subscriptionId);
+    auto request = make_shared<const string>(filters->serialize(subscriptionId));
+    auto subscriptionEventHandler = this->_withVerification(
+        this->_createVerificationFlag(subscriptionId),
+        eventHandler);
+
+    unique_lock<mutex> relaysLock(this->_propertyMutex);
+    vector<RelayId> targetRelays = this->_membership->activeRelays.ids();
+    relaysLock.unlock();
+
     vector<future<tuple<string, bool>>> requestFutures;
-    for (const string relay : this->_activeRelays)
+    for (RelayId relayId : targetRelays)
     {
+        const string& relay = this->_relays->uri(relayId);
         unique_lock<mutex> lock(this->_propertyMutex);
-        this->_subscriptions[subscriptionId].push_back(relay);
+        this->_membership->subscriptions[subscriptionId].insert(relayId);
         lock.unlock();
 
+        // The message handler outlives this call, so it must own copies of the handlers.
         future<tuple<string, bool>> requestFuture = async(
-            [this, &relay, &request, &eventHandler, &eoseHandler, &closeHandler]()
+            [this, relayId, relay, subscriptionId, request, subscriptionEventHandler, eoseHandler, closeHandler]()
             {
-                return this->_client->send(
-                    request,
-                    relay,
-                    [this, &eventHandler, &eoseHandler, &closeHandler](string payload)
+                auto relayMetrics = &this->_metrics->relay(relay);
+                auto sentAt = chrono::steady_clock::now();
+                auto relayEoseHandler = [relayMetrics, sentAt, eoseHandler](const string& subscriptionId)
+                {
+                    relayMetrics->eoseLatency.record(nanosecondsSince(sentAt));
+                    eoseHandler(subscriptionId);
+                };
+                auto relayCloseHandler = [relay, closeHandler](const string& subscriptionId, const string& reason)
+                {
+                    closeHandler(subscriptionId, reason, relay);
+                };
+
+                this->_router->add(
+                    relayId,
+                    subscriptionId,
+                    [this, subscriptionEventHandler, relayEoseHandler, relayCloseHandler](string_view payload)
                     {
-                        this->_onSubscriptionMessage(payload, eventHandler, eoseHandler, closeHandler);
+                        this->_onSubscriptionMessage(payload, subscriptionEventHandler, relayEoseHandler, relayCloseHandler);
+                    },
+                    [subscriptionId, relayCloseHandler](string_view reason)
+                    {
+                        relayCloseHandler(subscriptionId, string(reason));
                     });
+
+                TraceSpan sendSpan("send", this->_relays->traceName(relayId));
+                bool success = this->_client->send(request, relay, this->_routeMessages(relayId));
+                sendSpan.end();
+
+                if (success)
+                {
+                    relayMetrics->recordSent(request->size());
+                }
+                return make_tuple(relay, success);
             }
         );
         requestFutures.push_back(move(requestFuture));
@@ -345,7 +639,7 @@ string NostrServiceBase::queryRelays(
         }
     }
 
-    std::size_t targetCount = this->_activeRelays.size();
+    std::size_t targetCount = targetRelays.size();
     std::size_t successfulCount = successfulRelays.size();
     PLOG_INFO << "Sent query to " << successfulCount << "/" << targetCount << " open relay connections.";
 
@@ -357,14 +651,23 @@ tuple<vector<string>, vector<string>> NostrServiceBase::closeSubscription(string
     vector<string> successfulRelays;
     vector<string> failedRelays;
 
-    vector<string> subscriptionRelays;
+    vector<RelayId> subscriptionRelays;
     std::size_t subscriptionRelayCount;
-    vector<future<tuple<string, bool>>> closeFutures;
+    vector<future<tuple<RelayId, bool>>> closeFutures;
+
+    // The subscription's routes are removed whether or not every relay receives the CLOSE, so a
+    // relay that keeps sending cannot reach the handlers of a closed subscription.
+    this->_router->removeAll(subscriptionId);
 
     try
     {
         unique_lock<mutex> lock(this->_propertyMutex);
-        subscriptionRelays = this->_subscriptions.at(subscriptionId);
+
+        // The subscription's verification flag is dropped whether or not every relay receives the
+        // CLOSE, since nothing else would ever erase it.  Its handlers hold their own reference.
+        this->_subscriptionVerification.erase(subscriptionId);
+
+        subscriptionRelays = this->_membership->subscriptions.at(subscriptionId).ids();
         subscriptionRelayCount = subscriptionRelays.size();
         lock.unlock();
     }
@@ -374,11 +677,11 @@ tuple<vector<string>, vector<string>> NostrServiceBase::closeSubscription(string
         return make_tuple(successfulRelays, failedRelays);
     }
 
-    for (const string relay : subscriptionRelays)
+    for (RelayId relay : subscriptionRelays)
     {
-        future<tuple<string, bool>> closeFuture = async([this, subscriptionId, relay]()
+        future<tuple<RelayId, bool>> closeFuture = async([this, subscriptionId, relay]()
         {
-            bool success = this->closeSubscription(subscriptionId, relay);
+            bool success = this->_closeSubscription(subscriptionId, relay);
 
             return make_tuple(relay, success);
         });
@@ -387,14 +690,14 @@ tuple<vector<string>, vector<string>> NostrServiceBase::closeSubscription(string
 
     for (auto& closeFuture : closeFutures)
     {
-        auto [uri, success] = closeFuture.get();
+        auto [relay, success] = closeFuture.get();
         if (success)
         {
-            successfulRelays.push_back(uri);
+            successfulRelays.push_back(this->_relays->uri(relay));
         }
         else
         {
-            failedRelays.push_back(uri);
+            failedRelays.push_back(this->_relays->uri(relay));
         }
     }
 
@@ -406,7 +709,7 @@ tuple<vector<string>, vector<string>> NostrServiceBase::closeSubscription(string
     if (failedRelays.empty())
     {
         lock_guard<mutex> lock(this->_propertyMutex);
-        this->_subscriptions.erase(subscriptionId);
+        this->_membership->subscriptions.erase(subscriptionId);
     }
 
     return make_tuple(successfulRelays, failedRelays);
@@ -414,49 +717,21 @@ tuple<vector<string>, vector<string>> NostrServiceBase::closeSubscription(string
 
 bool NostrServiceBase::closeSubscription(string subscriptionId, string relay)
 {
-    if (!this->_hasSubscription(subscriptionId, relay))
+    optional<RelayId> relayId = this->_relays->find(relay);
+    if (!relayId.has_value())
     {
         PLOG_WARNING << "Subscription " << subscriptionId << " not found on relay " << relay;
         return false;
     }
 
-    if (!this->_isConnected(relay))
-    {
-        PLOG_WARNING << "Relay " << relay << " is not connected.";
-        return false;
-    }
-
-    string request = this->_generateCloseRequest(subscriptionId);
-    auto [uri, success] = this->_client->send(request, relay);
-
-    if (success)
-    {
-        lock_guard<mutex> lock(this->_propertyMutex);
-        auto it = find(
-            this->_subscriptions[subscriptionId].begin(),
-            this->_subscriptions[subscriptionId].end(),
-            relay);
-
-        if (it != this->_subscriptions[subscriptionId].end())
-        {
-            this->_subscriptions[subscriptionId].erase(it);
-        }
-
-        PLOG_INFO << "Sent close request for subscription " << subscriptionId << " to relay " << relay;
-    }
-    else
-    {
-        PLOG_WARNING << "Failed to send close request to relay " << relay;
-    }
-
-    return success;
+    return this->_closeSubscription(subscriptionId, *relayId);
 };
 
 vector<string> NostrServiceBase::closeSubscriptions()
 {
     unique_lock<mutex> lock(this->_propertyMutex);
     vector<string> subscriptionIds;
-    for (auto& [subscriptionId, relays] : this->_subscriptions)
+    for (auto& [subscriptionId, relays] : this->_membership->subscriptions)
     {
         subscriptionIds.push_back(subscriptionId);
     }
@@ -475,16 +750,87 @@ vector<string> NostrServiceBase::closeSubscriptions()
     return remainingSubscriptions;
 };
 
-vector<string> NostrServiceBase::_getConnectedRelays(vector<string> relays)
+void NostrServiceBase::setEventVerification(bool isEnabled)
+{
+    this->_verifyEventsByDefault = isEnabled;
+};
+
+bool NostrServiceBase::setEventVerification(string subscriptionId, bool isEnabled)
+{
+    lock_guard<mutex> lock(this->_propertyMutex);
+    auto it = this->_subscriptionVerification.find(subscriptionId);
+    if (it == this->_subscriptionVerification.end())
+    {
+        PLOG_WARNING << "Subscription " << subscriptionId << " not found.";
+        return false;
+    }
+
+    it->second->store(isEnabled);
+    return true;
+};
+
+void NostrServiceBase::setConnectionTimeout(chrono::milliseconds timeout)
+{
+    this->_connectionTimeout = timeout.count();
+};
+
+chrono::milliseconds NostrServiceBase::connectionTimeout() const
+{
+    return chrono::milliseconds(this->_connectionTimeout.load());
+};
+
+EventVerifierStats NostrServiceBase::verificationStats() const
+{
+    return this->_eventVerifier->stats();
+};
+
+ServiceMetricsSnapshot NostrServiceBase::metrics() const
+{
+    ServiceMetricsSnapshot snapshot;
+    this->_metrics->snapshot(snapshot);
+    snapshot.verification = this->_eventVerifier->stats();
+    for (auto& relay : snapshot.relays)
+    {
+        relay.outboundQueueDepth = this->_client->queuedMessageCount(relay.relay);
+    }
+
+    lock_guard<mutex> lock(this->_propertyMutex);
+    snapshot.activeRelays = this->_membership->activeRelays.size();
+    snapshot.activeSubscriptions = count_if(
+        this->_membership->subscriptions.begin(),
+        this->_membership->subscriptions.end(),
+        [](const auto& subscription) { return !subscription.second.empty(); });
+
+    return snapshot;
+};
+
+vector<RelayId> NostrServiceBase::_internRelays(const vector<string>& relays)
+{
+    vector<RelayId> relayIds;
+    RelaySet seenRelays;
+    for (const string& relay : relays)
+    {
+        RelayId relayId = this->_relays->intern(relay);
+        if (seenRelays.insert(relayId))
+        {
+            relayIds.push_back(relayId);
+        }
+    }
+    return relayIds;
+};
+
+vector<RelayId> NostrServiceBase::_getConnectedRelays(const vector<RelayId>& relays)
 {
     PLOG_VERBOSE << "Identifying connected relays.";
-    vector<string> connectedRelays;
-    for (string relay : relays)
+    vector<RelayId> connectedRelays;
+    for (RelayId relay : relays)
     {
-        bool isActive = find(this->_activeRelays.begin(), this->_activeRelays.end(), relay)
-            != this->_activeRelays.end();
-        bool isConnected = this->_client->isConnected(relay);
-        PLOG_VERBOSE << "Relay " << relay << " is active: " << isActive << ", is connected: " << isConnected;
+        const string& uri = this->_relays->uri(relay);
+        bool isConnected = this->_client->isConnected(uri);
+
+        lock_guard<mutex> lock(this->_propertyMutex);
+        bool isActive = this->_membership->activeRelays.contains(relay);
+        PLOG_VERBOSE << "Relay " << uri << " is active: " << isActive << ", is connected: " << isConnected;
 
         if (isActive && isConnected)
         {
@@ -496,95 +842,182 @@ vector<string> NostrServiceBase::_getConnectedRelays(vector<string> relays)
         }
         else if (!isActive && isConnected)
         {
-            this->_activeRelays.push_back(relay);
+            this->_membership->activeRelays.insert(relay);
             connectedRelays.push_back(relay);
         }
     }
     return connectedRelays;
 };
 
-vector<string> NostrServiceBase::_getUnconnectedRelays(vector<string> relays)
+vector<RelayId> NostrServiceBase::_getUnconnectedRelays(const vector<RelayId>& relays)
 {
     PLOG_VERBOSE << "Identifying unconnected relays.";
-    vector<string> unconnectedRelays;
-    for (string relay : relays)
+    vector<RelayId> unconnectedRelays;
+    for (RelayId relay : relays)
     {
-        bool isActive = find(this->_activeRelays.begin(), this->_activeRelays.end(), relay)
-            != this->_activeRelays.end();
-        bool isConnected = this->_client->isConnected(relay);
-        PLOG_VERBOSE << "Relay " << relay << " is active: " << isActive << ", is connected: " << isConnected;
+        const string& uri = this->_relays->uri(relay);
+        bool isConnected = this->_client->isConnected(uri);
+
+        lock_guard<mutex> lock(this->_propertyMutex);
+        bool isActive = this->_membership->activeRelays.contains(relay);
+        PLOG_VERBOSE << "Relay " << uri << " is active: " << isActive << ", is connected: " << isConnected;
 
         if (!isActive && !isConnected)
         {
-            PLOG_VERBOSE << "Relay " << relay << " is not active and not connected.";
+            PLOG_VERBOSE << "Relay " << uri << " is not active and not connected.";
             unconnectedRelays.push_back(relay);
         }
         else if (isActive && !isConnected)
         {
-            PLOG_VERBOSE << "Relay " << relay << " is active but not connected.  Removing from active relays list.";
+            PLOG_VERBOSE << "Relay " << uri << " is active but not connected.  Removing from active relays list.";
             this->_eraseActiveRelay(relay);
             unconnectedRelays.push_back(relay);
         }
         else if (!isActive && isConnected)
         {
-            PLOG_VERBOSE << "Relay " << relay << " is connected but not active.  Adding to active relays list.";
-            this->_activeRelays.push_back(relay);
+            PLOG_VERBOSE << "Relay " << uri << " is connected but not active.  Adding to active relays list.";
+            this->_membership->activeRelays.insert(relay);
         }
     }
     return unconnectedRelays;
 };
 
-bool NostrServiceBase::_isConnected(string relay)
+bool NostrServiceBase::_isConnected(RelayId relay)
 {
-    auto it = find(this->_activeRelays.begin(), this->_activeRelays.end(), relay);
-    if (it != this->_activeRelays.end()) // If the relay is in this->_activeRelays
-    {
-        return true;
-    }
-    return false;
+    lock_guard<mutex> lock(this->_propertyMutex);
+    return this->_membership->activeRelays.contains(relay);
 };
 
-void NostrServiceBase::_eraseActiveRelay(string relay)
+void NostrServiceBase::_eraseActiveRelay(RelayId relay)
 {
-    auto it = find(this->_activeRelays.begin(), this->_activeRelays.end(), relay);
-    if (it != this->_activeRelays.end()) // If the relay is in this->_activeRelays
-    {
-        this->_activeRelays.erase(it);
-    }
+    this->_membership->activeRelays.erase(relay);
 };
 
-void NostrServiceBase::_connect(string relay)
+future<bool> NostrServiceBase::_connect(RelayId relay)
 {
-    PLOG_VERBOSE << "Connecting to relay " << relay;
-    this->_client->openConnection(relay);
+    const string& uri = this->_relays->uri(relay);
+    PLOG_VERBOSE << "Connecting to relay " << uri;
+
+    // The span runs from this relay's open to the end of its handshake, so relays opened together
+    // each report their own connect time.
+    const uint64_t traceStart = Tracing::now();
+    const char* traceRelay = this->_relays->traceName(relay);
+    return this->_client->openConnection(
+        uri,
+        [traceRelay, traceStart]()
+        {
+            if (Tracing::isEnabled())
+            {
+                Tracing::record({ "connect", traceRelay, traceStart, Tracing::now() - traceStart });
+            }
+        },
+        [this, lifetime = this->_lifetime, uri, relay](string_view reason)
+        {
+            PLOG_ERROR << "Failed to connect to relay " << uri << ": " << reason;
+            lifetime->ifAlive([this, relay, reason]() { this->_router->close(relay, reason); });
+        },
+        [this, lifetime = this->_lifetime, relay](string_view reason)
+        {
+            lifetime->ifAlive([this, relay, reason]() { this->_onDisconnected(relay, reason); });
+        });
+};
 
-    lock_guard<mutex> lock(this->_propertyMutex);
-    bool isConnected = this->_client->isConnected(relay);
+void NostrServiceBase::_awaitConnections(vector<tuple<RelayId, future<bool>>> pendingConnections)
+{
+    const auto deadline = chrono::steady_clock::now() + this->connectionTimeout();
 
-    if (isConnected)
+    // Every handshake is already under way, so waiting on each in turn against the same deadline
+    // ends as soon as the slowest one finishes, or at the deadline.
+    for (auto& [relay, isOpen] : pendingConnections)
     {
-        PLOG_VERBOSE << "Connected to relay " << relay << ": " << isConnected;
-        this->_activeRelays.push_back(relay);
+        const string& uri = this->_relays->uri(relay);
+        if (isOpen.wait_until(deadline) != future_status::ready)
+        {
+            PLOG_ERROR << "Failed to connect to relay " << uri << " within " << this->connectionTimeout().count() << " ms.";
+            this->_metrics->relay(uri).connectFailures.add();
+            continue;
+        }
+
+        if (!isOpen.get())
+        {
+            this->_metrics->relay(uri).connectFailures.add();
+            continue;
+        }
+
+        this->_onConnected(relay);
     }
-    else
+};
+
+void NostrServiceBase::_onConnected(RelayId relay)
+{
+    const string& uri = this->_relays->uri(relay);
+    PLOG_VERBOSE << "Connected to relay " << uri;
+    auto& relayMetrics = this->_metrics->relay(uri);
+    if (relayMetrics.connects.value() > 0)
     {
-        PLOG_ERROR << "Failed to connect to relay " << relay;
+        relayMetrics.reconnects.add();
     }
+    relayMetrics.connects.add();
+
+    lock_guard<mutex> lock(this->_propertyMutex);
+    this->_membership->activeRelays.insert(relay);
 };
 
-void NostrServiceBase::_disconnect(string relay)
+void NostrServiceBase::_onDisconnected(RelayId relay, string_view reason)
 {
-    this->_client->closeConnection(relay);
+    PLOG_WARNING << "Connection to relay " << this->_relays->uri(relay) << " closed: " << reason;
+
+    unique_lock<mutex> lock(this->_propertyMutex);
+    this->_eraseActiveRelay(relay);
+    lock.unlock();
+
+    // Publishes and queries waiting on the relay will get no more replies from it.
+    this->_router->close(relay, reason);
+};
+
+void NostrServiceBase::_disconnect(RelayId relay)
+{
+    this->_client->closeConnection(this->_relays->uri(relay));
 
     lock_guard<mutex> lock(this->_propertyMutex);
     this->_eraseActiveRelay(relay);
 };
 
+nostr::client::MessageHandler NostrServiceBase::_routeMessages(RelayId relay)
+{
+    auto router = this->_router;
+    auto lifetime = this->_lifetime;
+    auto metrics = this->_metrics;
+    auto relayMetrics = &metrics->relay(this->_relays->uri(relay));
+    const char* traceRelay = this->_relays->traceName(relay);
+
+    // Routes use the service, so messages that arrive after it is destroyed are dropped.  A
+    // message the routes cannot parse is dropped too, rather than thrown back to the client's
+    // I/O loop, where it would end the process.
+    return [router, lifetime, metrics, relay, relayMetrics, traceRelay](string_view message)
+    {
+        lifetime->ifAlive([&]()
+        {
+            TraceSpan frameSpan("frame", traceRelay);
+            relayMetrics->recordReceived(message.size());
+            try
+            {
+                if (router->dispatch(relay, message) == 0)
+                {
+                    PLOG_VERBOSE << "Ignored a message from relay " << traceRelay << " that answers no open request.";
+                }
+            }
+            catch (const exception& e)
+            {
+                PLOG_WARNING << "Dropped a malformed message from relay " << traceRelay << ": " << e.what();
+            }
+        });
+    };
+};
+
 string NostrServiceBase::_generateSubscriptionId()
 {
-    UUIDv4::UUIDGenerator<std::mt19937_64> uuidGenerator;
-    UUIDv4::UUID uuid = uuidGenerator.getUUID();
-    return uuid.str();
+    return nostr::internal::IdGenerator::next();
 };
 
 string NostrServiceBase::_generateCloseRequest(string subscriptionId)
@@ -593,56 +1026,180 @@ string NostrServiceBase::_generateCloseRequest(string subscriptionId)
     return jarr.dump();
 };
 
+string NostrServiceBase::_generateEventMessage(shared_ptr<nostr::data::Event> event)
+{
+    string serializedEvent;
+    try
+    {
+        serializedEvent = event->serialize();
+    }
+    catch (const std::invalid_argument& e)
+    {
+        PLOG_ERROR << "Failed to sign event: " << e.what();
+        throw e;
+    }
+    catch (const json::exception& je)
+    {
+        PLOG_ERROR << "Failed to serialize event: " << je.what();
+        throw je;
+    }
+
+    // The serialized event is already a JSON object, so it is spliced into the message as is,
+    // rather than parsed back into a json value only to be dumped again.
+    return "[\"EVENT\"," + serializedEvent + "]";
+};
+
 bool NostrServiceBase::_hasSubscription(string subscriptionId)
 {
     lock_guard<mutex> lock(this->_propertyMutex);
-    auto it = this->_subscriptions.find(subscriptionId);
+    auto it = this->_membership->subscriptions.find(subscriptionId);
 
-    return it != this->_subscriptions.end();
+    return it != this->_membership->subscriptions.end();
 };
 
-bool NostrServiceBase::_hasSubscription(string subscriptionId, string relay)
+bool NostrServiceBase::_hasSubscription(const string& subscriptionId, RelayId relay)
 {
     lock_guard<mutex> lock(this->_propertyMutex);
-    auto subscriptionIt = this->_subscriptions.find(subscriptionId);
+    auto it = this->_membership->subscriptions.find(subscriptionId);
+
+    return it != this->_membership->subscriptions.end() && it->second.contains(relay);
+};
+
+bool NostrServiceBase::_closeSubscription(const string& subscriptionId, RelayId relay)
+{
+    const string& uri = this->_relays->uri(relay);
+    if (!this->_hasSubscription(subscriptionId, relay))
+    {
+        PLOG_WARNING << "Subscription " << subscriptionId << " not found on relay " << uri;
+        return false;
+    }
 
-    if (subscriptionIt == this->_subscriptions.end())
+    // Delivery stops even if the CLOSE cannot be sent, since the caller is done with the relay.
+    this->_router->removeOnRelay(subscriptionId, relay);
+
+    if (!this->_isConnected(relay))
     {
+        PLOG_WARNING << "Relay " << uri << " is not connected.";
         return false;
     }
 
-    auto relays = this->_subscriptions[subscriptionId];
-    auto relayIt = find(relays.begin(), relays.end(), relay);
+    auto request = make_shared<const string>(this->_generateCloseRequest(subscriptionId));
+    TraceSpan sendSpan("send", this->_relays->traceName(relay));
+    bool success = this->_client->send(request, uri);
+    sendSpan.end();
+
+    if (success)
+    {
+        this->_metrics->relay(uri).recordSent(request->size());
+
+        lock_guard<mutex> lock(this->_propertyMutex);
+        auto it = this->_membership->subscriptions.find(subscriptionId);
+        if (it != this->_membership->subscriptions.end() && it->second.erase(relay) && it->second.empty())
+        {
+            // Closed on its last relay, so the subscription is gone.
+            this->_membership->subscriptions.erase(it);
+            this->_subscriptionVerification.erase(subscriptionId);
+        }
+
+        PLOG_INFO << "Sent close request for subscription " << subscriptionId << " to relay " << uri;
+    }
+    else
+    {
+        PLOG_WARNING << "Failed to send close request to relay " << uri;
+    }
+
+    return success;
+};
+
+shared_ptr<atomic<bool>> NostrServiceBase::_createVerificationFlag(const string& subscriptionId)
+{
+    auto verifyEvents = make_shared<atomic<bool>>(this->_verifyEventsByDefault.load());
+
+    lock_guard<mutex> lock(this->_propertyMutex);
+    this->_subscriptionVerification[subscriptionId] = verifyEvents;
 
-    return relayIt != relays.end();
+    return verifyEvents;
+};
+
+function<void(const string&, shared_ptr<nostr::data::Event>)> NostrServiceBase::_withVerification(
+    shared_ptr<atomic<bool>> verifyEvents,
+    function<void(const string&, shared_ptr<nostr::data::Event>)> eventHandler
+)
+{
+    auto eventVerifier = this->_eventVerifier;
+    return [verifyEvents, eventVerifier, eventHandler](
+        const string& subscriptionId,
+        shared_ptr<nostr::data::Event> event)
+    {
+        if (!verifyEvents->load(memory_order_relaxed))
+        {
+            eventHandler(subscriptionId, event);
+            return;
+        }
+
+        eventVerifier->submit(
+            event,
+            [subscriptionId, eventHandler](shared_ptr<nostr::data::Event> verifiedEvent, bool isValid)
+            {
+                if (isValid)
+                {
+                    eventHandler(subscriptionId, verifiedEvent);
+                }
+                else
+                {
+                    PLOG_WARNING << "Dropped event " << verifiedEvent->id << " on subscription " << subscriptionId << ": verification failed.";
+                }
+            });
+    };
 };
 
 void NostrServiceBase::_onSubscriptionMessage(
-    string message,
+    string_view message,
     function<void(const string&, shared_ptr<nostr::data::Event>)> eventHandler,
     function<void(const string&)> eoseHandler,
     function<void(const string&, const string&)> closeHandler
 )
 {
+    TraceSpan messageSpan("onSubscriptionMessage");
     try
     {
+        auto parseStart = chrono::steady_clock::now();
+        TraceSpan decodeSpan("decode");
         json jMessage = json::parse(message);
         string messageType = jMessage.at(0);
+        PLOG_VERBOSE << "Received " << messageType << " message of " << message.size() << " bytes.";
         if (messageType == "EVENT")
         {
             string subscriptionId = jMessage.at(1);
-            nostr::data::Event event = nostr::data::Event::fromString(jMessage.at(2));
+
+            // Relays send the event as an object, per NIP-01.  Events embedded as JSON strings,
+            // as earlier versions of this library published them, are still accepted.
+            const json& jEvent = jMessage.at(2);
+            nostr::data::Event event = jEvent.is_string()
+                ? nostr::data::Event::fromString(jEvent.get<string>())
+                : jEvent.get<nostr::data::Event>();
+            decodeSpan.end();
+            this->_metrics->parseTime().record(nanosecondsSince(parseStart));
+
+            TraceSpan handlerSpan("handler");
             eventHandler(subscriptionId, make_shared<nostr::data::Event>(event));
         }
         else if (messageType == "EOSE")
         {
             string subscriptionId = jMessage.at(1);
+            decodeSpan.end();
+
+            TraceSpan handlerSpan("handler");
             eoseHandler(subscriptionId);
         }
-        else if (messageType == "CLOSE")
+        // NIP-01 relays send CLOSED.  CLOSE is still accepted from relays that predate it.
+        else if (messageType == "CLOSED" || messageType == "CLOSE")
         {
             string subscriptionId = jMessage.at(1);
             string reason = jMessage.at(2);
+            decodeSpan.end();
+
+            TraceSpan handlerSpan("handler");
             closeHandler(subscriptionId, reason);
         }
     }
@@ -664,8 +1221,8 @@ void NostrServiceBase::_onSubscriptionMessage(
 };
 
 void NostrServiceBase::_onAcceptance(
-    string message,
-    function<void(const bool)> acceptanceHandler
+    string_view message,
+    function<void(const string&, const bool)> acceptanceHandler
 )
 {
     try
@@ -674,8 +1231,9 @@ void NostrServiceBase::_onAcceptance(
         string messageType = jMessage[0];
         if (messageType == "OK")
         {
+            string eventId = jMessage[1];
             bool isAccepted = jMessage[2];
-            acceptanceHandler(isAccepted);
+            acceptanceHandler(eventId, isAccepted);
         }
     }
     catch (const json::exception& je)
@@ -0,0 +1,187 @@
+#include <cstdio>
+#include <functional>
+#include <sstream>
+
+#include "service/service_metrics.hpp"
+
+using namespace nostr::service;
+using namespace std;
+
+#pragma region Local Statics
+
+static string escapeLabel(const string& value)
+{
+    string escaped;
+    escaped.reserve(value.size());
+    for (char c : value)
+    {
+        switch (c)
+        {
+        case '\\':
+            escaped += "\\\\";
+            break;
+        case '"':
+            escaped += "\\\"";
+            break;
+        case '\n':
+            escaped += "\\n";
+            break;
+        default:
+            escaped += c;
+        }
+    }
+    return escaped;
+};
+
+static string formatSeconds(uint64_t nanoseconds)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.9g", nanoseconds / 1e9);
+    return buffer;
+};
+
+static void writeHeader(ostringstream& out, const char* name, const char* type, const char* help)
+{
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " " << type << "\n";
+};
+
+static void writeSummary(
+    ostringstream& out,
+    const string& name,
+    const string& labels,
+    const LatencySummary& summary)
+{
+    const string separator = labels.empty() ? "" : ",";
+    const pair<const char*, uint64_t> quantiles[] = {
+        { "0.5", summary.p50 },
+        { "0.9", summary.p90 },
+        { "0.99", summary.p99 },
+        { "0.999", summary.p999 }
+    };
+
+    for (const auto& [quantile, value] : quantiles)
+    {
+        out << name << "{" << labels << separator << "quantile=\"" << quantile << "\"} "
+            << formatSeconds(value) << "\n";
+    }
+
+    string suffixLabels = labels.empty() ? "" : "{" + labels + "}";
+    out << name << "_sum" << suffixLabels << " " << formatSeconds(summary.sum) << "\n";
+    out << name << "_count" << suffixLabels << " " << summary.count << "\n";
+};
+
+#pragma endregion
+
+string ServiceMetricsSnapshot::toPrometheusText() const
+{
+    ostringstream out;
+
+    auto writeRelayCounter = [&](
+        const char* name,
+        const char* help,
+        function<uint64_t(const RelayMetricsSnapshot&)> value)
+    {
+        writeHeader(out, name, "counter", help);
+        for (const auto& relay : this->relays)
+        {
+            out << name << "{relay=\"" << escapeLabel(relay.relay) << "\"} " << value(relay) << "\n";
+        }
+    };
+
+    writeRelayCounter(
+        "aedile_relay_messages_received_total",
+        "Messages received from the relay.",
+        [](const RelayMetricsSnapshot& relay) { return relay.messagesIn; });
+    writeRelayCounter(
+        "aedile_relay_messages_sent_total",
+        "Messages sent to the relay.",
+        [](const RelayMetricsSnapshot& relay) { return relay.messagesOut; });
+    writeRelayCounter(
+        "aedile_relay_received_bytes_total",
+        "Payload bytes received from the relay.",
+        [](const RelayMetricsSnapshot& relay) { return relay.bytesIn; });
+    writeRelayCounter(
+        "aedile_relay_sent_bytes_total",
+        "Payload bytes sent to the relay.",
+        [](const RelayMetricsSnapshot& relay) { return relay.bytesOut; });
+    writeRelayCounter(
+        "aedile_relay_connects_total",
+        "Successful connections to the relay.",
+        [](const RelayMetricsSnapshot& relay) { return relay.connects; });
+    writeRelayCounter(
+        "aedile_relay_reconnects_total",
+        "Successful connections to the relay after the first.",
+        [](const RelayMetricsSnapshot& relay) { return relay.reconnects; });
+    writeRelayCounter(
+        "aedile_relay_connect_failures_total",
+        "Failed connection attempts to the relay.",
+        [](const RelayMetricsSnapshot& relay) { return relay.connectFailures; });
+
+    writeHeader(
+        out,
+        "aedile_relay_outbound_queue_depth",
+        "gauge",
+        "Messages queued for the relay and not yet written.");
+    for (const auto& relay : this->relays)
+    {
+        out << "aedile_relay_outbound_queue_depth{relay=\"" << escapeLabel(relay.relay) << "\"} "
+            << relay.outboundQueueDepth << "\n";
+    }
+
+    writeHeader(
+        out,
+        "aedile_relay_eose_latency_seconds",
+        "summary",
+        "Time from sending a REQ to receiving its EOSE.");
+    for (const auto& relay : this->relays)
+    {
+        writeSummary(
+            out,
+            "aedile_relay_eose_latency_seconds",
+            "relay=\"" + escapeLabel(relay.relay) + "\"",
+            relay.eoseLatency);
+    }
+
+    writeHeader(
+        out,
+        "aedile_relay_ok_latency_seconds",
+        "summary",
+        "Time from sending an EVENT to receiving its OK.");
+    for (const auto& relay : this->relays)
+    {
+        writeSummary(
+            out,
+            "aedile_relay_ok_latency_seconds",
+            "relay=\"" + escapeLabel(relay.relay) + "\"",
+            relay.okLatency);
+    }
+
+    writeHeader(
+        out,
+        "aedile_message_parse_seconds",
+        "summary",
+        "Time spent decoding each received EVENT message.");
+    writeSummary(out, "aedile_message_parse_seconds", "", this->parseTime);
+
+    writeHeader(out, "aedile_active_relays", "gauge", "Relays the service is connected to.");
+    out << "aedile_active_relays " << this->activeRelays << "\n";
+
+    writeHeader(out, "aedile_active_subscriptions", "gauge", "Subscriptions open on at least one relay.");
+    out << "aedile_active_subscriptions " << this->activeSubscriptions << "\n";
+
+    writeHeader(
+        out,
+        "aedile_verification_queue_depth",
+        "gauge",
+        "Events waiting for a verification worker.");
+    out << "aedile_verification_queue_depth " << this->verification.pending << "\n";
+
+    writeHeader(out, "aedile_events_verified_total", "counter", "Events that passed verification.");
+    out << "aedile_events_verified_total " << this->verification.verified << "\n";
+
+    writeHeader(out, "aedile_events_rejected_total", "counter", "Events that failed verification.");
+    out << "aedile_events_rejected_total " << this->verification.rejected << "\n";
+
+    return out.str();
+};
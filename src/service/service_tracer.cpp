@@ -0,0 +1,79 @@
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+
+#include "service/service_tracer.hpp"
+#include "../internal/tracing.hpp"
+
+using namespace nlohmann;
+using namespace nostr::internal;
+using namespace nostr::service;
+using namespace std;
+
+void ServiceTracer::enable(size_t spansPerThread)
+{
+    Tracing::setEnabled(true, spansPerThread);
+};
+
+void ServiceTracer::disable()
+{
+    Tracing::setEnabled(false, 0);
+};
+
+bool ServiceTracer::isEnabled()
+{
+    return Tracing::isEnabled();
+};
+
+void ServiceTracer::clear()
+{
+    Tracing::clear();
+};
+
+uint64_t ServiceTracer::droppedCount()
+{
+    return Tracing::droppedCount();
+};
+
+string ServiceTracer::toChromeTraceJson()
+{
+    json traceEvents = json::array();
+    for (const auto& [threadId, records] : Tracing::collect())
+    {
+        for (const auto& record : records)
+        {
+            json traceEvent = {
+                { "name", record.name },
+                { "cat", "aedile" },
+                { "ph", "X" },
+                { "ts", record.startNanoseconds / 1000.0 },
+                { "dur", record.durationNanoseconds / 1000.0 },
+                { "pid", 1 },
+                { "tid", threadId }
+            };
+            if (record.relay != nullptr)
+            {
+                traceEvent["args"] = { { "relay", record.relay } };
+            }
+            traceEvents.push_back(move(traceEvent));
+        }
+    }
+
+    json trace = {
+        { "traceEvents", move(traceEvents) },
+        { "displayTimeUnit", "ns" }
+    };
+    return trace.dump();
+};
+
+bool ServiceTracer::writeChromeTrace(const string& path)
+{
+    ofstream file(path, ios::out | ios::trunc);
+    if (!file)
+    {
+        return false;
+    }
+
+    file << ServiceTracer::toChromeTraceJson();
+    return static_cast<bool>(file);
+};
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#include "cryptography/noscrypt_context_pool.hpp"
+#include "signer/noscrypt_local_signer.hpp"
+#include "../cryptography/nostr_secure_rng.hpp"
+#include "../internal/hex_encoding.hpp"
+#include "../internal/logging.hpp"
+#include "../internal/noscrypt_logger.hpp"
+#include "../internal/worker_pool.hpp"
+
+using namespace std;
+using namespace nostr::cryptography;
+using namespace nostr::data;
+using namespace nostr::internal;
+using namespace nostr::signer;
+
+#pragma region Constructors and Destructors
+
+NoscryptLocalSigner::NoscryptLocalSigner(
+    shared_ptr<plog::IAppender> appender,
+    const NCSecretKey& secretKey,
+    size_t workerCount
+)
+{
+    nostr::internal::initLogging(appender);
+
+    this->_secretKey = secretKey;
+
+    const NCContext* context = NoscryptContextPool::local();
+    NCResult validationResult = NCValidateSecretKey(context, &this->_secretKey);
+    if (validationResult != NC_SUCCESS)
+    {
+        NostrSecureRng::zero(&this->_secretKey, sizeof(NCSecretKey));
+        throw invalid_argument("NoscryptLocalSigner: The provided secret key is invalid.");
+    }
+
+    NCResult pubkeyResult = NCGetPublicKey(
+        context,
+        &this->_secretKey,
+        &this->_publicKey);
+    if (pubkeyResult != NC_SUCCESS)
+    {
+        NC_LOG_ERROR(pubkeyResult);
+        NostrSecureRng::zero(&this->_secretKey, sizeof(NCSecretKey));
+        throw invalid_argument("NoscryptLocalSigner: Unable to derive a public key from the secret key.");
+    }
+    this->_publicKeyHex = encodeHex(this->_publicKey.key, sizeof(this->_publicKey.key));
+
+    if (workerCount == 0)
+    {
+        workerCount = max<size_t>(1, thread::hardware_concurrency());
+    }
+
+    if (workerCount > 1)
+    {
+        this->_pool = make_unique<WorkerPool>(workerCount);
+    }
+};
+
+NoscryptLocalSigner::~NoscryptLocalSigner()
+{
+    // Workers sign with the secret key, so they are stopped before it is wiped.
+    this->_pool.reset();
+    NostrSecureRng::zero(&this->_secretKey, sizeof(NCSecretKey));
+};
+
+#pragma endregion
+
+#pragma region Public Interface
+
+shared_ptr<promise<bool>> NoscryptLocalSigner::sign(shared_ptr<Event> event)
+{
+    auto signingPromise = make_shared<promise<bool>>();
+
+    signingPromise->set_value(this->_signEvent(*event));
+
+    return signingPromise;
+};
+
+vector<bool> NoscryptLocalSigner::signEvents(const vector<shared_ptr<Event>>& events)
+{
+    vector<uint8_t> results(events.size(), 0);
+    auto signEvent = [this, &events, &results](size_t i)
+    {
+        results[i] = this->_signEvent(*events[i]) ? 1 : 0;
+    };
+
+    if (this->_pool)
+    {
+        this->_pool->parallelFor(events.size(), signEvent);
+    }
+    else
+    {
+        for (size_t i = 0; i < events.size(); i++)
+        {
+            signEvent(i);
+        }
+    }
+
+    return vector<bool>(results.begin(), results.end());
+};
+
+string NoscryptLocalSigner::publicKey() const
+{
+    return this->_publicKeyHex;
+};
+
+#pragma endregion
+
+#pragma region Signing Helpers
+
+bool NoscryptLocalSigner::_signEvent(Event& event) const
+{
+    if (event.pubkey.empty())
+    {
+        event.pubkey = this->_publicKeyHex;
+    }
+    else
+    {
+        NCPublicKey eventPubkey;
+        if (!decodeHex(event.pubkey, eventPubkey.key, sizeof(eventPubkey.key))
+            || !equal(begin(eventPubkey.key), end(eventPubkey.key), begin(this->_publicKey.key)))
+        {
+            PLOG_ERROR << "Cannot sign an event whose pubkey " << event.pubkey << " does not belong to this signer.";
+            return false;
+        }
+        event.pubkey = this->_publicKeyHex;
+    }
+
+    try
+    {
+        event.validate();
+    }
+    catch (const invalid_argument& e)
+    {
+        PLOG_ERROR << "Cannot sign an invalid event: " << e.what();
+        return false;
+    }
+
+    // The event ID is the digest of the canonical serialization, and it is also the message that
+    // is signed, so it is computed once and signed directly.
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    event.computeDigest(digest);
+
+    uint8_t schnorrSig[64];
+    uint8_t random32[32];
+
+    // Secure random signing entropy is required.
+    NostrSecureRng::fill(random32, sizeof(random32));
+
+    // Each thread signs with its own context, so concurrent signers need no lock.
+    NCResult signatureResult = NCSignDigest(
+        NoscryptContextPool::local(),
+        &this->_secretKey,
+        random32,
+        digest,
+        schnorrSig
+    );
+
+    // The random buffer could leak sensitive signing information.
+    NostrSecureRng::zero(random32, sizeof(random32));
+
+    if (signatureResult != NC_SUCCESS)
+    {
+        NC_LOG_ERROR(signatureResult);
+        return false;
+    }
+
+    event.id = encodeHex(digest, sizeof(digest));
+    event.sig = encodeHex(schnorrSig, sizeof(schnorrSig));
+
+    return true;
+};
+
+#pragma endregion
@@ -1,54 +1,36 @@
 #include <algorithm>
 #include <chrono>
 #include <cstring>
+#include <limits>
 #include <memory>
 #include <sstream>
 #include <tuple>
 
 #include <nlohmann/json.hpp>
-#include <uuid_v4.h>
 
+#include "cryptography/base64.hpp"
+#include "cryptography/event_verifier.hpp"
+#include "cryptography/noscrypt_context_pool.hpp"
 #include "signer/noscrypt_signer.hpp"
 #include "../cryptography/nostr_secure_rng.hpp"
 #include "../cryptography/noscrypt_cipher.hpp"
+#include "../cryptography/conversation_key_cache.hpp"
+#include "../internal/hex_encoding.hpp"
+#include "../internal/id_generator.hpp"
+#include "../internal/lifetime_guard.hpp"
+#include "../internal/logging.hpp"
 #include "../internal/noscrypt_logger.hpp"
 
 using namespace std;
 using namespace nostr::data;
+using namespace nostr::encoding;
+using namespace nostr::internal;
 using namespace nostr::service;
 using namespace nostr::signer;
 using namespace nostr::cryptography;
 
 #pragma region Local Statics
 
-static shared_ptr<NCContext> ncAllocContext()
-{
-    /* 
-	* Use the utilties library to allocate a new Noscrypt context. 
-    * Shared pointer will call free when smart pointer is destroyed 
-    */
-
-    return shared_ptr<NCContext>(
-        NCUtilContextAlloc(),
-        &NCUtilContextFree
-    );
-}
-
-static shared_ptr<NCContext> initNoscryptContext()
-{
-    //Use helper to allocate a dynamic sized shared pointer
-    auto ctx = ncAllocContext();
-
-    auto randomEntropy = make_unique<uint8_t>(NC_CONTEXT_ENTROPY_SIZE);
-    NostrSecureRng::fill(randomEntropy.get(), NC_CONTEXT_ENTROPY_SIZE);
-
-    NCResult initResult = NCInitContext(ctx.get(), randomEntropy.get());
-
-    NC_LOG_ERROR(initResult);
-
-    return ctx;
-};
-
 /**
  * @brief Generates a private/public key pair for local use.
  * @returns The generated keypair of the form `[privateKey, publicKey]`, or a pair of empty
@@ -57,7 +39,7 @@ static shared_ptr<NCContext> initNoscryptContext()
  * of this class.
  */
 static void createLocalKeypair(
-    const shared_ptr<const NCContext> ctx,
+    const NCContext* ctx,
     shared_ptr<NCSecretKey> secret,
     shared_ptr<NCPublicKey> pubkey
 )
@@ -65,12 +47,12 @@ static void createLocalKeypair(
     NCResult secretValidationResult;
 
     NostrSecureRng::fill(secret.get(), sizeof(NCSecretKey));
-    secretValidationResult = NCValidateSecretKey(ctx.get(), secret.get());
+    secretValidationResult = NCValidateSecretKey(ctx, secret.get());
 
     NC_LOG_ERROR(secretValidationResult);
 
     // Use noscrypt to derive the public key from its private counterpart.
-    NCResult pubkeyGenerationResult = NCGetPublicKey(ctx.get(), secret.get(), pubkey.get());
+    NCResult pubkeyGenerationResult = NCGetPublicKey(ctx, secret.get(), pubkey.get());
 
     NC_LOG_ERROR(pubkeyGenerationResult);
 };
@@ -84,22 +66,40 @@ NoscryptSigner::NoscryptSigner(
     shared_ptr<INostrServiceBase> nostrService
 )
 {
-    plog::init(plog::debug, appender.get());
+    nostr::internal::initLogging(appender);
 
-    this->_noscryptContext = initNoscryptContext();
+    this->_conversationKeys = make_shared<ConversationKeyCache>();
 
+    this->_localPrivateKey = make_shared<NCSecretKey>();
+    this->_localPublicKey = make_shared<NCPublicKey>();
     createLocalKeypair(
-        this->_noscryptContext, 
-        this->_localPrivateKey, 
+        NoscryptContextPool::local(),
+        this->_localPrivateKey,
         this->_localPublicKey
     );
 
     this->_nostrService = nostrService;
+    this->_lifetime = make_shared<LifetimeGuard>();
 };
 
 NoscryptSigner::~NoscryptSigner()
 {
-    NCDestroyContext(this->_noscryptContext.get());
+    // The service may outlive the signer, so the subscription's handlers are cut off first.
+    this->_lifetime->end();
+
+    // A retired subscription may still be open on the relays that did not close it.
+    unique_lock<mutex> lock(this->_pendingRequestMutex);
+    string responseSubscriptionId = this->_responseSubscriptionId;
+    this->_isResponseSubscriptionOpen = false;
+    lock.unlock();
+
+    if (!responseSubscriptionId.empty())
+    {
+        this->_nostrService->closeSubscription(responseSubscriptionId);
+    }
+    this->_failPendingRequests("The signer was destroyed.");
+
+    NostrSecureRng::zero(this->_localPrivateKey.get(), sizeof(NCSecretKey));
 };
 
 #pragma endregion
@@ -187,42 +187,25 @@ string NoscryptSigner::generateConnectionToken(
     return ss.str();
 };
 
-promise<bool> NoscryptSigner::ping()
+shared_ptr<promise<bool>> NoscryptSigner::ping()
 {
-    promise<bool> pingPromise;
+    auto pingPromise = make_shared<promise<bool>>();
 
-    // Generate a ping message and wrap it for the signer.
+    // Generate a ping message for the signer.
     nlohmann::json jrpc =
     {
         { "id", this->_generateSignerRequestId() },
         { "method", "ping" },
         { "params", nlohmann::json::array() }
     };
-    auto messageEvent = this->_wrapSignerMessage(jrpc);
-
-    // Generate a filter to receive the response.
-    auto pingFilter = this->_buildSignerMessageFilters();
 
-    this->_nostrService->publishEvent(messageEvent);
-
-    // TODO: Handle the relay response.
-    this->_nostrService->queryRelays(
-        pingFilter,
-        [this, &pingPromise](const string&, shared_ptr<Event> pongEvent)
-        {
-            // 
-            string pongMessage = this->_unwrapSignerMessage(pongEvent);
-            pingPromise.set_value(pongMessage == "pong");
-        },
-        [&pingPromise](const string&)
+    this->_sendSignerRequest(
+        jrpc,
+        [pingPromise](const nlohmann::json& response)
         {
-            pingPromise.set_value(false);
-        },
-        [&pingPromise](const string&, const string&)
-        {
-            pingPromise.set_value(false);
+            pingPromise->set_value(response.contains("result") && response.at("result") == "pong");
         });
-    
+
     return pingPromise;
 };
 
@@ -236,43 +219,59 @@ shared_ptr<promise<bool>> NoscryptSigner::sign(shared_ptr<Event> event)
     auto params = nlohmann::json::array();
     params.push_back(event->serialize());
 
-    auto requestId = this->_generateSignerRequestId();
+    // The signer must return this event, signed by the user, and nothing else.
+    Event requestedEvent = *event;
+    string userPublicKey = this->_getRemotePublicKey();
 
-    // Create a filter set to find events from the remote signer.
-    auto remoteSignerFilters = this->_buildSignerMessageFilters();
-
-    // Generate the signing request event.
     nlohmann::json jrpc = {
-        { "id", requestId },
+        { "id", this->_generateSignerRequestId() },
         { "method", "sign_event" },
         { "params", params }
     };
-    auto signingRequest = this->_wrapSignerMessage(jrpc);
-
-    // Send the signing request.
-    this->_nostrService->publishEvent(signingRequest);
 
-    // Wait for the remote signer's response.
-    this->_nostrService->queryRelays(
-        remoteSignerFilters,
-        [this, &event, &signingPromise](const string&, shared_ptr<Event> signerEvent)
-        {
-            // Assign the response event to the `event` parameter, accomplishing the intended
-            // function result via side effect.
-            string signerResponse = this->_unwrapSignerMessage(signerEvent);
-            event = make_shared<Event>(Event::fromString(signerResponse));
-            signingPromise->set_value(true);
-        },
-        [&signingPromise](const string&)
+    this->_sendSignerRequest(
+        jrpc,
+        [event, requestedEvent, userPublicKey, signingPromise](const nlohmann::json& response)
         {
-            signingPromise->set_value(false);
-        },
-        [&signingPromise](const string&, const string&)
-        {
-            signingPromise->set_value(false);
-        }
-    );
-    
+            if (response.contains("error") || !response.contains("result"))
+            {
+                PLOG_ERROR << "The remote signer did not sign the event: " << (response.contains("error") ? response.at("error").dump() : "no result");
+                signingPromise->set_value(false);
+                return;
+            }
+
+            try
+            {
+                // Update the caller's event in place with the signed event returned by the signer.
+                Event signedEvent = Event::fromString(response.at("result"));
+                if (!EventVerifier::verifyEvent(NoscryptContextPool::local(), signedEvent))
+                {
+                    PLOG_ERROR << "The remote signer returned an event with an invalid signature.";
+                    signingPromise->set_value(false);
+                    return;
+                }
+
+                if (signedEvent.pubkey != userPublicKey
+                    || signedEvent.kind != requestedEvent.kind
+                    || signedEvent.createdAt != requestedEvent.createdAt
+                    || signedEvent.tags != requestedEvent.tags
+                    || signedEvent.content != requestedEvent.content)
+                {
+                    PLOG_ERROR << "The remote signer returned an event other than the one it was asked to sign.";
+                    signingPromise->set_value(false);
+                    return;
+                }
+
+                *event = signedEvent;
+                signingPromise->set_value(true);
+            }
+            catch (const exception& e)
+            {
+                PLOG_ERROR << "Unable to parse the signed event returned by the remote signer: " << e.what();
+                signingPromise->set_value(false);
+            }
+        });
+
     return signingPromise;
 };
 
@@ -295,13 +294,9 @@ inline void NoscryptSigner::_setLocalPrivateKey(const string value)
 {
     auto seckey = make_unique<NCSecretKey>();
 
-    for (auto i = 0; i < sizeof(NCSecretKey); i++)
+    if (!nostr::internal::decodeHex(value, seckey->key, sizeof(NCSecretKey)))
     {
-        stringstream ss;
-        ss << hex << value.substr(i * 2, 2);
-        uint8_t byte;
-        ss >> byte;
-        seckey->key[i] = byte;
+        PLOG_ERROR << "The key is not a 64-character hex string.";
     }
 
     this->_localPrivateKey = move(seckey);
@@ -322,13 +317,9 @@ inline void NoscryptSigner::_setLocalPublicKey(const string value)
 {
     auto pubkey = make_unique<NCPublicKey>();
 
-    for (auto i = 0; i < sizeof(NCPublicKey); i++)
+    if (!nostr::internal::decodeHex(value, pubkey->key, sizeof(NCPublicKey)))
     {
-        stringstream ss;
-        ss << hex << value.substr(i * 2, 2);
-        uint8_t byte;
-        ss >> byte;
-        pubkey->key[i] = byte;
+        PLOG_ERROR << "The key is not a 64-character hex string.";
     }
 
     this->_localPublicKey = move(pubkey);
@@ -349,13 +340,9 @@ inline void NoscryptSigner::_setRemotePublicKey(const string value)
 {
     auto pubkey = make_unique<NCPublicKey>();
 
-    for (auto i = 0; i < sizeof(NCPublicKey); i++)
+    if (!nostr::internal::decodeHex(value, pubkey->key, sizeof(NCPublicKey)))
     {
-        stringstream ss;
-        ss << hex << value.substr(i * 2, 2);
-        uint8_t byte;
-        ss >> byte;
-        pubkey->key[i] = byte;
+        PLOG_ERROR << "The key is not a 64-character hex string.";
     }
 
     this->_remotePublicKey = move(pubkey);
@@ -382,7 +369,7 @@ int NoscryptSigner::_parseRemotePublicKey(string connectionToken)
         return -1;
     }
 
-    string remotePubkey = connectionToken.substr(pubkeyStart, queryStart);
+    string remotePubkey = connectionToken.substr(pubkeyStart, queryStart - pubkeyStart);
     this->_setRemotePublicKey(remotePubkey);
 
     return queryStart + 1;
@@ -418,9 +405,7 @@ void NoscryptSigner::_handleConnectionTokenParam(string param)
 
 inline string NoscryptSigner::_generateSignerRequestId() const
 {
-    UUIDv4::UUIDGenerator<std::mt19937_64> uuidGenerator;
-    UUIDv4::UUID uuid = uuidGenerator.getUUID();
-    return uuid.str();
+    return nostr::internal::IdGenerator::next();
 };
 
 shared_ptr<Event> NoscryptSigner::_wrapSignerMessage(nlohmann::json jrpc)
@@ -455,15 +440,17 @@ shared_ptr<Event> NoscryptSigner::_wrapSignerMessage(nlohmann::json jrpc)
     //Secure random signing entropy is required
 	NostrSecureRng::fill(random32, sizeof(random32));
 
-    // Sign the wrapper message with the local secret key.
-    string serializedEvent = wrapperEvent->serialize();
+    // Sign the wrapper message's ID with the local secret key, as specified by NIP-01.
+    wrapperEvent->validate();
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    wrapperEvent->computeDigest(digest);
+    wrapperEvent->id = nostr::internal::encodeHex(digest, sizeof(digest));
 
-    NCResult signatureResult = NCSignData(
-        this->_noscryptContext.get(),
+    NCResult signatureResult = NCSignDigest(
+        NoscryptContextPool::local(),
         this->_localPrivateKey.get(),
         random32,
-        reinterpret_cast<const uint8_t*>(serializedEvent.c_str()),
-        serializedEvent.length(),
+        digest,
         schnorrSig
     );
 
@@ -478,17 +465,19 @@ shared_ptr<Event> NoscryptSigner::_wrapSignerMessage(nlohmann::json jrpc)
     }
 
     // Add the signature to the event.
-    wrapperEvent->sig = string(
-        reinterpret_cast<char*>(schnorrSig), 
-        sizeof(schnorrSig)
-    );
+    wrapperEvent->sig = nostr::internal::encodeHex(schnorrSig, sizeof(schnorrSig));
 
     return wrapperEvent;
 };
 
 string NoscryptSigner::_unwrapSignerMessage(shared_ptr<Event> event)
 {
-    // TODO: Verify the incoming event.
+    // Only accept responses that were actually signed by the remote signer.
+    if (!nostr::cryptography::EventVerifier::verifyEvent(NoscryptContextPool::local(), *event))
+    {
+        PLOG_WARNING << "Received a signer message with an invalid ID or signature; discarding it.";
+        return string();
+    }
 
     // Extract and decrypt the event payload.
     string encryptedContent = event->content;
@@ -516,9 +505,239 @@ inline shared_ptr<Filters> NoscryptSigner::_buildSignerMessageFilters() const
     filters->tags["p"] = { this->_getLocalPublicKey() };
     filters->since = time(nullptr);
 
+    // The response subscription stays open for the lifetime of the signer, so it must not be
+    // bounded by the default `until` of the present.
+    filters->until = numeric_limits<uint32_t>::max();
+    filters->limit = 64;
+
     return filters;
 };
 
+bool NoscryptSigner::_openResponseSubscription()
+{
+    lock_guard<mutex> subscriptionLock(this->_responseSubscriptionMutex);
+
+    unique_lock<mutex> requestLock(this->_pendingRequestMutex);
+    if (this->_isResponseSubscriptionOpen)
+    {
+        return true;
+    }
+    string staleSubscriptionId = this->_responseSubscriptionId;
+    this->_responseSubscriptionId.clear();
+    this->_closedResponseRelays.clear();
+    this->_isResponseSubscriptionOpen = true;
+    requestLock.unlock();
+
+    // A relay closed the previous subscription, so make sure the others drop it too.
+    if (!staleSubscriptionId.empty())
+    {
+        this->_nostrService->closeSubscription(staleSubscriptionId);
+    }
+
+    try
+    {
+        string subscriptionId = this->_nostrService->queryRelays(
+            this->_buildSignerMessageFilters(),
+            [this, lifetime = this->_lifetime](const string&, shared_ptr<Event> signerEvent)
+            {
+                lifetime->ifAlive([&]() { this->_handleSignerResponse(signerEvent); });
+            },
+            [](const string&)
+            {
+                // Stored responses have been delivered; the subscription stays open for new ones.
+            },
+            [this, lifetime = this->_lifetime](
+                const string& subscriptionId,
+                const string& reason,
+                const string& relay)
+            {
+                lifetime->ifAlive([&]() { this->_onResponseSubscriptionClosed(subscriptionId, relay, reason); });
+            });
+
+        requestLock.lock();
+        this->_responseSubscriptionId = subscriptionId;
+    }
+    catch (const exception& e)
+    {
+        PLOG_ERROR << "Unable to open the remote signer response subscription: " << e.what();
+
+        requestLock.lock();
+        this->_isResponseSubscriptionOpen = false;
+        return false;
+    }
+
+    return true;
+};
+
+void NoscryptSigner::_sendSignerRequest(
+    nlohmann::json jrpc,
+    function<void(const nlohmann::json&)> responseHandler
+)
+{
+    string requestId = jrpc.at("id");
+
+    if (!this->_openResponseSubscription())
+    {
+        responseHandler({ { "id", requestId }, { "error", "Unable to subscribe to remote signer responses." } });
+        return;
+    }
+
+    auto requestEvent = this->_wrapSignerMessage(jrpc);
+    if (requestEvent == nullptr)
+    {
+        responseHandler({ { "id", requestId }, { "error", "Unable to sign the request to the remote signer." } });
+        return;
+    }
+
+    // Register the handler before publishing, since the response may arrive on another thread
+    // before `publishEvent` returns.
+    unique_lock<mutex> lock(this->_pendingRequestMutex);
+    this->_pendingRequests[requestId].responseHandler = responseHandler;
+    lock.unlock();
+
+    auto [successes, failures] = this->_nostrService->publishEvent(requestEvent);
+
+    // The response can only arrive through a relay that accepted the request and has not closed
+    // the response subscription.
+    lock.lock();
+    auto it = this->_pendingRequests.find(requestId);
+    if (it == this->_pendingRequests.end())
+    {
+        return;
+    }
+
+    for (const string& relay : successes)
+    {
+        if (this->_closedResponseRelays.count(relay) == 0)
+        {
+            it->second.relays.insert(relay);
+        }
+    }
+    it->second.isPublished = true;
+
+    if (!it->second.relays.empty())
+    {
+        return;
+    }
+
+    this->_pendingRequests.erase(it);
+    this->_retireResponseSubscriptionIfIdle();
+    lock.unlock();
+
+    responseHandler({
+        { "id", requestId },
+        { "error", successes.empty()
+            ? "No relay accepted the request to the remote signer."
+            : "Every relay that accepted the request to the remote signer has closed the response subscription." }
+    });
+};
+
+void NoscryptSigner::_handleSignerResponse(shared_ptr<Event> event)
+{
+    string signerMessage;
+    try
+    {
+        signerMessage = this->_unwrapSignerMessage(event);
+    }
+    catch (const exception& e)
+    {
+        PLOG_ERROR << "Unable to unwrap a message from the remote signer: " << e.what();
+        return;
+    }
+
+    if (signerMessage.empty())
+    {
+        return;
+    }
+
+    nlohmann::json response = nlohmann::json::parse(signerMessage, nullptr, false);
+    if (response.is_discarded() || !response.contains("id") || !response.at("id").is_string())
+    {
+        PLOG_WARNING << "Received a malformed message from the remote signer.";
+        return;
+    }
+
+    // Take the handler out of the map so a duplicate response, such as one delivered by a second
+    // relay, is ignored.
+    function<void(const nlohmann::json&)> responseHandler;
+    unique_lock<mutex> lock(this->_pendingRequestMutex);
+    auto it = this->_pendingRequests.find(response.at("id"));
+    if (it == this->_pendingRequests.end())
+    {
+        return;
+    }
+    responseHandler = move(it->second.responseHandler);
+    this->_pendingRequests.erase(it);
+    this->_retireResponseSubscriptionIfIdle();
+    lock.unlock();
+
+    responseHandler(response);
+};
+
+void NoscryptSigner::_onResponseSubscriptionClosed(
+    const string& subscriptionId,
+    const string& relay,
+    const string& reason
+)
+{
+    PLOG_WARNING << "The remote signer response subscription " << subscriptionId << " was closed by " << relay << ": " << reason;
+
+    vector<pair<string, function<void(const nlohmann::json&)>>> failedRequests;
+    unique_lock<mutex> lock(this->_pendingRequestMutex);
+
+    // Ignore a late CLOSE for a subscription that has since been replaced.
+    if (!this->_responseSubscriptionId.empty() && subscriptionId != this->_responseSubscriptionId)
+    {
+        return;
+    }
+
+    this->_closedResponseRelays.insert(relay);
+
+    // Requests that have not been published yet will skip this relay when they are.
+    for (auto it = this->_pendingRequests.begin(); it != this->_pendingRequests.end();)
+    {
+        PendingRequest& request = it->second;
+        if (!request.isPublished || request.relays.erase(relay) == 0 || !request.relays.empty())
+        {
+            ++it;
+            continue;
+        }
+
+        failedRequests.emplace_back(it->first, move(request.responseHandler));
+        it = this->_pendingRequests.erase(it);
+    }
+
+    this->_retireResponseSubscriptionIfIdle();
+    lock.unlock();
+
+    for (auto& [requestId, responseHandler] : failedRequests)
+    {
+        responseHandler({ { "id", requestId }, { "error", reason } });
+    }
+};
+
+void NoscryptSigner::_retireResponseSubscriptionIfIdle()
+{
+    // The next request opens a fresh subscription, so the closing relays serve responses again.
+    if (!this->_closedResponseRelays.empty() && this->_pendingRequests.empty())
+    {
+        this->_isResponseSubscriptionOpen = false;
+    }
+};
+
+void NoscryptSigner::_failPendingRequests(const string& reason)
+{
+    unordered_map<string, PendingRequest> failedRequests;
+    unique_lock<mutex> lock(this->_pendingRequestMutex);
+    failedRequests.swap(this->_pendingRequests);
+    lock.unlock();
+
+    for (auto& [requestId, request] : failedRequests)
+    {
+        request.responseHandler({ { "id", requestId }, { "error", reason } });
+    }
+};
+
 #pragma endregion
 
 #pragma region Cryptography
@@ -535,38 +754,47 @@ string NoscryptSigner::_decryptNip04(string input)
 
 string NoscryptSigner::_encryptNip44(string input)
 {
-    NoscryptCipher cipher = NoscryptCipher(
-        NoscryptCipherVersion::NIP44,
-        NoscryptCipherMode::CIPHER_MODE_ENCRYPT
-    );
+    uint8_t conversationKey[NC_CONV_KEY_SIZE];
+    if (!this->_conversationKeys->get(
+        NoscryptContextPool::local(),
+        *this->_localPrivateKey,
+        *this->_remotePublicKey,
+        conversationKey))
+    {
+        return string();
+    }
 
-	auto output = cipher.update(
-		this->_noscryptContext,
-		this->_localPrivateKey,
-		this->_remotePublicKey,
-		input
-    );
+    auto output = NoscryptCipher::encryptNip44(NoscryptContextPool::local(), conversationKey, input);
+    NostrSecureRng::zero(conversationKey, sizeof(conversationKey));
 
     return output.empty()
         ? string()
-        : NoscryptCipher::naiveEncodeBase64(output);
+        : Base64::encode(output);
 };
 
 string NoscryptSigner::_decryptNip44(string input)
 {
-    //TODO handle input validation as per nip44 spec
+    string payload;
+    if (!Base64::decode(input, payload))
+    {
+        PLOG_ERROR << "NIP-44 payload is not valid base64.";
+        return string();
+    }
 
-    NoscryptCipher cipher = NoscryptCipher(
-        NoscryptCipherVersion::NIP44, 
-        NoscryptCipherMode::CIPHER_MODE_DECRYPT
-    );
+    uint8_t conversationKey[NC_CONV_KEY_SIZE];
+    if (!this->_conversationKeys->get(
+        NoscryptContextPool::local(),
+        *this->_localPrivateKey,
+        *this->_remotePublicKey,
+        conversationKey))
+    {
+        return string();
+    }
 
-    return cipher.update(
-        this->_noscryptContext,
-        this->_localPrivateKey,
-        this->_remotePublicKey,
-        NoscryptCipher::naiveDecodeBase64(input)
-    );
+    auto output = NoscryptCipher::decryptNip44(NoscryptContextPool::local(), conversationKey, payload);
+    NostrSecureRng::zero(conversationKey, sizeof(conversationKey));
+
+    return output;
 };
 
 #pragma endregion
@@ -0,0 +1,106 @@
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <plog/Formatters/TxtFormatter.h>
+#include <plog/Log.h>
+
+#include "logging/async_appender.hpp"
+
+using namespace nostr::logging;
+using namespace std;
+using namespace ::testing;
+
+namespace nostr_test
+{
+class AsyncAppenderTest : public testing::Test
+{
+public:
+    typedef AsyncAppender<plog::TxtFormatter> TxtAsyncAppender;
+
+    static void writeRecord(plog::IAppender& appender, int number)
+    {
+        plog::Record record(plog::info, "writeRecord", __LINE__, __FILE__, nullptr, 0);
+        record << "message " << number << ";";
+        appender.write(record);
+    };
+};
+
+TEST_F(AsyncAppenderTest, Write_PassesLinesToSink_InOrder)
+{
+    mutex linesMutex;
+    vector<string> lines;
+    TxtAsyncAppender appender(64, [&](const plog::util::nstring& line)
+    {
+        lock_guard<mutex> lock(linesMutex);
+        lines.push_back(line);
+    });
+
+    for (int i = 0; i < 50; i++)
+    {
+        writeRecord(appender, i);
+    }
+    appender.flush();
+
+    lock_guard<mutex> lock(linesMutex);
+    ASSERT_EQ(lines.size(), 50);
+    for (int i = 0; i < 50; i++)
+    {
+        ASSERT_NE(lines[i].find("message " + to_string(i) + ";"), string::npos);
+    }
+    ASSERT_EQ(appender.droppedCount(), 0);
+};
+
+TEST_F(AsyncAppenderTest, Write_DropsLines_WhenRingIsFull)
+{
+    promise<void> sinkReleased;
+    shared_future<void> isSinkReleased = sinkReleased.get_future().share();
+    promise<void> sinkEntered;
+    once_flag sinkEnteredOnce;
+
+    size_t writtenCount = 0;
+    TxtAsyncAppender appender(8, [&](const plog::util::nstring&)
+    {
+        call_once(sinkEnteredOnce, [&]() { sinkEntered.set_value(); });
+        isSinkReleased.wait();
+        writtenCount++;
+    });
+    ASSERT_EQ(appender.capacity(), 8);
+
+    // The writer takes the first line and blocks in the sink, so the ring fills behind it.
+    writeRecord(appender, 0);
+    sinkEntered.get_future().wait();
+    for (int i = 1; i < 100; i++)
+    {
+        writeRecord(appender, i);
+    }
+
+    ASSERT_EQ(appender.droppedCount(), 100 - 1 - appender.capacity());
+
+    sinkReleased.set_value();
+    appender.flush();
+    ASSERT_EQ(writtenCount + appender.droppedCount(), 100);
+};
+
+TEST_F(AsyncAppenderTest, Destructor_WritesPendingLines)
+{
+    auto lines = make_shared<vector<string>>();
+    {
+        TxtAsyncAppender appender(1024, [lines](const plog::util::nstring& line)
+        {
+            lines->push_back(line);
+        });
+
+        for (int i = 0; i < 500; i++)
+        {
+            writeRecord(appender, i);
+        }
+    }
+
+    ASSERT_EQ(lines->size(), 500);
+    ASSERT_NE(lines->back().find("message 499;"), string::npos);
+};
+} // namespace nostr_test
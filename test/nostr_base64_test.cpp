@@ -0,0 +1,205 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <openssl/evp.h>
+
+#include "cryptography/base64.hpp"
+
+using namespace nostr::encoding;
+using namespace std;
+using namespace ::testing;
+
+namespace nostr_test
+{
+class NostrBase64Test : public testing::Test
+{
+public:
+    static vector<uint8_t> randomBytes(mt19937& rng, size_t size)
+    {
+        uniform_int_distribution<int> byteDistribution(0, 255);
+        vector<uint8_t> bytes(size);
+        for (auto& byte : bytes)
+        {
+            byte = static_cast<uint8_t>(byteDistribution(rng));
+        }
+
+        return bytes;
+    };
+
+    static string referenceEncode(const vector<uint8_t>& bytes)
+    {
+        string encoded(Base64::encodedSize(bytes.size()) + 1, '\0');
+        int length = EVP_EncodeBlock(
+            reinterpret_cast<uint8_t*>(&encoded[0]),
+            bytes.data(),
+            static_cast<int>(bytes.size()));
+        encoded.resize(length);
+
+        return encoded;
+    };
+};
+
+TEST_F(NostrBase64Test, Encode_MatchesRfc4648Vectors)
+{
+    ASSERT_EQ(Base64::encode(""), "");
+    ASSERT_EQ(Base64::encode("f"), "Zg==");
+    ASSERT_EQ(Base64::encode("fo"), "Zm8=");
+    ASSERT_EQ(Base64::encode("foo"), "Zm9v");
+    ASSERT_EQ(Base64::encode("foob"), "Zm9vYg==");
+    ASSERT_EQ(Base64::encode("fooba"), "Zm9vYmE=");
+    ASSERT_EQ(Base64::encode("foobar"), "Zm9vYmFy");
+};
+
+TEST_F(NostrBase64Test, Decode_MatchesRfc4648Vectors)
+{
+    const vector<pair<string, string>> vectors = {
+        { "", "" },
+        { "Zg==", "f" },
+        { "Zm8=", "fo" },
+        { "Zm9v", "foo" },
+        { "Zm9vYg==", "foob" },
+        { "Zm9vYmE=", "fooba" },
+        { "Zm9vYmFy", "foobar" },
+    };
+
+    for (const auto& [encoded, decoded] : vectors)
+    {
+        string output;
+        ASSERT_TRUE(Base64::decode(encoded, output)) << encoded;
+        ASSERT_EQ(output, decoded);
+    }
+};
+
+TEST_F(NostrBase64Test, EncodeAndDecode_MatchOpenSsl_ForRandomInputs)
+{
+    mt19937 rng(0x6e697034);
+
+    // Cover every tail length across the scalar and vector block boundaries, then longer inputs.
+    for (size_t size = 0; size < 600; size += size < 200 ? 1 : 37)
+    {
+        auto bytes = randomBytes(rng, size);
+
+        string encoded;
+        Base64::encode(bytes.data(), bytes.size(), encoded);
+        ASSERT_EQ(encoded, referenceEncode(bytes)) << "size " << size;
+
+        vector<uint8_t> decoded;
+        ASSERT_TRUE(Base64::decode(encoded.data(), encoded.size(), decoded)) << "size " << size;
+        ASSERT_EQ(decoded, bytes) << "size " << size;
+    }
+};
+
+TEST_F(NostrBase64Test, Decode_RejectsMalformedInput)
+{
+    const vector<string> malformed = {
+        "Zg",           // Not a multiple of four characters.
+        "Zm9v\n",       // Whitespace.
+        "Zm9v Zm9v",
+        "Zg==Zm9v",     // Padding before the end.
+        "Z===",         // Too much padding.
+        "====",
+        "Zm=v",
+        "Zh==",         // Non-zero bits discarded by padding.
+        "Zm9=",
+        "Zm9v-_8A",     // The URL-safe alphabet.
+    };
+
+    for (const auto& input : malformed)
+    {
+        string output = "unchanged";
+        ASSERT_FALSE(Base64::decode(input, output)) << input;
+        ASSERT_TRUE(output.empty());
+    }
+};
+
+TEST_F(NostrBase64Test, Decode_RejectsInvalidCharacter_AtEveryPosition)
+{
+    mt19937 rng(7);
+    auto bytes = randomBytes(rng, 150);
+    const string encoded = referenceEncode(bytes);
+
+    // The vector paths validate whole blocks, so an invalid character must be caught wherever it
+    // falls within one.
+    for (char invalid : { '*', '\x80', '\xff', '\0' })
+    {
+        for (size_t i = 0; i < encoded.size(); i++)
+        {
+            string corrupted = encoded;
+            corrupted[i] = invalid;
+
+            vector<uint8_t> decoded;
+            ASSERT_FALSE(Base64::decode(corrupted.data(), corrupted.size(), decoded)) << i;
+        }
+    }
+};
+
+TEST_F(NostrBase64Test, Encoder_MatchesOneShotEncoding_ForAnyChunking)
+{
+    mt19937 rng(11);
+    auto bytes = randomBytes(rng, 257);
+    const string expected = Base64::encode(string(bytes.begin(), bytes.end()));
+
+    for (size_t chunkSize : { 1, 2, 3, 5, 16, 31, 100, 257 })
+    {
+        Base64Encoder encoder;
+        string encoded;
+        for (size_t offset = 0; offset < bytes.size(); offset += chunkSize)
+        {
+            encoder.update(bytes.data() + offset, min(chunkSize, bytes.size() - offset), encoded);
+        }
+        encoder.finish(encoded);
+
+        ASSERT_EQ(encoded, expected) << "chunk size " << chunkSize;
+    }
+};
+
+TEST_F(NostrBase64Test, Decoder_MatchesOneShotDecoding_ForAnyChunking)
+{
+    mt19937 rng(13);
+    auto bytes = randomBytes(rng, 254);
+    const string encoded = referenceEncode(bytes);
+
+    for (size_t chunkSize : { 1, 2, 3, 4, 5, 17, 64, 1000 })
+    {
+        Base64Decoder decoder;
+        vector<uint8_t> decoded;
+        for (size_t offset = 0; offset < encoded.size(); offset += chunkSize)
+        {
+            ASSERT_TRUE(decoder.update(
+                encoded.data() + offset,
+                min(chunkSize, encoded.size() - offset),
+                decoded));
+        }
+        ASSERT_TRUE(decoder.finish(decoded));
+
+        ASSERT_EQ(decoded, bytes) << "chunk size " << chunkSize;
+    }
+};
+
+TEST_F(NostrBase64Test, Decoder_RejectsPaddingBeforeTheEnd)
+{
+    Base64Decoder decoder;
+    vector<uint8_t> decoded;
+
+    decoder.update("Zg==", 4, decoded);
+    ASSERT_FALSE(decoder.update("Zm9v", 4, decoded));
+    ASSERT_FALSE(decoder.finish(decoded));
+
+    // The decoder is reset by `finish`.
+    decoded.clear();
+    ASSERT_TRUE(decoder.update("Zm9vYg==", 8, decoded));
+    ASSERT_TRUE(decoder.finish(decoded));
+    ASSERT_EQ(string(decoded.begin(), decoded.end()), "foob");
+};
+
+TEST_F(NostrBase64Test, Decoder_RejectsTruncatedInput)
+{
+    Base64Decoder decoder;
+    vector<uint8_t> decoded;
+
+    ASSERT_TRUE(decoder.update("Zm9vY", 5, decoded));
+    ASSERT_FALSE(decoder.finish(decoded));
+};
+} // namespace nostr_test
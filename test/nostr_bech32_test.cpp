@@ -213,4 +213,246 @@ TEST_F(Bech32Test, NeventDecoding) {
 
     ASSERT_EQ(false, parsed.data.nevent.has_kind);
 }
+
+TEST_F(Bech32Test, EncodeBytesMatchesNostrEncoder) {
+    NostrBech32 encoder = NostrBech32();
+    NostrBech32Encoding input;
+    input.data.npub.pubkey = "3bf0c63fcb93463407af97a5e5ee64fa883d107ef9e558472c4eb9aaaefa459d";
+    input.type = NOSTR_BECH32_NPUB;
+
+    std::string expectedEncoding;
+    ASSERT_TRUE(encoder.encodeNostrBech32(input, expectedEncoding));
+
+    uint8_t pubkey[KEY_LENGTH];
+    for (int i = 0; i < KEY_LENGTH; i++)
+        pubkey[i] = std::stoi(input.data.npub.pubkey.substr(2 * i, 2), nullptr, 16);
+
+    char encoded[Bech32::encodedLength(4, KEY_LENGTH)];
+    std::size_t length = Bech32::encodeBytes(
+        "npub", 4, pubkey, KEY_LENGTH, BECH32_ENCODING_BECH32, encoded, sizeof(encoded));
+
+    ASSERT_EQ(sizeof(encoded), length);
+    ASSERT_EQ(expectedEncoding, std::string(encoded, length));
+
+    // An output buffer one byte too short is rejected rather than overrun.
+    ASSERT_EQ(0, Bech32::encodeBytes(
+        "npub", 4, pubkey, KEY_LENGTH, BECH32_ENCODING_BECH32, encoded, sizeof(encoded) - 1));
+}
+
+TEST_F(Bech32Test, DecodeBytesReferenceVectors) {
+    struct Vector
+    {
+        std::string encoding;
+        Bech32EncodingType enc;
+        std::size_t hrpLength;
+        std::string payloadHex;
+    };
+
+    // Valid strings from BIP-173 and BIP-350.
+    std::vector<Vector> vectors = {
+        { "A12UEL5L", BECH32_ENCODING_BECH32, 1, "" },
+        { "a12uel5l", BECH32_ENCODING_BECH32, 1, "" },
+        { "an83characterlonghumanreadablepartthatcontainsthenumber1andtheexcludedcharactersbio1tt5tgs", BECH32_ENCODING_BECH32, 83, "" },
+        { "abcdef1qpzry9x8gf2tvdw0s3jn54khce6mua7lmqqqxw", BECH32_ENCODING_BECH32, 6, "00443214c74254b635cf84653a56d7c675be77df" },
+        { "A1LQFN3A", BECH32_ENCODING_BECH32M, 1, "" },
+        { "abcdef1l7aum6echk45nj3s0wdvt2fg8x9yrzpqzd3ryx", BECH32_ENCODING_BECH32M, 6, "ffbbcdeb38bdab49ca307b9ac5a928398a418820" },
+    };
+
+    for (const auto &vector : vectors)
+    {
+        uint8_t payload[64];
+        std::size_t hrpLength, payloadLength;
+        Bech32EncodingType enc = Bech32::decodeBytes(
+            vector.encoding.data(), vector.encoding.size(), hrpLength, payload, sizeof(payload), payloadLength);
+
+        ASSERT_EQ(vector.enc, enc) << vector.encoding;
+        ASSERT_EQ(vector.hrpLength, hrpLength) << vector.encoding;
+
+        std::string payloadHex;
+        char digits[3];
+        for (std::size_t i = 0; i < payloadLength; i++)
+        {
+            snprintf(digits, sizeof(digits), "%02x", payload[i]);
+            payloadHex += digits;
+        }
+        ASSERT_EQ(vector.payloadHex, payloadHex) << vector.encoding;
+    }
+}
+
+TEST_F(Bech32Test, DecodeBytesRejectsInvalidStrings) {
+    std::vector<std::string> invalid = {
+        "x1b4n0q5v",        // invalid data character
+        "li1dgmt3",         // checksum too short
+        "A1G7SGD8",         // checksum calculated with an uppercase human readable part
+        "10a06t8",          // empty human readable part
+        "a12UEL5L",         // mixed case
+        "abcdef1qpzry9x8gf2tvdw0s3jn54khce6mua7lmqqqxx", // bad checksum
+        "npub180cvv07tjdrrgpa0j7j7tmnyl2yr6yr7l8j4s3evf6u64th6gkwsyjh6w\xff",
+    };
+
+    for (const auto &encoding : invalid)
+    {
+        uint8_t payload[64];
+        std::size_t hrpLength, payloadLength;
+        ASSERT_EQ(BECH32_ENCODING_NONE, Bech32::decodeBytes(
+            encoding.data(), encoding.size(), hrpLength, payload, sizeof(payload), payloadLength)) << encoding;
+    }
+
+    // A valid string whose payload does not fit in the output buffer.
+    std::string npub = "npub180cvv07tjdrrgpa0j7j7tmnyl2yr6yr7l8j4s3evf6u64th6gkwsyjh6w6";
+    uint8_t payload[KEY_LENGTH - 1];
+    std::size_t hrpLength, payloadLength;
+    ASSERT_EQ(BECH32_ENCODING_NONE, Bech32::decodeBytes(
+        npub.data(), npub.size(), hrpLength, payload, sizeof(payload), payloadLength));
+}
+
+TEST_F(Bech32Test, BatchRoundTrip) {
+    std::vector<std::string> pubkeys = {
+        "3bf0c63fcb93463407af97a5e5ee64fa883d107ef9e558472c4eb9aaaefa459d",
+        "0689df5847a8d3376892da29622d7c0fdc1ef1958f4bc4471d90966aa1eca9f2",
+        "not a hex key",
+        "c6047f9441ed7d6d3045406e95c07cd85c778e4b8cef3ca7abac09b95c709ee5",
+    };
+
+    std::vector<std::string> npubs = Bech32::encodeBatch("npub", pubkeys);
+    ASSERT_EQ(pubkeys.size(), npubs.size());
+    ASSERT_EQ("npub180cvv07tjdrrgpa0j7j7tmnyl2yr6yr7l8j4s3evf6u64th6gkwsyjh6w6", npubs[0]);
+    ASSERT_TRUE(npubs[2].empty());
+
+    NostrBech32 decoder = NostrBech32();
+    for (std::size_t i : { 0, 1, 3 })
+    {
+        NostrBech32Encoding parsed;
+        ASSERT_TRUE(decoder.parseNostrBech32(npubs[i], parsed));
+        ASSERT_EQ(pubkeys[i], parsed.data.npub.pubkey);
+    }
+
+    // Uppercase strings decode; strings with another prefix or a bad checksum do not.
+    std::string uppercase = npubs[1];
+    for (char &c : uppercase)
+        c = std::toupper(c);
+    std::string corrupted = npubs[3];
+    corrupted[10] = corrupted[10] == 'q' ? 'p' : 'q';
+
+    std::vector<std::string> decoded = Bech32::decodeBatch(
+        "npub",
+        { npubs[0], uppercase, "note10nrucl4e5yqjq7ddau4ua9gq3jpq7a795y4udmg6ytkkmduamz7semt62g", corrupted });
+    ASSERT_EQ(4, decoded.size());
+    ASSERT_EQ(pubkeys[0], decoded[0]);
+    ASSERT_EQ(pubkeys[1], decoded[1]);
+    ASSERT_TRUE(decoded[2].empty());
+    ASSERT_TRUE(decoded[3].empty());
+}
+
+static std::vector<uint8_t> hexToBytes(const std::string &hex)
+{
+    std::vector<uint8_t> bytes;
+    for (std::size_t i = 0; i + 1 < hex.size(); i += 2)
+        bytes.push_back(std::stoi(hex.substr(i, 2), nullptr, 16));
+    return bytes;
+}
+
+TEST_F(Bech32Test, EntityNeventRoundTrip) {
+    std::string encoding = "nevent1qqsx5u4fcsjyw3d3lz7ejfc2z5nvjpwaj90kkyrpqcvx8a9656ctwyqpzamhxue69uhhyetvv9ujumn0wd68ytnzv9hxgtczyqrgnh6cg75dxdmgjtdzjc3d0s8ac8h3jk85h3z8rkgfv64paj5lyznxtln";
+    auto expected_id = hexToBytes("6a72a9c4244745b1f8bd99270a1526c905dd915f6b1061061863f4baa6b0b710");
+    auto expected_pubkey = hexToBytes("0689df5847a8d3376892da29622d7c0fdc1ef1958f4bc4471d90966aa1eca9f2");
+
+    NostrBech32Entity parsed;
+    ASSERT_TRUE(NostrBech32::parseEntity(encoding.data(), encoding.size(), parsed));
+
+    ASSERT_EQ(NOSTR_BECH32_NEVENT, parsed.type());
+    ASSERT_EQ(KEY_LENGTH, parsed.specialLength());
+    ASSERT_EQ(expected_id, std::vector<uint8_t>(parsed.special(), parsed.special() + KEY_LENGTH));
+    ASSERT_TRUE(parsed.hasAuthor());
+    ASSERT_EQ(expected_pubkey, std::vector<uint8_t>(parsed.author(), parsed.author() + KEY_LENGTH));
+    ASSERT_FALSE(parsed.hasKind());
+    ASSERT_EQ(1, parsed.relayCount());
+    ASSERT_EQ("wss://relay.nostr.band/", parsed.relay(0));
+
+    char reencoded[NostrBech32Entity::maxEncodedLength];
+    std::size_t length = NostrBech32::encodeEntity(parsed, reencoded, sizeof(reencoded));
+    ASSERT_EQ(encoding, std::string(reencoded, length));
+}
+
+TEST_F(Bech32Test, EntityNaddrMatchesNostrEncoder) {
+    auto pubkey = hexToBytes("75656740209960c74fe373e6943f8a21ab896889d8691276a60f86aadbc8f92a");
+
+    NostrBech32Entity input(NOSTR_BECH32_NADDR);
+    ASSERT_TRUE(input.setIdentifier("1737430513300"));
+    ASSERT_TRUE(input.addRelay("wss://relay.nostr.band/"));
+    ASSERT_TRUE(input.setAuthor(pubkey.data()));
+    input.setKind(30023);
+
+    std::string expectedEncoding = "naddr1qqxnzdenxu6rxvp4xyenxvpsqythwumn8ghj7un9d3shjtnwdaehgu3wvfskuep0qgs82et8gqsfjcx8fl3h8e55879zr2ufdzyas6gjw6nqlp42m0y0j2srqsqqqa285r8tkj";
+    char encoded[NostrBech32Entity::maxEncodedLength];
+    std::size_t length = NostrBech32::encodeEntity(input, encoded, sizeof(encoded));
+    ASSERT_EQ(expectedEncoding, std::string(encoded, length));
+
+    NostrBech32Entity parsed;
+    ASSERT_TRUE(NostrBech32::parseEntity(encoded, length, parsed));
+    ASSERT_EQ(NOSTR_BECH32_NADDR, parsed.type());
+    ASSERT_EQ("1737430513300", parsed.identifier());
+    ASSERT_EQ(pubkey, std::vector<uint8_t>(parsed.author(), parsed.author() + KEY_LENGTH));
+    ASSERT_EQ(30023, parsed.kind());
+    ASSERT_EQ(1, parsed.relayCount());
+    ASSERT_EQ("wss://relay.nostr.band/", parsed.relay(0));
+
+    // An naddr without a kind is incomplete.
+    NostrBech32Entity incomplete(NOSTR_BECH32_NADDR);
+    incomplete.setIdentifier("1737430513300");
+    incomplete.setAuthor(pubkey.data());
+    ASSERT_EQ(0, NostrBech32::encodeEntity(incomplete, encoded, sizeof(encoded)));
+}
+
+TEST_F(Bech32Test, EntitySkipsUnknownTlvsAndRejectsTruncatedOnes) {
+    auto pubkey = hexToBytes("3bf0c63fcb93463407af97a5e5ee64fa883d107ef9e558472c4eb9aaaefa459d");
+
+    std::vector<uint8_t> stream = { TLV_SPECIAL, KEY_LENGTH };
+    stream.insert(stream.end(), pubkey.begin(), pubkey.end());
+    stream.insert(stream.end(), { 9, 2, 0xAB, 0xCD });
+    stream.insert(stream.end(), { TLV_RELAY, 3, 'w', 's', 's' });
+
+    char encoded[NostrBech32Entity::maxEncodedLength];
+    std::size_t length = Bech32::encodeBytes(
+        "nprofile", 8, stream.data(), stream.size(), BECH32_ENCODING_BECH32, encoded, sizeof(encoded));
+    ASSERT_NE(0, length);
+
+    NostrBech32Entity parsed;
+    ASSERT_TRUE(NostrBech32::parseEntity(encoded, length, parsed));
+    ASSERT_EQ(NOSTR_BECH32_NPROFILE, parsed.type());
+    ASSERT_EQ(pubkey, std::vector<uint8_t>(parsed.special(), parsed.special() + KEY_LENGTH));
+    ASSERT_EQ(1, parsed.relayCount());
+    ASSERT_EQ("wss", parsed.relay(0));
+
+    // A relay TLV that claims more bytes than remain.
+    stream[stream.size() - 4] = 10;
+    length = Bech32::encodeBytes(
+        "nprofile", 8, stream.data(), stream.size(), BECH32_ENCODING_BECH32, encoded, sizeof(encoded));
+    ASSERT_FALSE(NostrBech32::parseEntity(encoded, length, parsed));
+
+    // An unknown prefix.
+    length = Bech32::encodeBytes(
+        "nfoo", 4, pubkey.data(), pubkey.size(), BECH32_ENCODING_BECH32, encoded, sizeof(encoded));
+    ASSERT_FALSE(NostrBech32::parseEntity(encoded, length, parsed));
+}
+
+TEST_F(Bech32Test, EntityEnforcesCapacity) {
+    NostrBech32Entity entity(NOSTR_BECH32_NPROFILE);
+    uint8_t pubkey[KEY_LENGTH] = { 0 };
+    ASSERT_TRUE(entity.setSpecial(pubkey, sizeof(pubkey)));
+    ASSERT_FALSE(entity.setSpecial(pubkey, sizeof(pubkey)));
+
+    for (int i = 0; i < MAX_RELAYS; i++)
+        ASSERT_TRUE(entity.addRelay("wss://relay.example.com"));
+    ASSERT_FALSE(entity.addRelay("wss://relay.example.com"));
+    ASSERT_EQ(MAX_RELAYS, entity.relayCount());
+
+    ASSERT_FALSE(entity.addRelay(std::string(256, 'a')));
+
+    // The encoding does not fit in a buffer one byte short.
+    char encoded[NostrBech32Entity::maxEncodedLength];
+    std::size_t length = NostrBech32::encodeEntity(entity, encoded, sizeof(encoded));
+    ASSERT_NE(0, length);
+    ASSERT_EQ(0, NostrBech32::encodeEntity(entity, encoded, length - 1));
+}
 }
\ No newline at end of file
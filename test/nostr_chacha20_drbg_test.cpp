@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include <openssl/evp.h>
+
+#include "cryptography/chacha20_drbg.hpp"
+#include "cryptography/nostr_secure_rng.hpp"
+
+using namespace nostr::cryptography;
+using namespace std;
+using namespace ::testing;
+
+namespace nostr
+{
+namespace cryptography
+{
+/**
+ * @brief Reaches into a `ChaCha20Drbg` to observe its key and buffer.
+ */
+class ChaCha20DrbgProbe
+{
+public:
+    static vector<uint8_t> key(const ChaCha20Drbg& drbg)
+    {
+        return vector<uint8_t>(drbg._key, drbg._key + sizeof(drbg._key));
+    };
+
+    static size_t servedSinceReseed(const ChaCha20Drbg& drbg)
+    {
+        return drbg._servedSinceReseed;
+    };
+
+    static bool isSeeded(const ChaCha20Drbg& drbg)
+    {
+        return drbg._isSeeded;
+    };
+
+    /**
+     * @brief Returns whether every byte of the buffer before the read position is zero, which
+     * covers both served output and the copy of the current key.
+     */
+    static bool isConsumedBufferWiped(const ChaCha20Drbg& drbg)
+    {
+        return all_of(drbg._buffer, drbg._buffer + drbg._position, [](uint8_t byte) { return byte == 0; });
+    };
+
+    static size_t unservedSize(const ChaCha20Drbg& drbg)
+    {
+        return ChaCha20Drbg::bufferSize - drbg._position;
+    };
+
+    /**
+     * @brief Makes every later reseed and refill of the generator fail.
+     */
+    static void breakCipher(ChaCha20Drbg& drbg)
+    {
+        EVP_CIPHER_CTX_free(drbg._cipherContext);
+        drbg._cipherContext = nullptr;
+        drbg._isSeeded = false;
+    };
+
+    static ChaCha20Drbg* threadDrbg()
+    {
+        return NostrSecureRng::_threadDrbg(false);
+    };
+};
+} // namespace cryptography
+} // namespace nostr
+
+namespace nostr_test
+{
+class NostrChaCha20DrbgTest : public testing::Test
+{
+public:
+    /**
+     * @brief Computes the keystream a refill produces under the given key.
+     */
+    static vector<uint8_t> keystream(const vector<uint8_t>& key)
+    {
+        const uint8_t zeroIv[16] = { 0 };
+        vector<uint8_t> output(ChaCha20Drbg::bufferSize, 0);
+        int outputLength = 0;
+
+        EVP_CIPHER_CTX* context = EVP_CIPHER_CTX_new();
+        EVP_EncryptInit_ex(context, EVP_chacha20(), nullptr, key.data(), zeroIv);
+        EVP_EncryptUpdate(context, output.data(), &outputLength, output.data(), static_cast<int>(output.size()));
+        EVP_CIPHER_CTX_free(context);
+
+        return output;
+    };
+};
+
+TEST_F(NostrChaCha20DrbgTest, Generate_ErasesKeyAndServedBytes)
+{
+    ChaCha20Drbg drbg;
+    uint8_t output[100];
+    ASSERT_TRUE(drbg.generate(output, 1));
+    ASSERT_TRUE(ChaCha20DrbgProbe::isConsumedBufferWiped(drbg));
+
+    // Drain the buffer, so the next call refills it under the current key.
+    vector<uint8_t> drained(ChaCha20DrbgProbe::unservedSize(drbg));
+    ASSERT_TRUE(drbg.generate(drained.data(), drained.size()));
+    ASSERT_TRUE(ChaCha20DrbgProbe::isConsumedBufferWiped(drbg));
+    vector<uint8_t> oldKey = ChaCha20DrbgProbe::key(drbg);
+
+    ASSERT_TRUE(drbg.generate(output, sizeof(output)));
+
+    // The output comes from the old key's keystream, after the 32 bytes that became the new key.
+    vector<uint8_t> expected = keystream(oldKey);
+    ASSERT_TRUE(equal(output, output + sizeof(output), expected.begin() + 32));
+    ASSERT_EQ(ChaCha20DrbgProbe::key(drbg), vector<uint8_t>(expected.begin(), expected.begin() + 32));
+    ASSERT_NE(ChaCha20DrbgProbe::key(drbg), oldKey);
+    ASSERT_TRUE(ChaCha20DrbgProbe::isConsumedBufferWiped(drbg));
+};
+
+TEST_F(NostrChaCha20DrbgTest, Generate_Reseeds_AfterReseedInterval)
+{
+    ChaCha20Drbg drbg;
+    vector<uint8_t> chunk(64 * 1024);
+    for (size_t served = 0; served < ChaCha20Drbg::reseedInterval; served += chunk.size())
+    {
+        ASSERT_TRUE(drbg.generate(chunk.data(), chunk.size()));
+    }
+    ASSERT_EQ(ChaCha20DrbgProbe::servedSinceReseed(drbg), ChaCha20Drbg::reseedInterval);
+
+    // Without a reseed, the next refill would run under the current key.
+    vector<uint8_t> unreseeded = keystream(ChaCha20DrbgProbe::key(drbg));
+
+    uint8_t output[32];
+    ASSERT_TRUE(drbg.generate(output, sizeof(output)));
+    ASSERT_EQ(ChaCha20DrbgProbe::servedSinceReseed(drbg), sizeof(output));
+    ASSERT_FALSE(equal(output, output + sizeof(output), unreseeded.begin() + 32));
+};
+
+TEST_F(NostrChaCha20DrbgTest, Reseed_DiscardsBufferedOutput)
+{
+    ChaCha20Drbg drbg;
+    uint8_t output[16];
+    ASSERT_TRUE(drbg.generate(output, sizeof(output)));
+    vector<uint8_t> key = ChaCha20DrbgProbe::key(drbg);
+
+    ASSERT_TRUE(drbg.reseed());
+    ASSERT_EQ(ChaCha20DrbgProbe::unservedSize(drbg), 0);
+    ASSERT_EQ(ChaCha20DrbgProbe::servedSinceReseed(drbg), 0);
+    ASSERT_NE(ChaCha20DrbgProbe::key(drbg), key);
+};
+
+TEST_F(NostrChaCha20DrbgTest, Generate_Diverges_InForkedChild)
+{
+    ChaCha20Drbg drbg;
+    uint8_t output[32];
+    ASSERT_TRUE(drbg.generate(output, sizeof(output)));
+
+    int pipeFds[2];
+    ASSERT_EQ(pipe(pipeFds), 0);
+
+    // Parent and child share the generator's state, so they would serve the same bytes if the
+    // child did not notice the fork and reseed.
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0)
+    {
+        uint8_t childOutput[32] = { 0 };
+        bool isGenerated = drbg.generate(childOutput, sizeof(childOutput));
+        ssize_t written = write(pipeFds[1], childOutput, sizeof(childOutput));
+        _exit(isGenerated && written == sizeof(childOutput) ? 0 : 1);
+    }
+
+    close(pipeFds[1]);
+    uint8_t parentOutput[32];
+    ASSERT_TRUE(drbg.generate(parentOutput, sizeof(parentOutput)));
+
+    uint8_t childOutput[32];
+    ASSERT_EQ(read(pipeFds[0], childOutput, sizeof(childOutput)), sizeof(childOutput));
+    close(pipeFds[0]);
+
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+
+    ASSERT_NE(memcmp(parentOutput, childOutput, sizeof(parentOutput)), 0);
+};
+
+TEST_F(NostrChaCha20DrbgTest, SecureRngFill_UsesThreadGenerator_WhenBuffered)
+{
+    bool wasBuffered = NostrSecureRng::isBuffered();
+    NostrSecureRng::setBuffered(true);
+
+    // A fresh thread, so the generator starts unused and dies with the thread.
+    thread([]()
+    {
+        uint8_t output[48];
+        NostrSecureRng::fill(output, sizeof(output));
+
+        ChaCha20Drbg* drbg = ChaCha20DrbgProbe::threadDrbg();
+        ASSERT_NE(drbg, nullptr);
+        ASSERT_EQ(ChaCha20DrbgProbe::servedSinceReseed(*drbg), sizeof(output));
+    }).join();
+
+    NostrSecureRng::setBuffered(wasBuffered);
+};
+
+TEST_F(NostrChaCha20DrbgTest, SecureRngFill_FallsBackToSystemSource_WhenGeneratorFails)
+{
+    bool wasBuffered = NostrSecureRng::isBuffered();
+    NostrSecureRng::setBuffered(true);
+
+    thread([]()
+    {
+        uint8_t output[64];
+        NostrSecureRng::fill(output, 1);
+        ChaCha20Drbg* drbg = ChaCha20DrbgProbe::threadDrbg();
+        ASSERT_NE(drbg, nullptr);
+        ChaCha20DrbgProbe::breakCipher(*drbg);
+
+        memset(output, 0, sizeof(output));
+        NostrSecureRng::fill(output, sizeof(output));
+
+        ASSERT_FALSE(ChaCha20DrbgProbe::isSeeded(*drbg));
+        ASSERT_TRUE(any_of(output, output + sizeof(output), [](uint8_t byte) { return byte != 0; }));
+    }).join();
+
+    NostrSecureRng::setBuffered(wasBuffered);
+};
+} // namespace nostr_test
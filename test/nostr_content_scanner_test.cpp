@@ -0,0 +1,151 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "cryptography/nostr_content_scanner.hpp"
+
+using namespace nostr::encoding;
+using namespace std;
+using namespace ::testing;
+
+namespace nostr_test
+{
+class NostrContentScannerTest : public testing::Test
+{
+public:
+    static inline const string npub =
+        "npub180cvv07tjdrrgpa0j7j7tmnyl2yr6yr7l8j4s3evf6u64th6gkwsyjh6w6";
+    static inline const string npubHex =
+        "3bf0c63fcb93463407af97a5e5ee64fa883d107ef9e558472c4eb9aaaefa459d";
+
+    static inline const string note =
+        "note10nrucl4e5yqjq7ddau4ua9gq3jpq7a795y4udmg6ytkkmduamz7semt62g";
+    static inline const string noteHex =
+        "7cc7cc7eb9a1012079adef2bce95008c820f77c5a12bc6ed1a22ed6db79dd8bd";
+
+    static inline const string nevent =
+        "nevent1qqsx5u4fcsjyw3d3lz7ejfc2z5nvjpwaj90kkyrpqcvx8a9656ctwyqpzamhxue69uhhyetvv9ujumn0wd68ytnzv9hxgtczyqrgnh6cg75dxdmgjtdzjc3d0s8ac8h3jk85h3z8rkgfv64paj5lyznxtln";
+    static inline const string neventHex =
+        "6a72a9c4244745b1f8bd99270a1526c905dd915f6b1061061863f4baa6b0b710";
+
+    static inline const string naddr =
+        "naddr1qqxnzdenxu6rxvp4xyenxvpsqythwumn8ghj7un9d3shjtnwdaehgu3wvfskuep0qgs82et8gqsfjcx8fl3h8e55879zr2ufdzyas6gjw6nqlp42m0y0j2srqsqqqa285r8tkj";
+    static inline const string naddrAuthorHex =
+        "75656740209960c74fe373e6943f8a21ab896889d8691276a60f86aadbc8f92a";
+};
+
+TEST_F(NostrContentScannerTest, Scan_FindsAllReferenceTypes)
+{
+    string content = "GM nostr:" + npub + ", have you read nostr:" + nevent
+        + "? It quotes nostr:" + note + "\nand links nostr:" + naddr + ".";
+
+    vector<NostrContentReference> references;
+    ASSERT_EQ(NostrContentScanner::scan(content, references), 4);
+    ASSERT_EQ(references.size(), 4);
+
+    EXPECT_EQ(references[0].type, NOSTR_BECH32_NPUB);
+    EXPECT_EQ(references[0].uri, "nostr:" + npub);
+    EXPECT_EQ(references[0].encoding, npub);
+    EXPECT_EQ(references[0].hexId(), npubHex);
+
+    EXPECT_EQ(references[1].type, NOSTR_BECH32_NEVENT);
+    EXPECT_EQ(references[1].encoding, nevent);
+    EXPECT_EQ(references[1].hexId(), neventHex);
+    EXPECT_FALSE(references[1].hasKind);
+
+    EXPECT_EQ(references[2].type, NOSTR_BECH32_NOTE);
+    EXPECT_EQ(references[2].hexId(), noteHex);
+
+    EXPECT_EQ(references[3].type, NOSTR_BECH32_NADDR);
+    EXPECT_EQ(references[3].encoding, naddr);
+    EXPECT_EQ(references[3].hexId(), naddrAuthorHex);
+    EXPECT_TRUE(references[3].hasKind);
+    EXPECT_EQ(references[3].kind, 30023);
+
+    // The views point into the scanned content rather than copies of it.
+    EXPECT_EQ(references[0].uri.data(), content.data() + 3);
+};
+
+TEST_F(NostrContentScannerTest, Scan_SkipsInvalidAndSecretReferences)
+{
+    string corrupted = npub;
+    corrupted[20] = corrupted[20] == 'q' ? 'p' : 'q';
+
+    string content = "nostr:" + corrupted + " nostr:nsec1vl029mgpspedva04g90vltkh6fvh240zqtv9k0t9af8935ke9laqsnlfe5"
+        + " nostr:nrelay1qqqqqq nostr: nostr:npub1 " + npub + " nostr:" + note;
+
+    vector<NostrContentReference> references;
+    ASSERT_EQ(NostrContentScanner::scan(content, references), 1);
+    EXPECT_EQ(references[0].type, NOSTR_BECH32_NOTE);
+    EXPECT_EQ(references[0].hexId(), noteHex);
+};
+
+TEST_F(NostrContentScannerTest, Scan_FindsReferencesAtEveryAlignment)
+{
+    // Shift the reference across SIMD block boundaries, and end the content right after it.
+    for (size_t padding = 0; padding < 40; padding++)
+    {
+        string content = string(padding, 'n') + "nostr:" + note;
+
+        vector<NostrContentReference> references;
+        ASSERT_EQ(NostrContentScanner::scan(content, references), 1) << "padding " << padding;
+        EXPECT_EQ(references[0].uri.data() - content.data(), padding);
+        EXPECT_EQ(references[0].hexId(), noteHex);
+    }
+};
+
+TEST_F(NostrContentScannerTest, Scan_AppendsAcrossNotes)
+{
+    vector<NostrContentReference> references;
+    NostrContentScanner::scan("nothing to see here", references);
+    NostrContentScanner::scan("cc nostr:" + npub, references);
+    NostrContentScanner::scan("nostr:" + note + " and nostr:" + npub, references);
+
+    ASSERT_EQ(references.size(), 3);
+    EXPECT_EQ(references[0].type, NOSTR_BECH32_NPUB);
+    EXPECT_EQ(references[1].type, NOSTR_BECH32_NOTE);
+    EXPECT_EQ(references[2].type, NOSTR_BECH32_NPUB);
+};
+
+TEST_F(NostrContentScannerTest, Scan_VisitorReceivesDecodedEntity)
+{
+    string content = "Read this: nostr:" + naddr;
+
+    vector<string> identifiers;
+    vector<string> relays;
+    size_t count = NostrContentScanner::scan(content,
+        [&](const NostrContentReference& reference, const NostrBech32Entity& entity)
+        {
+            identifiers.emplace_back(entity.identifier());
+            for (size_t i = 0; i < entity.relayCount(); i++)
+            {
+                relays.emplace_back(entity.relay(i));
+            }
+        });
+
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(identifiers.size(), 1);
+    EXPECT_EQ(identifiers[0], "1737430513300");
+    ASSERT_EQ(relays.size(), 1);
+    EXPECT_EQ(relays[0], "wss://relay.nostr.band/");
+};
+
+TEST_F(NostrContentScannerTest, FindScheme_MatchesNaiveSearch)
+{
+    string content = "no nostr here, nostr:, nostr nostr:x nnostr: nostr:" + string(50, ' ') + "nostr:";
+
+    size_t position = 0;
+    while (true)
+    {
+        size_t expected = content.find("nostr:", position);
+        size_t actual = NostrContentScanner::findScheme(content, position);
+        ASSERT_EQ(actual, expected);
+        if (actual == string::npos)
+        {
+            break;
+        }
+        position = actual + 1;
+    }
+};
+} // namespace nostr_test
@@ -0,0 +1,65 @@
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "cryptography/noscrypt_context_pool.hpp"
+
+using namespace nostr::cryptography;
+using namespace std;
+using namespace ::testing;
+
+namespace nostr_test
+{
+TEST(NostrContextPoolTest, Local_ReturnsSameContext_OnSameThread)
+{
+    const NCContext* first = NoscryptContextPool::local();
+    const NCContext* second = NoscryptContextPool::local();
+
+    ASSERT_NE(first, nullptr);
+    ASSERT_EQ(first, second);
+};
+
+TEST(NostrContextPoolTest, Local_ReturnsDistinctContexts_AcrossThreads)
+{
+    const NCContext* mainContext = NoscryptContextPool::local();
+    const NCContext* workerContext = nullptr;
+
+    thread worker([&workerContext]() { workerContext = NoscryptContextPool::local(); });
+    worker.join();
+
+    ASSERT_NE(workerContext, nullptr);
+    ASSERT_NE(workerContext, mainContext);
+};
+
+TEST(NostrContextPoolTest, Local_DestroysContext_WhenThreadExits)
+{
+    NoscryptContextPool::local();
+    size_t liveCount = NoscryptContextPool::liveCount();
+    size_t workerLiveCount = 0;
+
+    thread worker([&workerLiveCount]()
+    {
+        NoscryptContextPool::local();
+        workerLiveCount = NoscryptContextPool::liveCount();
+    });
+    worker.join();
+
+    ASSERT_EQ(workerLiveCount, liveCount + 1);
+    ASSERT_EQ(NoscryptContextPool::liveCount(), liveCount);
+};
+
+TEST(NostrContextPoolTest, Create_ReturnsContextOwnedByCaller)
+{
+    NoscryptContextPool::local();
+    size_t liveCount = NoscryptContextPool::liveCount();
+
+    {
+        auto context = NoscryptContextPool::create();
+        ASSERT_NE(context, nullptr);
+        ASSERT_NE(context.get(), NoscryptContextPool::local());
+        ASSERT_EQ(NoscryptContextPool::liveCount(), liveCount + 1);
+    }
+
+    ASSERT_EQ(NoscryptContextPool::liveCount(), liveCount);
+};
+} // namespace nostr_test
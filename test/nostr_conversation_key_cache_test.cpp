@@ -0,0 +1,207 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "cryptography/conversation_key_cache.hpp"
+#include "cryptography/noscrypt_context_pool.hpp"
+#include "internal/hex_encoding.hpp"
+
+using namespace nostr::cryptography;
+using namespace nostr::internal;
+using namespace std;
+using namespace ::testing;
+
+namespace nostr
+{
+namespace cryptography
+{
+/**
+ * @brief Reaches into a `ConversationKeyCache` to observe what happens to evicted keys.
+ */
+class ConversationKeyCacheProbe
+{
+public:
+    static void evictOldest(ConversationKeyCache& cache)
+    {
+        lock_guard<mutex> lock(cache._entryMutex);
+        cache._evictOldest();
+    };
+
+    static size_t size(ConversationKeyCache& cache)
+    {
+        lock_guard<mutex> lock(cache._entryMutex);
+        return cache._entries.size();
+    };
+
+    /**
+     * @brief Returns the key storage of the most recently used entry.
+     */
+    static const uint8_t* newestKey(ConversationKeyCache& cache)
+    {
+        lock_guard<mutex> lock(cache._entryMutex);
+        return cache._entries.front().conversationKey;
+    };
+
+    /**
+     * @brief Returns the key storage of the last evicted entry, or null if it has been reused.
+     */
+    static const uint8_t* evictedKey(ConversationKeyCache& cache)
+    {
+        lock_guard<mutex> lock(cache._entryMutex);
+        return cache._spare.empty() ? nullptr : cache._spare.front().conversationKey;
+    };
+};
+} // namespace cryptography
+} // namespace nostr
+
+namespace nostr_test
+{
+class NostrConversationKeyCacheTest : public testing::Test
+{
+public:
+    // The public keys of the secret keys 0x01 through 0x04.
+    inline static const vector<string> peerPublicKeys = {
+        "79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798",
+        "c6047f9441ed7d6d3045406e95c07cd85c778e4b8cef3ca7abac09b95c709ee5",
+        "f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9",
+        "e493dbf1c10d80f3581e4904930b1404cc6c13900ee0758474fa94abe8c4cd13"
+    };
+
+    NCSecretKey localKey;
+    vector<NCPublicKey> peers;
+
+    void SetUp() override
+    {
+        memset(localKey.key, 0, sizeof(localKey.key));
+        localKey.key[31] = 5;
+
+        for (const string& hex : peerPublicKeys)
+        {
+            NCPublicKey peer;
+            ASSERT_TRUE(decodeHex(hex, peer.key, sizeof(peer.key)));
+            peers.push_back(peer);
+        }
+    };
+
+    string lookUp(ConversationKeyCache& cache, size_t peer)
+    {
+        uint8_t key[NC_CONV_KEY_SIZE];
+        EXPECT_TRUE(cache.get(NoscryptContextPool::local(), localKey, peers[peer], key));
+        return encodeHex(key, sizeof(key));
+    };
+
+    string derive(size_t peer)
+    {
+        uint8_t key[NC_CONV_KEY_SIZE];
+        EXPECT_EQ(NCGetConversationKey(NoscryptContextPool::local(), &localKey, &peers[peer], key), NC_SUCCESS);
+        return encodeHex(key, sizeof(key));
+    };
+};
+
+TEST_F(NostrConversationKeyCacheTest, Get_DerivesOnMiss_AndReusesOnHit)
+{
+    ConversationKeyCache cache(4);
+
+    ASSERT_EQ(lookUp(cache, 0), derive(0));
+    ASSERT_EQ(cache.misses(), 1);
+    ASSERT_EQ(cache.hits(), 0);
+
+    ASSERT_EQ(lookUp(cache, 0), derive(0));
+    ASSERT_EQ(cache.misses(), 1);
+    ASSERT_EQ(cache.hits(), 1);
+
+    ASSERT_EQ(lookUp(cache, 1), derive(1));
+    ASSERT_EQ(cache.misses(), 2);
+};
+
+TEST_F(NostrConversationKeyCacheTest, Get_KeysEntriesByLocalKeyAsWellAsPeer)
+{
+    ConversationKeyCache cache(4);
+    lookUp(cache, 0);
+
+    NCSecretKey otherLocalKey;
+    memset(otherLocalKey.key, 0, sizeof(otherLocalKey.key));
+    otherLocalKey.key[31] = 6;
+
+    uint8_t key[NC_CONV_KEY_SIZE];
+    ASSERT_TRUE(cache.get(NoscryptContextPool::local(), otherLocalKey, peers[0], key));
+    ASSERT_EQ(cache.misses(), 2);
+    ASSERT_NE(encodeHex(key, sizeof(key)), derive(0));
+};
+
+TEST_F(NostrConversationKeyCacheTest, Get_EvictsLeastRecentlyUsed)
+{
+    ConversationKeyCache cache(3);
+    lookUp(cache, 0);
+    lookUp(cache, 1);
+    lookUp(cache, 2);
+
+    // Touch the oldest entry, so that peer 1 becomes the least recently used.
+    lookUp(cache, 0);
+    lookUp(cache, 3);
+    ASSERT_EQ(nostr::cryptography::ConversationKeyCacheProbe::size(cache), 3);
+    uint64_t misses = cache.misses();
+
+    lookUp(cache, 0);
+    lookUp(cache, 2);
+    lookUp(cache, 3);
+    ASSERT_EQ(cache.misses(), misses);
+
+    lookUp(cache, 1);
+    ASSERT_EQ(cache.misses(), misses + 1);
+};
+
+TEST_F(NostrConversationKeyCacheTest, Evict_ZeroesTheEvictedKey)
+{
+    ConversationKeyCache cache(2);
+    lookUp(cache, 0);
+    lookUp(cache, 1);
+    lookUp(cache, 0);
+
+    // Peer 1 is now the oldest entry.
+    nostr::cryptography::ConversationKeyCacheProbe::evictOldest(cache);
+
+    const uint8_t* evictedKey = nostr::cryptography::ConversationKeyCacheProbe::evictedKey(cache);
+    ASSERT_NE(evictedKey, nullptr);
+    const uint8_t zeroKey[NC_CONV_KEY_SIZE] = { 0 };
+    ASSERT_EQ(memcmp(evictedKey, zeroKey, sizeof(zeroKey)), 0);
+
+    // The evicted node is reused for the next entry, which holds its own key.
+    lookUp(cache, 2);
+    ASSERT_EQ(nostr::cryptography::ConversationKeyCacheProbe::evictedKey(cache), nullptr);
+    ASSERT_EQ(nostr::cryptography::ConversationKeyCacheProbe::newestKey(cache), evictedKey);
+    ASSERT_EQ(encodeHex(evictedKey, NC_CONV_KEY_SIZE), derive(2));
+};
+
+TEST_F(NostrConversationKeyCacheTest, Clear_ZeroesAndForgetsEveryKey)
+{
+    ConversationKeyCache cache(4);
+    lookUp(cache, 0);
+    lookUp(cache, 1);
+
+    cache.clear();
+    ASSERT_EQ(nostr::cryptography::ConversationKeyCacheProbe::size(cache), 0);
+
+    const uint8_t* evictedKey = nostr::cryptography::ConversationKeyCacheProbe::evictedKey(cache);
+    ASSERT_NE(evictedKey, nullptr);
+    const uint8_t zeroKey[NC_CONV_KEY_SIZE] = { 0 };
+    ASSERT_EQ(memcmp(evictedKey, zeroKey, sizeof(zeroKey)), 0);
+
+    uint64_t misses = cache.misses();
+    lookUp(cache, 0);
+    ASSERT_EQ(cache.misses(), misses + 1);
+};
+
+TEST_F(NostrConversationKeyCacheTest, Get_DerivesEveryTime_WhenCapacityIsZero)
+{
+    ConversationKeyCache cache(0);
+
+    ASSERT_EQ(lookUp(cache, 0), derive(0));
+    ASSERT_EQ(lookUp(cache, 0), derive(0));
+    ASSERT_EQ(cache.misses(), 2);
+    ASSERT_EQ(cache.hits(), 0);
+    ASSERT_EQ(nostr::cryptography::ConversationKeyCacheProbe::size(cache), 0);
+};
+} // namespace nostr_test
@@ -0,0 +1,234 @@
+#include <chrono>
+#include <future>
+#include <mutex>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "cryptography/event_verifier.hpp"
+#include "cryptography/verified_event_cache.hpp"
+#include "data/data.hpp"
+
+using namespace nostr::cryptography;
+using namespace nostr::data;
+using namespace std;
+using namespace ::testing;
+
+namespace nostr_test
+{
+/**
+ * @brief Returns a text note signed with the secret key 0x03 (the first BIP-340 test vector key).
+ */
+shared_ptr<Event> signedTestEvent()
+{
+    auto event = make_shared<Event>();
+
+    event->id = "60705943cb13597e94afa0b4658d58573963db7eca0c06c5de1825e206a759bd";
+    event->pubkey = "f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9";
+    event->createdAt = 1700000000;
+    event->kind = 1;
+    event->tags = {
+        { "t", "aedile" }
+    };
+    event->content = "Verified hello from aedile.";
+    event->sig = "fcbb45d92e962398f430c19dca685df9af104245848cef4b222da67f4d278271"
+                 "44770021e01473d18628151e670ddcb48bf258c03ec6e3feac21ed0ae40a2ff7";
+
+    return event;
+}
+
+TEST(EventVerifierTest, VerifyEvent_Accepts_ValidEvent)
+{
+    EventVerifier verifier(1);
+    auto results = verifier.verify({ signedTestEvent() });
+
+    ASSERT_EQ(results.size(), 1);
+    ASSERT_TRUE(results[0]);
+};
+
+TEST(EventVerifierTest, VerifyEvent_Rejects_TamperedContent)
+{
+    auto event = signedTestEvent();
+    event->content = "Forged hello from aedile.";
+
+    EventVerifier verifier(1);
+    auto results = verifier.verify({ event });
+
+    ASSERT_FALSE(results[0]);
+};
+
+TEST(EventVerifierTest, VerifyEvent_Rejects_TamperedSignature)
+{
+    auto event = signedTestEvent();
+    event->sig[10] = event->sig[10] == '0' ? '1' : '0';
+
+    EventVerifier verifier(1);
+    auto results = verifier.verify({ event });
+
+    ASSERT_FALSE(results[0]);
+};
+
+TEST(EventVerifierTest, VerifyEvent_Rejects_MalformedHex)
+{
+    auto shortSig = signedTestEvent();
+    shortSig->sig.pop_back();
+
+    auto badPubkey = signedTestEvent();
+    badPubkey->pubkey[0] = 'x';
+
+    auto unsignedEvent = signedTestEvent();
+    unsignedEvent->sig.clear();
+
+    EventVerifier verifier(1);
+    auto results = verifier.verify({ shortSig, badPubkey, unsignedEvent });
+
+    ASSERT_THAT(results, ElementsAre(false, false, false));
+};
+
+TEST(EventVerifierTest, Verify_ReturnsResults_InInputOrder)
+{
+    vector<shared_ptr<Event>> events;
+    vector<bool> expected;
+    for (int i = 0; i < 100; i++)
+    {
+        auto event = signedTestEvent();
+        if (i % 3 == 0)
+        {
+            event->createdAt++;
+        }
+        events.push_back(event);
+        expected.push_back(i % 3 != 0);
+    }
+
+    EventVerifier verifier(4, 8);
+    auto results = verifier.verify(events);
+
+    ASSERT_EQ(results, expected);
+
+    auto stats = verifier.stats();
+    ASSERT_EQ(stats.verified + stats.rejected, events.size());
+    ASSERT_EQ(stats.rejected, 34);
+};
+
+TEST(EventVerifierTest, Submit_InvokesHandler_ForEveryEvent)
+{
+    const size_t eventCount = 50;
+    mutex resultsMutex;
+    size_t validCount = 0;
+    size_t invalidCount = 0;
+    promise<void> donePromise;
+
+    EventVerifier verifier(2, 4);
+    for (size_t i = 0; i < eventCount; i++)
+    {
+        auto event = signedTestEvent();
+        if (i % 2 == 0)
+        {
+            event->sig = string(128, '0');
+        }
+
+        verifier.submit(event, [&](shared_ptr<Event>, bool isValid)
+        {
+            lock_guard<mutex> lock(resultsMutex);
+            (isValid ? validCount : invalidCount)++;
+            if (validCount + invalidCount == eventCount)
+            {
+                donePromise.set_value();
+            }
+        });
+    }
+
+    auto doneFuture = donePromise.get_future();
+    ASSERT_EQ(doneFuture.wait_for(chrono::seconds(10)), future_status::ready);
+    ASSERT_EQ(validCount, eventCount / 2);
+    ASSERT_EQ(invalidCount, eventCount / 2);
+
+    auto stats = verifier.stats();
+    ASSERT_EQ(stats.verified, eventCount / 2);
+    ASSERT_EQ(stats.rejected, eventCount / 2);
+};
+
+TEST(EventVerifierTest, Verify_SkipsSignatureCheck_ForCachedEvents)
+{
+    EventVerifier verifier(1);
+    verifier.verify({ signedTestEvent() });
+    auto results = verifier.verify({ signedTestEvent() });
+
+    ASSERT_TRUE(results[0]);
+
+    auto stats = verifier.stats();
+    ASSERT_EQ(stats.verified, 2);
+    ASSERT_EQ(stats.cacheMisses, 1);
+    ASSERT_EQ(stats.cacheHits, 1);
+};
+
+TEST(EventVerifierTest, Verify_Rejects_ForgedCopiesOfCachedEvents)
+{
+    auto tamperedContent = signedTestEvent();
+    tamperedContent->content = "Forged hello from aedile.";
+
+    auto tamperedSignature = signedTestEvent();
+    tamperedSignature->sig = string(128, '0');
+
+    EventVerifier verifier(1);
+    verifier.verify({ signedTestEvent() });
+    auto results = verifier.verify({ tamperedContent, tamperedSignature });
+
+    ASSERT_THAT(results, ElementsAre(false, false));
+    ASSERT_EQ(verifier.stats().cacheHits, 0);
+};
+
+TEST(VerifiedEventCacheTest, Contains_RequiresMatchingSignature)
+{
+    VerifiedEventCache cache(16, 4);
+    EventId id{};
+    EventSignature signature{};
+    signature[0] = 1;
+
+    ASSERT_FALSE(cache.contains(id, signature));
+    cache.insert(id, signature);
+    ASSERT_TRUE(cache.contains(id, signature));
+
+    EventSignature otherSignature{};
+    ASSERT_FALSE(cache.contains(id, otherSignature));
+
+    auto stats = cache.stats();
+    ASSERT_EQ(stats.hits, 1);
+    ASSERT_EQ(stats.misses, 2);
+    ASSERT_EQ(stats.size, 1);
+};
+
+TEST(VerifiedEventCacheTest, Insert_EvictsLeastRecentlyUsed_WhenFull)
+{
+    // A single shard makes the eviction order predictable.
+    VerifiedEventCache cache(2, 1);
+    EventSignature signature{};
+    EventId first{}, second{}, third{};
+    first[0] = 1;
+    second[0] = 2;
+    third[0] = 3;
+
+    cache.insert(first, signature);
+    cache.insert(second, signature);
+    ASSERT_TRUE(cache.contains(first, signature));
+
+    cache.insert(third, signature);
+
+    ASSERT_TRUE(cache.contains(first, signature));
+    ASSERT_FALSE(cache.contains(second, signature));
+    ASSERT_TRUE(cache.contains(third, signature));
+    ASSERT_EQ(cache.stats().size, 2);
+};
+
+TEST(VerifiedEventCacheTest, ZeroCapacity_DisablesCache)
+{
+    VerifiedEventCache cache(0);
+    EventId id{};
+    EventSignature signature{};
+
+    cache.insert(id, signature);
+
+    ASSERT_FALSE(cache.contains(id, signature));
+    ASSERT_EQ(cache.stats().size, 0);
+};
+} // namespace nostr_test
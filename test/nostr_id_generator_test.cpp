@@ -0,0 +1,82 @@
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "internal/id_generator.hpp"
+
+using namespace nostr::internal;
+using namespace std;
+using namespace ::testing;
+
+namespace nostr_test
+{
+TEST(NostrIdGeneratorTest, Next_UsesOnlyTheUrlSafeBase64Alphabet)
+{
+    const string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+    for (int i = 0; i < 1000; i++)
+    {
+        string id = IdGenerator::next();
+        ASSERT_EQ(id.find_first_not_of(alphabet), string::npos) << id;
+    }
+};
+
+TEST(NostrIdGeneratorTest, Next_FitsTheSubscriptionIdLimit)
+{
+    for (int i = 0; i < 1000; i++)
+    {
+        string id = IdGenerator::next();
+        ASSERT_FALSE(id.empty());
+        ASSERT_LE(id.size(), IdGenerator::maxLength);
+        ASSERT_LE(id.size(), 64);
+    }
+};
+
+TEST(NostrIdGeneratorTest, Next_IsUniqueAcrossThreads)
+{
+    const int threadCount = 8;
+    const int idsPerThread = 20000;
+
+    mutex idMutex;
+    unordered_set<string> ids;
+    vector<thread> threads;
+    for (int t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&]()
+        {
+            vector<string> threadIds;
+            for (int i = 0; i < idsPerThread; i++)
+            {
+                threadIds.push_back(IdGenerator::next());
+            }
+
+            lock_guard<mutex> lock(idMutex);
+            ids.insert(threadIds.begin(), threadIds.end());
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ(ids.size(), threadCount * idsPerThread);
+};
+
+TEST(NostrIdGeneratorTest, Next_SharesNoPrefixBetweenConsecutiveIds)
+{
+    // IDs from one thread must not be linkable by a common prefix, nor reveal a count.  Among a
+    // thousand IDs, even eight characters (48 random bits) should all differ.
+    unordered_set<string> prefixes;
+    for (int i = 0; i < 1000; i++)
+    {
+        prefixes.insert(IdGenerator::next().substr(0, 8));
+    }
+
+    ASSERT_EQ(prefixes.size(), 1000);
+};
+} // namespace nostr_test
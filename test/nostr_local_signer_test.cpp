@@ -0,0 +1,114 @@
+#include <cstring>
+#include <stdexcept>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <plog/Appenders/ConsoleAppender.h>
+#include <plog/Formatters/TxtFormatter.h>
+
+#include "cryptography/event_verifier.hpp"
+#include "signer/noscrypt_local_signer.hpp"
+
+using namespace nostr::cryptography;
+using namespace nostr::data;
+using namespace nostr::signer;
+using namespace std;
+using namespace ::testing;
+
+namespace nostr_test
+{
+class NostrLocalSignerTest : public testing::Test
+{
+public:
+    // The public key of the secret key 0x03 (the first BIP-340 test vector key).
+    inline static const string testPublicKey = "f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9";
+
+    shared_ptr<plog::ConsoleAppender<plog::TxtFormatter>> testAppender;
+    NCSecretKey testSecretKey;
+
+    void SetUp() override
+    {
+        testAppender = make_shared<plog::ConsoleAppender<plog::TxtFormatter>>();
+
+        memset(testSecretKey.key, 0, sizeof(testSecretKey.key));
+        testSecretKey.key[31] = 3;
+    };
+
+    static shared_ptr<Event> unsignedTextNote(string content)
+    {
+        auto event = make_shared<Event>();
+        event->createdAt = 1700000000;
+        event->kind = 1;
+        event->tags = { { "t", "aedile" } };
+        event->content = content;
+
+        return event;
+    };
+};
+
+TEST_F(NostrLocalSignerTest, Constructor_DerivesPublicKey)
+{
+    NoscryptLocalSigner signer(testAppender, testSecretKey);
+
+    ASSERT_EQ(signer.publicKey(), testPublicKey);
+};
+
+TEST_F(NostrLocalSignerTest, Constructor_Throws_OnInvalidSecretKey)
+{
+    NCSecretKey zeroKey;
+    memset(zeroKey.key, 0, sizeof(zeroKey.key));
+
+    ASSERT_THROW(NoscryptLocalSigner(testAppender, zeroKey), invalid_argument);
+};
+
+TEST_F(NostrLocalSignerTest, Sign_ProducesVerifiableEvent)
+{
+    NoscryptLocalSigner signer(testAppender, testSecretKey);
+    auto event = unsignedTextNote("Verified hello from aedile.");
+
+    auto signingPromise = signer.sign(event);
+
+    ASSERT_TRUE(signingPromise->get_future().get());
+    ASSERT_EQ(event->pubkey, testPublicKey);
+    ASSERT_EQ(event->id, "60705943cb13597e94afa0b4658d58573963db7eca0c06c5de1825e206a759bd");
+    ASSERT_EQ(event->sig.size(), 128);
+
+    EventVerifier verifier(1);
+    ASSERT_TRUE(verifier.verify({ event })[0]);
+};
+
+TEST_F(NostrLocalSignerTest, Sign_Fails_ForAnotherAuthorsEvent)
+{
+    NoscryptLocalSigner signer(testAppender, testSecretKey);
+    auto event = unsignedTextNote("Hello, World!");
+    event->pubkey = "dc4cd086cd7ce5b1832adf4fdd1211289880d2c7e295bcb0e684c01acee77c06";
+
+    auto signingPromise = signer.sign(event);
+
+    ASSERT_FALSE(signingPromise->get_future().get());
+    ASSERT_TRUE(event->sig.empty());
+};
+
+TEST_F(NostrLocalSignerTest, SignEvents_SignsEveryEvent_AcrossWorkers)
+{
+    NoscryptLocalSigner signer(testAppender, testSecretKey, 4);
+
+    vector<shared_ptr<Event>> events;
+    for (int i = 0; i < 50; i++)
+    {
+        events.push_back(unsignedTextNote("Batch note " + to_string(i)));
+    }
+    events[7]->kind = -1;
+
+    auto results = signer.signEvents(events);
+
+    ASSERT_EQ(results.size(), events.size());
+    EventVerifier verifier(2);
+    auto verified = verifier.verify(events);
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        ASSERT_EQ(results[i], i != 7);
+        ASSERT_EQ(verified[i], i != 7);
+    }
+};
+} // namespace nostr_test
@@ -0,0 +1,119 @@
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "cryptography/nip44_batch_cipher.hpp"
+
+using namespace nostr::cryptography;
+using namespace std;
+using namespace ::testing;
+
+namespace nostr_test
+{
+class NostrNip44BatchCipherTest : public testing::Test
+{
+public:
+    // The public keys of the secret keys 0x02 and 0x03.
+    inline static const string alicePublicKey = "c6047f9441ed7d6d3045406e95c07cd85c778e4b8cef3ca7abac09b95c709ee5";
+    inline static const string bobPublicKey = "f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9";
+
+    NCSecretKey aliceSecretKey;
+    NCSecretKey bobSecretKey;
+
+    void SetUp() override
+    {
+        memset(aliceSecretKey.key, 0, sizeof(aliceSecretKey.key));
+        aliceSecretKey.key[31] = 2;
+
+        memset(bobSecretKey.key, 0, sizeof(bobSecretKey.key));
+        bobSecretKey.key[31] = 3;
+    };
+};
+
+TEST_F(NostrNip44BatchCipherTest, Constructor_Throws_OnInvalidSecretKey)
+{
+    NCSecretKey zeroKey;
+    memset(zeroKey.key, 0, sizeof(zeroKey.key));
+
+    ASSERT_THROW(Nip44BatchCipher(zeroKey, 1), invalid_argument);
+};
+
+TEST_F(NostrNip44BatchCipherTest, Decrypt_RecoversMessagesEncryptedByPeer_InOrder)
+{
+    Nip44BatchCipher alice(aliceSecretKey, 4);
+    Nip44BatchCipher bob(bobSecretKey, 3);
+
+    vector<Nip44BatchItem> messages;
+    for (int i = 0; i < 200; i++)
+    {
+        messages.push_back({ bobPublicKey, "Message " + to_string(i) + string(i * 7, '.') });
+    }
+
+    auto encrypted = alice.encrypt(messages);
+    ASSERT_EQ(encrypted.size(), messages.size());
+
+    vector<Nip44BatchItem> payloads;
+    for (const auto& result : encrypted)
+    {
+        ASSERT_EQ(result.error, Nip44BatchError::NONE);
+        payloads.push_back({ alicePublicKey, result.output });
+    }
+
+    auto decrypted = bob.decrypt(payloads);
+    ASSERT_EQ(decrypted.size(), messages.size());
+    for (size_t i = 0; i < messages.size(); i++)
+    {
+        ASSERT_EQ(decrypted[i].error, Nip44BatchError::NONE);
+        ASSERT_EQ(decrypted[i].output, messages[i].payload);
+    }
+};
+
+TEST_F(NostrNip44BatchCipherTest, Decrypt_ReportsErrorsPerItem)
+{
+    Nip44BatchCipher alice(aliceSecretKey, 2);
+    Nip44BatchCipher bob(bobSecretKey, 2);
+
+    string payload = alice.encrypt({ { bobPublicKey, "Hello, Bob!" } })[0].output;
+    string tampered = payload;
+    tampered[tampered.size() / 2] = tampered[tampered.size() / 2] == 'A' ? 'B' : 'A';
+
+    auto results = bob.decrypt({
+        { alicePublicKey, payload },
+        { "not a public key", payload },
+        { alicePublicKey, "not base64!" },
+        { alicePublicKey, tampered },
+        { alicePublicKey, payload },
+    });
+
+    ASSERT_EQ(results.size(), 5);
+    ASSERT_EQ(results[0].error, Nip44BatchError::NONE);
+    ASSERT_EQ(results[0].output, "Hello, Bob!");
+    ASSERT_EQ(results[1].error, Nip44BatchError::INVALID_PUBLIC_KEY);
+    ASSERT_EQ(results[2].error, Nip44BatchError::INVALID_PAYLOAD);
+    ASSERT_EQ(results[3].error, Nip44BatchError::INVALID_PAYLOAD);
+    ASSERT_TRUE(results[3].output.empty());
+    ASSERT_EQ(results[4].error, Nip44BatchError::NONE);
+    ASSERT_EQ(results[4].output, "Hello, Bob!");
+};
+
+TEST_F(NostrNip44BatchCipherTest, Encrypt_ReportsErrorsPerItem)
+{
+    Nip44BatchCipher alice(aliceSecretKey, 2);
+
+    auto results = alice.encrypt({
+        { bobPublicKey, "Hello, Bob!" },
+        { bobPublicKey.substr(2), "Hello, Bob!" },
+        { bobPublicKey, "" },
+    });
+
+    ASSERT_EQ(results.size(), 3);
+    ASSERT_EQ(results[0].error, Nip44BatchError::NONE);
+    ASSERT_FALSE(results[0].output.empty());
+    ASSERT_EQ(results[1].error, Nip44BatchError::INVALID_PUBLIC_KEY);
+    ASSERT_EQ(results[2].error, Nip44BatchError::CIPHER_FAILED);
+    ASSERT_TRUE(results[2].output.empty());
+};
+} // namespace nostr_test
@@ -0,0 +1,459 @@
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "cryptography/base64.hpp"
+#include "cryptography/noscrypt_context_pool.hpp"
+#include "cryptography/noscrypt_cipher.hpp"
+#include "internal/hex_encoding.hpp"
+
+using namespace nostr::cryptography;
+using namespace nostr::encoding;
+using namespace nostr::internal;
+using namespace std;
+using namespace ::testing;
+
+namespace nostr_test
+{
+class NostrNoscryptCipherTest : public testing::Test
+{
+public:
+    /**
+     * @brief An encryption vector from the NIP-44 v2 specification.
+     */
+    struct EncryptionVector
+    {
+        string secretKey1;
+        string secretKey2;
+        string conversationKey;
+        string nonce;
+        string plaintext;
+        string payload;
+    };
+
+    // The `encrypt_decrypt` vectors of the NIP-44 v2 specification.
+    inline static const vector<EncryptionVector> encryptionVectors = {
+        {
+            "0000000000000000000000000000000000000000000000000000000000000001",
+            "0000000000000000000000000000000000000000000000000000000000000002",
+            "c41c775356fd92eadc63ff5a0dc1da211b268cbea22316767095b2871ea1412d",
+            "0000000000000000000000000000000000000000000000000000000000000001",
+            "a",
+            "AgAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAABee0G5VSK0/9YypIObAtDKfYEAjD35uVkHyB0F4DwrcNaCXlCWZKaArsGrY6M9wnuTMxWfp1RTN9Xga8no+kF5Vsb"
+        },
+        {
+            "0000000000000000000000000000000000000000000000000000000000000002",
+            "0000000000000000000000000000000000000000000000000000000000000001",
+            "c41c775356fd92eadc63ff5a0dc1da211b268cbea22316767095b2871ea1412d",
+            "f00000000000000000000000000000f00000000000000000000000000000000f",
+            "\U0001F355\U0001FAC3",
+            "AvAAAAAAAAAAAAAAAAAAAPAAAAAAAAAAAAAAAAAAAAAPSKSK6is9ngkX2+cSq85Th16oRTISAOfhStnixqZziKMDvB0QQzgFZdjLTPicCJaV8nDITO+QfaQ61+KbWQIOO2Yj"
+        },
+        {
+            "5c0c523f52a5b6fad39ed2403092df8cebc36318b39383bca6c00808626fab3a",
+            "4b22aa260e4acb7021e32f38a6cdf4b673c6a277755bfce287e370c924dc936d",
+            "3e2b52a63be47d34fe0a80e34e73d436d6963bc8f39827f327057a9986c20a45",
+            "b635236c42db20f021bb8d1cdff5ca75dd1a0cc72ea742ad750f33010b24f73b",
+            "表ポあA鷗ŒéＢ逍Üßªąñ丂㐀\U00020000",
+            "ArY1I2xC2yDwIbuNHN/1ynXdGgzHLqdCrXUPMwELJPc7s7JqlCMJBAIIjfkpHReBPXeoMCyuClwgbT419jUWU1PwaNl4FEQYKCDKVJz+97Mp3K+Q2YGa77B6gpxB/lr1QgoqpDf7wDVrDmOqGoiPjWDqy8KzLueKDcm9BVP8xeTJIxs="
+        },
+    };
+
+    // The secret keys 0x02 and 0x03, and their public keys.
+    NCSecretKey aliceSecretKey = secretKey("0000000000000000000000000000000000000000000000000000000000000002");
+    NCSecretKey bobSecretKey = secretKey("0000000000000000000000000000000000000000000000000000000000000003");
+    NCPublicKey alicePublicKey = publicKey(aliceSecretKey);
+    NCPublicKey bobPublicKey = publicKey(bobSecretKey);
+
+    static vector<uint8_t> fromHex(const string& hex)
+    {
+        vector<uint8_t> bytes(hex.size() / 2);
+        EXPECT_TRUE(decodeHex(hex, bytes.data(), bytes.size()));
+        return bytes;
+    };
+
+    static NCSecretKey secretKey(const string& hex)
+    {
+        NCSecretKey key;
+        EXPECT_TRUE(decodeHex(hex, key.key, sizeof(key.key)));
+        return key;
+    };
+
+    static NCPublicKey publicKey(const NCSecretKey& secretKey)
+    {
+        NCPublicKey key;
+        EXPECT_EQ(NCGetPublicKey(NoscryptContextPool::local(), &secretKey, &key), NC_SUCCESS);
+        return key;
+    };
+
+    static string conversationKey(const NCSecretKey& secretKey, const NCPublicKey& publicKey)
+    {
+        uint8_t key[NC_CONV_KEY_SIZE];
+        EXPECT_EQ(NCGetConversationKey(NoscryptContextPool::local(), &secretKey, &publicKey, key), NC_SUCCESS);
+        return encodeHex(key, sizeof(key));
+    };
+
+    static vector<uint8_t> decodePayload(const string& payload)
+    {
+        vector<uint8_t> bytes(Base64::maxDecodedSize(payload.size()));
+        size_t size = 0;
+        EXPECT_TRUE(Base64::decode(payload.data(), payload.size(), bytes.data(), size));
+        bytes.resize(size);
+        return bytes;
+    };
+
+    static string encodePayload(const vector<uint8_t>& payload)
+    {
+        string encoded;
+        Base64::encode(payload.data(), payload.size(), encoded);
+        return encoded;
+    };
+
+    /**
+     * @brief Builds a payload around an arbitrary padded plaintext, with a valid MAC, so that
+     * malformed padding can be presented to the decryptor.
+     */
+    static vector<uint8_t> sealPadded(const vector<uint8_t>& conversationKey, const vector<uint8_t>& padded)
+    {
+        vector<uint8_t> payload(1 + NC_ENCRYPTION_NONCE_SIZE + padded.size() + NC_ENCRYPTION_MAC_SIZE, 0);
+        payload[0] = 2;
+        uint8_t* nonce = payload.data() + 1;
+        uint8_t* ciphertext = nonce + NC_ENCRYPTION_NONCE_SIZE;
+        nonce[NC_ENCRYPTION_NONCE_SIZE - 1] = 1;
+
+        uint8_t hmacKey[NC_HMAC_KEY_SIZE];
+        NCEncryptionArgs args = {};
+        NCEncryptionSetProperty(&args, NC_ENC_SET_VERSION, NC_ENC_VERSION_NIP44);
+        NCEncryptionSetPropertyEx(&args, NC_ENC_SET_IV, nonce, NC_ENCRYPTION_NONCE_SIZE);
+        NCEncryptionSetPropertyEx(&args, NC_ENC_SET_NIP44_MAC_KEY, hmacKey, sizeof(hmacKey));
+        NCEncryptionSetData(&args, padded.data(), ciphertext, static_cast<uint32_t>(padded.size()));
+        EXPECT_EQ(NCEncryptEx(NoscryptContextPool::local(), conversationKey.data(), &args), NC_SUCCESS);
+        EXPECT_EQ(NCComputeMac(
+            NoscryptContextPool::local(),
+            hmacKey,
+            nonce,
+            static_cast<uint32_t>(NC_ENCRYPTION_NONCE_SIZE + padded.size()),
+            ciphertext + padded.size()), NC_SUCCESS);
+
+        return payload;
+    };
+};
+
+TEST_F(NostrNoscryptCipherTest, PaddedSize_MatchesSpecificationVectors)
+{
+    // The `calc_padded_len` vectors of the NIP-44 v2 specification.
+    const vector<pair<size_t, size_t>> vectors = {
+        { 16, 32 }, { 32, 32 }, { 33, 64 }, { 37, 64 }, { 45, 64 }, { 49, 64 }, { 64, 64 },
+        { 65, 96 }, { 100, 128 }, { 111, 128 }, { 200, 224 }, { 250, 256 }, { 320, 320 },
+        { 383, 384 }, { 384, 384 }, { 400, 448 }, { 500, 512 }, { 512, 512 }, { 515, 640 },
+        { 700, 768 }, { 800, 896 }, { 900, 1024 }, { 1020, 1024 }, { 65536, 65536 }
+    };
+
+    for (const auto& [length, paddedLength] : vectors)
+    {
+        EXPECT_EQ(NoscryptCipher::nip44PaddedSize(length), paddedLength) << "length " << length;
+    }
+};
+
+TEST_F(NostrNoscryptCipherTest, ConversationKey_MatchesSpecificationVector)
+{
+    NCSecretKey secretKey1 = secretKey("315e59ff51cb9209768cf7da80791ddcaae56ac9775eb25b6dee1234bc5d2268");
+    NCPublicKey publicKey2;
+    ASSERT_TRUE(decodeHex(
+        "c2f9d9948dc8c7c38321e4b85c8558872eafa0641cd269db76848a6073e69133",
+        publicKey2.key,
+        sizeof(publicKey2.key)));
+
+    ASSERT_EQ(
+        conversationKey(secretKey1, publicKey2),
+        "3dfef0ce2a4d80a25e7a328accf73448ef67096f65f79588e358d9a0eb9013f1");
+};
+
+TEST_F(NostrNoscryptCipherTest, ConversationKey_IsSymmetric_ForSpecificationVectors)
+{
+    for (const auto& vector : encryptionVectors)
+    {
+        NCSecretKey secretKey1 = secretKey(vector.secretKey1);
+        NCSecretKey secretKey2 = secretKey(vector.secretKey2);
+
+        EXPECT_EQ(conversationKey(secretKey1, publicKey(secretKey2)), vector.conversationKey);
+        EXPECT_EQ(conversationKey(secretKey2, publicKey(secretKey1)), vector.conversationKey);
+    }
+};
+
+TEST_F(NostrNoscryptCipherTest, Encrypt_WithFixedNonce_MatchesSpecificationVectors)
+{
+    for (const auto& vector : encryptionVectors)
+    {
+        auto key = fromHex(vector.conversationKey);
+        auto nonce = fromHex(vector.nonce);
+        std::vector<uint8_t> payload;
+
+        ASSERT_TRUE(NoscryptCipher::encryptNip44(
+            NoscryptContextPool::local(),
+            key.data(),
+            nonce.data(),
+            reinterpret_cast<const uint8_t*>(vector.plaintext.data()),
+            vector.plaintext.size(),
+            payload));
+        EXPECT_EQ(encodePayload(payload), vector.payload);
+    }
+};
+
+TEST_F(NostrNoscryptCipherTest, Decrypt_MatchesSpecificationVectors)
+{
+    for (const auto& vector : encryptionVectors)
+    {
+        auto key = fromHex(vector.conversationKey);
+        string payload;
+        for (uint8_t byte : decodePayload(vector.payload))
+        {
+            payload.push_back(static_cast<char>(byte));
+        }
+
+        EXPECT_EQ(NoscryptCipher::decryptNip44(NoscryptContextPool::local(), key.data(), payload), vector.plaintext);
+    }
+};
+
+TEST_F(NostrNoscryptCipherTest, Decrypt_Fails_OnInvalidMac)
+{
+    const auto& vector = encryptionVectors[0];
+    auto key = fromHex(vector.conversationKey);
+    std::vector<uint8_t> plaintext;
+
+    auto payload = decodePayload(vector.payload);
+    payload.back() ^= 0x01;
+    ASSERT_FALSE(NoscryptCipher::decryptNip44(NoscryptContextPool::local(), key.data(), payload.data(), payload.size(), plaintext));
+    ASSERT_TRUE(plaintext.empty());
+
+    // A flipped ciphertext bit must be caught by the MAC as well.
+    payload = decodePayload(vector.payload);
+    payload[1 + NC_ENCRYPTION_NONCE_SIZE] ^= 0x01;
+    ASSERT_FALSE(NoscryptCipher::decryptNip44(NoscryptContextPool::local(), key.data(), payload.data(), payload.size(), plaintext));
+
+    // So must a MAC computed under another conversation key.
+    auto otherKey = fromHex(encryptionVectors[2].conversationKey);
+    payload = decodePayload(vector.payload);
+    ASSERT_FALSE(NoscryptCipher::decryptNip44(NoscryptContextPool::local(), otherKey.data(), payload.data(), payload.size(), plaintext));
+};
+
+TEST_F(NostrNoscryptCipherTest, Decrypt_Fails_OnInvalidPadding)
+{
+    auto key = fromHex(encryptionVectors[0].conversationKey);
+    std::vector<uint8_t> plaintext;
+
+    // A five-byte message padded to 64 bytes rather than 32.
+    std::vector<uint8_t> overPadded(2 + 64, 0);
+    overPadded[1] = 5;
+    memcpy(overPadded.data() + 2, "hello", 5);
+    auto payload = sealPadded(key, overPadded);
+    ASSERT_FALSE(NoscryptCipher::decryptNip44(NoscryptContextPool::local(), key.data(), payload.data(), payload.size(), plaintext));
+
+    // A length prefix of zero.
+    std::vector<uint8_t> empty(2 + 32, 0);
+    payload = sealPadded(key, empty);
+    ASSERT_FALSE(NoscryptCipher::decryptNip44(NoscryptContextPool::local(), key.data(), payload.data(), payload.size(), plaintext));
+
+    // A length prefix longer than the padded plaintext.
+    std::vector<uint8_t> overlong(2 + 32, 0);
+    overlong[1] = 33;
+    payload = sealPadded(key, overlong);
+    ASSERT_FALSE(NoscryptCipher::decryptNip44(NoscryptContextPool::local(), key.data(), payload.data(), payload.size(), plaintext));
+
+    // The same construction with correct padding decrypts, so the failures above are the padding.
+    std::vector<uint8_t> wellPadded(2 + 32, 0);
+    wellPadded[1] = 5;
+    memcpy(wellPadded.data() + 2, "hello", 5);
+    payload = sealPadded(key, wellPadded);
+    ASSERT_TRUE(NoscryptCipher::decryptNip44(NoscryptContextPool::local(), key.data(), payload.data(), payload.size(), plaintext));
+    ASSERT_EQ(string(plaintext.begin(), plaintext.end()), "hello");
+};
+
+TEST_F(NostrNoscryptCipherTest, Decrypt_Fails_OnInvalidLengthOrVersion)
+{
+    const auto& vector = encryptionVectors[0];
+    auto key = fromHex(vector.conversationKey);
+    std::vector<uint8_t> plaintext;
+
+    auto payload = decodePayload(vector.payload);
+    payload.pop_back();
+    ASSERT_FALSE(NoscryptCipher::decryptNip44(NoscryptContextPool::local(), key.data(), payload.data(), payload.size(), plaintext));
+
+    payload = decodePayload(vector.payload);
+    payload.resize(1 + NC_ENCRYPTION_NONCE_SIZE + NC_ENCRYPTION_MAC_SIZE);
+    ASSERT_FALSE(NoscryptCipher::decryptNip44(NoscryptContextPool::local(), key.data(), payload.data(), payload.size(), plaintext));
+
+    payload = decodePayload(vector.payload);
+    payload[0] = 1;
+    ASSERT_FALSE(NoscryptCipher::decryptNip44(NoscryptContextPool::local(), key.data(), payload.data(), payload.size(), plaintext));
+};
+
+TEST_F(NostrNoscryptCipherTest, Encrypt_Fails_OnInvalidMessageLength)
+{
+    auto key = fromHex(encryptionVectors[0].conversationKey);
+
+    ASSERT_TRUE(NoscryptCipher::encryptNip44(NoscryptContextPool::local(), key.data(), string()).empty());
+    ASSERT_TRUE(NoscryptCipher::encryptNip44(NoscryptContextPool::local(), key.data(), string(65536, 'a')).empty());
+    ASSERT_FALSE(NoscryptCipher::encryptNip44(NoscryptContextPool::local(), key.data(), string(65535, 'a')).empty());
+};
+TEST_F(NostrNoscryptCipherTest, BufferOverloads_MatchStringOverloads_ByteForByte)
+{
+    auto key = fromHex(encryptionVectors[2].conversationKey);
+    auto nonce = fromHex(encryptionVectors[2].nonce);
+
+    // Reuse each buffer across messages of shrinking and growing sizes, as callers do.
+    std::vector<uint8_t> payload;
+    std::vector<uint8_t> plaintext;
+    for (size_t size : { 1000, 1, 33, 65535, 200, 32 })
+    {
+        string message(size, '\0');
+        for (size_t i = 0; i < size; i++)
+        {
+            message[i] = static_cast<char>('a' + i % 26);
+        }
+
+        string stringPayload = NoscryptCipher::encryptNip44(NoscryptContextPool::local(), key.data(), message);
+        ASSERT_FALSE(stringPayload.empty());
+
+        ASSERT_TRUE(NoscryptCipher::decryptNip44(
+            NoscryptContextPool::local(),
+            key.data(),
+            reinterpret_cast<const uint8_t*>(stringPayload.data()),
+            stringPayload.size(),
+            plaintext));
+        ASSERT_EQ(string(plaintext.begin(), plaintext.end()), message);
+        ASSERT_EQ(NoscryptCipher::decryptNip44(NoscryptContextPool::local(), key.data(), stringPayload), message);
+
+        // With the nonce fixed, repeated encryptions into the same buffer are identical.
+        ASSERT_TRUE(NoscryptCipher::encryptNip44(
+            NoscryptContextPool::local(),
+            key.data(),
+            nonce.data(),
+            reinterpret_cast<const uint8_t*>(message.data()),
+            message.size(),
+            payload));
+        std::vector<uint8_t> firstPayload = payload;
+        ASSERT_TRUE(NoscryptCipher::encryptNip44(
+            NoscryptContextPool::local(),
+            key.data(),
+            nonce.data(),
+            reinterpret_cast<const uint8_t*>(message.data()),
+            message.size(),
+            payload));
+        ASSERT_EQ(payload, firstPayload);
+        ASSERT_EQ(payload.size(), stringPayload.size());
+    }
+};
+
+TEST_F(NostrNoscryptCipherTest, PooledCipher_MatchesUnpooledCipher_ByteForByte)
+{
+    NoscryptCipherPool pool(NoscryptCipherVersion::NIP44);
+    auto context = NoscryptContextPool::local();
+
+    std::vector<uint8_t> pooledOutput;
+    for (size_t size : { 5, 300, 1, 4000 })
+    {
+        string message(size, 'x');
+        std::vector<uint8_t> input(message.begin(), message.end());
+
+        // Encrypt through the pool and decrypt without it.
+        {
+            auto encryptor = pool.acquire(NoscryptCipherMode::CIPHER_MODE_ENCRYPT);
+            ASSERT_TRUE(encryptor->update(context, &aliceSecretKey, &bobPublicKey, input.data(), input.size(), pooledOutput));
+        }
+        NoscryptCipher decryptor(NoscryptCipherVersion::NIP44, NoscryptCipherMode::CIPHER_MODE_DECRYPT);
+        std::vector<uint8_t> unpooledOutput;
+        ASSERT_TRUE(decryptor.update(context, &bobSecretKey, &alicePublicKey, pooledOutput.data(), pooledOutput.size(), unpooledOutput));
+        ASSERT_EQ(unpooledOutput, input);
+
+        // Encrypt without the pool, then decrypt the same payload both ways.
+        NoscryptCipher encryptor(NoscryptCipherVersion::NIP44, NoscryptCipherMode::CIPHER_MODE_ENCRYPT);
+        std::vector<uint8_t> payload;
+        ASSERT_TRUE(encryptor.update(context, &aliceSecretKey, &bobPublicKey, input.data(), input.size(), payload));
+
+        ASSERT_TRUE(decryptor.update(context, &bobSecretKey, &alicePublicKey, payload.data(), payload.size(), unpooledOutput));
+        {
+            auto pooledDecryptor = pool.acquire(NoscryptCipherMode::CIPHER_MODE_DECRYPT);
+            ASSERT_TRUE(pooledDecryptor->update(context, &bobSecretKey, &alicePublicKey, payload.data(), payload.size(), pooledOutput));
+        }
+        ASSERT_EQ(pooledOutput, unpooledOutput);
+        ASSERT_EQ(pooledOutput, input);
+    }
+
+    // Each lease returned its cipher, and the ciphers were reused rather than recreated.
+    ASSERT_EQ(pool.idleCount(NoscryptCipherMode::CIPHER_MODE_ENCRYPT), 1);
+    ASSERT_EQ(pool.idleCount(NoscryptCipherMode::CIPHER_MODE_DECRYPT), 1);
+};
+
+TEST_F(NostrNoscryptCipherTest, CipherPool_KeepsAtMostMaxIdleCiphers)
+{
+    NoscryptCipherPool pool(NoscryptCipherVersion::NIP44, 2);
+
+    {
+        auto first = pool.acquire(NoscryptCipherMode::CIPHER_MODE_ENCRYPT);
+        auto second = pool.acquire(NoscryptCipherMode::CIPHER_MODE_ENCRYPT);
+        auto third = pool.acquire(NoscryptCipherMode::CIPHER_MODE_ENCRYPT);
+        auto moved = move(third);
+        ASSERT_EQ(pool.idleCount(NoscryptCipherMode::CIPHER_MODE_ENCRYPT), 0);
+        ASSERT_EQ(moved->mode(), NoscryptCipherMode::CIPHER_MODE_ENCRYPT);
+    }
+
+    ASSERT_EQ(pool.idleCount(NoscryptCipherMode::CIPHER_MODE_ENCRYPT), 2);
+    ASSERT_EQ(pool.idleCount(NoscryptCipherMode::CIPHER_MODE_DECRYPT), 0);
+};
+
+TEST_F(NostrNoscryptCipherTest, CipherPool_IsSafeToShareAcrossThreads)
+{
+    const int threadCount = 8;
+    const int messagesPerThread = 200;
+    NoscryptCipherPool pool(NoscryptCipherVersion::NIP44, 4);
+    atomic<int> failures{ 0 };
+
+    vector<thread> threads;
+    for (int t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            auto context = NoscryptContextPool::local();
+            std::vector<uint8_t> payload;
+            std::vector<uint8_t> plaintext;
+
+            for (int i = 0; i < messagesPerThread; i++)
+            {
+                string message = "Thread " + to_string(t) + " message " + to_string(i) + string(i % 50, '.');
+                std::vector<uint8_t> input(message.begin(), message.end());
+
+                bool isEncrypted;
+                {
+                    auto encryptor = pool.acquire(NoscryptCipherMode::CIPHER_MODE_ENCRYPT);
+                    isEncrypted = encryptor->update(context, &aliceSecretKey, &bobPublicKey, input.data(), input.size(), payload);
+                }
+
+                bool isDecrypted;
+                {
+                    auto decryptor = pool.acquire(NoscryptCipherMode::CIPHER_MODE_DECRYPT);
+                    isDecrypted = decryptor->update(context, &bobSecretKey, &alicePublicKey, payload.data(), payload.size(), plaintext);
+                }
+
+                if (!isEncrypted || !isDecrypted || plaintext != input)
+                {
+                    failures.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ(failures.load(), 0);
+    ASSERT_LE(pool.idleCount(NoscryptCipherMode::CIPHER_MODE_ENCRYPT), 4);
+    ASSERT_LE(pool.idleCount(NoscryptCipherMode::CIPHER_MODE_DECRYPT), 4);
+};
+} // namespace nostr_test
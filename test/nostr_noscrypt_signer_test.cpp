@@ -0,0 +1,347 @@
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <plog/Appenders/ConsoleAppender.h>
+#include <plog/Formatters/TxtFormatter.h>
+
+#include "cryptography/nip44_batch_cipher.hpp"
+#include "service/nostr_service_base.hpp"
+#include "signer/noscrypt_local_signer.hpp"
+#include "signer/noscrypt_signer.hpp"
+
+using namespace nostr::cryptography;
+using namespace nostr::data;
+using namespace nostr::service;
+using namespace nostr::signer;
+using namespace std;
+using namespace ::testing;
+
+namespace nostr_test
+{
+class MockNostrService : public INostrServiceBase
+{
+public:
+    MOCK_METHOD(vector<string>, openRelayConnections, (), (override));
+    MOCK_METHOD(vector<string>, openRelayConnections, (vector<string> relays), (override));
+    MOCK_METHOD(void, closeRelayConnections, (), (override));
+    MOCK_METHOD(void, closeRelayConnections, (vector<string> relays), (override));
+    MOCK_METHOD((tuple<vector<string>, vector<string>>), publishEvent, (shared_ptr<Event> event), (override));
+    MOCK_METHOD((vector<tuple<vector<string>, vector<string>>>), publishEvents, (vector<shared_ptr<Event>> events), (override));
+    MOCK_METHOD(future<vector<shared_ptr<Event>>>, queryRelays, (shared_ptr<Filters> filters), (override));
+    MOCK_METHOD(string, queryRelays, (shared_ptr<Filters> filters, (function<void(const string&, shared_ptr<Event>)> eventHandler), function<void(const string&)> eoseHandler, (function<void(const string&, const string&)> closeHandler)), (override));
+    MOCK_METHOD(string, queryRelays, (shared_ptr<Filters> filters, (function<void(const string&, shared_ptr<Event>)> eventHandler), function<void(const string&)> eoseHandler, (function<void(const string&, const string&, const string&)> closeHandler)), (override));
+    MOCK_METHOD((tuple<vector<string>, vector<string>>), closeSubscription, (string subscriptionId), (override));
+    MOCK_METHOD(bool, closeSubscription, (string subscriptionId, string relay), (override));
+    MOCK_METHOD(vector<string>, closeSubscriptions, (), (override));
+    MOCK_METHOD(void, setEventVerification, (bool isEnabled), (override));
+    MOCK_METHOD(bool, setEventVerification, (string subscriptionId, bool isEnabled), (override));
+};
+
+typedef function<void(const string&, shared_ptr<Event>)> EventHandler;
+typedef function<void(const string&, const string&, const string&)> RelayCloseHandler;
+
+class NostrNoscryptSignerTest : public testing::Test
+{
+public:
+    // The remote signer acts for the user whose secret key is 0x03.
+    inline static const string userPublicKey = "f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9";
+    inline static const string responseSubscriptionId = "signer-responses";
+    inline static const string relayOne = "wss://relay.one";
+    inline static const string relayTwo = "wss://relay.two";
+
+    shared_ptr<plog::ConsoleAppender<plog::TxtFormatter>> testAppender;
+    shared_ptr<MockNostrService> mockService;
+    NCSecretKey userSecretKey;
+
+    shared_ptr<Nip44BatchCipher> bunkerCipher;
+    shared_ptr<NoscryptLocalSigner> bunkerSigner;
+
+    // The handlers of the response subscription, as given to the service by the signer.
+    EventHandler responseHandler;
+    RelayCloseHandler responseCloseHandler;
+
+    // The requests the signer has published, in order.
+    mutex publishedMutex;
+    vector<shared_ptr<Event>> publishedRequests;
+
+    void SetUp() override
+    {
+        testAppender = make_shared<plog::ConsoleAppender<plog::TxtFormatter>>();
+        mockService = make_shared<NiceMock<MockNostrService>>();
+
+        memset(userSecretKey.key, 0, sizeof(userSecretKey.key));
+        userSecretKey.key[31] = 3;
+        bunkerCipher = make_shared<Nip44BatchCipher>(userSecretKey, 1);
+        bunkerSigner = make_shared<NoscryptLocalSigner>(testAppender, userSecretKey);
+
+        ON_CALL(*mockService, queryRelays(_, _, _, An<RelayCloseHandler>()))
+            .WillByDefault([this](
+                shared_ptr<Filters>,
+                EventHandler eventHandler,
+                function<void(const string&)>,
+                RelayCloseHandler closeHandler)
+            {
+                responseHandler = eventHandler;
+                responseCloseHandler = closeHandler;
+                return responseSubscriptionId;
+            });
+        ON_CALL(*mockService, closeSubscription(An<string>()))
+            .WillByDefault(Return(make_tuple(vector<string>(), vector<string>())));
+    };
+
+    shared_ptr<NoscryptSigner> connectedSigner()
+    {
+        auto signer = make_shared<NoscryptSigner>(testAppender, mockService);
+        signer->receiveConnectionToken("bunker://" + userPublicKey + "?relay=" + relayOne);
+        return signer;
+    };
+
+    // Accepts each published request on the given relays without responding to it.
+    void acceptRequestsOn(vector<string> relays)
+    {
+        EXPECT_CALL(*mockService, publishEvent(_))
+            .WillRepeatedly([this, relays](shared_ptr<Event> event)
+            {
+                lock_guard<mutex> lock(publishedMutex);
+                publishedRequests.push_back(event);
+                return make_tuple(relays, vector<string>());
+            });
+    };
+
+    // Decrypts a request published by the client, as the remote signer would.
+    nlohmann::json readRequest(shared_ptr<Event> requestEvent)
+    {
+        auto results = bunkerCipher->decrypt({ { requestEvent->pubkey, requestEvent->content } });
+        return nlohmann::json::parse(results[0].output);
+    };
+
+    // Sends a response to a request through the response subscription, as the remote signer
+    // would.
+    void respond(shared_ptr<Event> requestEvent, nlohmann::json response)
+    {
+        auto results = bunkerCipher->encrypt({ { requestEvent->pubkey, response.dump() } });
+
+        auto responseEvent = make_shared<Event>();
+        responseEvent->kind = 24133;
+        responseEvent->tags = { { "p", requestEvent->pubkey } };
+        responseEvent->content = results[0].output;
+        ASSERT_TRUE(bunkerSigner->sign(responseEvent)->get_future().get());
+
+        responseHandler(responseSubscriptionId, responseEvent);
+    };
+
+    void respondPong(shared_ptr<Event> requestEvent)
+    {
+        respond(requestEvent, { { "id", readRequest(requestEvent).at("id") }, { "result", "pong" } });
+    };
+
+    static shared_ptr<Event> unsignedTextNote(string content)
+    {
+        auto event = make_shared<Event>();
+        event->pubkey = userPublicKey;
+        event->createdAt = 1700000000;
+        event->kind = 1;
+        event->tags = { { "t", "aedile" } };
+        event->content = content;
+
+        return event;
+    };
+};
+
+TEST_F(NostrNoscryptSignerTest, Requests_ShareOneResponseSubscription)
+{
+    EXPECT_CALL(*mockService, queryRelays(_, _, _, An<RelayCloseHandler>())).Times(1);
+    acceptRequestsOn({ relayOne });
+    auto signer = connectedSigner();
+
+    auto firstPing = signer->ping();
+    auto secondPing = signer->ping();
+    auto thirdPing = signer->ping();
+
+    ASSERT_EQ(publishedRequests.size(), 3);
+    for (auto& request : publishedRequests)
+    {
+        ASSERT_EQ(request->kind, 24133);
+        respondPong(request);
+    }
+
+    ASSERT_TRUE(firstPing->get_future().get());
+    ASSERT_TRUE(secondPing->get_future().get());
+    ASSERT_TRUE(thirdPing->get_future().get());
+};
+
+TEST_F(NostrNoscryptSignerTest, Requests_AreRegistered_BeforeTheyArePublished)
+{
+    auto signer = connectedSigner();
+
+    // The remote signer answers before `publishEvent` has returned.
+    EXPECT_CALL(*mockService, publishEvent(_))
+        .WillOnce([this](shared_ptr<Event> event)
+        {
+            respondPong(event);
+            return make_tuple(vector<string>{ relayOne }, vector<string>());
+        });
+
+    ASSERT_TRUE(signer->ping()->get_future().get());
+};
+
+TEST_F(NostrNoscryptSignerTest, Responses_AreRoutedByRequestId)
+{
+    acceptRequestsOn({ relayOne });
+    auto signer = connectedSigner();
+
+    auto pingPromise = signer->ping();
+    auto event = unsignedTextNote("Routed by ID.");
+    auto signingPromise = signer->sign(event);
+    ASSERT_EQ(publishedRequests.size(), 2);
+
+    // Answer the requests in the opposite order to the one in which they were sent.
+    auto signRequest = readRequest(publishedRequests[1]);
+    ASSERT_EQ(signRequest.at("method"), "sign_event");
+    auto requestedEvent = make_shared<Event>(Event::fromString(signRequest.at("params")[0]));
+    ASSERT_TRUE(bunkerSigner->sign(requestedEvent)->get_future().get());
+    respond(publishedRequests[1], { { "id", signRequest.at("id") }, { "result", requestedEvent->serialize() } });
+
+    auto pingFuture = pingPromise->get_future();
+    ASSERT_EQ(pingFuture.wait_for(chrono::seconds(0)), future_status::timeout);
+    respondPong(publishedRequests[0]);
+
+    ASSERT_TRUE(signingPromise->get_future().get());
+    ASSERT_EQ(event->id, requestedEvent->id);
+    ASSERT_EQ(event->sig, requestedEvent->sig);
+    ASSERT_TRUE(pingFuture.get());
+};
+
+TEST_F(NostrNoscryptSignerTest, Sign_Fails_WhenSignerReturnsAnotherEvent)
+{
+    acceptRequestsOn({ relayOne });
+    auto signer = connectedSigner();
+    auto event = unsignedTextNote("Sign exactly this.");
+    auto original = *event;
+
+    auto signingPromise = signer->sign(event);
+
+    // A valid signature by the user, but over different content.
+    auto request = readRequest(publishedRequests[0]);
+    auto substitutedEvent = make_shared<Event>(Event::fromString(request.at("params")[0]));
+    substitutedEvent->content = "Sign this instead.";
+    ASSERT_TRUE(bunkerSigner->sign(substitutedEvent)->get_future().get());
+    respond(publishedRequests[0], { { "id", request.at("id") }, { "result", substitutedEvent->serialize() } });
+
+    ASSERT_FALSE(signingPromise->get_future().get());
+    ASSERT_EQ(event->content, original.content);
+    ASSERT_TRUE(event->sig.empty());
+};
+
+TEST_F(NostrNoscryptSignerTest, Sign_Fails_WhenEventIsNotSignedByTheUser)
+{
+    acceptRequestsOn({ relayOne });
+    auto signer = connectedSigner();
+    auto event = unsignedTextNote("Sign exactly this.");
+
+    auto signingPromise = signer->sign(event);
+
+    // The same event, validly signed by someone other than the user.
+    NCSecretKey otherSecretKey;
+    memset(otherSecretKey.key, 0, sizeof(otherSecretKey.key));
+    otherSecretKey.key[31] = 2;
+    NoscryptLocalSigner otherSigner(testAppender, otherSecretKey);
+
+    auto request = readRequest(publishedRequests[0]);
+    auto impostorEvent = make_shared<Event>(Event::fromString(request.at("params")[0]));
+    impostorEvent->pubkey.clear();
+    ASSERT_TRUE(otherSigner.sign(impostorEvent)->get_future().get());
+    respond(publishedRequests[0], { { "id", request.at("id") }, { "result", impostorEvent->serialize() } });
+
+    ASSERT_FALSE(signingPromise->get_future().get());
+    ASSERT_TRUE(event->sig.empty());
+};
+
+TEST_F(NostrNoscryptSignerTest, Close_FailsOnlyRequestsOnTheClosingRelay)
+{
+    auto signer = connectedSigner();
+    EXPECT_CALL(*mockService, publishEvent(_))
+        .WillOnce([this](shared_ptr<Event> event)
+        {
+            publishedRequests.push_back(event);
+            return make_tuple(vector<string>{ relayOne }, vector<string>());
+        })
+        .WillOnce([this](shared_ptr<Event> event)
+        {
+            publishedRequests.push_back(event);
+            return make_tuple(vector<string>{ relayOne, relayTwo }, vector<string>());
+        })
+        .WillOnce([this](shared_ptr<Event> event)
+        {
+            publishedRequests.push_back(event);
+            return make_tuple(vector<string>{ relayTwo }, vector<string>());
+        });
+
+    auto relayOnePing = signer->ping();
+    auto bothRelaysPing = signer->ping();
+    auto relayTwoPing = signer->ping();
+
+    responseCloseHandler(responseSubscriptionId, "error: shutting down", relayOne);
+
+    auto relayOneFuture = relayOnePing->get_future();
+    ASSERT_EQ(relayOneFuture.wait_for(chrono::seconds(0)), future_status::ready);
+    ASSERT_FALSE(relayOneFuture.get());
+
+    respondPong(publishedRequests[1]);
+    respondPong(publishedRequests[2]);
+    ASSERT_TRUE(bothRelaysPing->get_future().get());
+    ASSERT_TRUE(relayTwoPing->get_future().get());
+};
+
+TEST_F(NostrNoscryptSignerTest, Close_FailsNewRequests_AcceptedOnlyByClosedRelays)
+{
+    acceptRequestsOn({ relayOne });
+    auto signer = connectedSigner();
+
+    auto pendingPing = signer->ping();
+    responseCloseHandler(responseSubscriptionId, "error: shutting down", relayOne);
+    ASSERT_FALSE(pendingPing->get_future().get());
+
+    // With nothing left pending, the next request opens a fresh subscription.
+    EXPECT_CALL(*mockService, closeSubscription(responseSubscriptionId)).Times(AtLeast(1));
+    EXPECT_CALL(*mockService, queryRelays(_, _, _, An<RelayCloseHandler>())).Times(1);
+    auto nextPing = signer->ping();
+    respondPong(publishedRequests[1]);
+
+    ASSERT_TRUE(nextPing->get_future().get());
+};
+
+TEST_F(NostrNoscryptSignerTest, Close_IgnoresReplacedSubscriptions)
+{
+    acceptRequestsOn({ relayOne });
+    auto signer = connectedSigner();
+
+    auto pendingPing = signer->ping();
+    responseCloseHandler("an-older-subscription", "error: shutting down", relayOne);
+
+    auto pendingFuture = pendingPing->get_future();
+    ASSERT_EQ(pendingFuture.wait_for(chrono::seconds(0)), future_status::timeout);
+    respondPong(publishedRequests[0]);
+    ASSERT_TRUE(pendingFuture.get());
+};
+
+TEST_F(NostrNoscryptSignerTest, Handlers_IgnoreMessages_AfterSignerIsDestroyed)
+{
+    acceptRequestsOn({ relayOne });
+    auto signer = connectedSigner();
+    auto pendingPing = signer->ping();
+    signer.reset();
+
+    // The service still holds the handlers, and may invoke them after the signer is gone.
+    respondPong(publishedRequests[0]);
+    responseCloseHandler(responseSubscriptionId, "error: shutting down", relayOne);
+
+    ASSERT_FALSE(pendingPing->get_future().get());
+};
+} // namespace nostr_test
@@ -1,6 +1,9 @@
 #include <chrono>
+#include <fstream>
 #include <future>
 #include <iostream>
+#include <set>
+#include <unordered_set>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -23,12 +26,53 @@ class MockWebSocketClient : public client::IWebSocketClient {
 public:
     MOCK_METHOD(void, start, (), (override));
     MOCK_METHOD(void, stop, (), (override));
-    MOCK_METHOD(void, openConnection, (string uri), (override));
-    MOCK_METHOD(bool, isConnected, (string uri), (override));
-    MOCK_METHOD((tuple<string, bool>), send, (string message, string uri), (override));
-    MOCK_METHOD((tuple<string, bool>), send, (string message, string uri, function<void(const string&)> messageHandler), (override));
-    MOCK_METHOD(void, receive, (string uri, function<void(const string&)> messageHandler), (override));
-    MOCK_METHOD(void, closeConnection, (string uri), (override));
+    MOCK_METHOD(void, openConnection, (string_view uri), (override));
+    MOCK_METHOD((future<bool>), openConnection, (string_view uri, function<void()> openHandler, function<void(string_view)> failHandler, function<void(string_view)> closeHandler), (override));
+    MOCK_METHOD(bool, isConnected, (string_view uri), (override));
+    MOCK_METHOD(bool, send, (client::SharedPayload message, string_view uri), (override));
+    MOCK_METHOD(bool, send, (client::SharedPayload message, string_view uri, client::MessageHandler messageHandler), (override));
+    MOCK_METHOD(void, receive, (string_view uri, client::MessageHandler messageHandler), (override));
+    MOCK_METHOD(void, closeConnection, (string_view uri), (override));
+    MOCK_METHOD(size_t, queuedMessageCount, (string_view uri), (override));
+
+    /**
+     * @brief Opens a connection through the mocked `openConnection` and `isConnected`, as the
+     * interface's default implementation does.
+     */
+    future<bool> openConnectionAndCheck(
+        string_view uri,
+        function<void()> openHandler,
+        function<void(string_view)> failHandler,
+        function<void(string_view)> closeHandler)
+    {
+        return client::IWebSocketClient::openConnection(uri, openHandler, failHandler, closeHandler);
+    };
+};
+
+/**
+ * @brief Counts the log records whose message contains the given text.
+ */
+class CountingAppender : public plog::IAppender
+{
+public:
+    explicit CountingAppender(string text) : _text(text) { };
+
+    void write(const plog::Record& record) override
+    {
+        if (string(record.getMessage()).find(this->_text) != string::npos)
+        {
+            this->_count++;
+        }
+    };
+
+    int count() const
+    {
+        return this->_count.load();
+    };
+
+private:
+    string _text;
+    atomic<int> _count{ 0 };
 };
 
 class NostrServiceBaseTest : public testing::Test
@@ -162,6 +206,9 @@ protected:
     {
         testAppender = make_shared<plog::ConsoleAppender<plog::TxtFormatter>>();
         mockClient = make_shared<MockWebSocketClient>();
+
+        ON_CALL(*mockClient, openConnection(_, _, _, _))
+            .WillByDefault(Invoke(mockClient.get(), &MockWebSocketClient::openConnectionAndCheck));
     };
 };
 
@@ -208,6 +255,24 @@ TEST_F(NostrServiceBaseTest, Destructor_StopsClient)
         mockClient);
 };
 
+TEST_F(NostrServiceBaseTest, Constructor_WritesEachLogRecordOnce_AfterSeveralServices)
+{
+    const string message = "No active relay connections to close.";
+    auto firstAppender = make_shared<CountingAppender>(message);
+    auto secondAppender = make_shared<CountingAppender>(message);
+
+    auto firstService = make_unique<nostr::service::NostrServiceBase>(firstAppender, mockClient);
+    auto sameAppenderService = make_unique<nostr::service::NostrServiceBase>(firstAppender, mockClient);
+    firstService->closeRelayConnections();
+    ASSERT_EQ(firstAppender->count(), 1);
+
+    // The latest appender replaces the earlier one rather than joining it.
+    auto secondService = make_unique<nostr::service::NostrServiceBase>(secondAppender, mockClient);
+    firstService->closeRelayConnections();
+    ASSERT_EQ(firstAppender->count(), 1);
+    ASSERT_EQ(secondAppender->count(), 1);
+};
+
 TEST_F(NostrServiceBaseTest, OpenRelayConnections_OpensConnections_ToDefaultRelays)
 {
     mutex connectionStatusMutex;
@@ -219,13 +284,13 @@ TEST_F(NostrServiceBaseTest, OpenRelayConnections_OpensConnections_ToDefaultRela
     EXPECT_CALL(*mockClient, openConnection(defaultTestRelays[1])).Times(1);
 
     EXPECT_CALL(*mockClient, isConnected(_))
-        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string uri)
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
         {
             lock_guard<mutex> lock(connectionStatusMutex);
-            bool status = connectionStatus->at(uri);
+            bool status = connectionStatus->at(string(uri));
             if (status == false)
             {
-                connectionStatus->at(uri) = true;
+                connectionStatus->at(string(uri)) = true;
             }
             return status;
         }));
@@ -244,6 +309,188 @@ TEST_F(NostrServiceBaseTest, OpenRelayConnections_OpensConnections_ToDefaultRela
     }
 };
 
+TEST_F(NostrServiceBaseTest, OpenRelayConnections_GivesUpOnRelays_ThatDoNotConnectBeforeTimeout)
+{
+    mutex connectionStatusMutex;
+    auto connectionStatus = make_shared<unordered_map<string, bool>>();
+    connectionStatus->insert({ defaultTestRelays[0], false });
+    connectionStatus->insert({ defaultTestRelays[1], false });
+
+    EXPECT_CALL(*mockClient, isConnected(_))
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
+        {
+            lock_guard<mutex> lock(connectionStatusMutex);
+            bool status = connectionStatus->at(string(uri));
+            if (status == false && uri == defaultTestRelays[0])
+            {
+                connectionStatus->at(string(uri)) = true;
+            }
+            return status;
+        }));
+
+    // The second relay never completes its handshake.
+    auto handshakePromise = make_shared<promise<bool>>();
+    EXPECT_CALL(*mockClient, openConnection(defaultTestRelays[0], _, _, _)).Times(1);
+    EXPECT_CALL(*mockClient, openConnection(defaultTestRelays[1], _, _, _))
+        .WillOnce(Invoke([handshakePromise](
+            string_view uri,
+            function<void()>,
+            function<void(string_view)>,
+            function<void(string_view)>)
+        {
+            return handshakePromise->get_future();
+        }));
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    nostrService->setConnectionTimeout(chrono::milliseconds(50));
+
+    auto startedAt = chrono::steady_clock::now();
+    auto connectedRelays = nostrService->openRelayConnections();
+    auto elapsed = chrono::steady_clock::now() - startedAt;
+
+    ASSERT_EQ(connectedRelays, vector<string>({ defaultTestRelays[0] }));
+    ASSERT_GE(elapsed, chrono::milliseconds(50));
+    ASSERT_LT(elapsed, chrono::seconds(5));
+
+    auto metrics = nostrService->metrics();
+    for (const auto& relay : metrics.relays)
+    {
+        ASSERT_EQ(relay.connects, relay.relay == defaultTestRelays[0] ? 1 : 0);
+        ASSERT_EQ(relay.connectFailures, relay.relay == defaultTestRelays[1] ? 1 : 0);
+    }
+};
+
+TEST_F(NostrServiceBaseTest, OpenRelayConnections_MarksRelayInactive_WhenConnectionCloses)
+{
+    EXPECT_CALL(*mockClient, isConnected(_)).WillRepeatedly(Return(false));
+
+    mutex closeHandlersMutex;
+    unordered_map<string, function<void(string_view)>> closeHandlers;
+    EXPECT_CALL(*mockClient, openConnection(_, _, _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([&closeHandlers, &closeHandlersMutex](
+            string_view uri,
+            function<void()> openHandler,
+            function<void(string_view)> failHandler,
+            function<void(string_view)> closeHandler)
+        {
+            lock_guard<mutex> lock(closeHandlersMutex);
+            closeHandlers[string(uri)] = closeHandler;
+
+            promise<bool> openPromise;
+            openPromise.set_value(true);
+            return openPromise.get_future();
+        }));
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    auto connectedRelays = nostrService->openRelayConnections();
+    ASSERT_EQ(connectedRelays.size(), defaultTestRelays.size());
+
+    // The relay drops the connection.
+    closeHandlers.at(defaultTestRelays[0])("Relay restarting.");
+
+    ASSERT_EQ(nostrService->activeRelays(), vector<string>({ defaultTestRelays[1] }));
+};
+
+TEST_F(NostrServiceBaseTest, OpenRelayConnections_IgnoresClose_AfterServiceIsDestroyed)
+{
+    EXPECT_CALL(*mockClient, isConnected(_)).WillRepeatedly(Return(false));
+
+    mutex closeHandlersMutex;
+    unordered_map<string, function<void(string_view)>> closeHandlers;
+    EXPECT_CALL(*mockClient, openConnection(_, _, _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([&closeHandlers, &closeHandlersMutex](
+            string_view uri,
+            function<void()> openHandler,
+            function<void(string_view)> failHandler,
+            function<void(string_view)> closeHandler)
+        {
+            lock_guard<mutex> lock(closeHandlersMutex);
+            closeHandlers[string(uri)] = closeHandler;
+
+            promise<bool> openPromise;
+            openPromise.set_value(true);
+            return openPromise.get_future();
+        }));
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    nostrService->openRelayConnections();
+    nostrService.reset();
+
+    // The client outlives the service, and reports the close afterwards.
+    closeHandlers.at(defaultTestRelays[0])("Client stopped.");
+};
+
+TEST_F(NostrServiceBaseTest, PublishEvent_ReportsFailure_WhenConnectionClosesBeforeOk)
+{
+    EXPECT_CALL(*mockClient, isConnected(_)).WillRepeatedly(Return(false));
+
+    mutex closeHandlersMutex;
+    unordered_map<string, function<void(string_view)>> closeHandlers;
+    EXPECT_CALL(*mockClient, openConnection(_, _, _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([&closeHandlers, &closeHandlersMutex](
+            string_view uri,
+            function<void()> openHandler,
+            function<void(string_view)> failHandler,
+            function<void(string_view)> closeHandler)
+        {
+            lock_guard<mutex> lock(closeHandlersMutex);
+            closeHandlers[string(uri)] = closeHandler;
+
+            promise<bool> openPromise;
+            openPromise.set_value(true);
+            return openPromise.get_future();
+        }));
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    nostrService->openRelayConnections();
+
+    // The first relay drops the connection instead of answering, and the second accepts.
+    EXPECT_CALL(*mockClient, send(_, _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([&closeHandlers, &closeHandlersMutex](
+            client::SharedPayload message,
+            string_view uri,
+            client::MessageHandler messageHandler)
+        {
+            if (uri == defaultTestRelays[0])
+            {
+                function<void(string_view)> closeHandler;
+                {
+                    lock_guard<mutex> lock(closeHandlersMutex);
+                    closeHandler = closeHandlers.at(string(uri));
+                }
+                closeHandler("Relay restarting.");
+                return true;
+            }
+
+            json messageArr = json::parse(*message);
+            json jarr = json::array({ "OK", messageArr.at(1).at("id"), true, "Event accepted" });
+            messageHandler(jarr.dump());
+            return true;
+        }));
+
+    auto testEvent = make_shared<nostr::data::Event>(getTextNoteTestEvent());
+    auto [successes, failures] = nostrService->publishEvent(testEvent);
+
+    ASSERT_EQ(successes, vector<string>({ defaultTestRelays[1] }));
+    ASSERT_EQ(failures, vector<string>({ defaultTestRelays[0] }));
+};
+
 TEST_F(NostrServiceBaseTest, OpenRelayConnections_OpensConnections_ToProvidedRelays)
 {
     vector<string> testRelays = { "wss://nos.lol" };
@@ -257,13 +504,13 @@ TEST_F(NostrServiceBaseTest, OpenRelayConnections_OpensConnections_ToProvidedRel
     EXPECT_CALL(*mockClient, openConnection(defaultTestRelays[1])).Times(0);
 
     EXPECT_CALL(*mockClient, isConnected(_))
-        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string uri)
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
         {
             lock_guard<mutex> lock(connectionStatusMutex);
-            bool status = connectionStatus->at(uri);
+            bool status = connectionStatus->at(string(uri));
             if (status == false)
             {
-                connectionStatus->at(uri) = true;
+                connectionStatus->at(string(uri)) = true;
             }
             return status;
         }));
@@ -297,13 +544,13 @@ TEST_F(NostrServiceBaseTest, OpenRelayConnections_AddsOpenConnections_ToActiveRe
     EXPECT_CALL(*mockClient, openConnection(testRelays[0])).Times(1);
 
     EXPECT_CALL(*mockClient, isConnected(_))
-        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string uri)
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
         {
             lock_guard<mutex> lock(connectionStatusMutex);
-            bool status = connectionStatus->at(uri);
+            bool status = connectionStatus->at(string(uri));
             if (status == false)
             {
-                connectionStatus->at(uri) = true;
+                connectionStatus->at(string(uri)) = true;
             }
             return status;
         }));
@@ -335,6 +582,39 @@ TEST_F(NostrServiceBaseTest, OpenRelayConnections_AddsOpenConnections_ToActiveRe
     }
 };
 
+TEST_F(NostrServiceBaseTest, OpenRelayConnections_TreatsEquivalentUris_AsOneRelay)
+{
+    vector<string> testRelays = { "WSS://Relay.Damus.io:443/", "wss://relay.damus.io" };
+
+    mutex connectionStatusMutex;
+    auto connectionStatus = make_shared<unordered_map<string, bool>>();
+    connectionStatus->insert({ defaultTestRelays[0], false });
+
+    // Only the normalized URI reaches the client, and only once.
+    EXPECT_CALL(*mockClient, openConnection(defaultTestRelays[0])).Times(1);
+
+    EXPECT_CALL(*mockClient, isConnected(_))
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
+        {
+            lock_guard<mutex> lock(connectionStatusMutex);
+            bool status = connectionStatus->at(string(uri));
+            if (status == false)
+            {
+                connectionStatus->at(string(uri)) = true;
+            }
+            return status;
+        }));
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    auto connectedRelays = nostrService->openRelayConnections(testRelays);
+
+    ASSERT_EQ(connectedRelays, vector<string>({ defaultTestRelays[0] }));
+    ASSERT_EQ(nostrService->activeRelays(), vector<string>({ defaultTestRelays[0] }));
+};
+
 TEST_F(NostrServiceBaseTest, CloseRelayConnections_ClosesConnections_ToActiveRelays)
 {
     mutex connectionStatusMutex;
@@ -343,13 +623,13 @@ TEST_F(NostrServiceBaseTest, CloseRelayConnections_ClosesConnections_ToActiveRel
     connectionStatus->insert({ defaultTestRelays[1], false });
 
     EXPECT_CALL(*mockClient, isConnected(_))
-        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string uri)
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
         {
             lock_guard<mutex> lock(connectionStatusMutex);
-            bool status = connectionStatus->at(uri);
+            bool status = connectionStatus->at(string(uri));
             if (status == false)
             {
-                connectionStatus->at(uri) = true;
+                connectionStatus->at(string(uri)) = true;
             }
             return status;
         }));
@@ -381,13 +661,13 @@ TEST_F(NostrServiceBaseTest, CloseRelayConnections_RemovesClosedConnections_From
     connectionStatus->insert({ testRelays[0], false });
 
     EXPECT_CALL(*mockClient, isConnected(_))
-        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string uri)
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
         {
             lock_guard<mutex> lock(connectionStatusMutex);
-            bool status = connectionStatus->at(uri);
+            bool status = connectionStatus->at(string(uri));
             if (status == false)
             {
-                connectionStatus->at(uri) = true;
+                connectionStatus->at(string(uri)) = true;
             }
             return status;
         }));
@@ -422,13 +702,13 @@ TEST_F(NostrServiceBaseTest, PublishEvent_CorrectlyIndicates_AllSuccesses)
     connectionStatus->insert({ defaultTestRelays[1], false });
 
     EXPECT_CALL(*mockClient, isConnected(_))
-        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string uri)
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
         {
             lock_guard<mutex> lock(connectionStatusMutex);
-            bool status = connectionStatus->at(uri);
+            bool status = connectionStatus->at(string(uri));
             if (status == false)
             {
-                connectionStatus->at(uri) = true;
+                connectionStatus->at(string(uri)) = true;
             }
             return status;
         }));
@@ -441,15 +721,15 @@ TEST_F(NostrServiceBaseTest, PublishEvent_CorrectlyIndicates_AllSuccesses)
 
     EXPECT_CALL(*mockClient, send(_, _, _))
         .Times(2)
-        .WillRepeatedly(Invoke([](string message, string uri, function<void(const string&)> messageHandler)
+        .WillRepeatedly(Invoke([](client::SharedPayload message, string_view uri, client::MessageHandler messageHandler)
         {
-            json messageArr = json::parse(message);
-            auto event = nostr::data::Event::fromString(messageArr[1]);
+            json messageArr = json::parse(*message);
+            auto event = nostr::data::Event::fromJson(messageArr[1]);
 
             json jarr = json::array({ "OK", event.id, true, "Event accepted" });
             messageHandler(jarr.dump());
 
-            return make_tuple(uri, true);
+            return true;
         }));
     
     auto testEvent = make_shared<nostr::data::Event>(getTextNoteTestEvent());
@@ -472,13 +752,13 @@ TEST_F(NostrServiceBaseTest, PublishEvent_CorrectlyIndicates_AllFailures)
     connectionStatus->insert({ defaultTestRelays[1], false });
 
     EXPECT_CALL(*mockClient, isConnected(_))
-        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string uri)
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
         {
             lock_guard<mutex> lock(connectionStatusMutex);
-            bool status = connectionStatus->at(uri);
+            bool status = connectionStatus->at(string(uri));
             if (status == false)
             {
-                connectionStatus->at(uri) = true;
+                connectionStatus->at(string(uri)) = true;
             }
             return status;
         }));
@@ -492,9 +772,9 @@ TEST_F(NostrServiceBaseTest, PublishEvent_CorrectlyIndicates_AllFailures)
     // Simulate a case where the message failed to send to all relays.
     EXPECT_CALL(*mockClient, send(_, _, _))
         .Times(2)
-        .WillRepeatedly(Invoke([](string message, string uri, function<void(const string&)> messageHandler)
+        .WillRepeatedly(Invoke([](client::SharedPayload message, string_view uri, client::MessageHandler messageHandler)
         {
-            return make_tuple(uri, false);
+            return false;
         }));
     
     auto testEvent = make_shared<nostr::data::Event>(getTextNoteTestEvent());
@@ -517,13 +797,13 @@ TEST_F(NostrServiceBaseTest, PublishEvent_CorrectlyIndicates_MixedSuccessesAndFa
     connectionStatus->insert({ defaultTestRelays[1], false });
 
     EXPECT_CALL(*mockClient, isConnected(_))
-        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string uri)
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
         {
             lock_guard<mutex> lock(connectionStatusMutex);
-            bool status = connectionStatus->at(uri);
+            bool status = connectionStatus->at(string(uri));
             if (status == false)
             {
-                connectionStatus->at(uri) = true;
+                connectionStatus->at(string(uri)) = true;
             }
             return status;
         }));
@@ -538,21 +818,21 @@ TEST_F(NostrServiceBaseTest, PublishEvent_CorrectlyIndicates_MixedSuccessesAndFa
     // the other, and the relay accepts it.
     EXPECT_CALL(*mockClient, send(_, defaultTestRelays[0], _))
         .Times(1)
-        .WillRepeatedly(Invoke([](string message, string uri, function<void(const string&)> messageHandler)
+        .WillRepeatedly(Invoke([](client::SharedPayload message, string_view uri, client::MessageHandler messageHandler)
         {
-            return make_tuple(uri, false);
+            return false;
         }));
     EXPECT_CALL(*mockClient, send(_, defaultTestRelays[1], _))
         .Times(1)
-        .WillRepeatedly(Invoke([](string message, string uri, function<void(const string&)> messageHandler)
+        .WillRepeatedly(Invoke([](client::SharedPayload message, string_view uri, client::MessageHandler messageHandler)
         {
-            json messageArr = json::parse(message);
-            auto event = nostr::data::Event::fromString(messageArr[1]);
+            json messageArr = json::parse(*message);
+            auto event = nostr::data::Event::fromJson(messageArr[1]);
 
             json jarr = json::array({ "OK", event.id, true, "Event accepted" });
             messageHandler(jarr.dump());
 
-            return make_tuple(uri, true);
+            return true;
         }));
     
     auto testEvent = make_shared<nostr::data::Event>(getTextNoteTestEvent());
@@ -573,13 +853,13 @@ TEST_F(NostrServiceBaseTest, PublishEvent_CorrectlyIndicates_RejectedEvent)
     connectionStatus->insert({ defaultTestRelays[1], false });
 
     EXPECT_CALL(*mockClient, isConnected(_))
-        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string uri)
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
         {
             lock_guard<mutex> lock(connectionStatusMutex);
-            bool status = connectionStatus->at(uri);
+            bool status = connectionStatus->at(string(uri));
             if (status == false)
             {
-                connectionStatus->at(uri) = true;
+                connectionStatus->at(string(uri)) = true;
             }
             return status;
         }));
@@ -593,15 +873,15 @@ TEST_F(NostrServiceBaseTest, PublishEvent_CorrectlyIndicates_RejectedEvent)
     // Simulate a scenario where the message is rejected by all target relays.
     EXPECT_CALL(*mockClient, send(_, _, _))
         .Times(2)
-        .WillRepeatedly(Invoke([](string message, string uri, function<void(const string&)> messageHandler)
+        .WillRepeatedly(Invoke([](client::SharedPayload message, string_view uri, client::MessageHandler messageHandler)
         {
-            json messageArr = json::parse(message);
-            auto event = nostr::data::Event::fromString(messageArr[1]);
+            json messageArr = json::parse(*message);
+            auto event = nostr::data::Event::fromJson(messageArr[1]);
 
             json jarr = json::array({ "OK", event.id, false, "Event rejected" });
             messageHandler(jarr.dump());
 
-            return make_tuple(uri, true);
+            return true;
         }));
     
     auto testEvent = make_shared<nostr::data::Event>(getTextNoteTestEvent());
@@ -622,13 +902,13 @@ TEST_F(NostrServiceBaseTest, PublishEvent_CorrectlyIndicates_EventRejectedBySome
     connectionStatus->insert({ defaultTestRelays[1], false });
 
     EXPECT_CALL(*mockClient, isConnected(_))
-        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string uri)
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
         {
             lock_guard<mutex> lock(connectionStatusMutex);
-            bool status = connectionStatus->at(uri);
+            bool status = connectionStatus->at(string(uri));
             if (status == false)
             {
-                connectionStatus->at(uri) = true;
+                connectionStatus->at(string(uri)) = true;
             }
             return status;
         }));
@@ -643,27 +923,27 @@ TEST_F(NostrServiceBaseTest, PublishEvent_CorrectlyIndicates_EventRejectedBySome
     // the other, and the relay accepts it.
     EXPECT_CALL(*mockClient, send(_, defaultTestRelays[0], _))
         .Times(1)
-        .WillRepeatedly(Invoke([](string message, string uri, function<void(const string&)> messageHandler)
+        .WillRepeatedly(Invoke([](client::SharedPayload message, string_view uri, client::MessageHandler messageHandler)
         {
-            json messageArr = json::parse(message);
-            auto event = nostr::data::Event::fromString(messageArr[1]);
+            json messageArr = json::parse(*message);
+            auto event = nostr::data::Event::fromJson(messageArr[1]);
 
             json jarr = json::array({ "OK", event.id, true, "Event accepted" });
             messageHandler(jarr.dump());
 
-            return make_tuple(uri, true);
+            return true;
         }));
     EXPECT_CALL(*mockClient, send(_, defaultTestRelays[1], _))
         .Times(1)
-        .WillRepeatedly(Invoke([](string message, string uri, function<void(const string&)> messageHandler)
+        .WillRepeatedly(Invoke([](client::SharedPayload message, string_view uri, client::MessageHandler messageHandler)
         {
-            json messageArr = json::parse(message);
-            auto event = nostr::data::Event::fromString(messageArr[1]);
+            json messageArr = json::parse(*message);
+            auto event = nostr::data::Event::fromJson(messageArr[1]);
 
             json jarr = json::array({ "OK", event.id, false, "Event rejected" });
             messageHandler(jarr.dump());
 
-            return make_tuple(uri, true);
+            return true;
         }));
     
     auto testEvent = make_shared<nostr::data::Event>(getTextNoteTestEvent());
@@ -676,6 +956,178 @@ TEST_F(NostrServiceBaseTest, PublishEvent_CorrectlyIndicates_EventRejectedBySome
     ASSERT_EQ(failures[0], defaultTestRelays[1]);
 };
 
+TEST_F(NostrServiceBaseTest, PublishEvents_SharesOnePayloadPerEvent_AndMatchesAcceptancesById)
+{
+    mutex connectionStatusMutex;
+    auto connectionStatus = make_shared<unordered_map<string, bool>>();
+    connectionStatus->insert({ defaultTestRelays[0], false });
+    connectionStatus->insert({ defaultTestRelays[1], false });
+
+    EXPECT_CALL(*mockClient, isConnected(_))
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
+        {
+            lock_guard<mutex> lock(connectionStatusMutex);
+            bool status = connectionStatus->at(string(uri));
+            if (status == false)
+            {
+                connectionStatus->at(string(uri)) = true;
+            }
+            return status;
+        }));
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    nostrService->openRelayConnections();
+
+    // Every event is sent with the relay's handler.  The second relay rejects the last event.
+    mutex sendMutex;
+    unordered_map<string, set<const string*>> payloadsByEventId;
+    EXPECT_CALL(*mockClient, send(_, _, _))
+        .Times(6)
+        .WillRepeatedly(Invoke([&](client::SharedPayload message, string_view uri, client::MessageHandler messageHandler)
+        {
+            json messageArr = json::parse(*message);
+            EXPECT_TRUE(messageArr.at(1).is_object());
+            auto event = nostr::data::Event::fromJson(messageArr.at(1));
+            {
+                lock_guard<mutex> lock(sendMutex);
+                payloadsByEventId[event.id].insert(message.get());
+            }
+
+            bool isAccepted = uri == defaultTestRelays[0] || event.content != "Time for some introductions!";
+            messageHandler(json::array({ "OK", event.id, isAccepted, "" }).dump());
+            return true;
+        }));
+    EXPECT_CALL(*mockClient, send(_, _)).Times(0);
+
+    vector<shared_ptr<nostr::data::Event>> testEvents;
+    for (auto event : getMultipleTextNoteTestEvents())
+    {
+        testEvents.push_back(make_shared<nostr::data::Event>(event));
+    }
+    auto results = nostrService->publishEvents(testEvents);
+
+    ASSERT_EQ(results.size(), testEvents.size());
+    for (size_t i = 0; i < testEvents.size(); i++)
+    {
+        // Every relay was sent the same buffer for a given event.
+        ASSERT_EQ(payloadsByEventId.at(testEvents[i]->id).size(), 1);
+
+        auto [successes, failures] = results[i];
+        if (i < testEvents.size() - 1)
+        {
+            ASSERT_EQ(successes.size(), defaultTestRelays.size());
+            ASSERT_TRUE(failures.empty());
+        }
+        else
+        {
+            ASSERT_EQ(successes, vector<string>({ defaultTestRelays[0] }));
+            ASSERT_EQ(failures, vector<string>({ defaultTestRelays[1] }));
+        }
+    }
+};
+
+TEST_F(NostrServiceBaseTest, PublishEvents_SendsRepeatedEventOnce_AndSettlesEveryCopy)
+{
+    mutex connectionStatusMutex;
+    auto connectionStatus = make_shared<unordered_map<string, bool>>();
+    connectionStatus->insert({ defaultTestRelays[0], false });
+    connectionStatus->insert({ defaultTestRelays[1], false });
+
+    EXPECT_CALL(*mockClient, isConnected(_))
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
+        {
+            lock_guard<mutex> lock(connectionStatusMutex);
+            bool status = connectionStatus->at(string(uri));
+            if (status == false)
+            {
+                connectionStatus->at(string(uri)) = true;
+            }
+            return status;
+        }));
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    nostrService->openRelayConnections();
+
+    // The event goes to each relay once.  The first relay accepts it, and the second cannot be
+    // sent to.
+    EXPECT_CALL(*mockClient, send(_, _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([](client::SharedPayload message, string_view uri, client::MessageHandler messageHandler)
+        {
+            if (uri == defaultTestRelays[1])
+            {
+                return false;
+            }
+
+            json messageArr = json::parse(*message);
+            auto event = nostr::data::Event::fromJson(messageArr.at(1));
+            messageHandler(json::array({ "OK", event.id, true, "" }).dump());
+            return true;
+        }));
+
+    auto testEvent = make_shared<nostr::data::Event>(getTextNoteTestEvent());
+    auto results = nostrService->publishEvents({ testEvent, testEvent });
+
+    ASSERT_EQ(results.size(), 2);
+    for (auto& [successes, failures] : results)
+    {
+        ASSERT_EQ(successes, vector<string>({ defaultTestRelays[0] }));
+        ASSERT_EQ(failures, vector<string>({ defaultTestRelays[1] }));
+    }
+};
+
+TEST_F(NostrServiceBaseTest, PublishEvent_ReportsFailure_WhenRelayDoesNotAnswerInTime)
+{
+    mutex connectionStatusMutex;
+    auto connectionStatus = make_shared<unordered_map<string, bool>>();
+    connectionStatus->insert({ defaultTestRelays[0], false });
+    connectionStatus->insert({ defaultTestRelays[1], false });
+
+    EXPECT_CALL(*mockClient, isConnected(_))
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
+        {
+            lock_guard<mutex> lock(connectionStatusMutex);
+            bool status = connectionStatus->at(string(uri));
+            if (status == false)
+            {
+                connectionStatus->at(string(uri)) = true;
+            }
+            return status;
+        }));
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    nostrService->openRelayConnections();
+    nostrService->setConnectionTimeout(chrono::milliseconds(100));
+
+    // The first relay never answers.
+    EXPECT_CALL(*mockClient, send(_, _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([](client::SharedPayload message, string_view uri, client::MessageHandler messageHandler)
+        {
+            if (uri != defaultTestRelays[0])
+            {
+                json messageArr = json::parse(*message);
+                messageHandler(json::array({ "OK", messageArr.at(1).at("id"), true, "" }).dump());
+            }
+            return true;
+        }));
+
+    auto testEvent = make_shared<nostr::data::Event>(getTextNoteTestEvent());
+    auto [successes, failures] = nostrService->publishEvent(testEvent);
+
+    ASSERT_EQ(successes, vector<string>({ defaultTestRelays[1] }));
+    ASSERT_EQ(failures, vector<string>({ defaultTestRelays[0] }));
+};
+
 TEST_F(NostrServiceBaseTest, QueryRelays_ReturnsEvents_UpToEOSE)
 {
     mutex connectionStatusMutex;
@@ -684,13 +1136,13 @@ TEST_F(NostrServiceBaseTest, QueryRelays_ReturnsEvents_UpToEOSE)
     connectionStatus->insert({ defaultTestRelays[1], false });
 
     EXPECT_CALL(*mockClient, isConnected(_))
-        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string uri)
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
         {
             lock_guard<mutex> lock(connectionStatusMutex);
-            bool status = connectionStatus->at(uri);
+            bool status = connectionStatus->at(string(uri));
             if (status == false)
             {
-                connectionStatus->at(uri) = true;
+                connectionStatus->at(string(uri)) = true;
             }
             return status;
         }));
@@ -714,14 +1166,14 @@ TEST_F(NostrServiceBaseTest, QueryRelays_ReturnsEvents_UpToEOSE)
     }
 
     // Expect the query messages.
-    EXPECT_CALL(*mockClient, send(HasSubstr("REQ"), _, _))
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("REQ")), _, _))
         .Times(2)
         .WillRepeatedly(Invoke([&testEvents](
-            string message,
-            string uri,
-            function<void(const string&)> messageHandler)
+            client::SharedPayload message,
+            string_view uri,
+            client::MessageHandler messageHandler)
         {
-            json messageArr = json::parse(message);
+            json messageArr = json::parse(*message);
             string subscriptionId = messageArr.at(1);
 
             for (auto event : testEvents)
@@ -734,14 +1186,14 @@ TEST_F(NostrServiceBaseTest, QueryRelays_ReturnsEvents_UpToEOSE)
             json jarr = json::array({ "EOSE", subscriptionId });
             messageHandler(jarr.dump());
 
-            return make_tuple(uri, true);
+            return true;
         }));
     // Expect the close subscription messages after the client receives events.
-    EXPECT_CALL(*mockClient, send(HasSubstr("CLOSE"), _))
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("CLOSE")), _))
         .Times(2)
-        .WillRepeatedly(Invoke([](string message, string uri)
+        .WillRepeatedly(Invoke([](client::SharedPayload message, string_view uri)
         {
-            return make_tuple(uri, true);
+            return true;
         }));
 
     auto filters = make_shared<nostr::data::Filters>(getKind0And1TestFilters());
@@ -768,7 +1220,7 @@ TEST_F(NostrServiceBaseTest, QueryRelays_ReturnsEvents_UpToEOSE)
     ASSERT_TRUE(subscriptions.empty());
 };
 
-TEST_F(NostrServiceBaseTest, QueryRelays_CallsHandler_WithReturnedEvents)
+TEST_F(NostrServiceBaseTest, QueryRelays_IgnoresRepeatedAndLateMessages)
 {
     mutex connectionStatusMutex;
     auto connectionStatus = make_shared<unordered_map<string, bool>>();
@@ -776,13 +1228,13 @@ TEST_F(NostrServiceBaseTest, QueryRelays_CallsHandler_WithReturnedEvents)
     connectionStatus->insert({ defaultTestRelays[1], false });
 
     EXPECT_CALL(*mockClient, isConnected(_))
-        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string uri)
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
         {
             lock_guard<mutex> lock(connectionStatusMutex);
-            bool status = connectionStatus->at(uri);
+            bool status = connectionStatus->at(string(uri));
             if (status == false)
             {
-                connectionStatus->at(uri) = true;
+                connectionStatus->at(string(uri)) = true;
             }
             return status;
         }));
@@ -794,42 +1246,345 @@ TEST_F(NostrServiceBaseTest, QueryRelays_CallsHandler_WithReturnedEvents)
     nostrService->openRelayConnections();
 
     auto testEvents = getMultipleTextNoteTestEvents();
-    vector<shared_ptr<nostr::data::Event>> sendableTestEvents;
-    for (nostr::data::Event testEvent : testEvents)
-    {
-        auto event = make_shared<nostr::data::Event>(testEvent);
-        auto serializedEvent = event->serialize();
-        auto deserializedEvent = nostr::data::Event::fromString(serializedEvent);
-
-        event = make_shared<nostr::data::Event>(deserializedEvent);
-        sendableTestEvents.push_back(event);
-    }
+    mutex handlerMutex;
+    vector<tuple<string, client::MessageHandler>> messageHandlers;
 
-    EXPECT_CALL(*mockClient, send(HasSubstr("REQ"), _, _))
+    // Each relay ends the query twice, and then closes it as well.
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("REQ")), _, _))
         .Times(2)
-        .WillRepeatedly(Invoke([&testEvents](
-            string message,
-            string uri,
-            function<void(const string&)> messageHandler)
+        .WillRepeatedly(Invoke([&testEvents, &handlerMutex, &messageHandlers](
+            client::SharedPayload message,
+            string_view uri,
+            client::MessageHandler messageHandler)
         {
-            json messageArr = json::parse(message);
+            json messageArr = json::parse(*message);
             string subscriptionId = messageArr.at(1);
+            {
+                lock_guard<mutex> lock(handlerMutex);
+                messageHandlers.emplace_back(subscriptionId, messageHandler);
+            }
 
             for (auto event : testEvents)
             {
                 auto sendableEvent = make_shared<nostr::data::Event>(event);
-                json jarr = json::array({ "EVENT", subscriptionId, sendableEvent->serialize() });
-                messageHandler(jarr.dump());
+                messageHandler(json::array({ "EVENT", subscriptionId, sendableEvent->serialize() }).dump());
             }
+            messageHandler(json::array({ "EOSE", subscriptionId }).dump());
+            messageHandler(json::array({ "EOSE", subscriptionId }).dump());
+            messageHandler(json::array({ "CLOSED", subscriptionId, "error: shutting down" }).dump());
 
-            json jarr = json::array({ "EOSE", subscriptionId });
-            messageHandler(jarr.dump());
-
-            return make_tuple(uri, true);
+            return true;
         }));
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("CLOSE")), _))
+        .Times(2)
+        .WillRepeatedly(Return(true));
 
     auto filters = make_shared<nostr::data::Filters>(getKind0And1TestFilters());
-    promise<void> eoseReceivedPromise;
+    auto results = nostrService->queryRelays(filters).get();
+    ASSERT_EQ(results.size(), testEvents.size());
+
+    // An event that arrives after the query has returned is dropped.
+    auto lateEvent = make_shared<nostr::data::Event>(getTextNoteTestEvent());
+    for (auto& [subscriptionId, messageHandler] : messageHandlers)
+    {
+        messageHandler(json::array({ "EVENT", subscriptionId, lateEvent->serialize() }).dump());
+    }
+    ASSERT_EQ(results.size(), testEvents.size());
+};
+
+TEST_F(NostrServiceBaseTest, QueryRelays_ReturnsEvents_WhenOneRelayClosesTheSubscription)
+{
+    mutex connectionStatusMutex;
+    auto connectionStatus = make_shared<unordered_map<string, bool>>();
+    connectionStatus->insert({ defaultTestRelays[0], false });
+    connectionStatus->insert({ defaultTestRelays[1], false });
+
+    EXPECT_CALL(*mockClient, isConnected(_))
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
+        {
+            lock_guard<mutex> lock(connectionStatusMutex);
+            bool status = connectionStatus->at(string(uri));
+            if (status == false)
+            {
+                connectionStatus->at(string(uri)) = true;
+            }
+            return status;
+        }));
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    nostrService->openRelayConnections();
+
+    auto testEvents = getMultipleTextNoteTestEvents();
+
+    // The first relay serves the query, and the second refuses it.
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("REQ")), _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([&testEvents](
+            client::SharedPayload message,
+            string_view uri,
+            client::MessageHandler messageHandler)
+        {
+            json messageArr = json::parse(*message);
+            string subscriptionId = messageArr.at(1);
+
+            if (uri == defaultTestRelays[1])
+            {
+                messageHandler(json::array({ "CLOSED", subscriptionId, "restricted: no queries" }).dump());
+                return true;
+            }
+
+            for (auto event : testEvents)
+            {
+                auto sendableEvent = make_shared<nostr::data::Event>(event);
+                messageHandler(json::array({ "EVENT", subscriptionId, sendableEvent->serialize() }).dump());
+            }
+            messageHandler(json::array({ "EOSE", subscriptionId }).dump());
+
+            return true;
+        }));
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("CLOSE")), _))
+        .WillRepeatedly(Return(true));
+
+    // A relay that closes one subscription keeps its connection.
+    EXPECT_CALL(*mockClient, closeConnection(_)).Times(0);
+
+    auto filters = make_shared<nostr::data::Filters>(getKind0And1TestFilters());
+    auto results = nostrService->queryRelays(filters).get();
+    ASSERT_EQ(results.size(), testEvents.size());
+
+    auto activeRelays = nostrService->activeRelays();
+    ASSERT_EQ(activeRelays.size(), defaultTestRelays.size());
+};
+
+TEST_F(NostrServiceBaseTest, QueryRelays_ReturnsEvents_EmbeddedAsObjects)
+{
+    mutex connectionStatusMutex;
+    auto connectionStatus = make_shared<unordered_map<string, bool>>();
+    connectionStatus->insert({ defaultTestRelays[0], false });
+    connectionStatus->insert({ defaultTestRelays[1], false });
+
+    EXPECT_CALL(*mockClient, isConnected(_))
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
+        {
+            lock_guard<mutex> lock(connectionStatusMutex);
+            bool status = connectionStatus->at(string(uri));
+            if (status == false)
+            {
+                connectionStatus->at(string(uri)) = true;
+            }
+            return status;
+        }));
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    nostrService->openRelayConnections();
+
+    auto testEvents = getMultipleTextNoteTestEvents();
+
+    // NIP-01 relays embed each event as a JSON object.
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("REQ")), _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([&testEvents](
+            client::SharedPayload message,
+            string_view uri,
+            client::MessageHandler messageHandler)
+        {
+            json messageArr = json::parse(*message);
+            string subscriptionId = messageArr.at(1);
+
+            for (auto event : testEvents)
+            {
+                auto sendableEvent = make_shared<nostr::data::Event>(event);
+                json jEvent = json::parse(sendableEvent->serialize());
+                json jarr = json::array({ "EVENT", subscriptionId, jEvent });
+                messageHandler(jarr.dump());
+            }
+
+            json jarr = json::array({ "EOSE", subscriptionId });
+            messageHandler(jarr.dump());
+
+            return true;
+        }));
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("CLOSE")), _))
+        .Times(2)
+        .WillRepeatedly(Invoke([](client::SharedPayload message, string_view uri)
+        {
+            return true;
+        }));
+
+    auto filters = make_shared<nostr::data::Filters>(getKind0And1TestFilters());
+    auto results = nostrService->queryRelays(filters).get();
+
+    ASSERT_EQ(results.size(), testEvents.size());
+    for (auto resultEvent : results)
+    {
+        ASSERT_NE(
+            find_if(
+                testEvents.begin(),
+                testEvents.end(),
+                [&resultEvent](const nostr::data::Event& testEvent)
+                {
+                    return testEvent.content == resultEvent->content;
+                }),
+            testEvents.end());
+    }
+};
+
+TEST_F(NostrServiceBaseTest, QueryRelays_DropsUnverifiedEvents_WhenVerificationIsEnabled)
+{
+    mutex connectionStatusMutex;
+    auto connectionStatus = make_shared<unordered_map<string, bool>>();
+    connectionStatus->insert({ defaultTestRelays[0], false });
+    connectionStatus->insert({ defaultTestRelays[1], false });
+
+    EXPECT_CALL(*mockClient, isConnected(_))
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
+        {
+            lock_guard<mutex> lock(connectionStatusMutex);
+            bool status = connectionStatus->at(string(uri));
+            if (status == false)
+            {
+                connectionStatus->at(string(uri)) = true;
+            }
+            return status;
+        }));
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    nostrService->setEventVerification(true);
+    nostrService->openRelayConnections();
+
+    // An event signed with the secret key 0x03.
+    nostr::data::Event signedEvent;
+    signedEvent.id = "60705943cb13597e94afa0b4658d58573963db7eca0c06c5de1825e206a759bd";
+    signedEvent.pubkey = "f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9";
+    signedEvent.createdAt = 1700000000;
+    signedEvent.kind = 1;
+    signedEvent.tags = { { "t", "aedile" } };
+    signedEvent.content = "Verified hello from aedile.";
+    signedEvent.sig = "fcbb45d92e962398f430c19dca685df9af104245848cef4b222da67f4d278271"
+                      "44770021e01473d18628151e670ddcb48bf258c03ec6e3feac21ed0ae40a2ff7";
+
+    nostr::data::Event forgedEvent = signedEvent;
+    forgedEvent.content = "Forged hello from aedile.";
+
+    auto testEvents = getMultipleTextNoteTestEvents();
+
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("REQ")), _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([&testEvents, &signedEvent, &forgedEvent](
+            client::SharedPayload message,
+            string_view uri,
+            client::MessageHandler messageHandler)
+        {
+            json messageArr = json::parse(*message);
+            string subscriptionId = messageArr.at(1);
+
+            // Unsigned events, a forged copy, and the genuine event.
+            for (auto event : testEvents)
+            {
+                auto sendableEvent = make_shared<nostr::data::Event>(event);
+                json jarr = json::array({ "EVENT", subscriptionId, sendableEvent->serialize() });
+                messageHandler(jarr.dump());
+            }
+            json forgedArr = json::array({ "EVENT", subscriptionId, json(forgedEvent).dump() });
+            messageHandler(forgedArr.dump());
+            json signedArr = json::array({ "EVENT", subscriptionId, json(signedEvent).dump() });
+            messageHandler(signedArr.dump());
+
+            json jarr = json::array({ "EOSE", subscriptionId });
+            messageHandler(jarr.dump());
+
+            return true;
+        }));
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("CLOSE")), _))
+        .Times(2)
+        .WillRepeatedly(Invoke([](client::SharedPayload message, string_view uri)
+        {
+            return true;
+        }));
+
+    auto filters = make_shared<nostr::data::Filters>(getKind0And1TestFilters());
+    auto results = nostrService->queryRelays(filters).get();
+
+    // Only one copy of the genuine event survives verification.
+    ASSERT_EQ(results.size(), 1);
+    ASSERT_EQ(*results[0], signedEvent);
+
+    auto stats = nostrService->verificationStats();
+    ASSERT_EQ(stats.verified, 2);
+    ASSERT_EQ(stats.rejected, 2 * (testEvents.size() + 1));
+};
+
+TEST_F(NostrServiceBaseTest, QueryRelays_CallsHandler_WithReturnedEvents)
+{
+    mutex connectionStatusMutex;
+    auto connectionStatus = make_shared<unordered_map<string, bool>>();
+    connectionStatus->insert({ defaultTestRelays[0], false });
+    connectionStatus->insert({ defaultTestRelays[1], false });
+
+    EXPECT_CALL(*mockClient, isConnected(_))
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
+        {
+            lock_guard<mutex> lock(connectionStatusMutex);
+            bool status = connectionStatus->at(string(uri));
+            if (status == false)
+            {
+                connectionStatus->at(string(uri)) = true;
+            }
+            return status;
+        }));
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    nostrService->openRelayConnections();
+
+    auto testEvents = getMultipleTextNoteTestEvents();
+    vector<shared_ptr<nostr::data::Event>> sendableTestEvents;
+    for (nostr::data::Event testEvent : testEvents)
+    {
+        auto event = make_shared<nostr::data::Event>(testEvent);
+        auto serializedEvent = event->serialize();
+        auto deserializedEvent = nostr::data::Event::fromString(serializedEvent);
+
+        event = make_shared<nostr::data::Event>(deserializedEvent);
+        sendableTestEvents.push_back(event);
+    }
+
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("REQ")), _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([&testEvents](
+            client::SharedPayload message,
+            string_view uri,
+            client::MessageHandler messageHandler)
+        {
+            json messageArr = json::parse(*message);
+            string subscriptionId = messageArr.at(1);
+
+            for (auto event : testEvents)
+            {
+                auto sendableEvent = make_shared<nostr::data::Event>(event);
+                json jarr = json::array({ "EVENT", subscriptionId, sendableEvent->serialize() });
+                messageHandler(jarr.dump());
+            }
+
+            json jarr = json::array({ "EOSE", subscriptionId });
+            messageHandler(jarr.dump());
+
+            return true;
+        }));
+
+    auto filters = make_shared<nostr::data::Filters>(getKind0And1TestFilters());
+    promise<void> eoseReceivedPromise;
     auto eoseReceivedFuture = eoseReceivedPromise.get_future();
     int eoseCount = 0;
 
@@ -867,11 +1622,11 @@ TEST_F(NostrServiceBaseTest, QueryRelays_CallsHandler_WithReturnedEvents)
     ASSERT_NO_THROW(subscriptions.at(generatedSubscriptionId));
     ASSERT_EQ(subscriptions.at(generatedSubscriptionId).size(), 2);
 
-    EXPECT_CALL(*mockClient, send(HasSubstr("CLOSE"), _))
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("CLOSE")), _))
         .Times(2)
-        .WillRepeatedly(Invoke([](string message, string uri)
+        .WillRepeatedly(Invoke([](client::SharedPayload message, string_view uri)
         {
-            return make_tuple(uri, true);
+            return true;
         }));
 
     auto [successes, failures] = nostrService->closeSubscription(generatedSubscriptionId);
@@ -883,6 +1638,261 @@ TEST_F(NostrServiceBaseTest, QueryRelays_CallsHandler_WithReturnedEvents)
     ASSERT_TRUE(subscriptions.empty());
 };
 
+TEST_F(NostrServiceBaseTest, QueryRelays_KeepsReceiving_AfterPublishOnTheSameRelays)
+{
+    mutex connectionStatusMutex;
+    auto connectionStatus = make_shared<unordered_map<string, bool>>();
+    connectionStatus->insert({ defaultTestRelays[0], false });
+    connectionStatus->insert({ defaultTestRelays[1], false });
+
+    EXPECT_CALL(*mockClient, isConnected(_))
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
+        {
+            lock_guard<mutex> lock(connectionStatusMutex);
+            bool status = connectionStatus->at(string(uri));
+            if (status == false)
+            {
+                connectionStatus->at(string(uri)) = true;
+            }
+            return status;
+        }));
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    nostrService->openRelayConnections();
+
+    // Like a real connection, each relay keeps only the handler of the latest send.
+    mutex handlerMutex;
+    unordered_map<string, client::MessageHandler> relayHandlers;
+    EXPECT_CALL(*mockClient, send(_, _, _))
+        .WillRepeatedly(Invoke([&handlerMutex, &relayHandlers](
+            client::SharedPayload message,
+            string_view uri,
+            client::MessageHandler messageHandler)
+        {
+            {
+                lock_guard<mutex> lock(handlerMutex);
+                relayHandlers[string(uri)] = messageHandler;
+            }
+
+            json messageArr = json::parse(*message);
+            if (messageArr.at(0) == "EVENT")
+            {
+                json jarr = json::array({ "OK", messageArr.at(1).at("id"), true, "Event accepted" });
+                messageHandler(jarr.dump());
+            }
+            return true;
+        }));
+
+    atomic<int> eventCount = 0;
+    promise<void> eoseReceivedPromise;
+    auto eoseReceivedFuture = eoseReceivedPromise.get_future();
+    atomic<int> eoseCount = 0;
+
+    auto filters = make_shared<nostr::data::Filters>(getKind0And1TestFilters());
+    string subscriptionId = nostrService->queryRelays(
+        filters,
+        [&eventCount](const string&, shared_ptr<nostr::data::Event>) { eventCount++; },
+        [&eoseReceivedPromise, &eoseCount](const string&)
+        {
+            if (++eoseCount == 2)
+            {
+                eoseReceivedPromise.set_value();
+            }
+        },
+        [](const string&, const string&) {});
+
+    // The publish replaces each relay's handler while the query is still open.
+    auto testEvent = make_shared<nostr::data::Event>(getTextNoteTestEvent());
+    auto [successes, failures] = nostrService->publishEvent(testEvent);
+    ASSERT_EQ(successes.size(), defaultTestRelays.size());
+
+    auto sendableEvent = make_shared<nostr::data::Event>(getTextNoteTestEvent());
+    for (const string& relay : defaultTestRelays)
+    {
+        client::MessageHandler messageHandler;
+        {
+            lock_guard<mutex> lock(handlerMutex);
+            messageHandler = relayHandlers.at(relay);
+        }
+        messageHandler(json::array({ "EVENT", subscriptionId, sendableEvent->serialize() }).dump());
+        messageHandler(json::array({ "EOSE", subscriptionId }).dump());
+    }
+
+    ASSERT_EQ(eoseReceivedFuture.wait_for(chrono::seconds(5)), future_status::ready);
+    ASSERT_EQ(eventCount.load(), 2);
+};
+
+TEST_F(NostrServiceBaseTest, QueryRelays_DropsMalformedMessages_WithoutThrowing)
+{
+    mutex connectionStatusMutex;
+    auto connectionStatus = make_shared<unordered_map<string, bool>>();
+    connectionStatus->insert({ defaultTestRelays[0], false });
+    connectionStatus->insert({ defaultTestRelays[1], false });
+
+    EXPECT_CALL(*mockClient, isConnected(_))
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
+        {
+            lock_guard<mutex> lock(connectionStatusMutex);
+            bool status = connectionStatus->at(string(uri));
+            if (status == false)
+            {
+                connectionStatus->at(string(uri)) = true;
+            }
+            return status;
+        }));
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    nostrService->openRelayConnections();
+
+    // Each relay sends an event without a signature and a truncated frame before its EOSE.
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("REQ")), _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([](
+            client::SharedPayload message,
+            string_view uri,
+            client::MessageHandler messageHandler)
+        {
+            json messageArr = json::parse(*message);
+            string subscriptionId = messageArr.at(1);
+
+            json unsignedEvent = json::parse(make_shared<nostr::data::Event>(getTextNoteTestEvent())->serialize());
+            unsignedEvent.erase("sig");
+            EXPECT_NO_THROW(messageHandler(json::array({ "EVENT", subscriptionId, unsignedEvent }).dump()));
+            EXPECT_NO_THROW(messageHandler("[\"EVENT\",\"" + subscriptionId + "\""));
+            messageHandler(json::array({ "EOSE", subscriptionId }).dump());
+
+            return true;
+        }));
+
+    atomic<int> eventCount = 0;
+    atomic<int> eoseCount = 0;
+    nostrService->queryRelays(
+        make_shared<nostr::data::Filters>(getKind0And1TestFilters()),
+        [&eventCount](const string&, shared_ptr<nostr::data::Event>) { eventCount++; },
+        [&eoseCount](const string&) { eoseCount++; },
+        [](const string&, const string&) {});
+
+    ASSERT_EQ(eventCount.load(), 0);
+    ASSERT_EQ(eoseCount.load(), 2);
+};
+
+TEST_F(NostrServiceBaseTest, CloseSubscription_ForgetsVerificationFlag_WhenSomeClosesFail)
+{
+    mutex connectionStatusMutex;
+    auto connectionStatus = make_shared<unordered_map<string, bool>>();
+    connectionStatus->insert({ defaultTestRelays[0], false });
+    connectionStatus->insert({ defaultTestRelays[1], false });
+
+    EXPECT_CALL(*mockClient, isConnected(_))
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
+        {
+            lock_guard<mutex> lock(connectionStatusMutex);
+            bool status = connectionStatus->at(string(uri));
+            if (status == false)
+            {
+                connectionStatus->at(string(uri)) = true;
+            }
+            return status;
+        }));
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    nostrService->openRelayConnections();
+
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("REQ")), _, _))
+        .Times(2)
+        .WillRepeatedly(Return(true));
+
+    auto filters = make_shared<nostr::data::Filters>(getKind0And1TestFilters());
+    string subscriptionId = nostrService->queryRelays(
+        filters,
+        [](const string&, shared_ptr<nostr::data::Event>) {},
+        [](const string&) {},
+        [](const string&, const string&) {});
+    ASSERT_TRUE(nostrService->setEventVerification(subscriptionId, true));
+
+    // The second relay never receives the CLOSE message.
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("CLOSE")), defaultTestRelays[0]))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("CLOSE")), defaultTestRelays[1]))
+        .WillOnce(Return(false));
+
+    auto [successes, failures] = nostrService->closeSubscription(subscriptionId);
+    ASSERT_EQ(successes, vector<string>({ defaultTestRelays[0] }));
+    ASSERT_EQ(failures, vector<string>({ defaultTestRelays[1] }));
+
+    ASSERT_FALSE(nostrService->setEventVerification(subscriptionId, false));
+};
+
+TEST_F(NostrServiceBaseTest, CloseSubscription_StopsDelivery_WhenSomeClosesFail)
+{
+    mutex connectionStatusMutex;
+    auto connectionStatus = make_shared<unordered_map<string, bool>>();
+    connectionStatus->insert({ defaultTestRelays[0], false });
+    connectionStatus->insert({ defaultTestRelays[1], false });
+
+    EXPECT_CALL(*mockClient, isConnected(_))
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
+        {
+            lock_guard<mutex> lock(connectionStatusMutex);
+            bool status = connectionStatus->at(string(uri));
+            if (status == false)
+            {
+                connectionStatus->at(string(uri)) = true;
+            }
+            return status;
+        }));
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    nostrService->openRelayConnections();
+
+    mutex handlerMutex;
+    unordered_map<string, client::MessageHandler> messageHandlers;
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("REQ")), _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([&handlerMutex, &messageHandlers](
+            client::SharedPayload,
+            string_view uri,
+            client::MessageHandler messageHandler)
+        {
+            lock_guard<mutex> lock(handlerMutex);
+            messageHandlers[string(uri)] = messageHandler;
+            return true;
+        }));
+
+    atomic<int> eventCount = 0;
+    auto filters = make_shared<nostr::data::Filters>(getKind0And1TestFilters());
+    string subscriptionId = nostrService->queryRelays(
+        filters,
+        [&eventCount](const string&, shared_ptr<nostr::data::Event>) { eventCount++; },
+        [](const string&) {},
+        [](const string&, const string&) {});
+
+    // The second relay never receives the CLOSE message, and keeps sending events.
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("CLOSE")), defaultTestRelays[0]))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("CLOSE")), defaultTestRelays[1]))
+        .WillOnce(Return(false));
+    nostrService->closeSubscription(subscriptionId);
+
+    auto lateEvent = make_shared<nostr::data::Event>(getTextNoteTestEvent());
+    messageHandlers.at(defaultTestRelays[1])(
+        json::array({ "EVENT", subscriptionId, lateEvent->serialize() }).dump());
+
+    ASSERT_EQ(eventCount.load(), 0);
+};
+
 TEST_F(NostrServiceBaseTest, Service_MaintainsMultipleSubscriptions_ThenClosesAll)
 {
     // Mock connections.
@@ -892,13 +1902,13 @@ TEST_F(NostrServiceBaseTest, Service_MaintainsMultipleSubscriptions_ThenClosesAl
     connectionStatus->insert({ testRelays[0], false });
 
     EXPECT_CALL(*mockClient, isConnected(_))
-        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string uri)
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
         {
             lock_guard<mutex> lock(connectionStatusMutex);
-            bool status = connectionStatus->at(uri);
+            bool status = connectionStatus->at(string(uri));
             if (status == false)
             {
-                connectionStatus->at(uri) = true;
+                connectionStatus->at(string(uri)) = true;
             }
             return status;
         }));
@@ -923,14 +1933,14 @@ TEST_F(NostrServiceBaseTest, Service_MaintainsMultipleSubscriptions_ThenClosesAl
     }
 
     vector<string> subscriptionIds;
-    EXPECT_CALL(*mockClient, send(HasSubstr("REQ"), _, _))
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("REQ")), _, _))
         .Times(2)
         .WillOnce(Invoke([&testEvents, &subscriptionIds](
-            string message,
-            string uri,
-            function<void(const string&)> messageHandler)
+            client::SharedPayload message,
+            string_view uri,
+            client::MessageHandler messageHandler)
         {
-            json messageArr = json::parse(message);
+            json messageArr = json::parse(*message);
             subscriptionIds.push_back(messageArr.at(1));
 
             for (auto event : testEvents)
@@ -943,14 +1953,14 @@ TEST_F(NostrServiceBaseTest, Service_MaintainsMultipleSubscriptions_ThenClosesAl
             json jarr = json::array({ "EOSE", subscriptionIds.at(0), });
             messageHandler(jarr.dump());
 
-            return make_tuple(uri, true);
+            return true;
         }))
         .WillOnce(Invoke([&testEvents, &subscriptionIds](
-            string message,
-            string uri,
-            function<void(const string&)> messageHandler)
+            client::SharedPayload message,
+            string_view uri,
+            client::MessageHandler messageHandler)
         {
-            json messageArr = json::parse(message);
+            json messageArr = json::parse(*message);
             subscriptionIds.push_back(messageArr.at(1));
 
             for (auto event : testEvents)
@@ -963,7 +1973,7 @@ TEST_F(NostrServiceBaseTest, Service_MaintainsMultipleSubscriptions_ThenClosesAl
             json jarr = json::array({ "EOSE", subscriptionIds.at(1), });
             messageHandler(jarr.dump());
 
-            return make_tuple(uri, true);
+            return true;
         }));
 
     // Send queries.
@@ -1030,11 +2040,11 @@ TEST_F(NostrServiceBaseTest, Service_MaintainsMultipleSubscriptions_ThenClosesAl
     ASSERT_EQ(subscriptions.at(longFormSubscriptionId).size(), 1);
 
     // Mock the relay response for closing subscriptions.
-    EXPECT_CALL(*mockClient, send(HasSubstr("CLOSE"), _))
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("CLOSE")), _))
         .Times(2)
-        .WillRepeatedly(Invoke([](string message, string uri)
+        .WillRepeatedly(Invoke([](client::SharedPayload message, string_view uri)
         {
-            return make_tuple(uri, true);
+            return true;
         }));
 
     // Close all subscriptions maintained by the service.
@@ -1045,4 +2055,234 @@ TEST_F(NostrServiceBaseTest, Service_MaintainsMultipleSubscriptions_ThenClosesAl
     subscriptions = nostrService->subscriptions();
     ASSERT_TRUE(subscriptions.empty());
 };
+
+TEST_F(NostrServiceBaseTest, Metrics_CountTrafficAndLatencies_PerRelay)
+{
+    mutex connectionStatusMutex;
+    auto connectionStatus = make_shared<unordered_map<string, bool>>();
+    connectionStatus->insert({ defaultTestRelays[0], false });
+    connectionStatus->insert({ defaultTestRelays[1], false });
+
+    EXPECT_CALL(*mockClient, isConnected(_))
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
+        {
+            lock_guard<mutex> lock(connectionStatusMutex);
+            bool status = connectionStatus->at(string(uri));
+            if (status == false)
+            {
+                connectionStatus->at(string(uri)) = true;
+            }
+            return status;
+        }));
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    nostrService->openRelayConnections();
+
+    auto testEvents = getMultipleTextNoteTestEvents();
+
+    // Each relay accepts the published event, and answers the query with every test event.
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("EVENT")), _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([](client::SharedPayload message, string_view uri, client::MessageHandler messageHandler)
+        {
+            json messageArr = json::parse(*message);
+            auto event = nostr::data::Event::fromJson(messageArr[1]);
+
+            json jarr = json::array({ "OK", event.id, true, "Event accepted" });
+            messageHandler(jarr.dump());
+
+            return true;
+        }));
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("REQ")), _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([&testEvents](
+            client::SharedPayload message,
+            string_view uri,
+            client::MessageHandler messageHandler)
+        {
+            json messageArr = json::parse(*message);
+            string subscriptionId = messageArr.at(1);
+
+            for (auto event : testEvents)
+            {
+                auto sendableEvent = make_shared<nostr::data::Event>(event);
+                json jarr = json::array({ "EVENT", subscriptionId, sendableEvent->serialize() });
+                messageHandler(jarr.dump());
+            }
+
+            json jarr = json::array({ "EOSE", subscriptionId });
+            messageHandler(jarr.dump());
+
+            return true;
+        }));
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("CLOSE")), _))
+        .Times(2)
+        .WillRepeatedly(Invoke([](client::SharedPayload message, string_view uri)
+        {
+            return true;
+        }));
+
+    auto testEvent = make_shared<nostr::data::Event>(getTextNoteTestEvent());
+    nostrService->publishEvent(testEvent);
+
+    auto filters = make_shared<nostr::data::Filters>(getKind0And1TestFilters());
+    nostrService->queryRelays(filters).get();
+
+    auto metrics = nostrService->metrics();
+    ASSERT_EQ(metrics.relays.size(), defaultTestRelays.size());
+    ASSERT_EQ(metrics.activeRelays, defaultTestRelays.size());
+    ASSERT_EQ(metrics.activeSubscriptions, 0);
+    ASSERT_EQ(metrics.parseTime.count, testEvents.size() * defaultTestRelays.size());
+
+    for (const auto& relay : metrics.relays)
+    {
+        ASSERT_NE(find(defaultTestRelays.begin(), defaultTestRelays.end(), relay.relay), defaultTestRelays.end());
+
+        // The EVENT, REQ, and CLOSE messages go out; one OK, the events, and one EOSE come back.
+        ASSERT_EQ(relay.messagesOut, 3);
+        ASSERT_EQ(relay.messagesIn, 1 + testEvents.size() + 1);
+        ASSERT_GT(relay.bytesOut, 0);
+        ASSERT_GT(relay.bytesIn, 0);
+        ASSERT_EQ(relay.connects, 1);
+        ASSERT_EQ(relay.reconnects, 0);
+        ASSERT_EQ(relay.okLatency.count, 1);
+        ASSERT_EQ(relay.eoseLatency.count, 1);
+        ASSERT_LE(relay.eoseLatency.p50, relay.eoseLatency.max);
+    }
+
+    string text = metrics.toPrometheusText();
+    ASSERT_NE(text.find("aedile_relay_messages_sent_total{relay=\"" + defaultTestRelays[0] + "\"} 3"), string::npos);
+    ASSERT_NE(text.find("aedile_relay_ok_latency_seconds_count{relay=\"" + defaultTestRelays[1] + "\"} 1"), string::npos);
+};
+
+TEST_F(NostrServiceBaseTest, Metrics_ReportOutboundQueueDepth_FromClient)
+{
+    EXPECT_CALL(*mockClient, isConnected(_)).WillRepeatedly(Return(false));
+    EXPECT_CALL(*mockClient, openConnection(_, _, _, _))
+        .WillRepeatedly(Invoke([](
+            string_view uri,
+            function<void()>,
+            function<void(string_view)>,
+            function<void(string_view)>)
+        {
+            promise<bool> openPromise;
+            openPromise.set_value(true);
+            return openPromise.get_future();
+        }));
+    EXPECT_CALL(*mockClient, queuedMessageCount(defaultTestRelays[0])).WillRepeatedly(Return(7));
+    EXPECT_CALL(*mockClient, queuedMessageCount(defaultTestRelays[1])).WillRepeatedly(Return(0));
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    nostrService->openRelayConnections();
+
+    auto metrics = nostrService->metrics();
+    ASSERT_EQ(metrics.relays.size(), defaultTestRelays.size());
+    for (const auto& relay : metrics.relays)
+    {
+        ASSERT_EQ(relay.outboundQueueDepth, relay.relay == defaultTestRelays[0] ? 7 : 0);
+    }
+
+    string text = metrics.toPrometheusText();
+    ASSERT_NE(text.find("aedile_relay_outbound_queue_depth{relay=\"" + defaultTestRelays[0] + "\"} 7"), string::npos);
+};
+
+TEST_F(NostrServiceBaseTest, Tracing_RecordsHotPathSpans_AsChromeTrace)
+{
+    mutex connectionStatusMutex;
+    auto connectionStatus = make_shared<unordered_map<string, bool>>();
+    connectionStatus->insert({ defaultTestRelays[0], false });
+    connectionStatus->insert({ defaultTestRelays[1], false });
+
+    EXPECT_CALL(*mockClient, isConnected(_))
+        .WillRepeatedly(Invoke([connectionStatus, &connectionStatusMutex](string_view uri)
+        {
+            lock_guard<mutex> lock(connectionStatusMutex);
+            bool status = connectionStatus->at(string(uri));
+            if (status == false)
+            {
+                connectionStatus->at(string(uri)) = true;
+            }
+            return status;
+        }));
+
+    service::ServiceTracer::clear();
+    service::ServiceTracer::enable();
+
+    auto nostrService = make_unique<nostr::service::NostrServiceBase>(
+        testAppender,
+        mockClient,
+        defaultTestRelays);
+    nostrService->openRelayConnections();
+
+    auto testEvents = getMultipleTextNoteTestEvents();
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("REQ")), _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([&testEvents](
+            client::SharedPayload message,
+            string_view uri,
+            client::MessageHandler messageHandler)
+        {
+            json messageArr = json::parse(*message);
+            string subscriptionId = messageArr.at(1);
+
+            for (auto event : testEvents)
+            {
+                auto sendableEvent = make_shared<nostr::data::Event>(event);
+                json jarr = json::array({ "EVENT", subscriptionId, sendableEvent->serialize() });
+                messageHandler(jarr.dump());
+            }
+
+            json jarr = json::array({ "EOSE", subscriptionId });
+            messageHandler(jarr.dump());
+
+            return true;
+        }));
+    EXPECT_CALL(*mockClient, send(Pointee(HasSubstr("CLOSE")), _))
+        .Times(2)
+        .WillRepeatedly(Invoke([](client::SharedPayload message, string_view uri)
+        {
+            return true;
+        }));
+
+    auto filters = make_shared<nostr::data::Filters>(getKind0And1TestFilters());
+    nostrService->queryRelays(filters).get();
+
+    service::ServiceTracer::disable();
+    string tracePath = testing::TempDir() + "aedile_service_trace.json";
+    ASSERT_TRUE(service::ServiceTracer::writeChromeTrace(tracePath));
+
+    ifstream traceFile(tracePath);
+    json trace = json::parse(traceFile);
+    service::ServiceTracer::clear();
+
+    unordered_map<string, size_t> spanCounts;
+    unordered_set<string> spanRelays;
+    for (const auto& traceEvent : trace.at("traceEvents"))
+    {
+        ASSERT_EQ(traceEvent.at("ph"), "X");
+        ASSERT_GE(traceEvent.at("dur").get<double>(), 0);
+        spanCounts[traceEvent.at("name")]++;
+        if (traceEvent.contains("args"))
+        {
+            spanRelays.insert(traceEvent.at("args").at("relay").get<string>());
+        }
+    }
+
+    // Each relay is connected once, receives a REQ and a CLOSE, and answers with every test
+    // event and an EOSE.
+    size_t framesPerRelay = testEvents.size() + 1;
+    ASSERT_EQ(spanCounts["connect"], defaultTestRelays.size());
+    ASSERT_EQ(spanCounts["send"], 2 * defaultTestRelays.size());
+    ASSERT_EQ(spanCounts["frame"], framesPerRelay * defaultTestRelays.size());
+    ASSERT_EQ(spanCounts["onSubscriptionMessage"], framesPerRelay * defaultTestRelays.size());
+    ASSERT_EQ(spanCounts["decode"], framesPerRelay * defaultTestRelays.size());
+    ASSERT_EQ(spanCounts["handler"], framesPerRelay * defaultTestRelays.size());
+    ASSERT_EQ(spanRelays, unordered_set<string>(defaultTestRelays.begin(), defaultTestRelays.end()));
+};
 } // namespace nostr_test